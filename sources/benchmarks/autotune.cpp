@@ -0,0 +1,33 @@
+#include "tao/linalg/Tuning.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/**
+ * Measures the block sizes of the host, and saves them where the
+ * library looks for them at startup, or to the path given.
+ *
+ * usage: autotune [path [size]]
+ * */
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : tao::tuning::default_path();
+    const int size = argc > 2 ? std::atoi(argv[2]) : 384;
+    if (path.empty()) {
+        std::printf("no path given, and neither TAO_PROFILE nor HOME is set\n");
+        return 1;
+    }
+    const tao::tuning::CacheSizes caches = tao::tuning::cache_sizes();
+    std::printf("caches: L1 %zu KB, L2 %zu KB, L3 %zu KB\n", caches.l1 >> 10, caches.l2 >> 10, caches.l3 >> 10);
+    const tao::tuning::Profile derived = tao::tuning::derived_profile(caches);
+    const tao::tuning::Profile tuned = tao::tuning::tune(size);
+    std::printf("%18s %12s %12s\n", "", "derived", "tuned");
+    std::printf("%18s %12d %12d\n", "gemm mc", derived.gemm.mc, tuned.gemm.mc);
+    std::printf("%18s %12d %12d\n", "gemm kc", derived.gemm.kc, tuned.gemm.kc);
+    std::printf("%18s %12d %12d\n", "gemm nc", derived.gemm.nc, tuned.gemm.nc);
+    std::printf("%18s %12d %12d\n", "transpose block", derived.transpose_block, tuned.transpose_block);
+    std::printf("%18s %12zu %12zu\n", "reduction grain", derived.reduction_grain, tuned.reduction_grain);
+    std::printf("%18s %12d %12d\n", "strassen cutoff", derived.strassen_cutoff, tuned.strassen_cutoff);
+    tao::tuning::save(tuned, path);
+    std::printf("saved to %s\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "tao/core.h"
+#include "tao/linalg/Backend.h"
+#include "tao/linalg/Blas.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Crossover between the native kernels and the BLAS backend: times
+ * square products of growing size both ways, and reports the
+ * smallest size from which the backend keeps winning, to be given
+ * to backend::set_thresholds.
+ * */
+namespace {
+
+using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Best of a few timings, once with and once without the backend.
+ * */
+template<typename F>
+std::pair<double, double> time_both(F&& f) {
+    double t[2];
+    for (int routed = 0; routed < 2; ++routed) {
+        tao::backend::set_enabled(routed == 1);
+        t[routed] = 1e30;
+        for (int r = 0; r < 5; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            t[routed] = std::min(t[routed], seconds_since(start));
+        }
+    }
+    return {t[0], t[1]};
+}
+
+/**
+ * The first size after which the backend is always faster.
+ * */
+std::size_t crossover(const std::size_t* size, const bool* faster, int count) {
+    std::size_t from = 0;
+    for (int i = count - 1; i >= 0 && faster[i]; --i)
+        from = size[i];
+    return from;
+}
+
+};
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[1])));
+    if (!tao::backend::available()) {
+        std::printf("built without a BLAS backend: configure with -DTAO_BLAS_BACKEND=ON\n");
+        return 0;
+    }
+    tao::backend::set_thresholds({0, 0});
+    std::printf("%u threads\n", tao::parallel::concurrency());
+
+    const int sizes[] = {16, 32, 64, 128, 192, 256, 384, 512, 768, 1024};
+    const int count = sizeof(sizes) / sizeof(sizes[0]);
+    std::size_t gemm_size[count], gemv_size[count];
+    bool gemm_faster[count], gemv_faster[count];
+    std::printf("%6s %12s %12s %12s %12s\n", "n", "gemm native", "gemm blas", "gemv native", "gemv blas");
+    for (int s = 0; s < count; ++s) {
+        const int n = sizes[s];
+        DMat a (n, n), b (n, n), c (n, n), x (n, 1), y (n, 1);
+        a.reset(0.5);
+        b.reset(0.25);
+        x.reset(1.0);
+        auto mm = time_both([&]() { tao::kernels::gemm(n, n, n, 1.0, a.raw(), a.ld(), b.raw(), b.ld(), 0.0, c.raw(), c.ld()); });
+        // a gemv reads as much as it computes, so repeat it to time it
+        const int reps = std::max(1, (1 << 22) / (n * n));
+        auto mv = time_both([&]() { for (int r = 0; r < reps; ++r) tao::gemv(1.0, a, x, 0.0, y); });
+        std::printf("%6d %10.2f GF %9.2f GF %9.2f GF %9.2f GF\n", n,
+            2e-9 * n * n * n / mm.first, 2e-9 * n * n * n / mm.second,
+            2e-9 * n * n * reps / mv.first, 2e-9 * n * n * reps / mv.second);
+        gemm_size[s] = std::size_t(n) * n * n;
+        gemv_size[s] = std::size_t(n) * n;
+        gemm_faster[s] = mm.second < mm.first;
+        gemv_faster[s] = mv.second < mv.first;
+    }
+    const std::size_t g3 = crossover(gemm_size, gemm_faster, count), g2 = crossover(gemv_size, gemv_faster, count);
+    std::printf("thresholds: gemm %zu, gemv %zu multiply-adds (0: the backend never kept winning)\n", g3, g2);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "tao/core.h"
+#include "tao/linalg/Batch.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Throughput of products, determinants and inverses of small
+ * matrices, one call per matrix against one batched call.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename T, int N>
+void run(const char* name) {
+    const std::size_t n = std::size_t(1) << 16, rounds = 10;
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<T> u {T(-1), T(1)};
+    std::vector<tao::Mat<T, N, N>> a (n, tao::Mat<T, N, N>(T(0))), b = a, c = a;
+    std::vector<T> det (n);
+    for (std::size_t i = 0; i < n; ++i)
+        for (int r = 0; r < N; ++r)
+            for (int k = 0; k < N; ++k) {
+                a[i](r, k) = u(gen) + (r == k ? T(N) : T(0));
+                b[i](r, k) = u(gen);
+            }
+    const double ops = double(n) * rounds * 1e-6;
+    auto rate = [&](auto&& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < rounds; ++r)
+            f();
+        return ops / seconds_since(start);
+    };
+
+    const double mul = rate([&]() { for (std::size_t i = 0; i < n; ++i) c[i] = a[i] * b[i]; });
+    const double batch_mul = rate([&]() { tao::batch_multiply(a.data(), b.data(), n, c.data()); });
+    std::printf("%-10s multiply   %8.2f M/s   batched %8.2f M/s\n", name, mul, batch_mul);
+    if constexpr (N == 4) {
+        const double d = rate([&]() { for (std::size_t i = 0; i < n; ++i) det[i] = tao::det(a[i]); });
+        const double batch_d = rate([&]() { tao::batch_det(a.data(), n, det.data()); });
+        std::printf("%-10s det        %8.2f M/s   batched %8.2f M/s\n", name, d, batch_d);
+        const double inv = rate([&]() { for (std::size_t i = 0; i < n; ++i) c[i] = tao::inverse(a[i]); });
+        const double batch_inv = rate([&]() { tao::batch_inverse(a.data(), n, c.data()); });
+        std::printf("%-10s inverse    %8.2f M/s   batched %8.2f M/s\n", name, inv, batch_inv);
+    } else {
+        const double batch_d = rate([&]() { tao::batch_det(a.data(), n, det.data()); });
+        const double batch_inv = rate([&]() { tao::batch_inverse(a.data(), n, c.data()); });
+        std::printf("%-10s det        %8s       batched %8.2f M/s\n", name, "-", batch_d);
+        std::printf("%-10s inverse    %8s       batched %8.2f M/s\n", name, "-", batch_inv);
+    }
+}
+
+};
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[1])));
+    std::printf("%u threads\n", tao::parallel::concurrency());
+    run<float, 4>("float 4x4");
+    run<float, 3>("float 3x3");
+    run<double, 4>("double 4x4");
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "tao/core.h"
+#include "tao/linalg/Blas.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Fused level 1 and 2 kernels against the operator expressions
+ * solvers write today, y += x * a and A * x.
+ * */
+namespace {
+
+using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename F>
+double rate(double elements, int rounds, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        f();
+    return elements * rounds / seconds_since(start) * 1e-9;
+}
+
+};
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[1])));
+    std::printf("%u threads\n", tao::parallel::concurrency());
+
+    const int n = 1 << 20;
+    tao::Mat<double, 64, 1> xs (1.0), ys (2.0);
+    DMat x (n, 1), y (n, 1);
+    x.reset(1.0);
+    y.reset(2.0);
+    const double a = 1e-9;
+    std::printf("axpy, G elements/s\n");
+    std::printf("  %-22s %8.3f\n", "y += x * a, 64", rate(64, 200000, [&]() { ys += xs * a; }));
+    std::printf("  %-22s %8.3f\n", "axpy, 64", rate(64, 200000, [&]() { tao::axpy(a, xs, ys); }));
+    std::printf("  %-22s %8.3f\n", "axpy, 2^20", rate(n, 50, [&]() { tao::axpy(a, x, y); }));
+    std::printf("  %-22s %8.3f\n", "axpby, 2^20", rate(n, 50, [&]() { tao::axpby(a, x, 0.5, y); }));
+
+    const int m = 1024;
+    DMat A (m, m), v (m, 1), w (m, 1);
+    A.reset(0.5);
+    v.reset(1.0);
+    std::printf("gemv %dx%d, G multiply-adds/s\n", m, m);
+    std::printf("  %-22s %8.3f\n", "A * x", rate(double(m) * m, 20, [&]() { w = A * v; }));
+    std::printf("  %-22s %8.3f\n", "gemv", rate(double(m) * m, 20, [&]() { tao::gemv(1.0, A, v, 0.0, w); }));
+    std::printf("  %-22s %8.3f\n", "ger", rate(double(m) * m, 20, [&]() { tao::ger(1e-9, v, w, A); }));
+    return y(0, 0) < 0.0 || w(0, 0) < 0.0 || ys(0) < 0.0;
+}
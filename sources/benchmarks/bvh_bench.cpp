@@ -0,0 +1,62 @@
+#include "tao/geometry/BVH.h"
+#include "tao/geometry/Sphere.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Times the BVH build over random primitives, then closest-hit
+ * and any-hit traversal of random rays.
+ *
+ * Usage: bvh_bench [primitives] [threads]
+ * */
+int main(int argc, char** argv) {
+    using namespace tao::geometry;
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    if (argc > 2)
+        tao::parallel::set_concurrency(std::atoi(argv[2]));
+
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> pos {-100.0f, 100.0f}, rad {0.2f, 1.0f};
+    std::vector<Sphere<float>> spheres;
+    std::vector<AABB<float>> bounds;
+    spheres.reserve(n);
+    bounds.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        spheres.emplace_back(tao::Vec3f {pos(gen), pos(gen), pos(gen)}, rad(gen));
+        bounds.push_back(spheres.back().bounds());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BVH<float> bvh {bounds};
+    std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+    std::printf("build: %zu primitives, %u threads, %.1f ms, %zu nodes, depth %d\n",
+            n, tao::parallel::concurrency(), build.count(), bvh.nodes().size(), bvh.depth());
+
+    const int rays = 1 << 18;
+    std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+    std::vector<Ray<float>> batch;
+    batch.reserve(rays);
+    for (int k = 0; k < rays; ++k)
+        batch.emplace_back(tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {u(gen), u(gen), u(gen)});
+    auto hit_sphere = [&](std::uint32_t i, const Ray<float>& r, float& t) { return intersect(spheres[i], r, t); };
+
+    int hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ray : batch) {
+        std::uint32_t p;
+        float t;
+        hits += bvh.closest_hit(ray, hit_sphere, p, t);
+    }
+    std::chrono::duration<double> closest = std::chrono::steady_clock::now() - start;
+    int occluded = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ray : batch)
+        occluded += bvh.any_hit(ray, hit_sphere);
+    std::chrono::duration<double> any = std::chrono::steady_clock::now() - start;
+    std::printf("closest hit: %.2f Mrays/s (%d hits), any hit: %.2f Mrays/s (%d hits), single thread\n",
+            rays / closest.count() * 1e-6, hits, rays / any.count() * 1e-6, occluded);
+    return 0;
+}
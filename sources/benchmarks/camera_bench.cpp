@@ -0,0 +1,76 @@
+#include "tao/geometry/Camera.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+/**
+ * Camera rays per second: one at a time, per tile into SoA buffers,
+ * and over the whole image with tiles spread over threads.
+ * */
+namespace {
+
+using namespace tao::geometry;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run(Projection kind, const char* name) {
+    const int width = 1920, height = 1080, frames = 10;
+    tao::Mat<float, 4, 4> placement (0.0f);
+    for (int i = 0; i < 4; ++i)
+        placement(i, i) = 1.0f;
+    placement(2, 3) = 5.0f;
+    auto camera = kind == Perspective ? Camera<float>::perspective(placement, 0.8f, width, height)
+        : Camera<float>::orthographic(placement, 2.0f, width, height);
+    const double rays = double(width) * height * frames;
+    float sink = 0.0f;
+
+    auto start = std::chrono::steady_clock::now();
+    if (kind == Perspective) {
+        // per pixel, through the generic matrix operations
+        const float tan_half = std::tan(0.4f), aspect = float(width) / height;
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                tao::Mat<float, 4, 1> p {(2.0f * (x + 0.5f) / width - 1.0f) * aspect * tan_half,
+                    (1.0f - 2.0f * (y + 0.5f) / height) * tan_half, -1.0f, 0.0f};
+                tao::Mat<float, 4, 1> d = placement * p;
+                tao::Vec3f u = tao::unitize(tao::Vec3f {d(0), d(1), d(2)});
+                sink += u(0) + u(1) + u(2);
+            }
+        std::printf("%-12s Mat per pixel  %8.1f Mrays/s\n", name, rays / frames / seconds_since(start) * 1e-6);
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                auto ray = camera.generate_ray(x + 0.5f, y + 0.5f);
+                sink += ray.direction(0) + ray.direction(1) + ray.direction(2) + ray.origin(0);
+            }
+    std::printf("%-12s single rays    %8.1f Mrays/s\n", name, rays / seconds_since(start) * 1e-6);
+
+    RayBuffer<float> buffer;
+    auto tiles = camera.tiles(32);
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        for (const Tile& tile : tiles) {
+            camera.generate(tile, buffer);
+            sink += buffer.direction[2][0];
+        }
+    std::printf("%-12s tiles          %8.1f Mrays/s\n", name, rays / seconds_since(start) * 1e-6);
+
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+        camera.for_each_tile(32, [](const Tile&, const RayBuffer<float>&) {});
+    std::printf("%-12s parallel tiles %8.1f Mrays/s  on %u threads  (%g)\n", name,
+            rays / seconds_since(start) * 1e-6, tao::parallel::concurrency(), double(sink));
+}
+
+};
+
+int main() {
+    run(Perspective, "perspective");
+    run(Orthographic, "orthographic");
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "tao/core.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+
+/**
+ * Compares the deterministic and the default execution modes of the
+ * reductions and of the matrix product over several thread counts.
+ * */
+namespace {
+
+template<typename F>
+double best_of(int runs, F&& f) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+};
+
+int main() {
+    const int n = 1 << 24, dim = 512;
+    tao::Mat<float, Dynamic, Dynamic> v (n, 1);
+    for (int i = 0; i < n; ++i)
+        v(i) = std::sin(float(i));
+    tao::Mat<float, Dynamic, Dynamic> a (dim, dim), b (dim, dim);
+    for (int i = 0; i < dim; ++i) {
+        for (int j = 0; j < dim; ++j) {
+            a(i, j) = std::cos(float(i * dim + j));
+            b(i, j) = std::sin(float(i + j));
+        }
+    }
+
+    std::printf("%8s %14s %10s %10s %14s %10s\n", "threads", "mode", "sum (ms)", "dot (ms)", "sum value", "gemm (ms)");
+    for (unsigned int threads : {1u, 2u, 4u, 8u, 16u}) {
+        tao::parallel::set_concurrency(threads);
+        for (bool det : {false, true}) {
+            tao::parallel::set_deterministic(det);
+            volatile float sink = 0.0f;
+            float value = tao::sum(v);
+            double sum_ms = best_of(5, [&]() { sink = tao::sum(v); });
+            double dot_ms = best_of(5, [&]() { sink = tao::inner(v, v); });
+            double gemm_ms = best_of(3, [&]() { auto c = a * b; sink = c(0, 0); });
+            std::printf("%8u %14s %10.3f %10.3f %14.9g %10.3f\n", threads,
+                    det ? "deterministic" : "default", sum_ms, dot_ms, value, gemm_ms);
+        }
+    }
+    return 0;
+}
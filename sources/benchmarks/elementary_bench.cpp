@@ -0,0 +1,71 @@
+#include "tao/core.h"
+#include "tao/linalg/Elementary.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Elementary functions over batches, in both accuracy tiers, and
+ * spherical angles of directions, against the per-vector functions.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename F>
+double rate(std::size_t n, int rounds, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        f();
+    return double(n) * rounds / seconds_since(start) * 1e-6;
+}
+
+};
+
+int main() {
+    namespace math = tao::math;
+    using math::Exact;
+    using math::Fast;
+    const std::size_t n = 1 << 14;
+    const int rounds = 400;
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+    std::vector<float> x (n), y (n), z (n), positive (n), out (n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = u(gen);
+        y[i] = u(gen);
+        z[i] = u(gen);
+        positive[i] = 0.001f + 100.0f * (u(gen) + 1.0f);
+    }
+
+    std::printf("Melements/s      exact     fast\n");
+    auto row = [&](const char* name, auto exact, auto fast) {
+        const double e = rate(n, rounds, exact), f = rate(n, rounds, fast);
+        std::printf("%-12s %9.1f %9.1f\n", name, e, f);
+    };
+    row("sqrt", [&] { math::sqrt<Exact>(positive.data(), out.data(), n); }, [&] { math::sqrt<Fast>(positive.data(), out.data(), n); });
+    row("rsqrt", [&] { math::rsqrt<Exact>(positive.data(), out.data(), n); }, [&] { math::rsqrt<Fast>(positive.data(), out.data(), n); });
+    row("exp", [&] { math::exp<Exact>(x.data(), out.data(), n); }, [&] { math::exp<Fast>(x.data(), out.data(), n); });
+    row("log", [&] { math::log<Exact>(positive.data(), out.data(), n); }, [&] { math::log<Fast>(positive.data(), out.data(), n); });
+    row("sin", [&] { math::sin<Exact>(positive.data(), out.data(), n); }, [&] { math::sin<Fast>(positive.data(), out.data(), n); });
+    row("cos", [&] { math::cos<Exact>(positive.data(), out.data(), n); }, [&] { math::cos<Fast>(positive.data(), out.data(), n); });
+    row("acos", [&] { math::acos<Exact>(x.data(), out.data(), n); }, [&] { math::acos<Fast>(x.data(), out.data(), n); });
+    row("atan2", [&] { math::atan2<Exact>(y.data(), x.data(), out.data(), n); }, [&] { math::atan2<Fast>(y.data(), x.data(), out.data(), n); });
+    row("theta", [&] { math::spherical_theta<Exact>(x.data(), y.data(), z.data(), out.data(), n); },
+        [&] { math::spherical_theta<Fast>(x.data(), y.data(), z.data(), out.data(), n); });
+    row("phi", [&] { math::spherical_phi<Exact>(x.data(), y.data(), out.data(), n); },
+        [&] { math::spherical_phi<Fast>(x.data(), y.data(), out.data(), n); });
+
+    std::vector<tao::Vec3f> directions;
+    for (std::size_t i = 0; i < n; ++i)
+        directions.push_back(tao::Vec3f {x[i], y[i], z[i]});
+    const double per_vector = rate(n, rounds, [&] {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = tao::spherical_theta(directions[i]) + tao::spherical_phi(directions[i]);
+    });
+    std::printf("theta + phi per Vec3f  %9.1f\n", per_vector);
+    return out[0] > 100.0f;
+}
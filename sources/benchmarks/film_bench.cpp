@@ -0,0 +1,122 @@
+#include "tao/geometry/Film.h"
+#include "tao/parallel/Parallel.h"
+#include "tao/sampling/Philox.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+/**
+ * Splat throughput of the accumulation modes, against a film guarded
+ * by a mutex: samples coherent within tiles, as when tracing camera
+ * paths, and samples crowding a few pixels from every thread.
+ * */
+namespace {
+
+using namespace tao::geometry;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * The approach the film replaces: one lock around plain planes.
+ * */
+struct LockedFilm {
+    int width, height;
+    std::vector<float> planes[4];
+    std::mutex lock;
+
+    LockedFilm(int w, int h) : width {w}, height {h} {
+        for (auto& p : planes)
+            p.assign(std::size_t(w) * h, 0.0f);
+    }
+
+    void add(float px, float py, const tao::Vec3f& value, float weight) {
+        const int x = int(px), y = int(py);
+        const std::size_t i = std::size_t(y) * width + x;
+        std::lock_guard<std::mutex> guard {lock};
+        planes[0][i] += value(0) * weight;
+        planes[1][i] += value(1) * weight;
+        planes[2][i] += value(2) * weight;
+        planes[3][i] += weight;
+    }
+};
+
+const int width = 512, height = 512, samples = 16, tile_size = 32;
+
+/**
+ * Splats the samples of every tile, tiles in parallel: begin(tile)
+ * makes the state of a tile, add(state, px, py, value) takes each
+ * sample, end(state) closes the tile. Returns millions of splats
+ * per second.
+ * */
+template<typename Begin, typename Add, typename End>
+double splat_rate(const std::vector<Tile>& tiles, bool crowded, Begin begin, Add add, End end) {
+    // the same offsets within pixels for every tile
+    std::vector<float> u (std::size_t(tile_size) * tile_size * samples * 2);
+    tao::sampling::Philox(3).uniform(0, u.data(), u.size());
+    auto start = std::chrono::steady_clock::now();
+    tao::parallel::parallel_for(0, tiles.size(), 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t t = lo; t < hi; ++t) {
+            const Tile& tile = tiles[t];
+            auto state = begin(tile);
+            std::size_t k = 0;
+            for (int y = tile.y0; y < tile.y1; ++y)
+                for (int x = tile.x0; x < tile.x1; ++x)
+                    for (int s = 0; s < samples; ++s, k += 2) {
+                        // crowded samples all fall in the 8x8 pixels at the center; the
+                        // others within their pixel, which rounding of x + u may leave
+                        const float px = crowded ? width / 2 - 4 + 8 * u[k] : std::min(float(x) + u[k], float(x) + 0.99f);
+                        const float py = crowded ? height / 2 - 4 + 8 * u[k + 1] : std::min(float(y) + u[k + 1], float(y) + 0.99f);
+                        add(state, px, py, tao::Vec3f {u[k], 0.5f, 1.0f - u[k]});
+                    }
+            end(state);
+        }
+    });
+    return double(width) * height * samples / seconds_since(start) * 1e-6;
+}
+
+};
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[1])));
+    tao::Mat<float, 4, 4> identity (0.0f);
+    for (int i = 0; i < 4; ++i) identity(i, i) = 1.0f;
+    const auto camera = Camera<float>::perspective(identity, 1.0f, width, height);
+    const std::vector<Tile> tiles = camera.tiles(tile_size);
+    std::printf("%u threads, %dx%d, %d samples per pixel\n", tao::parallel::concurrency(), width, height, samples);
+    std::printf("Msplats/s              radius 0.5  radius 1.5\n");
+
+    double locked = 0.0;
+    {
+        LockedFilm film {width, height};
+        locked = splat_rate(tiles, false, [&](const Tile&) { return 0; },
+            [&](int, float px, float py, const tao::Vec3f& v) { film.add(px, py, v, 1.0f); }, [](int) {});
+    }
+    std::printf("%-22s %10.1f %11s\n", "mutex", locked, "-");
+    const char* names[] = {"tiled", "atomic", "hybrid"};
+    for (auto mode : {Tiled, Atomic, Hybrid}) {
+        double rate[2];
+        for (int r = 0; r < 2; ++r) {
+            Film<float> film {width, height, r ? 1.5f : 0.5f, mode};
+            rate[r] = splat_rate(tiles, false, [&](const Tile& t) { return film.tile(t); },
+                [](FilmTile<float>& acc, float px, float py, const tao::Vec3f& v) { acc.add(px, py, v); },
+                [&](FilmTile<float>& acc) { film.merge(acc); });
+        }
+        std::printf("%-22s %10.1f %11.1f\n", names[mode], rate[0], rate[1]);
+    }
+
+    // every thread on the same pixels, through add
+    LockedFilm hot {width, height};
+    const double hot_locked = splat_rate(tiles, true, [&](const Tile&) { return 0; },
+        [&](int, float px, float py, const tao::Vec3f& v) { hot.add(px, py, v, 1.0f); }, [](int) {});
+    Film<float> film {width, height};
+    const double hot_atomic = splat_rate(tiles, true, [&](const Tile&) { return 0; },
+        [&](int, float px, float py, const tao::Vec3f& v) { film.add(px, py, v); }, [](int) {});
+    std::printf("crowded, mutex         %10.1f\ncrowded, atomic        %10.1f\n", hot_locked, hot_atomic);
+    return film.weight(width / 2, height / 2) < 0.0f;
+}
@@ -0,0 +1,96 @@
+#include "tao/core.h"
+#include "tao/linalg/Half.h"
+#include "tao/linalg/Reductions.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Cost of the 16-bit formats next to float: bulk conversion
+ * throughput both ways, then a square product and a sum of Half and
+ * BFloat16 matrices against the same in float, with the largest
+ * difference from the float results.
+ *
+ * usage: half_bench [size [threads]]
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename F>
+double best_of(int runs, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, seconds_since(start));
+    }
+    return best;
+}
+
+template<typename H>
+void conversions(const char* name, std::size_t n) {
+    std::vector<float> f (n), back (n);
+    std::vector<H> h (n);
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> u {-100.0f, 100.0f};
+    for (float& x : f) x = u(gen);
+    const double to = best_of(5, [&]() { tao::convert(f.data(), h.data(), n); });
+    const double from = best_of(5, [&]() { tao::convert(h.data(), back.data(), n); });
+    std::printf("%-9s float->16 %7.2f GB/s   16->float %7.2f GB/s\n", name,
+        n * sizeof(float) * 1e-9 / to, n * sizeof(float) * 1e-9 / from);
+}
+
+template<typename H>
+void products(const char* name, const tao::Mat<float, Dynamic, Dynamic>& a,
+        const tao::Mat<float, Dynamic, Dynamic>& b, const tao::Mat<float, Dynamic, Dynamic>& c, double float_time) {
+    const int n = a.nrows();
+    auto ha = tao::convert<H>(a), hb = tao::convert<H>(b);
+    tao::Mat<H, Dynamic, Dynamic> hc (n, n);
+    const double time = best_of(3, [&]() { tao::kernels::gemm(n, n, n, H(1.0f), ha.raw(), ha.ld(), hb.raw(), hb.ld(), H(0.0f), hc.raw(), hc.ld()); });
+    // against the float product of the rounded operands
+    auto fc = tao::convert<float>(ha) * tao::convert<float>(hb);
+    float worst = 0, drift = 0;
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) {
+            worst = std::max(worst, std::abs(float(hc.raw()[std::size_t(i) * hc.ld() + j]) - fc.raw()[std::size_t(i) * fc.ld() + j]));
+            drift = std::max(drift, std::abs(float(hc.raw()[std::size_t(i) * hc.ld() + j]) - c.raw()[std::size_t(i) * c.ld() + j]));
+        }
+    float s = 0;
+    const double sum_time = best_of(5, [&]() { s = tao::sum(ha); });
+    std::printf("%-9s gemm %8.3f s (%.2fx float)  rounding %.3g  vs float %.3g   sum %8.5f s = %g\n",
+        name, time, time / float_time, worst, drift, sum_time, s);
+}
+
+};
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? std::atoi(argv[1]) : 512;
+    if (argc > 2)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[2])));
+    tao::backend::set_enabled(false);
+    std::printf("%u threads, F16C %s\n", tao::parallel::concurrency(), tao::has_f16c() ? "yes" : "no");
+    conversions<tao::Half>("Half", std::size_t(1) << 24);
+    conversions<tao::BFloat16>("BFloat16", std::size_t(1) << 24);
+
+    std::mt19937 gen {2};
+    std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+    tao::Mat<float, Dynamic, Dynamic> a (n, n), b (n, n), c (n, n);
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) {
+            a.raw()[std::size_t(i) * a.ld() + j] = u(gen);
+            b.raw()[std::size_t(i) * b.ld() + j] = u(gen);
+        }
+    const double float_time = best_of(3, [&]() { tao::kernels::gemm(n, n, n, 1.0f, a.raw(), a.ld(), b.raw(), b.ld(), 0.0f, c.raw(), c.ld()); });
+    float s = 0;
+    const double sum_time = best_of(5, [&]() { s = tao::sum(a); });
+    std::printf("%-9s gemm %8.3f s                                       sum %8.5f s = %g\n", "float", float_time, sum_time, s);
+    products<tao::Half>("Half", a, b, c, float_time);
+    products<tao::BFloat16>("BFloat16", a, b, c, float_time);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "tao/geometry/Morton.h"
+#include "tao/parallel/RadixSort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Encoding of points along both curves, and sorting of the
+ * codes with the radix sort against std::sort.
+ * */
+namespace {
+
+using namespace tao::geometry;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+};
+
+int main() {
+    const std::size_t n = std::size_t(1) << 22;
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+    std::vector<tao::Vec3f> points;
+    points.reserve(n);
+    AABB<float> bounds;
+    for (std::size_t k = 0; k < n; ++k) {
+        points.emplace_back(tao::Vec3f {u(gen), u(gen), u(gen)});
+        bounds.expand(points.back());
+    }
+
+    std::vector<std::uint32_t> codes30 (n);
+    std::vector<std::uint64_t> codes63 (n);
+    for (auto curve : {Morton, Hilbert}) {
+        const char* name = curve == Morton ? "morton" : "hilbert";
+        auto start = std::chrono::steady_clock::now();
+        encode_points(points.data(), n, bounds, codes30.data(), curve);
+        std::printf("%-8s 30-bit  %8.1f Mpoints/s\n", name, n / seconds_since(start) * 1e-6);
+        start = std::chrono::steady_clock::now();
+        encode_points(points.data(), n, bounds, codes63.data(), curve);
+        std::printf("%-8s 63-bit  %8.1f Mpoints/s\n", name, n / seconds_since(start) * 1e-6);
+    }
+
+    encode_points(points.data(), n, bounds, codes63.data());
+    std::vector<std::uint64_t> keys = codes63;
+    auto start = std::chrono::steady_clock::now();
+    std::sort(keys.begin(), keys.end());
+    std::printf("std::sort           %8.3f s\n", seconds_since(start));
+    keys = codes63;
+    start = std::chrono::steady_clock::now();
+    tao::parallel::radix_sort(keys, 63);
+    std::printf("radix_sort          %8.3f s\n", seconds_since(start));
+    start = std::chrono::steady_clock::now();
+    auto order = spatial_order(points);
+    tao::parallel::reorder(points, order);
+    std::printf("spatial_order+reorder %6.3f s\n", seconds_since(start));
+    return 0;
+}
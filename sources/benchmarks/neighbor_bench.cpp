@@ -0,0 +1,51 @@
+#include "tao/geometry/HashGrid.h"
+#include "tao/geometry/KdTree.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Build and query times of the hash grid and the k-d tree
+ * on uniformly distributed points.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+};
+
+int main() {
+    using namespace tao::geometry;
+    const std::size_t n = std::size_t(1) << 22, m = std::size_t(1) << 18, k = 8;
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> u {0.0f, 1.0f};
+    std::vector<tao::Vec3f> points, queries;
+    points.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        points.emplace_back(tao::Vec3f {u(gen), u(gen), u(gen)});
+    for (std::size_t i = 0; i < m; ++i)
+        queries.emplace_back(tao::Vec3f {u(gen), u(gen), u(gen)});
+    // about 8 neighbors per query
+    const float radius = 0.0078f;
+
+    auto start = std::chrono::steady_clock::now();
+    HashGrid<float> grid {points, 2.0f * radius};
+    std::printf("hash grid build   %8.3f s\n", seconds_since(start));
+    start = std::chrono::steady_clock::now();
+    NeighborList list = grid.radius_search(queries, radius);
+    std::printf("radius queries    %8.1f Kqueries/s  (%zu neighbors)\n", m / seconds_since(start) * 1e-3,
+            list.indices.size());
+
+    start = std::chrono::steady_clock::now();
+    KdTree<float> tree {points};
+    std::printf("k-d tree build    %8.3f s\n", seconds_since(start));
+    std::vector<std::uint32_t> idx (m * k);
+    std::vector<float> d2 (m * k);
+    start = std::chrono::steady_clock::now();
+    tree.knn(queries.data(), m, k, idx.data(), d2.data());
+    std::printf("%zu-NN queries      %8.1f Kqueries/s\n", k, m / seconds_since(start) * 1e-3);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "tao/parallel/Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/**
+ * Cost of parallel calls on the scheduler, against starting threads
+ * on every call as parallel_for used to: flat calls of little work,
+ * and calls nested two deep, where spawning multiplies the threads.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * One thread per chunk, started and joined by the call.
+ * */
+template<typename F>
+void spawning_for(std::size_t begin, std::size_t end, std::size_t grain, F&& body) {
+    const std::size_t n = end - begin;
+    const std::size_t chunks = std::min<std::size_t>(tao::parallel::concurrency(), (n + grain - 1) / grain);
+    if (chunks <= 1) {
+        body(begin, end);
+        return;
+    }
+    const std::size_t size = (n + chunks - 1) / chunks;
+    std::vector<std::thread> threads;
+    for (std::size_t c = 1; c < chunks; ++c)
+        threads.emplace_back([&, c]() { body(begin + c * size, std::min(end, begin + (c + 1) * size)); });
+    body(begin, begin + size);
+    for (auto& t : threads)
+        t.join();
+}
+
+std::atomic<long> sink {0};
+
+void work(std::size_t lo, std::size_t hi) {
+    long s = 0;
+    for (std::size_t i = lo; i < hi; ++i)
+        s += long(i * i % 7);
+    sink += s;
+}
+
+/**
+ * Microseconds per outer call.
+ * */
+template<typename For>
+double call_cost(For&& run, int calls) {
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < calls; ++c)
+        run();
+    return seconds_since(start) / calls * 1e6;
+}
+
+};
+
+int main(int argc, char** argv) {
+    if (argc > 1)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[1])));
+    const std::size_t n = 1 << 14;
+    std::printf("%u threads, %zu elements per call\n", tao::parallel::concurrency(), n);
+    std::printf("us per call            flat    nested\n");
+
+    auto flat = [&](auto&& pfor) {
+        return [&, pfor]() { pfor(0, n, 256, work); };
+    };
+    auto nested = [&](auto&& pfor) {
+        return [&, pfor]() {
+            pfor(0, 16, 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i)
+                    pfor(0, n / 16, 64, work);
+            });
+        };
+    };
+    auto scheduler = [](std::size_t b, std::size_t e, std::size_t g, auto&& f) { tao::parallel::parallel_for(b, e, g, f); };
+    auto spawning = [](std::size_t b, std::size_t e, std::size_t g, auto&& f) { spawning_for(b, e, g, f); };
+
+    std::printf("%-18s %9.1f %9.1f\n", "spawn per call", call_cost(flat(spawning), 200), call_cost(nested(spawning), 20));
+    std::printf("%-18s %9.1f %9.1f\n", "work stealing", call_cost(flat(scheduler), 200), call_cost(nested(scheduler), 20));
+    std::printf("%-18s %9.1f\n", "serial", call_cost([&]() { work(0, n); }, 200));
+    return sink.load() < 0;
+}
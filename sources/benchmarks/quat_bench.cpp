@@ -0,0 +1,85 @@
+#include "tao/core.h"
+#include "tao/linalg/Quat.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Composition of rotations as 4x4 matrices and as quaternions, and
+ * interpolation and vector rotation over batches of joints.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+};
+
+int main() {
+    using tao::Quat;
+    const std::size_t n = 4096, frames = 500;
+    std::mt19937 gen {1};
+    std::normal_distribution<float> u {0.0f, 1.0f};
+    tao::QuatSoA<float> a (n), b (n), out (n);
+    std::vector<Quat<float>> qa, qb;
+    std::vector<tao::Mat<float, 4, 4>> ma, mb;
+    for (std::size_t i = 0; i < n; ++i) {
+        qa.push_back(Quat<float> {u(gen), u(gen), u(gen), u(gen)}.normalized());
+        qb.push_back(Quat<float> {u(gen), u(gen), u(gen), u(gen)}.normalized());
+        a.set(i, qa.back());
+        b.set(i, qb.back());
+        ma.push_back(qa.back().to_mat4());
+        mb.push_back(qb.back().to_mat4());
+    }
+    const double ops = double(n) * frames;
+    float sink = 0.0f;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f)
+        for (std::size_t i = 0; i < n; ++i)
+            sink += (ma[i] * mb[i])(0, 0);
+    std::printf("Mat4 compose        %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f)
+        for (std::size_t i = 0; i < n; ++i) {
+            const Quat<float> q = qa[i] * qb[i];
+            sink += q.w + q.x + q.y + q.z;
+        }
+    std::printf("Quat compose        %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f) {
+        tao::multiply(a, b, out);
+        sink += out.w[f];
+    }
+    std::printf("QuatSoA compose     %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f)
+        for (std::size_t i = 0; i < n; ++i) {
+            const Quat<float> q = slerp(qa[i], qb[i], float(f) / frames);
+            sink += q.w + q.x + q.y + q.z;
+        }
+    std::printf("Quat slerp          %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f) {
+        tao::slerp(a, b, float(f) / frames, out);
+        sink += out.w[f];
+    }
+    std::printf("QuatSoA slerp       %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f) {
+        tao::nlerp(a, b, float(f) / frames, out);
+        sink += out.w[f];
+    }
+    std::printf("QuatSoA nlerp       %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+
+    std::vector<float> x (n, 1.0f), y (n, 0.5f), z (n, -1.0f);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t f = 0; f < frames; ++f)
+        tao::rotate(a, x.data(), y.data(), z.data(), x.data(), y.data(), z.data());
+    std::printf("QuatSoA rotate      %8.1f M/s\n", ops / seconds_since(start) * 1e-6);
+    std::printf("(%g)\n", double(sink + x[0]));
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "tao/sampling/Philox.h"
+#include "tao/sampling/LowDiscrepancy.h"
+#include "tao/sampling/Warp.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Sample generation in blocks against one sample at a time, and
+ * batched warps in both accuracy tiers.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename F>
+double rate(std::size_t n, int rounds, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        f();
+    return double(n) * rounds / seconds_since(start) * 1e-6;
+}
+
+};
+
+int main() {
+    using namespace tao::sampling;
+    using tao::math::Exact;
+    using tao::math::Fast;
+    const std::size_t n = 1 << 14;
+    const int rounds = 400;
+    std::vector<float> u (n), v (n), x (n), y (n), z (n);
+    float sink = 0.0f;
+
+    std::printf("Msamples/s         block    single\n");
+    auto row = [&](const char* name, auto block, auto single) {
+        const double b = rate(n, rounds, block), s = rate(n, rounds, single);
+        std::printf("%-14s %9.1f %9.1f\n", name, b, s);
+    };
+    const Philox philox {1, 2};
+    const Sobol sobol, owen {9};
+    const Halton halton;
+    const R2 r2;
+    std::mt19937 mt {1};
+    std::uniform_real_distribution<float> uniform {0.0f, 1.0f};
+    row("philox", [&] { philox.uniform(0, u.data(), n); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = philox.uniform<float>(i); });
+    row("mt19937", [&] { for (std::size_t i = 0; i < n; ++i) u[i] = uniform(mt); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = uniform(mt); });
+    row("sobol", [&] { sobol.generate(0, n, 3, u.data()); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = sobol.sample<float>(std::uint32_t(i), 3); });
+    row("sobol owen", [&] { owen.generate(0, n, 3, u.data()); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = owen.sample<float>(std::uint32_t(i), 3); });
+    row("halton", [&] { halton.generate(0, n, 7, u.data()); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = halton.sample<float>(i, 7); });
+    row("r2", [&] { r2.generate(0, n, 1, u.data()); },
+        [&] { for (std::size_t i = 0; i < n; ++i) u[i] = r2.sample<float>(i, 1); });
+    sink += u[n / 2];
+
+    owen.generate(0, n, 0, u.data());
+    owen.generate(0, n, 1, v.data());
+    const SphericalTriangle<float> triangle {tao::Vec3f {1.0f, 0.2f, 0.1f}, tao::Vec3f {-0.3f, 1.0f, 0.4f}, tao::Vec3f {0.2f, -0.1f, 1.0f}};
+    std::printf("\nMwarps/s           exact      fast\n");
+    auto warp = [&](const char* name, auto exact, auto fast) {
+        const double e = rate(n, rounds, exact), f = rate(n, rounds, fast);
+        std::printf("%-14s %9.1f %9.1f\n", name, e, f);
+    };
+    warp("disk", [&] { concentric_disk<Exact>(u.data(), v.data(), x.data(), y.data(), n); },
+        [&] { concentric_disk<Fast>(u.data(), v.data(), x.data(), y.data(), n); });
+    warp("cosine", [&] { cosine_hemisphere<Exact>(u.data(), v.data(), x.data(), y.data(), z.data(), n); },
+        [&] { cosine_hemisphere<Fast>(u.data(), v.data(), x.data(), y.data(), z.data(), n); });
+    warp("sphere", [&] { uniform_sphere<Exact>(u.data(), v.data(), x.data(), y.data(), z.data(), n); },
+        [&] { uniform_sphere<Fast>(u.data(), v.data(), x.data(), y.data(), z.data(), n); });
+    warp("triangle", [&] { triangle.sample<Exact>(u.data(), v.data(), x.data(), y.data(), z.data(), n); },
+        [&] { triangle.sample<Fast>(u.data(), v.data(), x.data(), y.data(), z.data(), n); });
+    sink += x[n / 3] + y[n / 4] + z[n / 5];
+    return sink > 1e30f;
+}
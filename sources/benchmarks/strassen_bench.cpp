@@ -0,0 +1,93 @@
+#include "tao/core.h"
+#include "tao/linalg/Strassen.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+/**
+ * Speed and error growth of the Strassen-Winograd product: for square
+ * sizes, times gemm (0 levels) and 1 to 3 levels of recursion, and
+ * reports the largest error of each against a long double product,
+ * for elements uniform in [-1, 1] and in [0, 1]. Errors are in units
+ * of u k max|A| max|B|, u times the largest element |A| |B| can have,
+ * so that they compare across sizes; what to weigh against the time
+ * saved is how much each level adds to the error of gemm.
+ *
+ * usage: strassen_bench [largest size [threads]]
+ * */
+namespace {
+
+using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+DMat random_matrix(int n, double lo, unsigned seed) {
+    std::mt19937 gen {seed};
+    std::uniform_real_distribution<double> u {lo, 1.0};
+    DMat m (n, n);
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            m.raw()[std::size_t(i) * m.ld() + j] = u(gen);
+    return m;
+}
+
+/**
+ * Largest error of c, in units of k u max|A| max|B|.
+ * */
+double error(const DMat& c, const std::vector<long double>& exact, int n) {
+    long double worst = 0;
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            worst = std::max(worst, std::fabs(c.raw()[std::size_t(i) * c.ld() + j] - exact[std::size_t(i) * n + j]));
+    return double(worst / (n * std::numeric_limits<double>::epsilon() / 2));
+}
+
+};
+
+int main(int argc, char** argv) {
+    const int largest = argc > 1 ? std::atoi(argv[1]) : 1024;
+    if (argc > 2)
+        tao::parallel::set_concurrency(unsigned(std::atoi(argv[2])));
+    tao::backend::set_enabled(false);
+    std::printf("%u threads, current cutoff %d\n", tao::parallel::concurrency(), tao::strassen_cutoff());
+    std::printf("%6s %7s %10s %10s %14s %14s\n", "n", "levels", "time", "GF equiv", "error [-1,1]", "error [0,1]");
+    for (int n = 128; n <= largest; n *= 2) {
+        double errors[2][4];
+        double times[4];
+        for (int range = 0; range < 2; ++range) {
+            DMat a = random_matrix(n, range == 0 ? -1.0 : 0.0, 1), b = random_matrix(n, range == 0 ? -1.0 : 0.0, 2);
+            std::vector<long double> la (std::size_t(n) * n), lb (la.size()), lc (la.size());
+            for (int i = 0; i < n; ++i)
+                for (int j = 0; j < n; ++j) {
+                    la[std::size_t(i) * n + j] = a.raw()[std::size_t(i) * a.ld() + j];
+                    lb[std::size_t(i) * n + j] = b.raw()[std::size_t(i) * b.ld() + j];
+                }
+            tao::kernels::gemm(n, n, n, 1.0L, la.data(), n, lb.data(), n, 0.0L, lc.data(), n);
+            DMat c (n, n);
+            for (int levels = 0; levels < 4; ++levels) {
+                // a cutoff of n / 2^(levels - 1) splits exactly levels times
+                const int cutoff = levels == 0 ? n + 1 : n >> (levels - 1);
+                double best = 1e30;
+                for (int r = 0; r < (range == 0 ? 3 : 1); ++r) {
+                    auto start = std::chrono::steady_clock::now();
+                    tao::strassen_multiply(a, b, c, cutoff);
+                    best = std::min(best, seconds_since(start));
+                }
+                if (range == 0)
+                    times[levels] = best;
+                errors[range][levels] = error(c, lc, n);
+            }
+        }
+        for (int levels = 0; levels < 4; ++levels)
+            std::printf("%6d %7d %8.3f s %10.2f %14.3g %14.3g\n", n, levels, times[levels],
+                2e-9 * n * n * n / times[levels], errors[0][levels], errors[1][levels]);
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "tao/core.h"
+#include "tao/linalg/Transform.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Decomposition and recomposition of affine transforms, one at a
+ * time and in batches, with and without shear.
+ * */
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename T>
+void run(bool shear, const char* name) {
+    const std::size_t n = std::size_t(1) << 16, rounds = 20;
+    std::mt19937 gen {1};
+    std::normal_distribution<T> u {T(0), T(1)};
+    std::uniform_real_distribution<T> s {T(0.5), T(2)};
+    std::vector<tao::Mat<T, 4, 4>> m;
+    for (std::size_t i = 0; i < n; ++i) {
+        tao::TRS<T> trs {tao::Vec3<T> {u(gen), u(gen), u(gen)},
+            tao::Quat<T> {u(gen), u(gen), u(gen), u(gen)}.normalized(), tao::Vec3<T> {s(gen), s(gen), s(gen)}};
+        if (shear)
+            trs.stretch(0, 1) = trs.stretch(1, 0) = T(0.3);
+        m.push_back(tao::compose(trs));
+    }
+    std::vector<tao::TRS<T>> trs (n);
+    const double ops = double(n) * rounds;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < rounds; ++r)
+        for (std::size_t i = 0; i < n; ++i)
+            trs[i] = tao::decompose(m[i]);
+    std::printf("%-18s decompose        %8.2f M/s\n", name, ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < rounds; ++r)
+        tao::decompose(m.data(), n, trs.data());
+    std::printf("%-18s batch decompose  %8.2f M/s\n", name, ops / seconds_since(start) * 1e-6);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < rounds; ++r)
+        tao::compose(trs.data(), n, m.data());
+    std::printf("%-18s batch compose    %8.2f M/s\n", name, ops / seconds_since(start) * 1e-6);
+}
+
+};
+
+int main() {
+    run<float>(false, "float");
+    run<float>(true, "float sheared");
+    run<double>(false, "double");
+    run<double>(true, "double sheared");
+    return 0;
+}
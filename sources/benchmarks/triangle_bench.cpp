@@ -0,0 +1,51 @@
+#include "tao/geometry/Triangle.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Ray-triangle tests per second on one core, for both algorithms
+ * and packet widths.
+ * */
+namespace {
+
+using namespace tao::geometry;
+
+template<int W>
+void run(TriangleIntersection algorithm, const char* name) {
+    const int packets = 1 << 10, rays = 1 << 12;
+    std::mt19937 gen {1};
+    std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+    std::vector<TrianglePacket<float, W>> tris (packets);
+    for (auto& packet : tris)
+        for (int l = 0; l < W; ++l)
+            packet.set(l, Triangle<float> {tao::Vec3f {u(gen), u(gen), 5.0f + u(gen)},
+                    tao::Vec3f {u(gen), u(gen), 5.0f + u(gen)}, tao::Vec3f {u(gen), u(gen), 5.0f + u(gen)}});
+    std::vector<Ray<float>> batch;
+    for (int k = 0; k < rays; ++k)
+        batch.emplace_back(tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {0.2f * u(gen), 0.2f * u(gen), 1.0f});
+
+    unsigned long hit_count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& ray : batch) {
+        for (const auto& packet : tris) {
+            TriangleHits<float, W> hits;
+            intersect(packet, ray, hits, algorithm);
+            hit_count += __builtin_popcount(hits.mask);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double tests = double(rays) * packets * W;
+    std::printf("%-16s W=%d  %8.1f Mtests/s  (%lu hits)\n", name, W, tests / elapsed.count() * 1e-6, hit_count);
+}
+
+};
+
+int main() {
+    run<4>(MollerTrumbore, "moller-trumbore");
+    run<8>(MollerTrumbore, "moller-trumbore");
+    run<4>(Watertight, "watertight");
+    run<8>(Watertight, "watertight");
+    return 0;
+}
@@ -0,0 +1,324 @@
+#ifndef _TAO_AABB_
+#define _TAO_AABB_
+
+#include <limits>
+#include "tao/core.h"
+#include "tao/geometry/Ray.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * An axis-aligned bounding box. The default box is empty,
+ * with lower = +inf and upper = -inf, so that expanding it
+ * by anything gives that thing's bounds.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct AABB {
+
+    Vec3<T> lower;      /** the corner with the smallest coordinates */
+    Vec3<T> upper;      /** the corner with the largest coordinates */
+
+    /**
+     * Empty box.
+     * */
+    AABB() : lower (std::numeric_limits<T>::infinity()), upper (-std::numeric_limits<T>::infinity()) {}
+
+    /**
+     * Box around a single point.
+     *
+     * @param p the point
+     * */
+    explicit AABB(const Vec3<T>& p) : lower (p), upper (p) {}
+
+    /**
+     * Box around two points, in any order.
+     *
+     * @param a a corner
+     * @param b the opposite corner
+     * */
+    AABB(const Vec3<T>& a, const Vec3<T>& b) : AABB(a) {
+        expand(b);
+    }
+
+    /**
+     * Whether the box contains no point.
+     *
+     * @return true if lower > upper along some axis
+     * */
+    bool empty() const {
+        const T* lo = lower.raw();
+        const T* hi = upper.raw();
+        return lo[0] > hi[0] || lo[1] > hi[1] || lo[2] > hi[2];
+    }
+
+    /**
+     * Grows the box to contain a point.
+     *
+     * @param p the point
+     * */
+    void expand(const Vec3<T>& p) {
+        for (int a = 0; a < 3; ++a) {
+            T v = p.raw()[a];
+            lower.raw()[a] = v < lower.raw()[a] ? v : lower.raw()[a];
+            upper.raw()[a] = v > upper.raw()[a] ? v : upper.raw()[a];
+        }
+    }
+
+    /**
+     * Grows the box to contain another box.
+     *
+     * @param box the other box
+     * */
+    void expand(const AABB<T>& box) {
+        for (int a = 0; a < 3; ++a) {
+            T lo = box.lower.raw()[a], hi = box.upper.raw()[a];
+            lower.raw()[a] = lo < lower.raw()[a] ? lo : lower.raw()[a];
+            upper.raw()[a] = hi > upper.raw()[a] ? hi : upper.raw()[a];
+        }
+    }
+
+    /**
+     * Whether a point lies inside the box or on its boundary.
+     *
+     * @param p the point
+     * @return true if inside
+     * */
+    bool contains(const Vec3<T>& p) const {
+        for (int a = 0; a < 3; ++a)
+            if (p.raw()[a] < lower.raw()[a] || p.raw()[a] > upper.raw()[a])
+                return false;
+        return true;
+    }
+
+    /**
+     * The center of the box.
+     *
+     * @return (lower + upper) / 2
+     * */
+    Vec3<T> centroid() const {
+        Vec3<T> c (T(0));
+        for (int a = 0; a < 3; ++a)
+            c.raw()[a] = (lower.raw()[a] + upper.raw()[a]) * T(0.5);
+        return c;
+    }
+
+    /**
+     * The extent of the box along every axis.
+     *
+     * @return upper - lower
+     * */
+    Vec3<T> diagonal() const {
+        Vec3<T> d (T(0));
+        for (int a = 0; a < 3; ++a)
+            d.raw()[a] = upper.raw()[a] - lower.raw()[a];
+        return d;
+    }
+
+    /**
+     * The area of the faces of the box.
+     *
+     * @return the surface area, 0 for empty boxes
+     * */
+    T surface_area() const {
+        if (empty())
+            return T(0);
+        Vec3<T> d = diagonal();
+        const T* e = d.raw();
+        return T(2) * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+    }
+
+    /**
+     * The axis along which the box is the longest.
+     *
+     * @return 0, 1 or 2
+     * */
+    int max_extent() const {
+        Vec3<T> d = diagonal();
+        const T* e = d.raw();
+        if (e[0] >= e[1] && e[0] >= e[2])
+            return 0;
+        return e[1] >= e[2] ? 1 : 2;
+    }
+};
+
+/**
+ * Union of two boxes.
+ *
+ * @param a a box
+ * @param b another box
+ * @return the smallest box containing both
+ * */
+template<typename T>
+AABB<T> merge(const AABB<T>& a, const AABB<T>& b) {
+    AABB<T> box = a;
+    box.expand(b);
+    return box;
+}
+
+/**
+ * W boxes in structure-of-arrays layout, one lane per box, to be
+ * tested against a ray all at once.
+ * */
+template<typename T, int W>
+struct alignas(packet_alignment<T, W>()) AABBPacket {
+
+    T lower[3][W];      /** lower corners, per axis */
+    T upper[3][W];      /** upper corners, per axis */
+
+    /**
+     * Packet of empty boxes, which no ray hits.
+     * */
+    AABBPacket() {
+        for (int a = 0; a < 3; ++a) {
+            for (int l = 0; l < W; ++l) {
+                lower[a][l] = std::numeric_limits<T>::infinity();
+                upper[a][l] = -std::numeric_limits<T>::infinity();
+            }
+        }
+    }
+
+    /**
+     * Stores a box in a lane.
+     *
+     * @param lane the lane, in [0, W)
+     * @param box the box
+     * */
+    void set(int lane, const AABB<T>& box) {
+        for (int a = 0; a < 3; ++a) {
+            lower[a][lane] = box.lower.raw()[a];
+            upper[a][lane] = box.upper.raw()[a];
+        }
+    }
+};
+
+/**
+ * Slab test of a ray against a box given by its corners.
+ *
+ * The near plane of each slab is chosen by the sign of the inverse
+ * direction, so empty boxes are always missed; a ray lying on a slab
+ * plane produces NaN distances, which are ignored by the comparisons
+ * and count as a hit.
+ *
+ * @param lower the lower corner
+ * @param upper the upper corner
+ * @param origin the ray origin
+ * @param inv_direction the inverse of the ray direction
+ * @param tmin start of the valid segment
+ * @param tmax end of the valid segment
+ * @param t0 receives the entry distance
+ * @param t1 receives the exit distance
+ * @return whether the ray hits the box within [tmin, tmax]
+ * */
+template<typename T>
+inline bool slab_test(const T* lower, const T* upper, const T* origin, const T* inv_direction,
+        T tmin, T tmax, T& t0, T& t1) {
+    for (int a = 0; a < 3; ++a) {
+        const bool neg = inv_direction[a] < T(0);
+        T n = ((neg ? upper[a] : lower[a]) - origin[a]) * inv_direction[a];
+        T f = ((neg ? lower[a] : upper[a]) - origin[a]) * inv_direction[a] * slab_far_scale<T>();
+        tmin = n > tmin ? n : tmin;
+        tmax = f < tmax ? f : tmax;
+    }
+    t0 = tmin;
+    t1 = tmax;
+    return tmin <= tmax;
+}
+
+/**
+ * Slab test of a ray against a box.
+ *
+ * @param box the box
+ * @param ray the ray
+ * @param t0 receives the entry distance
+ * @param t1 receives the exit distance
+ * @return whether the ray hits the box within [tmin, tmax]
+ * */
+template<typename T>
+bool intersect(const AABB<T>& box, const Ray<T>& ray, T& t0, T& t1) {
+    return slab_test(box.lower.raw(), box.upper.raw(), ray.origin.raw(), ray.inv_direction.raw(),
+            ray.tmin, ray.tmax, t0, t1);
+}
+
+/**
+ * Slab test of one ray against W boxes, without branches: every lane
+ * runs the same instructions, so the loops compile to SIMD code.
+ *
+ * @param boxes the boxes
+ * @param ray the ray
+ * @param tnear if not null, receives the entry distance of every lane
+ * @return bit l set if the ray hits box l
+ * */
+template<typename T, int W>
+unsigned int intersect(const AABBPacket<T, W>& boxes, const Ray<T>& ray, T* tnear = nullptr) {
+    static_assert(W <= 32, "the hit mask holds up to 32 lanes");
+    T t0[W], t1[W];
+    for (int l = 0; l < W; ++l) {
+        t0[l] = ray.tmin;
+        t1[l] = ray.tmax;
+    }
+    for (int a = 0; a < 3; ++a) {
+        const T o = ray.origin.raw()[a];
+        const T inv = ray.inv_direction.raw()[a];
+        const T inv_far = inv * slab_far_scale<T>();
+        // the direction is the same for every lane, so is the choice of planes
+        const T* near_plane = inv < T(0) ? boxes.upper[a] : boxes.lower[a];
+        const T* far_plane = inv < T(0) ? boxes.lower[a] : boxes.upper[a];
+        for (int l = 0; l < W; ++l) {
+            T n = (near_plane[l] - o) * inv;
+            T f = (far_plane[l] - o) * inv_far;
+            t0[l] = n > t0[l] ? n : t0[l];
+            t1[l] = f < t1[l] ? f : t1[l];
+        }
+    }
+    unsigned int mask = 0;
+    for (int l = 0; l < W; ++l)
+        mask |= unsigned(t0[l] <= t1[l]) << l;
+    if (tnear != nullptr)
+        for (int l = 0; l < W; ++l)
+            tnear[l] = t0[l];
+    return mask;
+}
+
+/**
+ * Slab test of W rays against one box, without branches.
+ *
+ * @param box the box
+ * @param rays the rays
+ * @param tnear if not null, receives the entry distance of every lane
+ * @return bit l set if ray l hits the box
+ * */
+template<typename T, int W>
+unsigned int intersect(const AABB<T>& box, const RayPacket<T, W>& rays, T* tnear = nullptr) {
+    static_assert(W <= 32, "the hit mask holds up to 32 lanes");
+    T t0[W], t1[W];
+    for (int l = 0; l < W; ++l) {
+        t0[l] = rays.tmin[l];
+        t1[l] = rays.tmax[l];
+    }
+    for (int a = 0; a < 3; ++a) {
+        const T lo = box.lower.raw()[a], hi = box.upper.raw()[a];
+        for (int l = 0; l < W; ++l) {
+            const T inv = rays.inv_direction[a][l];
+            const bool neg = inv < T(0);
+            T n = ((neg ? hi : lo) - rays.origin[a][l]) * inv;
+            T f = ((neg ? lo : hi) - rays.origin[a][l]) * inv * slab_far_scale<T>();
+            t0[l] = n > t0[l] ? n : t0[l];
+            t1[l] = f < t1[l] ? f : t1[l];
+        }
+    }
+    unsigned int mask = 0;
+    for (int l = 0; l < W; ++l)
+        mask |= unsigned(t0[l] <= t1[l]) << l;
+    if (tnear != nullptr)
+        for (int l = 0; l < W; ++l)
+            tnear[l] = t0[l];
+    return mask;
+}
+
+};
+};
+
+#endif
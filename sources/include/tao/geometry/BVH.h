@@ -0,0 +1,1098 @@
+#ifndef _TAO_BVH_
+#define _TAO_BVH_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+#include "tao/geometry/Ray.h"
+#include "tao/geometry/AABB.h"
+#include "tao/linalg/Reductions.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * A node of a flattened BVH, 32 bytes in single precision.
+ *
+ * Nodes are stored in depth-first order: the first child of an
+ * interior node follows it, the second one is at offset. A leaf
+ * holds the primitives [offset, offset + count) of BVH::primitives().
+ * */
+template<typename T>
+struct alignas(32) BVHNode {
+    T lower[3];                 /** lower corner of the bounds */
+    std::uint32_t offset;       /** second child, or first primitive of a leaf */
+    T upper[3];                 /** upper corner of the bounds */
+    std::uint16_t count;        /** number of primitives, 0 for interior nodes */
+    std::uint16_t axis;         /** split axis of interior nodes */
+
+    /**
+     * Whether the node is a leaf.
+     *
+     * @return true if it holds primitives
+     * */
+    bool leaf() const { return count > 0; }
+};
+
+static_assert(sizeof(BVHNode<float>) == 32, "single precision BVH nodes must fit half a cache line");
+
+/**
+ * Parameters of the SAH builder.
+ * */
+struct BVHBuildOptions {
+    int bins = 16;                      /** SAH candidates per axis are bins - 1, at most 63 */
+    int max_leaf_size = 4;              /** leaves never hold more primitives, at most 65535 */
+    float traversal_cost = 1.0f;        /** cost of visiting a node */
+    float intersection_cost = 1.0f;     /** cost of testing a primitive */
+    int rebuild_depth = 4;              /** depth of the subtrees replaced by partial rebuilds */
+};
+
+/**
+ * When BVH::update rebuilds instead of only refitting. Ratios compare
+ * the SAH cost of the refitted tree, or subtree, to its cost when built.
+ * */
+struct BVHUpdatePolicy {
+    float rebuild_ratio = 1.5f;         /** whole-tree degradation that triggers a full rebuild */
+    float partial_ratio = 1.3f;         /** subtree degradation that triggers rebuilding the subtree */
+};
+
+/**
+ * What BVH::update did.
+ * */
+enum BVHUpdate {
+    Refitted = 0,           /** bounds were updated, the topology kept */
+    PartiallyRebuilt = 1,   /** the worst subtrees were rebuilt as well */
+    Rebuilt = 2             /** the whole tree was rebuilt */
+};
+
+/**
+ * Primitives [begin, end), by original index, whose bounds changed.
+ * */
+struct DirtyRange {
+    std::size_t begin;
+    std::size_t end;
+};
+
+/**
+ * Ranges with more primitives than this are binned in parallel.
+ * */
+constexpr std::size_t bvh_parallel_bin_threshold = std::size_t(1) << 15;
+
+/**
+ * Bounding volume hierarchy over primitives given by their bounds,
+ * built with the binned surface area heuristic.
+ *
+ * Construction splits the top of the tree breadth-first, binning big
+ * ranges in parallel and splitting all ranges of a level at once, until
+ * there are enough ranges to keep every thread busy; these subtrees are
+ * then built independently and spliced into a single depth-first array.
+ * Every split decision only depends on the primitives, so the tree is
+ * the same whatever the number of threads.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class BVH {
+
+    public:
+
+        /**
+         * Empty hierarchy.
+         * */
+        BVH() = default;
+
+        /**
+         * Builds the hierarchy.
+         *
+         * @param bounds the primitive bounds
+         * @param count the number of primitives
+         * @param options the builder parameters
+         * */
+        BVH(const AABB<T>* bounds, std::size_t count, BVHBuildOptions options = {}) : options {options} {
+            validate(options);
+            if (count > std::size_t(std::numeric_limits<std::uint32_t>::max()))
+                throw std::invalid_argument("too many primitives for 32-bit indices");
+            std::vector<PrimRef> refs (count);
+            parallel::parallel_for(0, count, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i)
+                    refs[i] = make_ref(bounds[i], static_cast<std::uint32_t>(i));
+            });
+            build(refs);
+        }
+
+        /**
+         * Builds the hierarchy.
+         *
+         * @param bounds the primitive bounds
+         * @param options the builder parameters
+         * */
+        explicit BVH(const std::vector<AABB<T>>& bounds, BVHBuildOptions options = {})
+            : BVH(bounds.data(), bounds.size(), options) {}
+
+        /**
+         * The nodes, the root first.
+         *
+         * @return the nodes in depth-first order
+         * */
+        const std::vector<BVHNode<T>>& nodes() const { return node_array; }
+
+        /**
+         * The primitive indices referenced by the leaves.
+         *
+         * @return original indices, in leaf order
+         * */
+        const std::vector<std::uint32_t>& primitives() const { return primitive_array; }
+
+        /**
+         * Number of levels.
+         *
+         * @return the depth of the deepest leaf plus one, 0 if empty
+         * */
+        int depth() const { return max_depth; }
+
+        /**
+         * Whether there is nothing to traverse.
+         *
+         * @return true if built over no primitives
+         * */
+        bool empty() const { return node_array.empty(); }
+
+        /**
+         * Bounds of all primitives.
+         *
+         * @return the bounds of the root
+         * */
+        AABB<T> bounds() const {
+            AABB<T> box;
+            if (!empty()) {
+                for (int a = 0; a < 3; ++a) {
+                    box.lower.raw()[a] = node_array[0].lower[a];
+                    box.upper.raw()[a] = node_array[0].upper[a];
+                }
+            }
+            return box;
+        }
+
+        /**
+         * Finds the nearest primitive hit by a ray. Children are visited
+         * near first, and subtrees farther than the best hit are skipped.
+         *
+         * @param ray the ray
+         * @param intersect_primitive called as f(index, ray, t), it returns
+         * whether primitive index is hit at a distance t within [ray.tmin, ray.tmax]
+         * @param primitive receives the index of the nearest primitive
+         * @param t receives its distance
+         * @return whether something was hit
+         * */
+        template<typename F>
+        bool closest_hit(const Ray<T>& ray, F&& intersect_primitive, std::uint32_t& primitive, T& t) const {
+            Ray<T> r = ray;
+            bool hit = false;
+            traverse(r, [&](std::uint32_t p) {
+                T tp = r.tmax;
+                if (intersect_primitive(p, static_cast<const Ray<T>&>(r), tp)) {
+                    hit = true;
+                    primitive = p;
+                    t = tp;
+                    r.tmax = tp;
+                }
+                return false;
+            });
+            return hit;
+        }
+
+        /**
+         * Whether a ray hits any primitive, stopping at the first hit;
+         * meant for shadow rays.
+         *
+         * @param ray the ray
+         * @param intersect_primitive as in closest_hit
+         * @return whether something was hit
+         * */
+        template<typename F>
+        bool any_hit(const Ray<T>& ray, F&& intersect_primitive) const {
+            Ray<T> r = ray;
+            return traverse(r, [&](std::uint32_t p) {
+                T tp = r.tmax;
+                return intersect_primitive(p, static_cast<const Ray<T>&>(r), tp);
+            });
+        }
+
+        /**
+         * Recomputes every node bound from new primitive bounds, keeping
+         * the topology. Levels are processed bottom-up, the nodes of a
+         * level in parallel.
+         *
+         * @param bounds the primitive bounds, as many as when built
+         * */
+        void refit(const AABB<T>* bounds) {
+            ensure_topology();
+            for (std::size_t d = levels.size(); d-- > 0;)
+                refit_level(levels[d], bounds);
+        }
+
+        /**
+         * Recomputes the bounds of the leaves holding dirty primitives
+         * and of their ancestors only.
+         *
+         * @param bounds the primitive bounds, as many as when built
+         * @param dirty ranges of primitives whose bounds changed
+         * */
+        void refit(const AABB<T>* bounds, const std::vector<DirtyRange>& dirty) {
+            ensure_topology();
+            std::vector<std::vector<std::uint32_t>> marked (levels.size());
+            std::vector<char> flag (node_array.size(), 0);
+            for (const DirtyRange& range : dirty) {
+                if (range.begin > range.end || range.end > primitive_array.size())
+                    throw std::invalid_argument("dirty range [" + std::to_string(range.begin) + ", "
+                            + std::to_string(range.end) + ") out of " + std::to_string(primitive_array.size())
+                            + " primitives");
+                for (std::size_t p = range.begin; p < range.end; ++p) {
+                    // walk up until an ancestor is already marked
+                    for (std::uint32_t node = leaf_of[p]; !flag[node]; node = parent_array[node]) {
+                        flag[node] = 1;
+                        marked[depth_array[node]].push_back(node);
+                        if (node == 0)
+                            break;
+                    }
+                }
+            }
+            for (std::size_t d = marked.size(); d-- > 0;)
+                refit_level(marked[d], bounds);
+        }
+
+        /**
+         * Surface area heuristic cost of the tree: the expected cost of
+         * tracing a random ray that hits the root.
+         *
+         * @return the SAH cost, 0 if empty
+         * */
+        T sah_cost() const {
+            return empty() ? T(0) : subtree_cost(0);
+        }
+
+        /**
+         * Degradation of the tree since it was last fully built.
+         *
+         * @return the current SAH cost over the cost right after the build
+         * */
+        T quality_ratio() const {
+            return reference_cost > T(0) ? sah_cost() / reference_cost : T(1);
+        }
+
+        /**
+         * Updates the tree for new primitive bounds: refits the dirty
+         * primitives, then rebuilds the whole tree if its SAH cost grew
+         * past policy.rebuild_ratio, or else the subtrees at
+         * options.rebuild_depth whose cost grew past policy.partial_ratio.
+         *
+         * @param bounds the primitive bounds, as many as when built
+         * @param dirty ranges of primitives whose bounds changed
+         * @param policy the rebuild thresholds
+         * @return what was done
+         * */
+        BVHUpdate update(const AABB<T>* bounds, const std::vector<DirtyRange>& dirty, BVHUpdatePolicy policy = {}) {
+            refit(bounds, dirty);
+            return rebuild_if_degraded(bounds, policy);
+        }
+
+        /**
+         * Updates the tree for new bounds of every primitive.
+         *
+         * @param bounds the primitive bounds, as many as when built
+         * @param policy the rebuild thresholds
+         * @return what was done
+         * */
+        BVHUpdate update(const AABB<T>* bounds, BVHUpdatePolicy policy = {}) {
+            refit(bounds);
+            return rebuild_if_degraded(bounds, policy);
+        }
+
+    protected:
+
+        /**
+         * Compact bounds used while building.
+         * */
+        struct Box {
+            T lower[3] = {std::numeric_limits<T>::infinity(), std::numeric_limits<T>::infinity(),
+                std::numeric_limits<T>::infinity()};
+            T upper[3] = {-std::numeric_limits<T>::infinity(), -std::numeric_limits<T>::infinity(),
+                -std::numeric_limits<T>::infinity()};
+
+            void expand(const T* lo, const T* hi) {
+                for (int a = 0; a < 3; ++a) {
+                    lower[a] = lo[a] < lower[a] ? lo[a] : lower[a];
+                    upper[a] = hi[a] > upper[a] ? hi[a] : upper[a];
+                }
+            }
+
+            void expand(const Box& b) { expand(b.lower, b.upper); }
+
+            T area() const {
+                T e[3];
+                for (int a = 0; a < 3; ++a)
+                    e[a] = upper[a] > lower[a] ? upper[a] - lower[a] : T(0);
+                return T(2) * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+            }
+        };
+
+        /**
+         * A primitive being sorted into the tree.
+         * */
+        struct PrimRef {
+            T lower[3];
+            std::uint32_t index;
+            T upper[3];
+
+            T centroid(int a) const { return (lower[a] + upper[a]) * T(0.5); }
+        };
+
+        /**
+         * Primitives [begin, end) of the reference array, with their bounds.
+         * */
+        struct Range {
+            std::size_t begin, end;
+            Box bounds;         /** bounds of the primitives */
+            Box centroids;      /** bounds of their centroids */
+            int depth;
+        };
+
+        static constexpr int max_bins = 64;
+
+        struct Bin {
+            Box bounds;
+            Box centroids;
+            std::size_t count = 0;
+        };
+
+        /**
+         * Bins along the three axes; only the first bin_count() of
+         * each axis are used, and reset, so that small ranges stay cheap.
+         * */
+        struct BinSet {
+            Bin bins[3][max_bins];
+            BinSet() {}
+        };
+
+        /**
+         * How a range is divided: primitives whose bin along axis
+         * is at most bin go left. Axis -1 means an object median.
+         * */
+        struct Split {
+            int axis = -1;
+            int bin = 0;
+            Range left, right;
+        };
+
+        /**
+         * A range whose subtree is built by a single thread.
+         * */
+        struct Task {
+            Range range;
+            std::vector<BVHNode<T>> nodes;
+            std::size_t base = 0;
+            int depth = 0;
+        };
+
+        /**
+         * An interior node of the top of the tree; children refer to
+         * other top nodes when non-negative, to task ~child otherwise.
+         * */
+        struct TopNode {
+            Box bounds;
+            int axis;
+            long child[2];
+            std::size_t position = 0, second = 0;
+        };
+
+        BVHBuildOptions options;
+        std::vector<BVHNode<T>> node_array;
+        std::vector<std::uint32_t> primitive_array;
+        int max_depth = 0;
+
+        T reference_cost = T(0);                    /** SAH cost after the last full build */
+        std::vector<std::uint32_t> rebuild_roots;   /** roots of the subtrees partial rebuilds replace */
+        std::vector<T> rebuild_reference;           /** their SAH costs when built */
+
+        // derived on the first refit after a build
+        bool topology_ready = false;
+        std::vector<std::uint32_t> parent_array;
+        std::vector<std::uint32_t> depth_array;
+        std::vector<std::uint32_t> leaf_of;         /** leaf of every primitive, by original index */
+        std::vector<std::vector<std::uint32_t>> levels;
+
+        static PrimRef make_ref(const AABB<T>& bounds, std::uint32_t index) {
+            PrimRef ref;
+            for (int a = 0; a < 3; ++a) {
+                ref.lower[a] = bounds.lower.raw()[a];
+                ref.upper[a] = bounds.upper.raw()[a];
+            }
+            ref.index = index;
+            return ref;
+        }
+
+        static T node_area(const BVHNode<T>& node) {
+            T e[3];
+            for (int a = 0; a < 3; ++a)
+                e[a] = node.upper[a] > node.lower[a] ? node.upper[a] - node.lower[a] : T(0);
+            return T(2) * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+        }
+
+        /**
+         * One past the last node of the subtree rooted at a node,
+         * following the second children down to a leaf.
+         * */
+        std::size_t subtree_end(std::uint32_t root) const {
+            while (!node_array[root].leaf())
+                root = node_array[root].offset;
+            return std::size_t(root) + 1;
+        }
+
+        /**
+         * SAH cost of the subtree rooted at a node, relative to its area.
+         * */
+        T subtree_cost(std::uint32_t root) const {
+            const std::size_t end = subtree_end(root);
+            const BVHNode<T>* nodes = node_array.data();
+            const T ct = T(options.traversal_cost), ci = T(options.intersection_cost);
+            T cost = kernels::accumulate<T>(end - root, [nodes, root, ct, ci](std::size_t k) {
+                const BVHNode<T>& node = nodes[root + k];
+                return node_area(node) * (node.leaf() ? ci * T(node.count) : ct);
+            }, Pairwise);
+            T area = node_area(nodes[root]);
+            return area > T(0) ? cost / area : cost;
+        }
+
+        /**
+         * Records the costs later updates are compared with.
+         * */
+        void capture_reference() {
+            reference_cost = sah_cost();
+            rebuild_roots.clear();
+            if (empty())
+                return;
+            std::vector<std::pair<std::uint32_t, int>> stack {{0u, 0}};
+            while (!stack.empty()) {
+                auto [node, d] = stack.back();
+                stack.pop_back();
+                if (node_array[node].leaf() || d == options.rebuild_depth) {
+                    rebuild_roots.push_back(node);
+                    continue;
+                }
+                stack.push_back({node_array[node].offset, d + 1});
+                stack.push_back({node + 1, d + 1});
+            }
+            rebuild_reference.resize(rebuild_roots.size());
+            for (std::size_t k = 0; k < rebuild_roots.size(); ++k)
+                rebuild_reference[k] = subtree_cost(rebuild_roots[k]);
+        }
+
+        /**
+         * Derives parents, depths, levels and primitive leaves from the nodes.
+         * */
+        void ensure_topology() {
+            if (topology_ready)
+                return;
+            const std::size_t n = node_array.size();
+            parent_array.assign(n, 0);
+            depth_array.assign(n, 0);
+            std::uint32_t deepest = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const BVHNode<T>& node = node_array[i];
+                if (node.leaf()) {
+                    deepest = std::max(deepest, depth_array[i]);
+                    continue;
+                }
+                for (std::uint32_t c : {std::uint32_t(i + 1), node.offset}) {
+                    parent_array[c] = static_cast<std::uint32_t>(i);
+                    depth_array[c] = depth_array[i] + 1;
+                }
+            }
+            levels.assign(n > 0 ? deepest + 1 : 0, {});
+            leaf_of.assign(primitive_array.size(), 0);
+            for (std::size_t i = 0; i < n; ++i) {
+                levels[depth_array[i]].push_back(static_cast<std::uint32_t>(i));
+                const BVHNode<T>& node = node_array[i];
+                if (node.leaf())
+                    for (std::uint32_t p = node.offset; p < node.offset + node.count; ++p)
+                        leaf_of[primitive_array[p]] = static_cast<std::uint32_t>(i);
+            }
+            topology_ready = true;
+        }
+
+        /**
+         * Recomputes the bounds of nodes whose children are up to date.
+         * */
+        void refit_level(const std::vector<std::uint32_t>& level, const AABB<T>* bounds) {
+            BVHNode<T>* nodes = node_array.data();
+            const std::uint32_t* prims = primitive_array.data();
+            parallel::parallel_for(0, level.size(), 1 << 12, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t k = lo; k < hi; ++k) {
+                    BVHNode<T>& node = nodes[level[k]];
+                    Box box;
+                    if (node.leaf()) {
+                        for (std::uint32_t p = node.offset; p < node.offset + node.count; ++p)
+                            box.expand(bounds[prims[p]].lower.raw(), bounds[prims[p]].upper.raw());
+                    } else {
+                        const BVHNode<T>& first = nodes[level[k] + 1];
+                        const BVHNode<T>& second = nodes[node.offset];
+                        box.expand(first.lower, first.upper);
+                        box.expand(second.lower, second.upper);
+                    }
+                    for (int a = 0; a < 3; ++a) {
+                        node.lower[a] = box.lower[a];
+                        node.upper[a] = box.upper[a];
+                    }
+                }
+            });
+        }
+
+        BVHUpdate rebuild_if_degraded(const AABB<T>* bounds, const BVHUpdatePolicy& policy) {
+            if (empty())
+                return Refitted;
+            if (sah_cost() > T(policy.rebuild_ratio) * reference_cost) {
+                std::vector<PrimRef> refs (primitive_array.size());
+                parallel::parallel_for(0, refs.size(), 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t i = lo; i < hi; ++i)
+                        refs[i] = make_ref(bounds[i], static_cast<std::uint32_t>(i));
+                });
+                build(refs);
+                return Rebuilt;
+            }
+            std::vector<std::size_t> degraded;
+            for (std::size_t k = 0; k < rebuild_roots.size(); ++k)
+                if (!node_array[rebuild_roots[k]].leaf()
+                        && subtree_cost(rebuild_roots[k]) > T(policy.partial_ratio) * rebuild_reference[k])
+                    degraded.push_back(k);
+            if (degraded.empty())
+                return Refitted;
+            rebuild_subtrees(bounds, degraded);
+            return PartiallyRebuilt;
+        }
+
+        /**
+         * Rebuilds some of the rebuild_roots subtrees over their own
+         * primitives, then splices them back, shifting the nodes after
+         * every subtree that changed size.
+         * */
+        void rebuild_subtrees(const AABB<T>* bounds, const std::vector<std::size_t>& which) {
+            struct Piece {
+                std::uint32_t root;
+                std::size_t end;
+                std::vector<BVHNode<T>> nodes;
+                long shift;         /** size change of this and all previous pieces */
+            };
+            std::vector<Piece> pieces;
+            for (std::size_t k : which) {
+                Piece piece {rebuild_roots[k], subtree_end(rebuild_roots[k]), {}, 0};
+                std::uint32_t first = piece.root, last = piece.root;
+                while (!node_array[first].leaf())
+                    ++first;
+                while (!node_array[last].leaf())
+                    last = node_array[last].offset;
+                const std::size_t begin = node_array[first].offset;
+                const std::size_t end = node_array[last].offset + node_array[last].count;
+                std::vector<PrimRef> refs (end - begin);
+                for (std::size_t i = 0; i < refs.size(); ++i)
+                    refs[i] = make_ref(bounds[primitive_array[begin + i]], primitive_array[begin + i]);
+                int depth;
+                build_nodes(refs, piece.nodes, depth);
+                for (auto& node : piece.nodes)
+                    if (node.leaf())
+                        node.offset += static_cast<std::uint32_t>(begin);
+                for (std::size_t i = 0; i < refs.size(); ++i)
+                    primitive_array[begin + i] = refs[i].index;
+                long previous = pieces.empty() ? 0 : pieces.back().shift;
+                piece.shift = previous + long(piece.nodes.size()) - long(piece.end - piece.root);
+                pieces.push_back(std::move(piece));
+            }
+
+            // new position of an old node outside the rebuilt subtrees
+            auto moved = [&pieces](std::size_t old) {
+                long shift = 0;
+                for (const Piece& piece : pieces) {
+                    if (piece.end > old)
+                        break;
+                    shift = piece.shift;
+                }
+                return std::size_t(long(old) + shift);
+            };
+            std::vector<BVHNode<T>> nodes (std::size_t(long(node_array.size()) + pieces.back().shift));
+            std::size_t old = 0;
+            for (std::size_t k = 0; k <= pieces.size(); ++k) {
+                const std::size_t stop = k < pieces.size() ? pieces[k].root : node_array.size();
+                for (; old < stop; ++old) {
+                    BVHNode<T> node = node_array[old];
+                    if (!node.leaf())
+                        node.offset = static_cast<std::uint32_t>(moved(node.offset));
+                    nodes[moved(old)] = node;
+                }
+                if (k == pieces.size())
+                    break;
+                const std::size_t base = moved(pieces[k].root);
+                for (std::size_t i = 0; i < pieces[k].nodes.size(); ++i) {
+                    BVHNode<T> node = pieces[k].nodes[i];
+                    if (!node.leaf())
+                        node.offset += static_cast<std::uint32_t>(base);
+                    nodes[base + i] = node;
+                }
+                old = pieces[k].end;
+            }
+            node_array.swap(nodes);
+
+            // rebuild roots keep their order; refresh the rebuilt references
+            for (std::size_t k = 0; k < rebuild_roots.size(); ++k)
+                rebuild_roots[k] = static_cast<std::uint32_t>(moved(rebuild_roots[k]));
+            for (std::size_t k : which)
+                rebuild_reference[k] = subtree_cost(rebuild_roots[k]);
+            topology_ready = false;
+            ensure_topology();
+            max_depth = static_cast<int>(levels.size());
+        }
+
+        static void validate(const BVHBuildOptions& options) {
+            if (options.bins < 2 || options.bins > max_bins)
+                throw std::invalid_argument("BVH bins must be in [2, " + std::to_string(max_bins) + "]");
+            if (options.max_leaf_size < 1 || options.max_leaf_size > 65535)
+                throw std::invalid_argument("BVH leaf size must be in [1, 65535]");
+        }
+
+        /**
+         * Bounds and centroid bounds of a range, in parallel when big.
+         * */
+        static void measure(const PrimRef* refs, Range& range) {
+            auto serial = [refs](std::size_t lo, std::size_t hi, Box& bounds, Box& centroids) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    T c[3] = {refs[i].centroid(0), refs[i].centroid(1), refs[i].centroid(2)};
+                    bounds.expand(refs[i].lower, refs[i].upper);
+                    centroids.expand(c, c);
+                }
+            };
+            std::size_t n = range.end - range.begin;
+            std::size_t tasks = std::min<std::size_t>(parallel::concurrency(), n / bvh_parallel_bin_threshold);
+            range.bounds = Box {};
+            range.centroids = Box {};
+            if (tasks <= 1) {
+                serial(range.begin, range.end, range.bounds, range.centroids);
+                return;
+            }
+            std::vector<Box> bounds (tasks), centroids (tasks);
+            parallel::parallel_for(0, tasks, 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t t = lo; t < hi; ++t)
+                    serial(range.begin + n * t / tasks, range.begin + n * (t + 1) / tasks, bounds[t], centroids[t]);
+            });
+            for (std::size_t t = 0; t < tasks; ++t) {
+                range.bounds.expand(bounds[t]);
+                range.centroids.expand(centroids[t]);
+            }
+        }
+
+        /**
+         * Number of bins of a range: small ranges use fewer bins,
+         * as they cannot fill more than one per primitive.
+         * */
+        int bin_count(const Range& range) const {
+            return static_cast<int>(std::min<std::size_t>(options.bins, std::max<std::size_t>(range.end - range.begin, 2)));
+        }
+
+        /**
+         * Bin of a centroid coordinate along an axis.
+         * */
+        static int bin_of(T c, T lower, T scale, int bins) {
+            int k = static_cast<int>((c - lower) * scale);
+            return std::min(std::max(k, 0), bins - 1);
+        }
+
+        /**
+         * Scale mapping centroid coordinates to bins along every axis,
+         * 0 along axes where all centroids coincide.
+         * */
+        void bin_scales(const Range& range, T* scale) const {
+            const int bins = bin_count(range);
+            for (int a = 0; a < 3; ++a) {
+                T extent = range.centroids.upper[a] - range.centroids.lower[a];
+                scale[a] = extent > T(0) ? T(bins) * (T(1) - std::numeric_limits<T>::epsilon()) / extent : T(0);
+            }
+        }
+
+        void bin_serial(const PrimRef* refs, std::size_t lo, std::size_t hi, const Range& range,
+                const T* scale, BinSet& set) const {
+            const int bins = bin_count(range);
+            for (std::size_t i = lo; i < hi; ++i) {
+                T c[3] = {refs[i].centroid(0), refs[i].centroid(1), refs[i].centroid(2)};
+                for (int a = 0; a < 3; ++a) {
+                    Bin& bin = set.bins[a][bin_of(c[a], range.centroids.lower[a], scale[a], bins)];
+                    bin.bounds.expand(refs[i].lower, refs[i].upper);
+                    bin.centroids.expand(c, c);
+                    ++bin.count;
+                }
+            }
+        }
+
+        /**
+         * Finds the cheapest SAH split of a range, or decides it is a leaf.
+         *
+         * @param refs the primitives
+         * @param range the range
+         * @param split receives the split
+         * @param scratch bins reused across calls
+         * @return false if the range must become a leaf
+         * */
+        bool find_split(const PrimRef* refs, const Range& range, Split& split, BinSet& scratch) const {
+            const std::size_t n = range.end - range.begin;
+            if (n <= 1)
+                return false;
+            T scale[3];
+            bin_scales(range, scale);
+            const int bins = bin_count(range);
+            BinSet* set = &scratch;
+            for (int a = 0; a < 3; ++a)
+                for (int k = 0; k < bins; ++k)
+                    set->bins[a][k] = Bin {};
+            std::size_t tasks = std::min<std::size_t>(parallel::concurrency(), n / bvh_parallel_bin_threshold);
+            if (tasks <= 1) {
+                bin_serial(refs, range.begin, range.end, range, scale, *set);
+            } else {
+                std::vector<BinSet> partial (tasks);
+                for (auto& p : partial)
+                    for (int a = 0; a < 3; ++a)
+                        for (int k = 0; k < bins; ++k)
+                            p.bins[a][k] = Bin {};
+                parallel::parallel_for(0, tasks, 1, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t t = lo; t < hi; ++t)
+                        bin_serial(refs, range.begin + n * t / tasks, range.begin + n * (t + 1) / tasks,
+                                range, scale, partial[t]);
+                });
+                for (std::size_t t = 0; t < tasks; ++t) {
+                    for (int a = 0; a < 3; ++a) {
+                        for (int k = 0; k < bins; ++k) {
+                            Bin& bin = set->bins[a][k];
+                            bin.bounds.expand(partial[t].bins[a][k].bounds);
+                            bin.centroids.expand(partial[t].bins[a][k].centroids);
+                            bin.count += partial[t].bins[a][k].count;
+                        }
+                    }
+                }
+            }
+
+            // sweep the bins from the right, then from the left
+            const T parent_area = range.bounds.area();
+            T best_cost = std::numeric_limits<T>::infinity();
+            for (int a = 0; a < 3; ++a) {
+                if (scale[a] == T(0))
+                    continue;
+                T right_cost[max_bins];
+                Box acc;
+                std::size_t count = 0;
+                for (int k = bins - 1; k > 0; --k) {
+                    acc.expand(set->bins[a][k].bounds);
+                    count += set->bins[a][k].count;
+                    right_cost[k - 1] = count > 0 ? acc.area() * T(count) : std::numeric_limits<T>::infinity();
+                }
+                acc = Box {};
+                count = 0;
+                for (int k = 0; k < bins - 1; ++k) {
+                    acc.expand(set->bins[a][k].bounds);
+                    count += set->bins[a][k].count;
+                    if (count == 0 || count == n)
+                        continue;
+                    T cost = acc.area() * T(count) + right_cost[k];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        split.axis = a;
+                        split.bin = k;
+                    }
+                }
+            }
+
+            const T leaf_cost = T(options.intersection_cost) * T(n);
+            best_cost = T(options.traversal_cost) + T(options.intersection_cost) * best_cost
+                / (parent_area > T(0) ? parent_area : T(1));
+            if (split.axis < 0) {
+                // all centroids coincide: an object median keeps leaves small
+                if (n <= std::size_t(options.max_leaf_size))
+                    return false;
+                split.axis = -1;
+            } else if (n <= std::size_t(options.max_leaf_size) && leaf_cost <= best_cost) {
+                return false;
+            }
+
+            split.left = Range {range.begin, range.begin, Box {}, Box {}, range.depth + 1};
+            split.right = Range {range.begin, range.end, Box {}, Box {}, range.depth + 1};
+            if (split.axis >= 0) {
+                for (int k = 0; k < bins; ++k) {
+                    const Bin& bin = set->bins[split.axis][k];
+                    Range& side = k <= split.bin ? split.left : split.right;
+                    side.bounds.expand(bin.bounds);
+                    side.centroids.expand(bin.centroids);
+                    if (k <= split.bin)
+                        split.left.end += bin.count;
+                }
+            } else {
+                split.left.end = range.begin + n / 2;
+            }
+            split.right.begin = split.left.end;
+            return true;
+        }
+
+        /**
+         * Moves the primitives of a range to their side of a split.
+         * */
+        void partition(PrimRef* refs, const Range& range, Split& split) const {
+            if (split.axis < 0) {
+                measure(refs, split.left);
+                measure(refs, split.right);
+                return;
+            }
+            T scale[3];
+            bin_scales(range, scale);
+            const int a = split.axis, bins = bin_count(range);
+            const T lower = range.centroids.lower[a];
+            std::partition(refs + range.begin, refs + range.end, [&](const PrimRef& ref) {
+                return bin_of(ref.centroid(a), lower, scale[a], bins) <= split.bin;
+            });
+        }
+
+        /**
+         * Writes the node of a range.
+         * */
+        static BVHNode<T> make_node(const Box& bounds, std::uint32_t offset, std::uint16_t count, int axis) {
+            BVHNode<T> node;
+            for (int a = 0; a < 3; ++a) {
+                node.lower[a] = bounds.lower[a];
+                node.upper[a] = bounds.upper[a];
+            }
+            node.offset = offset;
+            node.count = count;
+            node.axis = static_cast<std::uint16_t>(axis < 0 ? 0 : axis);
+            return node;
+        }
+
+        /**
+         * Builds the subtree of a task, depth-first, with an explicit stack.
+         * Second-child offsets are relative to the first node of the task.
+         * */
+        void build_task(PrimRef* refs, Task& task) const {
+            struct Item {
+                Range range;
+                std::size_t parent;     /** node whose second child this is, or -1 */
+            };
+            std::vector<Item> stack {Item {task.range, std::size_t(-1)}};
+            std::unique_ptr<BinSet> scratch {new BinSet()};
+            while (!stack.empty()) {
+                Item item = stack.back();
+                stack.pop_back();
+                std::size_t index = task.nodes.size();
+                if (item.parent != std::size_t(-1))
+                    task.nodes[item.parent].offset = static_cast<std::uint32_t>(index);
+                task.depth = std::max(task.depth, item.range.depth + 1);
+                Split split;
+                if (!find_split(refs, item.range, split, *scratch)) {
+                    task.nodes.push_back(make_node(item.range.bounds, static_cast<std::uint32_t>(item.range.begin),
+                                static_cast<std::uint16_t>(item.range.end - item.range.begin), 0));
+                    continue;
+                }
+                partition(refs, item.range, split);
+                task.nodes.push_back(make_node(item.range.bounds, 0, 0, split.axis));
+                stack.push_back(Item {split.right, index});
+                stack.push_back(Item {split.left, std::size_t(-1)});
+            }
+        }
+
+        /**
+         * Places the top nodes and task subtrees in depth-first order.
+         *
+         * @return the position of the subtree
+         * */
+        std::size_t place(std::vector<TopNode>& top, std::vector<Task>& tasks, long child, std::size_t& cursor) const {
+            if (child < 0) {
+                Task& task = tasks[~child];
+                task.base = cursor;
+                cursor += task.nodes.size();
+                return task.base;
+            }
+            TopNode& node = top[child];
+            node.position = cursor++;
+            place(top, tasks, node.child[0], cursor);
+            top[child].second = place(top, tasks, top[child].child[1], cursor);
+            return top[child].position;
+        }
+
+        /**
+         * Builds the nodes over refs, which are reordered; leaves refer to
+         * positions in refs.
+         *
+         * @param refs the primitives
+         * @param nodes receives the nodes in depth-first order
+         * @param depth receives the number of levels
+         * */
+        void build_nodes(std::vector<PrimRef>& refs, std::vector<BVHNode<T>>& nodes, int& depth) const {
+            const std::size_t n = refs.size();
+            nodes.clear();
+            depth = 0;
+            if (n == 0)
+                return;
+
+            Range root {0, n, Box {}, Box {}, 0};
+            measure(refs.data(), root);
+            // tasks never become single leaves of the top of the tree
+            const std::size_t task_size = std::max<std::size_t>({4096, std::size_t(options.max_leaf_size),
+                    n / (std::size_t(8) * parallel::concurrency())});
+
+            // split the top of the tree one level at a time
+            std::vector<TopNode> top;
+            std::vector<Task> tasks;
+            std::vector<Range> level;
+            auto enqueue = [&](const Range& range, long* slot) {
+                if (range.end - range.begin <= task_size) {
+                    *slot = ~long(tasks.size());
+                    tasks.push_back(Task {range, {}, 0, 0});
+                } else {
+                    *slot = long(level.size());
+                    level.push_back(range);
+                }
+            };
+            long root_ref;
+            enqueue(root, &root_ref);
+            while (!level.empty()) {
+                std::vector<Split> splits (level.size());
+                std::vector<char> split_found (level.size());
+                parallel::parallel_for(0, level.size(), 1, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t r = lo; r < hi; ++r) {
+                        std::unique_ptr<BinSet> scratch {new BinSet()};
+                        split_found[r] = find_split(refs.data(), level[r], splits[r], *scratch);
+                        if (split_found[r])
+                            partition(refs.data(), level[r], splits[r]);
+                    }
+                });
+                std::vector<Range> current;
+                current.swap(level);
+                std::size_t first = top.size();
+                for (std::size_t r = 0; r < current.size(); ++r)
+                    top.push_back(TopNode {current[r].bounds, splits[r].axis, {0, 0}});
+                // ranges bigger than a task always have a split, leaves being smaller
+                for (std::size_t r = 0; r < current.size(); ++r) {
+                    long left_slot, right_slot;
+                    enqueue(splits[r].left, &left_slot);
+                    enqueue(splits[r].right, &right_slot);
+                    top[first + r].child[0] = left_slot >= 0 ? long(first + current.size()) + left_slot : left_slot;
+                    top[first + r].child[1] = right_slot >= 0 ? long(first + current.size()) + right_slot : right_slot;
+                }
+            }
+            if (root_ref >= 0)
+                root_ref = 0;
+
+            parallel::parallel_for(0, tasks.size(), 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t t = lo; t < hi; ++t)
+                    build_task(refs.data(), tasks[t]);
+            });
+
+            std::size_t cursor = 0;
+            place(top, tasks, root_ref, cursor);
+            nodes.resize(cursor);
+            for (const TopNode& node : top)
+                nodes[node.position] = make_node(node.bounds, static_cast<std::uint32_t>(node.second), 0, node.axis);
+            parallel::parallel_for(0, tasks.size(), 1, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t t = lo; t < hi; ++t) {
+                    const Task& task = tasks[t];
+                    for (std::size_t i = 0; i < task.nodes.size(); ++i) {
+                        BVHNode<T> node = task.nodes[i];
+                        if (!node.leaf())
+                            node.offset += static_cast<std::uint32_t>(task.base);
+                        nodes[task.base + i] = node;
+                    }
+                }
+            });
+            for (const Task& task : tasks)
+                depth = std::max(depth, task.depth);
+        }
+
+        void build(std::vector<PrimRef>& refs) {
+            build_nodes(refs, node_array, max_depth);
+            primitive_array.resize(refs.size());
+            parallel::parallel_for(0, refs.size(), 1 << 16, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i)
+                    primitive_array[i] = refs[i].index;
+            });
+            topology_ready = false;
+            capture_reference();
+        }
+
+        /**
+         * Visits the leaves hit by a ray, near children first, with a
+         * stack as deep as the tree. visit(primitive) returning true
+         * stops the traversal; it may shorten ray.tmax.
+         *
+         * @return whether the traversal was stopped
+         * */
+        template<typename Visit>
+        bool traverse(Ray<T>& ray, Visit&& visit) const {
+            if (node_array.empty())
+                return false;
+            const T* o = ray.origin.raw();
+            const T* inv = ray.inv_direction.raw();
+            const BVHNode<T>* nodes = node_array.data();
+            T t0, t1;
+            if (!slab_test(nodes[0].lower, nodes[0].upper, o, inv, ray.tmin, ray.tmax, t0, t1))
+                return false;
+
+            struct Entry {
+                std::uint32_t node;
+                T tnear;
+            };
+            constexpr int short_stack = 64;
+            Entry local[short_stack];
+            std::vector<Entry> spill;
+            Entry* stack = local;
+            if (max_depth > short_stack) {
+                spill.resize(max_depth);
+                stack = spill.data();
+            }
+            int top = 0;
+            std::uint32_t current = 0;
+            while (true) {
+                const BVHNode<T>& node = nodes[current];
+                if (node.leaf()) {
+                    for (std::uint32_t p = node.offset; p < node.offset + node.count; ++p)
+                        if (visit(primitive_array[p]))
+                            return true;
+                } else {
+                    std::uint32_t near = current + 1, far = node.offset;
+                    T dn, df, exit;
+                    bool hn = slab_test(nodes[near].lower, nodes[near].upper, o, inv, ray.tmin, ray.tmax, dn, exit);
+                    bool hf = slab_test(nodes[far].lower, nodes[far].upper, o, inv, ray.tmin, ray.tmax, df, exit);
+                    if (hn && hf) {
+                        if (df < dn) {
+                            std::swap(near, far);
+                            std::swap(dn, df);
+                        }
+                        stack[top++] = Entry {far, df};
+                        current = near;
+                        continue;
+                    }
+                    if (hn || hf) {
+                        current = hn ? near : far;
+                        continue;
+                    }
+                }
+                // resume with the nearest pending subtree still in reach
+                do {
+                    if (top == 0)
+                        return false;
+                    --top;
+                } while (stack[top].tnear > ray.tmax);
+                current = stack[top].node;
+            }
+        }
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef _TAO_CAMERA_
+#define _TAO_CAMERA_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "tao/core.h"
+#include "tao/geometry/Ray.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * How camera rays leave the image plane.
+ * */
+enum Projection {
+    Perspective,        /** from a single eye point */
+    Orthographic        /** parallel, from every point of the plane */
+};
+
+/**
+ * A rectangle of pixels [x0, x1) x [y0, y1).
+ * */
+struct Tile {
+    int x0, y0, x1, y1;
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+    std::size_t size() const { return std::size_t(width()) * std::size_t(height()); }
+};
+
+/**
+ * Rays in structure-of-arrays layout, for a whole tile at once.
+ * Reusing a buffer across tiles only allocates when it grows.
+ * */
+template<typename T>
+struct RayBuffer {
+
+    std::vector<T> origin[3];       /** origins, per axis */
+    std::vector<T> direction[3];    /** unit directions, per axis */
+
+    /**
+     * Number of rays.
+     *
+     * @return the ray count
+     * */
+    std::size_t size() const { return origin[0].size(); }
+
+    /**
+     * Sets the number of rays.
+     *
+     * @param n the ray count
+     * */
+    void resize(std::size_t n) {
+        for (int a = 0; a < 3; ++a) {
+            origin[a].resize(n);
+            direction[a].resize(n);
+        }
+    }
+
+    /**
+     * A ray of the buffer.
+     *
+     * @param i its position
+     * @return the ray, with its inverse direction computed
+     * */
+    Ray<T> ray(std::size_t i) const {
+        return Ray<T> {Vec3<T> {origin[0][i], origin[1][i], origin[2][i]},
+            Vec3<T> {direction[0][i], direction[1][i], direction[2][i]}};
+    }
+};
+
+/**
+ * A pinhole or orthographic camera over a raster of pixels.
+ *
+ * Camera space is right-handed: the camera looks down -z, with x to
+ * the right and y up. Raster space has its origin at the top-left
+ * corner, y growing downwards, and pixel (x, y) covers [x, x + 1) x
+ * [y, y + 1). Since raster to camera to world is affine, it is folded
+ * on construction into an origin and two per-pixel steps in world
+ * space, so that a ray costs a few multiply-adds and a normalization.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class Camera {
+
+    public:
+
+        /**
+         * Pinhole camera.
+         *
+         * @param camera_to_world placement of the camera
+         * @param vertical_fov full vertical field of view, in radians
+         * @param width raster width, in pixels
+         * @param height raster height, in pixels
+         * @return the camera
+         * */
+        static Camera perspective(const Mat<T, 4, 4>& camera_to_world, T vertical_fov, int width, int height) {
+            if (!(vertical_fov > T(0) && vertical_fov < T(M_PI)))
+                throw std::invalid_argument("field of view must be in (0, pi)");
+            return Camera(Perspective, camera_to_world, std::tan(vertical_fov / T(2)), width, height);
+        }
+
+        /**
+         * Orthographic camera.
+         *
+         * @param camera_to_world placement of the camera
+         * @param half_height half the height of the viewed region, in camera units
+         * @param width raster width, in pixels
+         * @param height raster height, in pixels
+         * @return the camera
+         * */
+        static Camera orthographic(const Mat<T, 4, 4>& camera_to_world, T half_height, int width, int height) {
+            if (!(half_height > T(0)))
+                throw std::invalid_argument("orthographic cameras must view a region of positive height");
+            return Camera(Orthographic, camera_to_world, half_height, width, height);
+        }
+
+        int width() const { return raster_width; }
+
+        int height() const { return raster_height; }
+
+        Projection projection() const { return kind; }
+
+        /**
+         * Ray through a raster position.
+         *
+         * @param px raster x, x + 0.5 being the center of column x
+         * @param py raster y, y + 0.5 being the center of row y
+         * @return the ray, with a unit direction
+         * */
+        Ray<T> generate_ray(T px, T py) const {
+            T o[3], d[3];
+            for (int a = 0; a < 3; ++a) {
+                o[a] = base_origin[a] + px * origin_dx[a] + py * origin_dy[a];
+                d[a] = base_direction[a] + px * direction_dx[a] + py * direction_dy[a];
+            }
+            const T inv = T(1) / std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            return Ray<T> {Vec3<T> {o[0], o[1], o[2]}, Vec3<T> {d[0] * inv, d[1] * inv, d[2] * inv}};
+        }
+
+        /**
+         * Rays through every pixel of a tile, row after row.
+         *
+         * @param tile the pixels, within the raster
+         * @param rays receives tile.size() rays
+         * @param jitter_x offset within each pixel along x, in [0, 1)
+         * @param jitter_y offset within each pixel along y, in [0, 1)
+         * */
+        void generate(const Tile& tile, RayBuffer<T>& rays, T jitter_x = T(0.5), T jitter_y = T(0.5)) const {
+            if (tile.x0 < 0 || tile.y0 < 0 || tile.x1 > raster_width || tile.y1 > raster_height
+                    || tile.x0 > tile.x1 || tile.y0 > tile.y1)
+                throw std::invalid_argument("tile outside of the raster");
+            rays.resize(tile.size());
+            const int w = tile.width();
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                const T py = T(y) + jitter_y;
+                const std::size_t row = std::size_t(y - tile.y0) * w;
+                T o[3], d[3];
+                for (int a = 0; a < 3; ++a) {
+                    o[a] = base_origin[a] + py * origin_dy[a] + (T(tile.x0) + jitter_x) * origin_dx[a];
+                    d[a] = base_direction[a] + py * direction_dy[a] + (T(tile.x0) + jitter_x) * direction_dx[a];
+                }
+                T* ox = rays.origin[0].data() + row;
+                T* oy = rays.origin[1].data() + row;
+                T* oz = rays.origin[2].data() + row;
+                T* dx = rays.direction[0].data() + row;
+                T* dy = rays.direction[1].data() + row;
+                T* dz = rays.direction[2].data() + row;
+                for (int i = 0; i < w; ++i) {
+                    const T fi = T(i);
+                    ox[i] = o[0] + fi * origin_dx[0];
+                    oy[i] = o[1] + fi * origin_dx[1];
+                    oz[i] = o[2] + fi * origin_dx[2];
+                    const T x = d[0] + fi * direction_dx[0];
+                    const T y = d[1] + fi * direction_dx[1];
+                    const T z = d[2] + fi * direction_dx[2];
+                    const T inv = T(1) / std::sqrt(x * x + y * y + z * z);
+                    dx[i] = x * inv;
+                    dy[i] = y * inv;
+                    dz[i] = z * inv;
+                }
+            }
+        }
+
+        /**
+         * Cuts the raster into tiles, row-major.
+         *
+         * @param tile_size edge of the tiles; tiles on the right and
+         * bottom borders may be smaller
+         * @return the tiles
+         * */
+        std::vector<Tile> tiles(int tile_size) const {
+            if (tile_size < 1)
+                throw std::invalid_argument("tiles must be at least one pixel wide");
+            std::vector<Tile> result;
+            for (int y = 0; y < raster_height; y += tile_size)
+                for (int x = 0; x < raster_width; x += tile_size)
+                    result.push_back(Tile {x, y, std::min(x + tile_size, raster_width), std::min(y + tile_size, raster_height)});
+            return result;
+        }
+
+        /**
+         * Generates the rays of every tile, tiles being spread over
+         * threads, and calls f(tile, rays) for each; there is one
+         * buffer per range of tiles that the scheduler hands to a
+         * thread, a few per thread.
+         *
+         * @param tile_size edge of the tiles
+         * @param f the consumer of the rays, called concurrently for different tiles
+         * */
+        template<typename F>
+        void for_each_tile(int tile_size, F&& f) const {
+            const std::vector<Tile> all = tiles(tile_size);
+            parallel::parallel_for(0, all.size(), 1, [&](std::size_t lo, std::size_t hi) {
+                RayBuffer<T> rays;
+                for (std::size_t t = lo; t < hi; ++t) {
+                    generate(all[t], rays);
+                    f(all[t], static_cast<const RayBuffer<T>&>(rays));
+                }
+            });
+        }
+
+        /**
+         * Raster position of a point, the inverse of generate_ray.
+         *
+         * @param p a point in world space
+         * @param px receives the raster x
+         * @param py receives the raster y
+         * @return false if the point is behind a pinhole camera
+         * */
+        bool project(const Vec3<T>& p, T& px, T& py) const {
+            const T* w = p.raw();
+            T c[3];
+            for (int i = 0; i < 3; ++i)
+                c[i] = world_to_camera[i][0] * w[0] + world_to_camera[i][1] * w[1]
+                    + world_to_camera[i][2] * w[2] + world_to_camera[i][3];
+            if (kind == Perspective) {
+                if (!(c[2] < T(0)))
+                    return false;
+                c[0] /= -c[2];
+                c[1] /= -c[2];
+            }
+            px = (c[0] - plane_x0) / plane_dx;
+            py = (c[1] - plane_y0) / plane_dy;
+            return true;
+        }
+
+    protected:
+
+        Projection kind;
+        int raster_width, raster_height;
+        T plane_x0, plane_y0, plane_dx, plane_dy;       /** raster to camera plane */
+        T base_origin[3], origin_dx[3], origin_dy[3];   /** world origin of raster (0, 0), and its steps */
+        T base_direction[3], direction_dx[3], direction_dy[3];
+        T world_to_camera[3][4];
+
+        Camera(Projection kind, const Mat<T, 4, 4>& camera_to_world, T half_extent, int width, int height)
+            : kind {kind}, raster_width {width}, raster_height {height} {
+            if (width < 1 || height < 1)
+                throw std::invalid_argument("the raster must have at least one pixel");
+            const T aspect = T(width) / T(height);
+            plane_x0 = -aspect * half_extent;
+            plane_y0 = half_extent;
+            plane_dx = T(2) * aspect * half_extent / T(width);
+            plane_dy = T(-2) * half_extent / T(height);
+
+            const T* m = camera_to_world.raw();
+            const int ld = camera_to_world.ld();
+            // camera-space x, y and origin of the plane, mapped to world space
+            for (int a = 0; a < 3; ++a) {
+                const T* row = m + a * ld;
+                const T step_x = row[0] * plane_dx, step_y = row[1] * plane_dy;
+                const T corner = row[0] * plane_x0 + row[1] * plane_y0;
+                if (kind == Perspective) {
+                    base_origin[a] = row[3];
+                    origin_dx[a] = origin_dy[a] = T(0);
+                    base_direction[a] = corner - row[2];
+                    direction_dx[a] = step_x;
+                    direction_dy[a] = step_y;
+                } else {
+                    base_origin[a] = corner + row[3];
+                    origin_dx[a] = step_x;
+                    origin_dy[a] = step_y;
+                    base_direction[a] = -row[2];
+                    direction_dx[a] = direction_dy[a] = T(0);
+                }
+            }
+            const T det = tao::det(camera_to_world);
+            if (!(det != T(0)))
+                throw std::invalid_argument("camera to world transform must be invertible");
+            Mat<T, 4, 4> inv = tao::inverse(camera_to_world);
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 4; ++j)
+                    world_to_camera[i][j] = inv.raw()[i * inv.ld() + j];
+        }
+};
+
+};
+};
+
+#endif
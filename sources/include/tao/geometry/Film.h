@@ -0,0 +1,370 @@
+#ifndef _TAO_FILM_
+#define _TAO_FILM_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "tao/core.h"
+#include "tao/geometry/Camera.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * How tiles of samples reach the shared film.
+ * */
+enum Accumulation {
+    Tiled,      /** privately, margins included, added to the film when merged */
+    Atomic,     /** straight to the film, every pixel through atomic adds */
+    Hybrid      /** privately within the tile, atomically beyond its edges */
+};
+
+namespace kernels {
+
+/**
+ * Atomic floating-point add, as a compare-and-swap loop. Ordering
+ * is relaxed: merged results are read after the threads join.
+ * */
+template<typename T>
+inline void atomic_add(std::atomic<T>& a, T v) {
+    T old = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(old, old + v, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Floor of a number well within the range of int, without the call
+ * std::floor makes before SSE4.1.
+ * */
+template<typename T>
+inline int floor_int(T v) {
+    const int i = int(v);
+    return i - (v < T(i));
+}
+
+/**
+ * Add by a plain load and store, for pixels that a single thread
+ * writes at a time.
+ * */
+template<typename T>
+inline void owned_add(std::atomic<T>& a, T v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+};
+
+template<typename T>
+class FilmTile;
+
+/**
+ * An image accumulating weighted radiance from concurrent threads.
+ *
+ * Every sample is splatted through a box filter: pixel (x, y) takes
+ * the samples whose position is within the filter radius of its
+ * center, (x + 1/2, y + 1/2), adding their weighted values and
+ * weights; the resolved pixel is the ratio. Pixels are stored as
+ * four planes, one per channel and one for the weights.
+ *
+ * Samples reach the film either one by one through add, which is
+ * always safe, or tile by tile through a FilmTile, whose behaviour
+ * depends on the Accumulation mode of the film. In Hybrid mode, a
+ * merge updates the pixels that no other tile can reach without
+ * atomics, so add must not run concurrently with merges.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class Film {
+
+    public:
+
+        /**
+         * Empty film.
+         *
+         * @param width raster width, in pixels
+         * @param height raster height, in pixels
+         * @param radius half the width of the box filter, at least half a pixel
+         * @param mode how tiles are merged
+         * */
+        Film(int width, int height, T radius = T(0.5), Accumulation mode = Hybrid)
+            : raster_width {width}, raster_height {height}, filter_radius {radius}, accumulation {mode} {
+            if (width < 1 || height < 1)
+                throw std::invalid_argument("the raster must have at least one pixel");
+            if (!(radius >= T(0.5)) || !std::isfinite(radius))
+                throw std::invalid_argument("the filter radius must be finite and at least half a pixel");
+            // pixels a sample reaches beyond its own, on each side
+            reach = int(std::ceil(radius + T(0.5))) - 1;
+            const std::size_t n = std::size_t(width) * std::size_t(height);
+            for (auto& plane : planes)
+                plane = std::vector<std::atomic<T>> (n);
+            clear();
+        }
+
+        int width() const { return raster_width; }
+
+        int height() const { return raster_height; }
+
+        T radius() const { return filter_radius; }
+
+        Accumulation mode() const { return accumulation; }
+
+        /**
+         * Resets every pixel. Not thread-safe.
+         * */
+        void clear() {
+            for (auto& plane : planes)
+                for (auto& p : plane)
+                    p.store(T(0), std::memory_order_relaxed);
+        }
+
+        /**
+         * Splats a sample, through atomic adds. Thread-safe.
+         *
+         * @param px raster x of the sample
+         * @param py raster y of the sample
+         * @param value its radiance
+         * @param weight its weight
+         * */
+        void add(T px, T py, const Vec3<T>& value, T weight = T(1)) {
+            int x0, y0, x1, y1;
+            if (!footprint(px, py, x0, y0, x1, y1))
+                return;
+            const T* rgb = value.raw();
+            const T v[4] = {rgb[0] * weight, rgb[1] * weight, rgb[2] * weight, weight};
+            for (int y = y0; y < y1; ++y)
+                for (int x = x0; x < x1; ++x) {
+                    const std::size_t i = std::size_t(y) * raster_width + x;
+                    for (int c = 0; c < 4; ++c)
+                        kernels::atomic_add(planes[c][i], v[c]);
+                }
+        }
+
+        /**
+         * A private accumulator for the samples of a tile.
+         *
+         * @param pixels the pixels whose samples it will take, within the raster
+         * @return the accumulator, to be merged back
+         * */
+        FilmTile<T> tile(const Tile& pixels) {
+            return FilmTile<T>(*this, pixels);
+        }
+
+        /**
+         * Adds what a tile accumulated to the film. Thread-safe with
+         * merges of other tiles; in Hybrid mode, tiles merged
+         * concurrently must be disjoint.
+         *
+         * @param tile the accumulator, emptied
+         * */
+        void merge(FilmTile<T>& tile) {
+            if (tile.film != this)
+                throw std::invalid_argument("tile of another film");
+            const Tile& b = tile.bounds;
+            const Tile& own = tile.tile;
+            for (int y = b.y0; y < b.y1; ++y)
+                for (int x = b.x0; x < b.x1; ++x) {
+                    const std::size_t j = std::size_t(y - b.y0) * b.width() + (x - b.x0);
+                    if (tile.planes[0][j] == T(0) && tile.planes[1][j] == T(0)
+                            && tile.planes[2][j] == T(0) && tile.planes[3][j] == T(0))
+                        continue;
+                    const std::size_t i = std::size_t(y) * raster_width + x;
+                    // in Hybrid mode, neighbors reach only the border of a tile
+                    const bool exclusive = accumulation == Hybrid
+                        && x >= own.x0 + reach && x < own.x1 - reach && y >= own.y0 + reach && y < own.y1 - reach;
+                    for (int c = 0; c < 4; ++c) {
+                        if (exclusive)
+                            kernels::owned_add(planes[c][i], tile.planes[c][j]);
+                        else
+                            kernels::atomic_add(planes[c][i], tile.planes[c][j]);
+                        tile.planes[c][j] = T(0);
+                    }
+                }
+        }
+
+        /**
+         * Accumulated weight of a pixel.
+         *
+         * @param x the column
+         * @param y the row
+         * @return the sum of the weights of its samples
+         * */
+        T weight(int x, int y) const {
+            return planes[3][index(x, y)].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Resolved value of a pixel.
+         *
+         * @param x the column
+         * @param y the row
+         * @return the weighted mean of its samples, zero without samples
+         * */
+        Vec3<T> pixel(int x, int y) const {
+            const std::size_t i = index(x, y);
+            const T w = planes[3][i].load(std::memory_order_relaxed);
+            const T inv = w != T(0) ? T(1) / w : T(0);
+            return Vec3<T> {planes[0][i].load(std::memory_order_relaxed) * inv,
+                planes[1][i].load(std::memory_order_relaxed) * inv, planes[2][i].load(std::memory_order_relaxed) * inv};
+        }
+
+        /**
+         * Resolves the whole image into three planes, row-major.
+         *
+         * @param r receives width() * height() red values
+         * @param g receives the green values
+         * @param b receives the blue values
+         * */
+        void resolve(T* r, T* g, T* b) const {
+            T* out[3] = {r, g, b};
+            const std::size_t n = planes[3].size();
+            for (std::size_t i = 0; i < n; ++i) {
+                const T w = planes[3][i].load(std::memory_order_relaxed);
+                const T inv = w != T(0) ? T(1) / w : T(0);
+                for (int c = 0; c < 3; ++c)
+                    out[c][i] = planes[c][i].load(std::memory_order_relaxed) * inv;
+            }
+        }
+
+    protected:
+
+        friend class FilmTile<T>;
+
+        int raster_width, raster_height;
+        T filter_radius;
+        Accumulation accumulation;
+        int reach;
+        std::vector<std::atomic<T>> planes[4];     /** red, green, blue and weight sums */
+
+        std::size_t index(int x, int y) const {
+            if (x < 0 || y < 0 || x >= raster_width || y >= raster_height)
+                throw std::invalid_argument("pixel outside of the raster");
+            return std::size_t(y) * raster_width + x;
+        }
+
+        /**
+         * Pixels [x0, x1) x [y0, y1) whose centers are in (p - r, p + r],
+         * clipped to the raster.
+         *
+         * @return false if there are none, p being off the raster or NaN
+         * */
+        bool footprint(T px, T py, int& x0, int& y0, int& x1, int& y1) const {
+            const T r = filter_radius;
+            if (!(px > -r && px < T(raster_width) + r && py > -r && py < T(raster_height) + r))
+                return false;
+            if (reach == 0 && r == T(0.5)) {
+                // the default box takes the samples of the pixel itself
+                x0 = kernels::floor_int(px);
+                y0 = kernels::floor_int(py);
+                x1 = x0 + 1;
+                y1 = y0 + 1;
+                return x0 >= 0 && y0 >= 0 && x0 < raster_width && y0 < raster_height;
+            }
+            x0 = std::max(0, kernels::floor_int(px - r - T(0.5)) + 1);
+            y0 = std::max(0, kernels::floor_int(py - r - T(0.5)) + 1);
+            x1 = std::min(raster_width, kernels::floor_int(px + r - T(0.5)) + 1);
+            y1 = std::min(raster_height, kernels::floor_int(py + r - T(0.5)) + 1);
+            return x0 < x1 && y0 < y1;
+        }
+};
+
+/**
+ * Samples of a tile, accumulated by a single thread without
+ * synchronization until merged into their film. What it buffers
+ * depends on the mode of the film: in Tiled mode, every pixel its
+ * samples reach; in Hybrid mode, the pixels of the tile, the others
+ * being added to the film atomically right away; in Atomic mode,
+ * nothing.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class FilmTile {
+
+    public:
+
+        /**
+         * Splats a sample.
+         *
+         * @param px raster x of the sample, within the tile
+         * @param py raster y of the sample, within the tile
+         * @param value its radiance
+         * @param weight its weight
+         * */
+        void add(T px, T py, const Vec3<T>& value, T weight = T(1)) {
+            if (!(px >= T(tile.x0) && px < T(tile.x1) && py >= T(tile.y0) && py < T(tile.y1)))
+                throw std::invalid_argument("sample outside of its tile");
+            if (film->accumulation == Atomic) {
+                film->add(px, py, value, weight);
+                return;
+            }
+            int x0, y0, x1, y1;
+            if (!film->footprint(px, py, x0, y0, x1, y1))
+                return;
+            const T* rgb = value.raw();
+            const T v[4] = {rgb[0] * weight, rgb[1] * weight, rgb[2] * weight, weight};
+            const std::size_t w = bounds.width();
+            T* const p[4] = {planes[0].data(), planes[1].data(), planes[2].data(), planes[3].data()};
+            if (x0 >= bounds.x0 && x1 <= bounds.x1 && y0 >= bounds.y0 && y1 <= bounds.y1) {
+                if (x1 - x0 == 1 && y1 - y0 == 1) {
+                    const std::size_t j = std::size_t(y0 - bounds.y0) * w + (x0 - bounds.x0);
+                    for (int c = 0; c < 4; ++c)
+                        p[c][j] += v[c];
+                    return;
+                }
+                for (int y = y0; y < y1; ++y)
+                    for (int x = x0; x < x1; ++x) {
+                        const std::size_t j = std::size_t(y - bounds.y0) * w + (x - bounds.x0);
+                        for (int c = 0; c < 4; ++c)
+                            p[c][j] += v[c];
+                    }
+                return;
+            }
+            for (int y = y0; y < y1; ++y)
+                for (int x = x0; x < x1; ++x) {
+                    if (x >= bounds.x0 && x < bounds.x1 && y >= bounds.y0 && y < bounds.y1) {
+                        const std::size_t j = std::size_t(y - bounds.y0) * w + (x - bounds.x0);
+                        for (int c = 0; c < 4; ++c)
+                            p[c][j] += v[c];
+                    } else {
+                        const std::size_t i = std::size_t(y) * film->raster_width + x;
+                        for (int c = 0; c < 4; ++c)
+                            kernels::atomic_add(film->planes[c][i], v[c]);
+                    }
+                }
+        }
+
+        /**
+         * The tile whose samples it takes.
+         *
+         * @return the tile
+         * */
+        const Tile& pixels() const { return tile; }
+
+    protected:
+
+        friend class Film<T>;
+
+        Film<T>* film;
+        Tile tile;                      /** pixels of the samples */
+        Tile bounds;                    /** pixels buffered */
+        std::vector<T> planes[4];
+
+        FilmTile(Film<T>& owner, const Tile& t) : film {&owner}, tile {t} {
+            if (t.x0 < 0 || t.y0 < 0 || t.x1 > owner.raster_width || t.y1 > owner.raster_height
+                    || t.x0 > t.x1 || t.y0 > t.y1)
+                throw std::invalid_argument("tile outside of the raster");
+            const int margin = owner.accumulation == Tiled ? owner.reach : 0;
+            bounds = owner.accumulation == Atomic ? Tile {t.x0, t.y0, t.x0, t.y0}
+                : Tile {std::max(0, t.x0 - margin), std::max(0, t.y0 - margin),
+                    std::min(owner.raster_width, t.x1 + margin), std::min(owner.raster_height, t.y1 + margin)};
+            for (auto& plane : planes)
+                plane.assign(bounds.size(), T(0));
+        }
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef _TAO_HASH_GRID_
+#define _TAO_HASH_GRID_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "tao/core.h"
+#include "tao/geometry/AABB.h"
+#include "tao/parallel/Parallel.h"
+#include "tao/parallel/RadixSort.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * Neighbors of a batch of queries, in compressed rows: the neighbors
+ * of query q are indices[offsets[q]] to indices[offsets[q + 1] - 1].
+ * */
+struct NeighborList {
+    std::vector<std::size_t> offsets;       /** one more than the queries */
+    std::vector<std::uint32_t> indices;     /** point indices, increasing within a query */
+
+    /**
+     * Number of neighbors of a query.
+     *
+     * @param q the query
+     * @return its neighbor count
+     * */
+    std::size_t count(std::size_t q) const { return offsets[q + 1] - offsets[q]; }
+
+    /**
+     * Neighbors of a query.
+     *
+     * @param q the query
+     * @return pointer to its first neighbor
+     * */
+    const std::uint32_t* neighbors(std::size_t q) const { return indices.data() + offsets[q]; }
+};
+
+/**
+ * Uniform grid over a point set, with cells hashed into a table of
+ * about as many buckets as points, for fixed-radius neighbor queries.
+ *
+ * Points are counting-sorted by bucket with a radix sort, and kept
+ * in bucket order, so that the points of a bucket are contiguous and
+ * memory does not depend on the extent of the grid. Cells sharing a
+ * bucket are told apart by the distance test.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class HashGrid {
+
+    public:
+
+        /**
+         * Empty grid.
+         * */
+        HashGrid() = default;
+
+        /**
+         * Builds the grid.
+         *
+         * @param points the points
+         * @param count the number of points
+         * @param cell_size edge of the cells, best about twice the query radius
+         * */
+        HashGrid(const Vec3<T>* points, std::size_t count, T cell_size) : cell {cell_size} {
+            if (!(cell_size > T(0)))
+                throw std::invalid_argument("hash grid cells must have a positive size");
+            if (count >= std::size_t(std::numeric_limits<std::uint32_t>::max()))
+                throw std::invalid_argument("too many points for 32-bit indices");
+            inv_cell = T(1) / cell_size;
+            AABB<T> box;
+            for (std::size_t i = 0; i < count; ++i)
+                box.expand(points[i]);
+            for (int a = 0; a < 3; ++a)
+                origin[a] = count > 0 ? box.lower.raw()[a] : T(0);
+            while ((std::size_t(1) << table_bits) < count && table_bits < 31)
+                ++table_bits;
+            const std::uint32_t buckets = std::uint32_t(1) << table_bits;
+
+            std::vector<std::uint32_t> keys (count);
+            index_array.resize(count);
+            parallel::parallel_for(0, count, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    std::int32_t c[3];
+                    cell_of(points[i].raw(), c);
+                    keys[i] = bucket_of(c);
+                    index_array[i] = std::uint32_t(i);
+                }
+            });
+            parallel::radix_sort(keys, index_array, table_bits);
+
+            // bucket b holds [start[b], start[b + 1]); positions fill the buckets they open
+            start.assign(std::size_t(buckets) + 1, 0);
+            parallel::parallel_for(0, count + 1, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    std::uint64_t first = i == 0 ? 0 : std::uint64_t(keys[i - 1]) + 1;
+                    std::uint64_t last = i == count ? buckets : keys[i];
+                    for (std::uint64_t b = first; b <= last; ++b)
+                        start[b] = std::uint32_t(i);
+                }
+            });
+
+            coords.resize(3 * count);
+            parallel::parallel_for(0, count, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i)
+                    for (int a = 0; a < 3; ++a)
+                        coords[3 * i + a] = points[index_array[i]].raw()[a];
+            });
+        }
+
+        /**
+         * Builds the grid.
+         *
+         * @param points the points
+         * @param cell_size edge of the cells, best about twice the query radius
+         * */
+        HashGrid(const std::vector<Vec3<T>>& points, T cell_size) : HashGrid(points.data(), points.size(), cell_size) {}
+
+        /**
+         * Number of points.
+         *
+         * @return the point count
+         * */
+        std::size_t size() const { return index_array.size(); }
+
+        /**
+         * Edge of the cells.
+         *
+         * @return the cell size
+         * */
+        T cell_size() const { return cell; }
+
+        /**
+         * Calls f(index, squared_distance) for every point within a
+         * distance of a query point, in no particular order.
+         *
+         * @param q the query point
+         * @param radius the search radius
+         * @param f the callback
+         * */
+        template<typename F>
+        void for_each_in_radius(const Vec3<T>& q, T radius, F&& f) const {
+            if (size() == 0 || !(radius >= T(0)))
+                return;
+            const T* p = q.raw();
+            const T r2 = radius * radius;
+            T lo[3], hi[3];
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = p[a] - radius;
+                hi[a] = p[a] + radius;
+            }
+            std::int32_t c0[3], c1[3];
+            cell_of(lo, c0);
+            cell_of(hi, c1);
+            std::uint64_t cells = 1;
+            for (int a = 0; a < 3; ++a)
+                cells *= std::uint64_t(std::int64_t(c1[a]) - c0[a] + 1);
+            auto scan = [&](std::uint32_t b) {
+                for (std::uint32_t i = start[b], end = start[b + 1]; i < end; ++i) {
+                    const T* x = coords.data() + 3 * std::size_t(i);
+                    const T dx = x[0] - p[0], dy = x[1] - p[1], dz = x[2] - p[2];
+                    const T d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 <= r2)
+                        f(index_array[i], d2);
+                }
+            };
+            const std::uint32_t buckets = std::uint32_t(1) << table_bits;
+            if (cells >= buckets) {
+                for (std::uint32_t b = 0; b < buckets; ++b)
+                    scan(b);
+                return;
+            }
+            // distinct cells may share a bucket, which must be scanned once
+            constexpr int local_size = 27;
+            std::uint32_t local[local_size];
+            std::vector<std::uint32_t> spill;
+            std::uint32_t* visited = local;
+            if (cells > std::uint64_t(local_size)) {
+                spill.resize(cells);
+                visited = spill.data();
+            }
+            std::size_t m = 0;
+            std::int32_t c[3];
+            for (c[0] = c0[0]; c[0] <= c1[0]; ++c[0])
+                for (c[1] = c0[1]; c[1] <= c1[1]; ++c[1])
+                    for (c[2] = c0[2]; c[2] <= c1[2]; ++c[2])
+                        visited[m++] = bucket_of(c);
+            std::sort(visited, visited + m);
+            m = std::unique(visited, visited + m) - visited;
+            for (std::size_t k = 0; k < m; ++k)
+                scan(visited[k]);
+        }
+
+        /**
+         * Points within a distance of a query point.
+         *
+         * @param q the query point
+         * @param radius the search radius
+         * @param result receives the point indices, increasing
+         * */
+        void radius_search(const Vec3<T>& q, T radius, std::vector<std::uint32_t>& result) const {
+            result.clear();
+            for_each_in_radius(q, radius, [&](std::uint32_t i, T) { result.push_back(i); });
+            std::sort(result.begin(), result.end());
+        }
+
+        /**
+         * Points within a distance of each query point. Queries are
+         * answered in parallel, counting first, then filling.
+         *
+         * @param queries the query points
+         * @param count the number of queries
+         * @param radius the search radius
+         * @return the neighbors of every query
+         * */
+        NeighborList radius_search(const Vec3<T>* queries, std::size_t count, T radius) const {
+            NeighborList list;
+            list.offsets.assign(count + 1, 0);
+            parallel::parallel_for(0, count, 256, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t q = lo; q < hi; ++q) {
+                    std::size_t found = 0;
+                    for_each_in_radius(queries[q], radius, [&](std::uint32_t, T) { ++found; });
+                    list.offsets[q + 1] = found;
+                }
+            });
+            std::partial_sum(list.offsets.begin(), list.offsets.end(), list.offsets.begin());
+            list.indices.resize(list.offsets[count]);
+            parallel::parallel_for(0, count, 256, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t q = lo; q < hi; ++q) {
+                    std::uint32_t* out = list.indices.data() + list.offsets[q];
+                    std::size_t found = 0;
+                    for_each_in_radius(queries[q], radius, [&](std::uint32_t i, T) { out[found++] = i; });
+                    std::sort(out, out + found);
+                }
+            });
+            return list;
+        }
+
+        /**
+         * Points within a distance of each query point.
+         *
+         * @param queries the query points
+         * @param radius the search radius
+         * @return the neighbors of every query
+         * */
+        NeighborList radius_search(const std::vector<Vec3<T>>& queries, T radius) const {
+            return radius_search(queries.data(), queries.size(), radius);
+        }
+
+    protected:
+
+        T cell {1};                                 /** edge of the cells */
+        T inv_cell {1};                             /** its inverse */
+        T origin[3] {};                             /** corner of cell (0, 0, 0) */
+        int table_bits {0};                         /** log2 of the bucket count */
+        std::vector<std::uint32_t> start {0, 0};    /** first point of every bucket, then the end */
+        std::vector<std::uint32_t> index_array;     /** original index of the points, in bucket order */
+        std::vector<T> coords;                      /** xyz of the points, in bucket order */
+
+        /**
+         * Integer cell of a position; cells far out of range wrap.
+         * */
+        void cell_of(const T* p, std::int32_t c[3]) const {
+            for (int a = 0; a < 3; ++a)
+                c[a] = std::int32_t(std::int64_t(std::floor((p[a] - origin[a]) * inv_cell)));
+        }
+
+        /**
+         * Bucket of a cell.
+         * */
+        std::uint32_t bucket_of(const std::int32_t c[3]) const {
+            const std::uint32_t h = (std::uint32_t(c[0]) * 73856093u) ^ (std::uint32_t(c[1]) * 19349663u)
+                ^ (std::uint32_t(c[2]) * 83492791u);
+            return table_bits == 0 ? 0 : (h * 2654435769u) >> (32 - table_bits);
+        }
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef _TAO_KD_TREE_
+#define _TAO_KD_TREE_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "tao/core.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * Index reported for neighbors that do not exist, when fewer
+ * points than asked for are in the tree.
+ * */
+constexpr std::uint32_t no_neighbor = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Balanced k-d tree over a point set, for k-nearest-neighbor queries.
+ *
+ * Every node splits its points at the median along the axis of widest
+ * spread, so the tree is complete and implicit: node i has children
+ * 2i + 1 and 2i + 2, the point range of a node follows from halving,
+ * and only the split planes are stored. Points are kept as coordinate
+ * arrays in tree order. The nodes of a level are split in parallel.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class KdTree {
+
+    public:
+
+        /**
+         * Empty tree.
+         * */
+        KdTree() = default;
+
+        /**
+         * Builds the tree.
+         *
+         * @param points the points
+         * @param count the number of points
+         * @param leaf_size leaves never hold more points
+         * */
+        KdTree(const Vec3<T>* points, std::size_t count, int leaf_size = 8) {
+            if (leaf_size < 1)
+                throw std::invalid_argument("k-d tree leaves must hold at least one point");
+            if (count >= std::size_t(no_neighbor))
+                throw std::invalid_argument("too many points for 32-bit indices");
+            point_count = count;
+            while (((count + (std::size_t(1) << levels) - 1) >> levels) > std::size_t(leaf_size))
+                ++levels;
+            split_array.resize((std::size_t(1) << levels) - 1);
+            axis_array.resize(split_array.size());
+
+            // splits move whole records, so that every level streams through memory
+            std::vector<Record> records (count);
+            parallel::parallel_for(0, count, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    for (int a = 0; a < 3; ++a)
+                        records[i].x[a] = points[i].raw()[a];
+                    records[i].index = std::uint32_t(i);
+                }
+            });
+            for (int d = 0; d < levels; ++d) {
+                const std::size_t first = (std::size_t(1) << d) - 1, width = std::size_t(1) << d;
+                parallel::parallel_for(0, width, 1, [&](std::size_t lo, std::size_t hi) {
+                    for (std::size_t k = lo; k < hi; ++k)
+                        split(records.data(), first + k, d);
+                });
+            }
+
+            index_array.resize(count);
+            coords.resize(3 * count);
+            parallel::parallel_for(0, count, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i) {
+                    for (int a = 0; a < 3; ++a)
+                        coords[3 * i + a] = records[i].x[a];
+                    index_array[i] = records[i].index;
+                }
+            });
+        }
+
+        /**
+         * Builds the tree.
+         *
+         * @param points the points
+         * @param leaf_size leaves never hold more points
+         * */
+        explicit KdTree(const std::vector<Vec3<T>>& points, int leaf_size = 8)
+            : KdTree(points.data(), points.size(), leaf_size) {}
+
+        /**
+         * Number of points.
+         *
+         * @return the point count
+         * */
+        std::size_t size() const { return point_count; }
+
+        /**
+         * Number of levels of interior nodes.
+         *
+         * @return the depth of the leaves
+         * */
+        int depth() const { return levels; }
+
+        /**
+         * The k nearest points to a query point, nearest first, equal
+         * distances by increasing index. Candidates are kept in a bounded
+         * max-heap in the output arrays; subtrees farther than the worst
+         * candidate are skipped.
+         *
+         * @param q the query point
+         * @param k the number of neighbors
+         * @param indices receives k point indices, no_neighbor past the point count
+         * @param dist2 receives their k squared distances, infinity past the point count
+         * @return the number of neighbors found, min(k, size())
+         * */
+        std::size_t knn(const Vec3<T>& q, std::size_t k, std::uint32_t* indices, T* dist2) const {
+            std::size_t found = 0;
+            if (k > 0 && point_count > 0)
+                found = search(q.raw(), k, indices, dist2);
+            // the heap is sorted in place, worst last
+            for (std::size_t end = found; end > 1; --end) {
+                std::swap(indices[0], indices[end - 1]);
+                std::swap(dist2[0], dist2[end - 1]);
+                sift_down(indices, dist2, 0, end - 1);
+            }
+            for (std::size_t j = found; j < k; ++j) {
+                indices[j] = no_neighbor;
+                dist2[j] = std::numeric_limits<T>::infinity();
+            }
+            return found;
+        }
+
+        /**
+         * The k nearest points to each query point, queries being
+         * answered in parallel.
+         *
+         * @param queries the query points
+         * @param count the number of queries
+         * @param k the number of neighbors
+         * @param indices receives k indices per query, row after row
+         * @param dist2 receives k squared distances per query, row after row
+         * */
+        void knn(const Vec3<T>* queries, std::size_t count, std::size_t k, std::uint32_t* indices, T* dist2) const {
+            parallel::parallel_for(0, count, 256, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t q = lo; q < hi; ++q)
+                    knn(queries[q], k, indices + q * k, dist2 + q * k);
+            });
+        }
+
+    protected:
+
+        /**
+         * Traversal stack entry.
+         * */
+        struct Entry {
+            std::uint32_t node;
+            std::uint32_t lo, hi;
+            std::int32_t depth;
+            T dist2;                    /** lower bound of the distance to the subtree */
+        };
+
+        /**
+         * A point and its original index, as sorted while building.
+         * */
+        struct Record {
+            T x[3];
+            std::uint32_t index;
+        };
+
+        std::size_t point_count {0};
+        int levels {0};
+        std::vector<T> split_array;                 /** split coordinate of the interior nodes */
+        std::vector<std::uint8_t> axis_array;       /** split axis of the interior nodes */
+        std::vector<std::uint32_t> index_array;     /** original index of the points, in tree order */
+        std::vector<T> coords;                      /** xyz of the points, in tree order */
+
+        /**
+         * Point range of a node, found by halving from the root.
+         * */
+        void range_of(std::size_t node, int depth, std::size_t& lo, std::size_t& hi) const {
+            lo = 0;
+            hi = point_count;
+            for (int d = depth - 1; d >= 0; --d) {
+                const std::size_t mid = lo + (hi - lo) / 2;
+                if ((((node + 1) >> d) & 1) == 0)
+                    hi = mid;
+                else
+                    lo = mid;
+            }
+        }
+
+        /**
+         * Splits the points of an interior node at the median.
+         * */
+        void split(Record* records, std::size_t node, int depth) {
+            std::size_t lo, hi;
+            range_of(node, depth, lo, hi);
+            T lower[3], upper[3];
+            for (int a = 0; a < 3; ++a) {
+                lower[a] = std::numeric_limits<T>::infinity();
+                upper[a] = -std::numeric_limits<T>::infinity();
+            }
+            for (std::size_t i = lo; i < hi; ++i) {
+                for (int a = 0; a < 3; ++a) {
+                    lower[a] = std::min(lower[a], records[i].x[a]);
+                    upper[a] = std::max(upper[a], records[i].x[a]);
+                }
+            }
+            int axis = 0;
+            for (int a = 1; a < 3; ++a)
+                if (upper[a] - lower[a] > upper[axis] - lower[axis])
+                    axis = a;
+            const std::size_t mid = lo + (hi - lo) / 2;
+            std::nth_element(records + lo, records + mid, records + hi, [axis](const Record& r, const Record& s) {
+                return r.x[axis] < s.x[axis] || (r.x[axis] == s.x[axis] && r.index < s.index);
+            });
+            axis_array[node] = std::uint8_t(axis);
+            split_array[node] = mid < hi ? records[mid].x[axis] : T(0);
+        }
+
+        /**
+         * Restores the max-heap order, by (distance, index), below a candidate.
+         * */
+        static void sift_down(std::uint32_t* idx, T* d2, std::size_t j, std::size_t n) {
+            for (;;) {
+                std::size_t c = 2 * j + 1;
+                if (c >= n)
+                    return;
+                if (c + 1 < n && worse(idx[c + 1], d2[c + 1], idx[c], d2[c]))
+                    ++c;
+                if (!worse(idx[c], d2[c], idx[j], d2[j]))
+                    return;
+                std::swap(idx[c], idx[j]);
+                std::swap(d2[c], d2[j]);
+                j = c;
+            }
+        }
+
+        static bool worse(std::uint32_t i, T di, std::uint32_t j, T dj) {
+            return di > dj || (di == dj && i > j);
+        }
+
+        /**
+         * Fills a heap of the k nearest candidates.
+         *
+         * @return the number of candidates
+         * */
+        std::size_t search(const T* q, std::size_t k, std::uint32_t* idx, T* d2) const {
+            std::size_t found = 0;
+            Entry stack[64];
+            int top = 0;
+            stack[top++] = Entry {0, 0, std::uint32_t(point_count), 0, T(0)};
+            while (top > 0) {
+                Entry e = stack[--top];
+                if (found == k && e.dist2 > d2[0])
+                    continue;
+                while (e.depth < levels) {
+                    const int axis = axis_array[e.node];
+                    const T diff = q[axis] - split_array[e.node];
+                    const std::uint32_t mid = e.lo + (e.hi - e.lo) / 2;
+                    Entry left {2 * e.node + 1, e.lo, mid, e.depth + 1, e.dist2};
+                    Entry right {2 * e.node + 2, mid, e.hi, e.depth + 1, e.dist2};
+                    Entry& far = diff < T(0) ? right : left;
+                    far.dist2 = std::max(e.dist2, diff * diff);
+                    stack[top++] = far;
+                    e = diff < T(0) ? left : right;
+                }
+                for (std::uint32_t i = e.lo; i < e.hi; ++i) {
+                    const T* x = coords.data() + 3 * std::size_t(i);
+                    const T dx = x[0] - q[0], dy = x[1] - q[1], dz = x[2] - q[2];
+                    const T d = dx * dx + dy * dy + dz * dz;
+                    const std::uint32_t id = index_array[i];
+                    if (found < k) {
+                        // sift the new candidate up
+                        std::size_t j = found++;
+                        idx[j] = id;
+                        d2[j] = d;
+                        while (j > 0 && worse(idx[j], d2[j], idx[(j - 1) / 2], d2[(j - 1) / 2])) {
+                            std::swap(idx[j], idx[(j - 1) / 2]);
+                            std::swap(d2[j], d2[(j - 1) / 2]);
+                            j = (j - 1) / 2;
+                        }
+                    } else if (worse(idx[0], d2[0], id, d)) {
+                        idx[0] = id;
+                        d2[0] = d;
+                        sift_down(idx, d2, 0, k);
+                    }
+                }
+            }
+            return found;
+        }
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef _TAO_MORTON_
+#define _TAO_MORTON_
+
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include "tao/core.h"
+#include "tao/geometry/AABB.h"
+#include "tao/parallel/Parallel.h"
+#include "tao/parallel/RadixSort.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace tao {
+namespace geometry {
+
+/**
+ * Space-filling curves along which points can be ordered.
+ * Morton (Z-order) codes are cheaper; Hilbert indices never
+ * jump between distant cells, so they give better locality.
+ * */
+enum SpaceFillingCurve {
+    Morton,
+    Hilbert
+};
+
+namespace kernels {
+
+/**
+ * Spreads the 10 lowest bits of x so that there are two zeros
+ * between consecutive bits.
+ * */
+inline std::uint32_t expand_bits(std::uint32_t x) {
+#if defined(__BMI2__)
+    return _pdep_u32(x, 0x09249249u);
+#else
+    x &= 0x000003ffu;
+    x = (x | (x << 16)) & 0x030000ffu;
+    x = (x | (x << 8)) & 0x0300f00fu;
+    x = (x | (x << 4)) & 0x030c30c3u;
+    x = (x | (x << 2)) & 0x09249249u;
+    return x;
+#endif
+}
+
+/**
+ * Spreads the 21 lowest bits of x so that there are two zeros
+ * between consecutive bits.
+ * */
+inline std::uint64_t expand_bits(std::uint64_t x) {
+#if defined(__BMI2__)
+    return _pdep_u64(x, 0x1249249249249249ull);
+#else
+    x &= 0x00000000001fffffull;
+    x = (x | (x << 32)) & 0x001f00000000ffffull;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+    x = (x | (x << 8)) & 0x100f00f00f00f00full;
+    x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+    x = (x | (x << 2)) & 0x1249249249249249ull;
+    return x;
+#endif
+}
+
+/**
+ * Skilling's transform of cell coordinates, in place, into the
+ * transposed Hilbert index: interleaving the result, x first,
+ * gives the index.
+ *
+ * @param x the coordinates, each below 2^bits
+ * @param bits bits per coordinate
+ * */
+template<typename U>
+void axes_to_transpose(U x[3], int bits) {
+    const U m = U(1) << (bits - 1);
+    for (U q = m; q > 1; q >>= 1) {
+        const U p = q - 1;
+        for (int i = 0; i < 3; ++i) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                U t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+    U t = 0;
+    for (U q = m; q > 1; q >>= 1)
+        if (x[2] & q)
+            t ^= q - 1;
+    for (int i = 0; i < 3; ++i)
+        x[i] ^= t;
+}
+
+};
+
+/**
+ * Morton code of a cell of a 1024^3 grid.
+ *
+ * @param x cell along x, below 1024, the most significant
+ * @param y cell along y, below 1024
+ * @param z cell along z, below 1024
+ * @return the 30-bit code
+ * */
+inline std::uint32_t morton30(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    return (kernels::expand_bits(x) << 2) | (kernels::expand_bits(y) << 1) | kernels::expand_bits(z);
+}
+
+/**
+ * Morton code of a cell of a 2097152^3 grid.
+ *
+ * @param x cell along x, below 2^21, the most significant
+ * @param y cell along y, below 2^21
+ * @param z cell along z, below 2^21
+ * @return the 63-bit code
+ * */
+inline std::uint64_t morton63(std::uint64_t x, std::uint64_t y, std::uint64_t z) {
+    return (kernels::expand_bits(x) << 2) | (kernels::expand_bits(y) << 1) | kernels::expand_bits(z);
+}
+
+/**
+ * Hilbert index of a cell of a 2^bits x 2^bits x 2^bits grid.
+ *
+ * @param x cell along x
+ * @param y cell along y
+ * @param z cell along z
+ * @param bits bits per coordinate, from 1 to 21
+ * @return the 3 * bits-bit index
+ * */
+inline std::uint64_t hilbert_index(std::uint64_t x, std::uint64_t y, std::uint64_t z, int bits) {
+    std::uint64_t c[3] {x, y, z};
+    kernels::axes_to_transpose(c, bits);
+    return morton63(c[0], c[1], c[2]);
+}
+
+/**
+ * Hilbert index of a cell of a 1024^3 grid.
+ * */
+inline std::uint32_t hilbert30(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    std::uint32_t c[3] {x, y, z};
+    kernels::axes_to_transpose(c, 10);
+    return morton30(c[0], c[1], c[2]);
+}
+
+/**
+ * Hilbert index of a cell of a 2097152^3 grid.
+ * */
+inline std::uint64_t hilbert63(std::uint64_t x, std::uint64_t y, std::uint64_t z) {
+    return hilbert_index(x, y, z, 21);
+}
+
+/**
+ * Cell of a point in a 2^bits per axis grid over a box.
+ * Points outside the box go to the nearest cell.
+ *
+ * @param p the point
+ * @param bounds the box
+ * @param bits bits per coordinate
+ * @param cell the cell coordinates
+ * */
+template<typename T, typename U>
+void quantize(const Vec3<T>& p, const AABB<T>& bounds, int bits, U cell[3]) {
+    const T* pp = p.raw();
+    const T* lo = bounds.lower.raw();
+    const T* hi = bounds.upper.raw();
+    const T cells = T(std::uint64_t(1) << bits);
+    const T last = cells - T(1);
+    for (int a = 0; a < 3; ++a) {
+        const T extent = hi[a] - lo[a];
+        T x = extent > T(0) ? (pp[a] - lo[a]) * (cells / extent) : T(0);
+        x = x < T(0) ? T(0) : (x > last ? last : x);
+        cell[a] = U(x);
+    }
+}
+
+/**
+ * 30-bit codes, along a curve, of points in a box. Points
+ * are encoded in parallel.
+ *
+ * @param points the points
+ * @param n number of points
+ * @param bounds the box, usually the bounds of the points
+ * @param codes the n codes
+ * @param curve the curve
+ * */
+template<typename T>
+void encode_points(const Vec3<T>* points, std::size_t n, const AABB<T>& bounds,
+        std::uint32_t* codes, SpaceFillingCurve curve = Morton) {
+    parallel::parallel_for(0, n, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+        std::uint32_t cell[3];
+        for (std::size_t i = lo; i < hi; ++i) {
+            quantize(points[i], bounds, 10, cell);
+            codes[i] = curve == Morton ? morton30(cell[0], cell[1], cell[2]) : hilbert30(cell[0], cell[1], cell[2]);
+        }
+    });
+}
+
+/**
+ * 63-bit codes, along a curve, of points in a box. Points
+ * are encoded in parallel.
+ *
+ * @param points the points
+ * @param n number of points
+ * @param bounds the box, usually the bounds of the points
+ * @param codes the n codes
+ * @param curve the curve
+ * */
+template<typename T>
+void encode_points(const Vec3<T>* points, std::size_t n, const AABB<T>& bounds,
+        std::uint64_t* codes, SpaceFillingCurve curve = Morton) {
+    parallel::parallel_for(0, n, 1 << 14, [&](std::size_t lo, std::size_t hi) {
+        std::uint64_t cell[3];
+        for (std::size_t i = lo; i < hi; ++i) {
+            quantize(points[i], bounds, 21, cell);
+            codes[i] = curve == Morton ? morton63(cell[0], cell[1], cell[2]) : hilbert63(cell[0], cell[1], cell[2]);
+        }
+    });
+}
+
+/**
+ * Order of points along a curve through their bounds, to be
+ * given to parallel::reorder for the points and anything stored
+ * alongside them. Equal codes keep their input order.
+ *
+ * @param points the points
+ * @param curve the curve
+ * @return the indices of the points, in curve order
+ * */
+template<typename T>
+std::vector<std::uint32_t> spatial_order(const std::vector<Vec3<T>>& points, SpaceFillingCurve curve = Morton) {
+    AABB<T> bounds;
+    for (const auto& p : points)
+        bounds.expand(p);
+    std::vector<std::uint64_t> codes (points.size());
+    encode_points(points.data(), points.size(), bounds, codes.data(), curve);
+    std::vector<std::uint32_t> order (points.size());
+    std::iota(order.begin(), order.end(), std::uint32_t(0));
+    parallel::radix_sort(codes, order, 63);
+    return order;
+}
+
+/**
+ * Order of primitives along a curve through the bounds of their
+ * centroids, as for points. Sorting primitives this way before
+ * building a BVH makes its leaves contiguous in memory.
+ *
+ * @param boxes the bounds of the primitives
+ * @param curve the curve
+ * @return the indices of the primitives, in curve order
+ * */
+template<typename T>
+std::vector<std::uint32_t> spatial_order(const std::vector<AABB<T>>& boxes, SpaceFillingCurve curve = Morton) {
+    std::vector<Vec3<T>> centroids;
+    centroids.reserve(boxes.size());
+    for (const auto& box : boxes)
+        centroids.push_back(box.centroid());
+    return spatial_order(centroids, curve);
+}
+
+};
+};
+
+#endif
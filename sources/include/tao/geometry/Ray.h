@@ -0,0 +1,126 @@
+#ifndef _TAO_RAY_
+#define _TAO_RAY_
+
+#include <cstddef>
+#include <limits>
+#include "tao/core.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * Factor applied to the far distance of slab tests, so that
+ * rounding in the three subtractions and products never makes
+ * a ray grazing a box miss it.
+ * */
+template<typename T>
+constexpr T slab_far_scale() {
+    constexpr T eps = std::numeric_limits<T>::epsilon() / 2;
+    return T(1) + T(2) * (3 * eps) / (T(1) - 3 * eps);
+}
+
+/**
+ * A ray origin + t direction, for t in [tmin, tmax].
+ *
+ * The inverse of the direction is computed on construction, since
+ * every slab test needs it; build a new ray rather than changing
+ * the direction of an existing one.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct Ray {
+
+    Vec3<T> origin;             /** the origin */
+    Vec3<T> direction;          /** the direction, not necessarily unit */
+    Vec3<T> inv_direction;      /** 1 / direction, per component */
+    T tmin;                     /** start of the valid segment */
+    T tmax;                     /** end of the valid segment */
+
+    /**
+     * Ray from an origin along a direction.
+     *
+     * @param origin the origin
+     * @param direction the direction, zero components allowed
+     * @param tmin start of the valid segment
+     * @param tmax end of the valid segment
+     * */
+    Ray(const Vec3<T>& origin, const Vec3<T>& direction,
+            T tmin = T(0), T tmax = std::numeric_limits<T>::infinity())
+        : origin (origin), direction (direction), inv_direction (T(0)), tmin {tmin}, tmax {tmax} {
+        for (int a = 0; a < 3; ++a)
+            this->inv_direction.raw()[a] = T(1) / direction.raw()[a];
+    }
+
+    /**
+     * Point at a given distance.
+     *
+     * @param t the parameter
+     * @return origin + t direction
+     * */
+    Vec3<T> operator()(T t) const {
+        Vec3<T> p (T(0));
+        for (int a = 0; a < 3; ++a)
+            p.raw()[a] = origin.raw()[a] + t * direction.raw()[a];
+        return p;
+    }
+};
+
+/**
+ * Alignment of packets whose rows hold W values of type T: the size
+ * of a row, for it to fill vector registers, but at most 64 bytes and
+ * only the largest power of two dividing it, so that any W compiles.
+ * */
+template<typename T, int W>
+constexpr std::size_t packet_alignment() {
+    constexpr std::size_t bytes = sizeof(T) * std::size_t(W);
+    constexpr std::size_t lowest = bytes & (~bytes + 1);
+    return lowest < 64 ? lowest : 64;
+}
+
+/**
+ * W rays in structure-of-arrays layout, one lane per ray, to be
+ * tested against a box all at once.
+ * */
+template<typename T, int W>
+struct alignas(packet_alignment<T, W>()) RayPacket {
+
+    T origin[3][W];             /** origins, per axis */
+    T inv_direction[3][W];      /** inverse directions, per axis */
+    T tmin[W];                  /** starts of the valid segments */
+    T tmax[W];                  /** ends of the valid segments */
+
+    /**
+     * Packet whose lanes never hit anything.
+     * */
+    RayPacket() {
+        for (int l = 0; l < W; ++l) {
+            for (int a = 0; a < 3; ++a) {
+                origin[a][l] = T(0);
+                inv_direction[a][l] = T(1);
+            }
+            tmin[l] = T(1);
+            tmax[l] = T(0);
+        }
+    }
+
+    /**
+     * Stores a ray in a lane.
+     *
+     * @param lane the lane, in [0, W)
+     * @param ray the ray
+     * */
+    void set(int lane, const Ray<T>& ray) {
+        for (int a = 0; a < 3; ++a) {
+            origin[a][lane] = ray.origin.raw()[a];
+            inv_direction[a][lane] = ray.inv_direction.raw()[a];
+        }
+        tmin[lane] = ray.tmin;
+        tmax[lane] = ray.tmax;
+    }
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _TAO_SPHERE_
+#define _TAO_SPHERE_
+
+#include <cmath>
+#include "tao/core.h"
+#include "tao/geometry/Ray.h"
+#include "tao/geometry/AABB.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * A sphere given by its center and radius.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct Sphere {
+
+    Vec3<T> center;     /** the center */
+    T radius;           /** the radius */
+
+    /**
+     * Sphere from center and radius.
+     *
+     * @param center the center
+     * @param radius the radius
+     * */
+    Sphere(const Vec3<T>& center, T radius) : center (center), radius {radius} {}
+
+    /**
+     * The box around the sphere.
+     *
+     * @return the bounds
+     * */
+    AABB<T> bounds() const {
+        AABB<T> box (center);
+        for (int a = 0; a < 3; ++a) {
+            box.lower.raw()[a] -= radius;
+            box.upper.raw()[a] += radius;
+        }
+        return box;
+    }
+};
+
+/**
+ * Nearest intersection of a ray with a sphere.
+ *
+ * The quadratic is solved from the offset between the center and its
+ * projection on the ray, which keeps its precision when the sphere is
+ * small compared to its distance to the origin.
+ *
+ * @param sphere the sphere
+ * @param ray the ray
+ * @param t receives the distance of the nearest hit within [tmin, tmax]
+ * @return whether there is such a hit
+ * */
+template<typename T>
+bool intersect(const Sphere<T>& sphere, const Ray<T>& ray, T& t) {
+    const T* o = ray.origin.raw();
+    const T* d = ray.direction.raw();
+    const T* c = sphere.center.raw();
+    T f[3] = {o[0] - c[0], o[1] - c[1], o[2] - c[2]};
+    T a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    if (a == T(0))
+        return false;
+    T b = -(f[0] * d[0] + f[1] * d[1] + f[2] * d[2]);
+    // the point of the line closest to the center, relative to it
+    T l[3] = {f[0] + (b / a) * d[0], f[1] + (b / a) * d[1], f[2] + (b / a) * d[2]};
+    T r2 = sphere.radius * sphere.radius;
+    T disc = a * (r2 - (l[0] * l[0] + l[1] * l[1] + l[2] * l[2]));
+    if (disc < T(0))
+        return false;
+    T q = b + std::copysign(std::sqrt(disc), b);
+    T c0 = f[0] * f[0] + f[1] * f[1] + f[2] * f[2] - r2;
+    T t0 = q != T(0) ? c0 / q : T(0);
+    T t1 = q / a;
+    if (t0 > t1) {
+        T tmp = t0;
+        t0 = t1;
+        t1 = tmp;
+    }
+    if (t0 >= ray.tmin && t0 <= ray.tmax) {
+        t = t0;
+        return true;
+    }
+    if (t1 >= ray.tmin && t1 <= ray.tmax) {
+        t = t1;
+        return true;
+    }
+    return false;
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef _TAO_TRIANGLE_
+#define _TAO_TRIANGLE_
+
+#include <cmath>
+#include "tao/core.h"
+#include "tao/geometry/Ray.h"
+#include "tao/geometry/AABB.h"
+
+namespace tao {
+namespace geometry {
+
+/**
+ * Ray-triangle intersection algorithms.
+ * */
+enum TriangleIntersection {
+    MollerTrumbore = 0,     /** fastest; rays through shared edges may miss both triangles */
+    Watertight = 1          /** Woop et al.: no ray slips through the edges of a closed mesh */
+};
+
+/**
+ * A triangle given by its vertices.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct Triangle {
+
+    Vec3<T> v0;     /** the first vertex */
+    Vec3<T> v1;     /** the second vertex */
+    Vec3<T> v2;     /** the third vertex */
+
+    /**
+     * Triangle from its vertices.
+     *
+     * @param v0 the first vertex
+     * @param v1 the second vertex
+     * @param v2 the third vertex
+     * */
+    Triangle(const Vec3<T>& v0, const Vec3<T>& v1, const Vec3<T>& v2) : v0 (v0), v1 (v1), v2 (v2) {}
+
+    /**
+     * The box around the triangle.
+     *
+     * @return the bounds
+     * */
+    AABB<T> bounds() const {
+        AABB<T> box (v0);
+        box.expand(v1);
+        box.expand(v2);
+        return box;
+    }
+};
+
+/**
+ * W triangles in structure-of-arrays layout, one lane per triangle.
+ * Vertices are kept rather than edges, so that neighbouring triangles
+ * compute shared edges identically, as watertightness requires.
+ * */
+template<typename T, int W>
+struct alignas(packet_alignment<T, W>()) TrianglePacket {
+
+    T v0[3][W];     /** first vertices, per axis */
+    T v1[3][W];     /** second vertices, per axis */
+    T v2[3][W];     /** third vertices, per axis */
+
+    /**
+     * Packet of degenerate triangles, which no ray hits.
+     * */
+    TrianglePacket() {
+        for (int a = 0; a < 3; ++a) {
+            for (int l = 0; l < W; ++l) {
+                v0[a][l] = T(0);
+                v1[a][l] = T(0);
+                v2[a][l] = T(0);
+            }
+        }
+    }
+
+    /**
+     * Stores a triangle in a lane.
+     *
+     * @param lane the lane, in [0, W)
+     * @param triangle the triangle
+     * */
+    void set(int lane, const Triangle<T>& triangle) {
+        for (int a = 0; a < 3; ++a) {
+            v0[a][lane] = triangle.v0.raw()[a];
+            v1[a][lane] = triangle.v1.raw()[a];
+            v2[a][lane] = triangle.v2.raw()[a];
+        }
+    }
+};
+
+/**
+ * Hits of a ray against a triangle packet. Lanes whose bit is not
+ * set in mask hold unspecified values.
+ * */
+template<typename T, int W>
+struct TriangleHits {
+    unsigned int mask;      /** bit l set if triangle l is hit */
+    T t[W];                 /** distances along the ray */
+    T u[W];                 /** barycentric weights of v1 */
+    T v[W];                 /** barycentric weights of v2 */
+
+    /**
+     * The nearest hit lane.
+     *
+     * @return its index, -1 if there is no hit
+     * */
+    int nearest() const {
+        int best = -1;
+        for (int l = 0; l < W; ++l)
+            if (((mask >> l) & 1u) && (best < 0 || t[l] < t[best]))
+                best = l;
+        return best;
+    }
+};
+
+namespace kernels {
+
+/**
+ * Möller-Trumbore test of one ray against W triangles, without
+ * branches, so that the lane loop compiles to SIMD code.
+ * */
+template<typename T, int W>
+void moller_trumbore(const TrianglePacket<T, W>& tris, const Ray<T>& ray, TriangleHits<T, W>& hits) {
+    const T o0 = ray.origin.raw()[0], o1 = ray.origin.raw()[1], o2 = ray.origin.raw()[2];
+    const T d0 = ray.direction.raw()[0], d1 = ray.direction.raw()[1], d2 = ray.direction.raw()[2];
+    const T tmin = ray.tmin, tmax = ray.tmax;
+    int hit[W];
+    for (int l = 0; l < W; ++l) {
+        const T e10 = tris.v1[0][l] - tris.v0[0][l], e11 = tris.v1[1][l] - tris.v0[1][l], e12 = tris.v1[2][l] - tris.v0[2][l];
+        const T e20 = tris.v2[0][l] - tris.v0[0][l], e21 = tris.v2[1][l] - tris.v0[1][l], e22 = tris.v2[2][l] - tris.v0[2][l];
+        const T s0 = o0 - tris.v0[0][l], s1 = o1 - tris.v0[1][l], s2 = o2 - tris.v0[2][l];
+        const T p0 = d1 * e22 - d2 * e21, p1 = d2 * e20 - d0 * e22, p2 = d0 * e21 - d1 * e20;
+        const T det = e10 * p0 + e11 * p1 + e12 * p2;
+        const T inv = T(1) / det;
+        const T u = (s0 * p0 + s1 * p1 + s2 * p2) * inv;
+        const T q0 = s1 * e12 - s2 * e11, q1 = s2 * e10 - s0 * e12, q2 = s0 * e11 - s1 * e10;
+        const T v = (d0 * q0 + d1 * q1 + d2 * q2) * inv;
+        const T t = (e20 * q0 + e21 * q1 + e22 * q2) * inv;
+        hits.t[l] = t;
+        hits.u[l] = u;
+        hits.v[l] = v;
+        hit[l] = (det != T(0)) & (u >= T(0)) & (v >= T(0)) & (u + v <= T(1)) & (t >= tmin) & (t <= tmax);
+    }
+    unsigned int mask = 0;
+    for (int l = 0; l < W; ++l)
+        mask |= unsigned(hit[l]) << l;
+    hits.mask = mask;
+}
+
+/**
+ * The watertight test of Woop, Benthin and Wald (JCGT 2013): vertices
+ * are sheared into a space where the ray runs along +z, and the edge
+ * functions are evaluated there. Edge functions that round to zero in
+ * single precision are evaluated again in double precision.
+ * */
+template<typename T, int W>
+void watertight(const TrianglePacket<T, W>& tris, const Ray<T>& ray, TriangleHits<T, W>& hits) {
+    const T* o = ray.origin.raw();
+    const T* d = ray.direction.raw();
+    // the dominant axis of the direction becomes z, keeping the winding
+    int kz = 0;
+    for (int a = 1; a < 3; ++a)
+        if (std::abs(d[a]) > std::abs(d[kz]))
+            kz = a;
+    int kx = (kz + 1) % 3, ky = (kx + 1) % 3;
+    if (d[kz] < T(0))
+        std::swap(kx, ky);
+    const T sx = d[kx] / d[kz], sy = d[ky] / d[kz], sz = T(1) / d[kz];
+    const T ox = o[kx], oy = o[ky], oz = o[kz];
+    const T* v0x = tris.v0[kx];
+    const T* v0y = tris.v0[ky];
+    const T* v0z = tris.v0[kz];
+    const T* v1x = tris.v1[kx];
+    const T* v1y = tris.v1[ky];
+    const T* v1z = tris.v1[kz];
+    const T* v2x = tris.v2[kx];
+    const T* v2y = tris.v2[ky];
+    const T* v2z = tris.v2[kz];
+
+    T ax[W], ay[W], bx[W], by[W], cx[W], cy[W];
+    T eu[W], ev[W], ew[W];
+    int degenerate[W];
+    for (int l = 0; l < W; ++l) {
+        const T az = v0z[l] - oz, bz = v1z[l] - oz, cz = v2z[l] - oz;
+        ax[l] = (v0x[l] - ox) - sx * az;
+        ay[l] = (v0y[l] - oy) - sy * az;
+        bx[l] = (v1x[l] - ox) - sx * bz;
+        by[l] = (v1y[l] - oy) - sy * bz;
+        cx[l] = (v2x[l] - ox) - sx * cz;
+        cy[l] = (v2y[l] - oy) - sy * cz;
+        eu[l] = cx[l] * by[l] - cy[l] * bx[l];
+        ev[l] = ax[l] * cy[l] - ay[l] * cx[l];
+        ew[l] = bx[l] * ay[l] - by[l] * ax[l];
+        degenerate[l] = (eu[l] == T(0)) | (ev[l] == T(0)) | (ew[l] == T(0));
+    }
+    if constexpr (sizeof(T) < sizeof(double)) {
+        for (int l = 0; l < W; ++l) {
+            if (!degenerate[l])
+                continue;
+            eu[l] = T(double(cx[l]) * double(by[l]) - double(cy[l]) * double(bx[l]));
+            ev[l] = T(double(ax[l]) * double(cy[l]) - double(ay[l]) * double(cx[l]));
+            ew[l] = T(double(bx[l]) * double(ay[l]) - double(by[l]) * double(ax[l]));
+        }
+    }
+    const T tmin = ray.tmin, tmax = ray.tmax;
+    int hit[W];
+    for (int l = 0; l < W; ++l) {
+        const T az = v0z[l] - oz, bz = v1z[l] - oz, cz = v2z[l] - oz;
+        const int negative = (eu[l] < T(0)) | (ev[l] < T(0)) | (ew[l] < T(0));
+        const int positive = (eu[l] > T(0)) | (ev[l] > T(0)) | (ew[l] > T(0));
+        const T det = eu[l] + ev[l] + ew[l];
+        const T inv = T(1) / det;
+        const T t = sz * (eu[l] * az + ev[l] * bz + ew[l] * cz) * inv;
+        hits.t[l] = t;
+        hits.u[l] = ev[l] * inv;
+        hits.v[l] = ew[l] * inv;
+        hit[l] = !(negative & positive) & (det != T(0)) & (t >= tmin) & (t <= tmax);
+    }
+    unsigned int mask = 0;
+    for (int l = 0; l < W; ++l)
+        mask |= unsigned(hit[l]) << l;
+    hits.mask = mask;
+}
+
+};
+
+/**
+ * Tests one ray against W triangles.
+ *
+ * @param tris the triangles
+ * @param ray the ray
+ * @param hits receives the hit mask, distances and barycentrics
+ * @param algorithm fast or watertight
+ * */
+template<typename T, int W>
+void intersect(const TrianglePacket<T, W>& tris, const Ray<T>& ray, TriangleHits<T, W>& hits,
+        TriangleIntersection algorithm = Watertight) {
+    static_assert(W <= 32, "the hit mask holds up to 32 lanes");
+    if (algorithm == Watertight)
+        kernels::watertight(tris, ray, hits);
+    else
+        kernels::moller_trumbore(tris, ray, hits);
+}
+
+/**
+ * Tests a ray against a single triangle.
+ *
+ * @param tri the triangle
+ * @param ray the ray
+ * @param t receives the distance
+ * @param u receives the barycentric weight of v1
+ * @param v receives the barycentric weight of v2
+ * @param algorithm fast or watertight
+ * @return whether the triangle is hit within [tmin, tmax]
+ * */
+template<typename T>
+bool intersect(const Triangle<T>& tri, const Ray<T>& ray, T& t, T& u, T& v,
+        TriangleIntersection algorithm = Watertight) {
+    TrianglePacket<T, 1> packet;
+    packet.set(0, tri);
+    TriangleHits<T, 1> hits;
+    intersect(packet, ray, hits, algorithm);
+    t = hits.t[0];
+    u = hits.u[0];
+    v = hits.v[0];
+    return hits.mask != 0;
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef _TAO_BINARY_
+#define _TAO_BINARY_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "tao/linalg/Mat.h"
+#include "tao/io/MappedFile.h"
+
+/**
+ * The tao binary matrix container.
+ *
+ * A file is a 64-byte little-endian header followed by the payload:
+ *
+ *   offset  size  field
+ *   0       8     magic, "TAOMAT\0\0"
+ *   8       4     version, currently 1
+ *   12      4     byte order mark, 0x01020304 as written by the producer
+ *   16      4     element type, see tao::io::ElementType
+ *   20      4     element size in bytes
+ *   24      4     storage order, 0 row-major, 1 column-major
+ *   28      4     reserved, zero
+ *   32      8     rows
+ *   40      8     cols
+ *   48      8     stride, elements between the starts of two rows
+ *                 (of two columns when column-major)
+ *   56      8     payload offset in bytes, a multiple of 64
+ *
+ * Each row occupies stride elements, the trailing stride - cols
+ * ones being zero padding. Since the payload starts 64-byte aligned,
+ * a padded stride keeps every row aligned once the file is mapped.
+ * */
+namespace tao {
+namespace io {
+
+/**
+ * Element type codes stored in the header.
+ * */
+enum ElementType : std::uint32_t {
+    Int8 = 1, UInt8 = 2, Int16 = 3, UInt16 = 4,
+    Int32 = 5, UInt32 = 6, Int64 = 7, UInt64 = 8,
+    Float32 = 9, Float64 = 10, Float16 = 11, BrainFloat16 = 12
+};
+
+/**
+ * Order in which elements are laid out in the payload.
+ * */
+enum StorageOrder : std::uint32_t {
+    RowMajor = 0,
+    ColMajor = 1
+};
+
+/**
+ * Maps a C++ element type to its header code.
+ * */
+template<typename T> struct element_type_traits;
+template<> struct element_type_traits<std::int8_t> { static constexpr ElementType value = Int8; };
+template<> struct element_type_traits<std::uint8_t> { static constexpr ElementType value = UInt8; };
+template<> struct element_type_traits<std::int16_t> { static constexpr ElementType value = Int16; };
+template<> struct element_type_traits<std::uint16_t> { static constexpr ElementType value = UInt16; };
+template<> struct element_type_traits<std::int32_t> { static constexpr ElementType value = Int32; };
+template<> struct element_type_traits<std::uint32_t> { static constexpr ElementType value = UInt32; };
+template<> struct element_type_traits<std::int64_t> { static constexpr ElementType value = Int64; };
+template<> struct element_type_traits<std::uint64_t> { static constexpr ElementType value = UInt64; };
+template<> struct element_type_traits<float> { static constexpr ElementType value = Float32; };
+template<> struct element_type_traits<double> { static constexpr ElementType value = Float64; };
+template<> struct element_type_traits<Half> { static constexpr ElementType value = Float16; };
+template<> struct element_type_traits<BFloat16> { static constexpr ElementType value = BrainFloat16; };
+
+constexpr std::uint32_t binary_version = 1;
+constexpr std::uint32_t binary_byte_order_mark = 0x01020304;
+constexpr std::size_t binary_payload_alignment = 64;
+
+/**
+ * The header of a binary matrix file.
+ * */
+struct BinaryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t element_type;
+    std::uint32_t element_size;
+    std::uint32_t order;
+    std::uint32_t reserved;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t stride;
+    std::uint64_t offset;
+};
+
+static_assert(sizeof(BinaryHeader) == 64, "binary header must be 64 bytes");
+
+/**
+ * Builds a header for a row-major payload starting right after it.
+ *
+ * @param type the element type code
+ * @param element_size the element size in bytes
+ * @param rows number of rows
+ * @param cols number of cols
+ * @param stride the leading dimension
+ * @return the header
+ * */
+BinaryHeader make_binary_header(ElementType type, std::size_t element_size,
+        std::uint64_t rows, std::uint64_t cols, std::uint64_t stride);
+
+/**
+ * Reads and validates a header: magic, version, byte order
+ * and that the payload fits in the given size.
+ *
+ * @param bytes the start of the file
+ * @param size the file size
+ * @return the header
+ * */
+BinaryHeader read_binary_header(const unsigned char* bytes, std::size_t size);
+
+/**
+ * Streaming writer: rows are appended one at a time, so matrices
+ * larger than memory can be produced. The header is patched with
+ * the final number of rows on close.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class BinaryWriter {
+
+    private:
+
+        std::FILE* file {nullptr};      /** Output file */
+        std::vector<char> buffer;       /** stdio buffer */
+        std::string path;               /** Output path, for errors */
+        int cols {0};                   /** Number of cols */
+        int stride {0};                 /** Stored leading dimension */
+        std::uint64_t rows {0};         /** Rows written so far */
+
+    public:
+
+        /**
+         * Opens a file for writing.
+         *
+         * @param path the output path
+         * @param cols the number of cols of every row
+         * @param layout whether rows are padded to 64 bytes in the file
+         * */
+        BinaryWriter(const std::string& path, int cols, StorageLayout layout = Packed)
+            : path {path}, cols {cols} {
+            if (cols < 0)
+                throw std::invalid_argument("negative cols number " + std::to_string(cols));
+            stride = (layout == Padded) ? padded_stride<T, binary_payload_alignment>(cols) : cols;
+            file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr)
+                throw std::runtime_error("could not open " + path + " for writing");
+            buffer.resize(std::size_t(1) << 20);
+            std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+            BinaryHeader header = make_binary_header(element_type_traits<T>::value,
+                    sizeof(T), 0, cols, stride);
+            write_bytes(&header, sizeof(header));
+        }
+
+        BinaryWriter(const BinaryWriter&) = delete;
+        BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+        ~BinaryWriter() {
+            try { close(); } catch (...) {/* destructors do not throw */}
+        }
+
+        /**
+         * Appends one row.
+         *
+         * @param row pointer to cols elements
+         * */
+        void write_row(const T* row) {
+            write_rows(row, 1, cols);
+        }
+
+        /**
+         * Appends count rows that are ld elements apart.
+         *
+         * @param first pointer to the first row
+         * @param count number of rows
+         * @param ld distance between rows in elements
+         * */
+        void write_rows(const T* first, int count, int ld) {
+            if (file == nullptr)
+                throw std::logic_error("write to a closed binary writer");
+            if (ld == stride && stride == cols) {
+                write_bytes(first, sizeof(T) * std::size_t(count) * std::size_t(cols));
+            } else {
+                static const T zeros[binary_payload_alignment] = {};
+                for (int i = 0; i < count; ++i) {
+                    write_bytes(first + std::size_t(i) * ld, sizeof(T) * cols);
+                    if (stride > cols)
+                        write_bytes(zeros, sizeof(T) * (stride - cols));
+                }
+            }
+            rows += count;
+        }
+
+        /**
+         * Appends all rows of a matrix.
+         *
+         * @param mat the matrix, whose cols must match
+         * */
+        template<int M, int N>
+        void write(const Mat<T, M, N>& mat) {
+            if (mat.ncols() != cols)
+                throw std::invalid_argument("expected " + std::to_string(cols)
+                        + " cols, got " + std::to_string(mat.ncols()));
+            write_rows(mat.raw(), mat.nrows(), mat.ld());
+        }
+
+        /**
+         * Finalizes the header and closes the file.
+         * */
+        void close() {
+            if (file == nullptr)
+                return;
+            BinaryHeader header = make_binary_header(element_type_traits<T>::value,
+                    sizeof(T), rows, cols, stride);
+            std::FILE* f = file;
+            file = nullptr;
+            bool ok = std::fflush(f) == 0
+                && std::fseek(f, 0, SEEK_SET) == 0
+                && std::fwrite(&header, sizeof(header), 1, f) == 1;
+            ok = (std::fclose(f) == 0) && ok;
+            if (!ok)
+                throw std::runtime_error("could not finalize " + path);
+        }
+
+        inline std::uint64_t rows_written() const { return rows; };
+
+    private:
+
+        void write_bytes(const void* bytes, std::size_t size) {
+            if (size > 0 && std::fwrite(bytes, 1, size, file) != size)
+                throw std::runtime_error("could not write to " + path);
+        }
+};
+
+/**
+ * Saves a matrix in the binary container.
+ *
+ * @param path the output path
+ * @param mat the matrix
+ * @param layout whether rows are padded to 64 bytes in the file
+ * */
+template<typename T, int M, int N>
+void save_binary(const std::string& path, const Mat<T, M, N>& mat, StorageLayout layout = Packed) {
+    BinaryWriter<T> writer {path, mat.ncols(), layout};
+    writer.write(mat);
+    writer.close();
+}
+
+};
+
+/**
+ * A read-only or copy-on-write view of a matrix stored in the binary
+ * container. Opening costs O(1) regardless of the size: the payload
+ * is paged in on demand when elements are touched.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class MappedMat {
+
+    private:
+
+        io::MappedFile file;        /** The mapping */
+        io::BinaryHeader header;    /** Validated header */
+        const T* first {nullptr};   /** First element of the payload */
+
+    public:
+
+        /**
+         * Maps a binary matrix file.
+         *
+         * @param path the file path
+         * @param mode read-only or copy-on-write
+         * */
+        MappedMat(const std::string& path, io::MapMode mode = io::ReadOnly) : file {path, mode} {
+            header = io::read_binary_header(file.data(), file.size());
+            if (header.element_type != io::element_type_traits<T>::value || header.element_size != sizeof(T))
+                throw std::invalid_argument("element type mismatch in " + path);
+            first = reinterpret_cast<const T*>(file.data() + header.offset);
+        }
+
+        inline int nrows() const { return static_cast<int>(header.rows); };
+        inline int ncols() const { return static_cast<int>(header.cols); };
+        inline int ld() const { return static_cast<int>(header.stride); };
+        inline io::StorageOrder order() const { return static_cast<io::StorageOrder>(header.order); };
+
+        /**
+         * Row-column read-only access operator.
+         *
+         * @param row the row, starting at top
+         * @param col the col, starting at left
+         * @return the element at row and col
+         * */
+        T operator()(int row, int col=0) const {
+            return first[index(row, col)];
+        }
+
+        /**
+         * Row-column set access, only for copy-on-write mappings.
+         *
+         * @param row the row, starting at top
+         * @param col the col, starting at left
+         * */
+        T& ref(int row, int col=0) {
+            return mutable_raw()[index(row, col)];
+        }
+
+        inline const T* raw() const { return first; };
+
+        /**
+         * Writable pointer to the payload, only for copy-on-write mappings.
+         *
+         * @return the first element
+         * */
+        inline T* mutable_raw() { return reinterpret_cast<T*>(file.mutable_data() + header.offset); };
+
+        /**
+         * Hints the kernel about how the payload will be read.
+         *
+         * @param access the access pattern
+         * */
+        void advise(io::MapAccess access) const {
+            file.advise(access, header.offset);
+        }
+
+        /**
+         * Copies the view into an owning row-major matrix.
+         *
+         * @param layout the layout of the result
+         * @return the matrix
+         * */
+        Mat<T, Dynamic, Dynamic> to_mat(StorageLayout layout = Packed) const {
+            Mat<T, Dynamic, Dynamic> mat (nrows(), ncols(), layout);
+            T* dst = mat.raw();
+            if (order() == io::RowMajor) {
+                for (int i = 0; i < nrows(); ++i)
+                    std::memcpy(dst + std::size_t(i) * mat.ld(), first + std::size_t(i) * ld(), sizeof(T) * ncols());
+            } else {
+                for (int j = 0; j < ncols(); ++j)
+                    for (int i = 0; i < nrows(); ++i)
+                        dst[std::size_t(i) * mat.ld() + j] = first[std::size_t(j) * ld() + i];
+            }
+            return mat;
+        }
+
+    private:
+
+        std::size_t index(int row, int col) const {
+            if (row < 0 || row >= nrows())
+                throw std::invalid_argument("invalid row access, when rows are " + std::to_string(nrows())
+                        + " and row is " + std::to_string(row));
+            if (col < 0 || col >= ncols())
+                throw std::invalid_argument("invalid col access, when cols are " + std::to_string(ncols())
+                        + " and col is " + std::to_string(col));
+            if (order() == io::RowMajor)
+                return std::size_t(row) * header.stride + col;
+            return std::size_t(col) * header.stride + row;
+        }
+};
+
+namespace io {
+
+/**
+ * Loads a binary matrix into memory.
+ *
+ * @param path the file path
+ * @return the matrix
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> load_binary(const std::string& path) {
+    MappedMat<T> view {path};
+    view.advise(Sequential);
+    return view.to_mat();
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef _TAO_MAPPED_FILE_
+#define _TAO_MAPPED_FILE_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace tao {
+namespace io {
+
+/**
+ * How a file is mapped into memory.
+ * */
+enum MapMode {
+    ReadOnly = 0,       /** pages are shared with the file and cannot be written */
+    CopyOnWrite = 1     /** writes go to private copies of the touched pages */
+};
+
+/**
+ * Expected access pattern, forwarded to the kernel as a hint.
+ * */
+enum MapAccess {
+    Normal = 0,
+    Sequential = 1,
+    Random = 2,
+    WillNeed = 3
+};
+
+/**
+ * A whole file mapped into memory. Mapping is O(1):
+ * pages are brought in on demand when first touched.
+ *
+ * @author Vitor Greati
+ * */
+class MappedFile {
+
+    private:
+
+        unsigned char* base {nullptr};  /** First byte of the mapping */
+        std::size_t length {0};         /** Size of the mapping in bytes */
+        MapMode mode {ReadOnly};        /** Mapping mode */
+
+    public:
+
+        MappedFile() {/* empty */}
+
+        /**
+         * Maps a file.
+         *
+         * @param path the file path
+         * @param mode read-only or copy-on-write
+         * */
+        MappedFile(const std::string& path, MapMode mode = ReadOnly);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        /**
+         * Hints the kernel about how a byte range will be read.
+         *
+         * @param access the access pattern
+         * @param offset first byte of the range
+         * @param size size of the range, 0 meaning up to the end
+         * */
+        void advise(MapAccess access, std::size_t offset = 0, std::size_t size = 0) const;
+
+        inline const unsigned char* data() const { return base; };
+
+        /**
+         * Writable pointer to the mapping, only for copy-on-write
+         * mappings: read-only pages fault when written.
+         *
+         * @return the first byte
+         * */
+        unsigned char* mutable_data() {
+            if (mode != CopyOnWrite)
+                throw std::logic_error("file mapped read-only");
+            return base;
+        }
+
+        inline std::size_t size() const { return length; };
+        inline MapMode map_mode() const { return mode; };
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef _TAO_NPY_
+#define _TAO_NPY_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "tao/linalg/Mat.h"
+#include "tao/linalg/Transpose.h"
+#include "tao/linalg/dyn/Mat.h"
+#include "tao/io/MappedFile.h"
+
+/**
+ * Reading and writing of NumPy .npy files and uncompressed .npz archives.
+ *
+ * Arrays are mapped, not read: a view costs O(1) to open and
+ * copying it into a matrix is a memcpy per row, or a blocked
+ * transpose when the array is stored in Fortran order.
+ * */
+namespace tao {
+namespace io {
+
+/**
+ * NumPy type descriptor of an element type.
+ * */
+template<typename T> struct npy_descr;
+template<> struct npy_descr<std::int8_t> { static constexpr const char* value = "|i1"; };
+template<> struct npy_descr<std::uint8_t> { static constexpr const char* value = "|u1"; };
+template<> struct npy_descr<std::int16_t> { static constexpr const char* value = "<i2"; };
+template<> struct npy_descr<std::uint16_t> { static constexpr const char* value = "<u2"; };
+template<> struct npy_descr<std::int32_t> { static constexpr const char* value = "<i4"; };
+template<> struct npy_descr<std::uint32_t> { static constexpr const char* value = "<u4"; };
+template<> struct npy_descr<std::int64_t> { static constexpr const char* value = "<i8"; };
+template<> struct npy_descr<std::uint64_t> { static constexpr const char* value = "<u8"; };
+template<> struct npy_descr<float> { static constexpr const char* value = "<f4"; };
+template<> struct npy_descr<double> { static constexpr const char* value = "<f8"; };
+template<> struct npy_descr<Half> { static constexpr const char* value = "<f2"; };
+
+/**
+ * A parsed .npy header.
+ * */
+struct NpyHeader {
+    std::string descr;                  /** NumPy type descriptor */
+    bool fortran_order {false};         /** Column-major data */
+    std::vector<std::uint64_t> shape;   /** Dimensions */
+    std::size_t data_offset {0};        /** Offset of the data from the start of the .npy */
+};
+
+/**
+ * Parses and validates the header of a .npy held in memory.
+ *
+ * @param bytes start of the .npy
+ * @param size size of the .npy in bytes
+ * @return the header
+ * */
+NpyHeader parse_npy_header(const unsigned char* bytes, std::size_t size);
+
+/**
+ * Checks that a descriptor matches the expected one, accepting
+ * the native byte order mark in place of little endian.
+ *
+ * @param found the descriptor in the file
+ * @param expected the descriptor of the element type
+ * */
+void check_npy_descr(const std::string& found, const char* expected);
+
+/**
+ * Interprets a shape as a matrix: () is 1x1, (n,) a column of n
+ * elements, (m, n) an m x n matrix. Other ranks are rejected.
+ *
+ * @param shape the shape
+ * @return rows and cols
+ * */
+std::pair<int, int> npy_matrix_shape(const std::vector<std::uint64_t>& shape);
+
+/**
+ * Builds the header of a 2-D C-ordered .npy, padded so that the
+ * data starts 64-byte aligned relative to the start of the file.
+ *
+ * @param descr the type descriptor
+ * @param rows number of rows
+ * @param cols number of cols
+ * @return the header bytes, magic included
+ * */
+std::string make_npy_header(const char* descr, std::uint64_t rows, std::uint64_t cols);
+
+/**
+ * CRC-32 as used by zip, continued from a previous value.
+ *
+ * @param crc the previous value, 0 to start
+ * @param bytes the data
+ * @param size the number of bytes
+ * @return the updated CRC
+ * */
+std::uint32_t crc32(std::uint32_t crc, const void* bytes, std::size_t size);
+
+/**
+ * Writes a whole .npy to a file, row by row.
+ *
+ * @param path the output path
+ * @param descr the type descriptor
+ * @param rows number of rows
+ * @param cols number of cols
+ * @param first first element, row-major
+ * @param ld distance between rows in elements
+ * @param element_size size of an element in bytes
+ * */
+void write_npy(const std::string& path, const char* descr, int rows, int cols,
+        const void* first, int ld, std::size_t element_size);
+
+};
+
+/**
+ * A zero-copy view of an array stored in a .npy file or
+ * in an uncompressed entry of a .npz archive.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class NpyView {
+
+    private:
+
+        std::shared_ptr<const io::MappedFile> file;     /** Keeps the mapping alive */
+        const unsigned char* first {nullptr};           /** First byte of the data */
+        int rows {0};                                   /** Number of rows */
+        int cols {0};                                   /** Number of cols */
+        bool fortran {false};                           /** Column-major data */
+
+    public:
+
+        /**
+         * Maps a .npy file.
+         *
+         * @param path the file path
+         * */
+        NpyView(const std::string& path)
+            : NpyView(std::make_shared<const io::MappedFile>(path), 0, 0) {/* empty */}
+
+        /**
+         * Views a .npy embedded at some offset of a mapping.
+         *
+         * @param file the mapping
+         * @param offset start of the .npy within the mapping
+         * @param size size of the .npy, 0 meaning up to the end
+         * */
+        NpyView(std::shared_ptr<const io::MappedFile> file, std::size_t offset, std::size_t size)
+            : file {std::move(file)} {
+            const io::MappedFile& f = *this->file;
+            if (offset > f.size())
+                throw std::invalid_argument("npy offset past the end of the file");
+            if (size == 0 || offset + size > f.size())
+                size = f.size() - offset;
+            io::NpyHeader header = io::parse_npy_header(f.data() + offset, size);
+            io::check_npy_descr(header.descr, io::npy_descr<T>::value);
+            auto [r, c] = io::npy_matrix_shape(header.shape);
+            if ((size - header.data_offset) / sizeof(T) / std::max(1, c) < std::size_t(r))
+                throw std::invalid_argument("truncated npy data");
+            rows = r;
+            cols = c;
+            fortran = header.fortran_order;
+            first = f.data() + offset + header.data_offset;
+        }
+
+        inline int nrows() const { return rows; };
+        inline int ncols() const { return cols; };
+        inline bool fortran_order() const { return fortran; };
+
+        /**
+         * Whether the data is aligned for T. It always is for .npy files
+         * and for archives written by tao, but other zip writers may
+         * place entries at arbitrary offsets.
+         *
+         * @return true if raw() may be dereferenced
+         * */
+        inline bool aligned() const { return is_aligned(first, alignof(T)); };
+
+        /**
+         * The data, row-major or, if fortran_order(), column-major.
+         * Only dereferenceable when aligned().
+         *
+         * @return the first element
+         * */
+        inline const T* raw() const { return reinterpret_cast<const T*>(first); };
+
+        /**
+         * Row-column read-only access operator.
+         *
+         * @param row the row, starting at top
+         * @param col the col, starting at left
+         * @return the element at row and col
+         * */
+        T operator()(int row, int col=0) const {
+            if (row < 0 || row >= rows)
+                throw std::invalid_argument("invalid row access, when rows are " + std::to_string(rows)
+                        + " and row is " + std::to_string(row));
+            if (col < 0 || col >= cols)
+                throw std::invalid_argument("invalid col access, when cols are " + std::to_string(cols)
+                        + " and col is " + std::to_string(col));
+            std::size_t i = fortran ? std::size_t(col) * rows + row : std::size_t(row) * cols + col;
+            T value;
+            std::memcpy(&value, first + i * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        /**
+         * Copies the array into row-major storage.
+         *
+         * @param dst the destination
+         * @param ldd distance between rows of the destination
+         * */
+        void copy_to(T* dst, int ldd) const {
+            if (!fortran) {
+                if (ldd == cols) {
+                    std::memcpy(dst, first, sizeof(T) * std::size_t(rows) * cols);
+                } else {
+                    for (int i = 0; i < rows; ++i)
+                        std::memcpy(dst + std::size_t(i) * ldd, first + std::size_t(i) * cols * sizeof(T), sizeof(T) * cols);
+                }
+            } else if (aligned()) {
+                tao::transpose(raw(), cols, rows, rows, dst, ldd);
+            } else {
+                aligned_buffer<T> staging (std::size_t(rows) * cols);
+                std::memcpy(staging.data(), first, sizeof(T) * staging.size());
+                tao::transpose(staging.data(), cols, rows, rows, dst, ldd);
+            }
+        }
+
+        /**
+         * Copies the view into an owning matrix.
+         *
+         * @param layout the layout of the result
+         * @return the matrix
+         * */
+        Mat<T, Dynamic, Dynamic> to_mat(StorageLayout layout = Packed) const {
+            Mat<T, Dynamic, Dynamic> mat (rows, cols, layout);
+            copy_to(mat.raw(), mat.ld());
+            return mat;
+        }
+};
+
+namespace io {
+
+/**
+ * Loads a .npy into a matrix.
+ *
+ * @param path the file path
+ * @return the matrix
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> load_npy(const std::string& path) {
+    NpyView<T> view {path};
+    return view.to_mat();
+}
+
+/**
+ * Loads a .npy into a deprecated dynamic matrix.
+ *
+ * @param path the file path
+ * @param mat the destination, resized to the array shape
+ * */
+template<typename T>
+void load_npy(const std::string& path, tao::deprecated::Mat<T>& mat) {
+    NpyView<T> view {path};
+    mat = tao::deprecated::Mat<T>(view.nrows(), view.ncols());
+    view.copy_to(mat.raw(), mat.ncols());
+}
+
+/**
+ * Saves a matrix as a 2-D C-ordered .npy.
+ *
+ * @param path the output path
+ * @param mat the matrix
+ * */
+template<typename T, int M, int N>
+void save_npy(const std::string& path, const Mat<T, M, N>& mat) {
+    write_npy(path, npy_descr<T>::value, mat.nrows(), mat.ncols(), mat.raw(), mat.ld(), sizeof(T));
+}
+
+/**
+ * Saves a deprecated dynamic matrix as a 2-D C-ordered .npy.
+ *
+ * @param path the output path
+ * @param mat the matrix
+ * */
+template<typename T>
+void save_npy(const std::string& path, const tao::deprecated::Mat<T>& mat) {
+    write_npy(path, npy_descr<T>::value, mat.nrows(), mat.ncols(), mat.raw(), mat.ncols(), sizeof(T));
+}
+
+/**
+ * An uncompressed .npz archive, mapped once and shared
+ * by the views of its arrays.
+ *
+ * @author Vitor Greati
+ * */
+class NpzArchive {
+
+    private:
+
+        /** Location of an array within the archive */
+        struct Entry {
+            std::size_t offset;     /** Start of the .npy */
+            std::size_t size;       /** Size of the .npy */
+            bool stored;            /** Whether the entry is uncompressed */
+        };
+
+        std::shared_ptr<const MappedFile> file;     /** The mapping */
+        std::map<std::string, Entry> entries;       /** Arrays by name, without .npy */
+
+    public:
+
+        /**
+         * Maps an archive and reads its central directory.
+         *
+         * @param path the file path
+         * */
+        NpzArchive(const std::string& path);
+
+        /**
+         * The names of the arrays, sorted.
+         *
+         * @return the names
+         * */
+        std::vector<std::string> names() const;
+
+        inline bool contains(const std::string& name) const { return entries.count(name) > 0; };
+
+        /**
+         * A zero-copy view of an array.
+         *
+         * @param name the array name
+         * @return the view
+         * */
+        template<typename T>
+        NpyView<T> view(const std::string& name) const {
+            const Entry& e = entry(name);
+            return NpyView<T>(file, e.offset, e.size);
+        }
+
+        /**
+         * Loads an array into a matrix.
+         *
+         * @param name the array name
+         * @return the matrix
+         * */
+        template<typename T>
+        Mat<T, Dynamic, Dynamic> load(const std::string& name) const {
+            return view<T>(name).to_mat();
+        }
+
+    private:
+
+        const Entry& entry(const std::string& name) const;
+};
+
+/**
+ * Writes an uncompressed .npz archive, one array at a time. Every
+ * array starts 64-byte aligned in the file, so views of the
+ * archive are always aligned. Zip64 records are emitted as needed.
+ *
+ * @author Vitor Greati
+ * */
+class NpzWriter {
+
+    private:
+
+        /** An array already written */
+        struct Entry {
+            std::string name;           /** File name within the archive */
+            std::uint32_t crc;          /** CRC-32 of the .npy */
+            std::uint64_t size;         /** Size of the .npy */
+            std::uint64_t offset;       /** Offset of the local header */
+        };
+
+        std::FILE* file {nullptr};      /** Output file */
+        std::vector<char> buffer;       /** stdio buffer */
+        std::string path;               /** Output path, for errors */
+        std::vector<Entry> entries;     /** Arrays written so far */
+        std::uint64_t position {0};     /** Bytes written so far */
+
+    public:
+
+        /**
+         * Opens an archive for writing.
+         *
+         * @param path the output path
+         * */
+        NpzWriter(const std::string& path);
+
+        NpzWriter(const NpzWriter&) = delete;
+        NpzWriter& operator=(const NpzWriter&) = delete;
+
+        ~NpzWriter();
+
+        /**
+         * Adds a matrix as name.npy.
+         *
+         * @param name the array name
+         * @param mat the matrix
+         * */
+        template<typename T, int M, int N>
+        void add(const std::string& name, const Mat<T, M, N>& mat) {
+            add_array(name, npy_descr<T>::value, mat.nrows(), mat.ncols(), mat.raw(), mat.ld(), sizeof(T));
+        }
+
+        /**
+         * Adds a deprecated dynamic matrix as name.npy.
+         *
+         * @param name the array name
+         * @param mat the matrix
+         * */
+        template<typename T>
+        void add(const std::string& name, const tao::deprecated::Mat<T>& mat) {
+            add_array(name, npy_descr<T>::value, mat.nrows(), mat.ncols(), mat.raw(), mat.ncols(), sizeof(T));
+        }
+
+        /**
+         * Writes the central directory and closes the file.
+         * */
+        void close();
+
+    private:
+
+        void add_array(const std::string& name, const char* descr, int rows, int cols,
+                const void* first, int ld, std::size_t element_size);
+
+        void write_bytes(const void* bytes, std::size_t size);
+};
+
+};
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef _TAO_TEXT_
+#define _TAO_TEXT_
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include "tao/linalg/Mat.h"
+#include "tao/io/MappedFile.h"
+#include "tao/parallel/Parallel.h"
+
+/**
+ * Text serialization of matrices, one row per line.
+ *
+ * Values are written with std::to_chars, which gives the shortest
+ * representation that reads back to the same value, and read with
+ * std::from_chars, straight from contiguous buffers: no locale, no
+ * streams. Big inputs are split at line boundaries and parsed in
+ * parallel, directly into the rows of the result.
+ * */
+namespace tao {
+namespace io {
+
+/**
+ * How values are separated within a line.
+ * */
+enum TextDialect {
+    Whitespace = 0,     /** any run of spaces and tabs */
+    Csv = 1,            /** commas, optionally surrounded by spaces */
+    Tsv = 2             /** tabs, optionally surrounded by spaces */
+};
+
+/**
+ * Inputs smaller than this are parsed by the calling thread only.
+ * */
+constexpr std::size_t text_parallel_threshold = std::size_t(1) << 20;
+
+/**
+ * Splits a buffer into about chunks pieces, each starting at
+ * the beginning of a line.
+ *
+ * @param first start of the buffer
+ * @param last end of the buffer
+ * @param chunks the desired number of pieces
+ * @return chunk boundaries, first and last included
+ * */
+std::vector<const char*> split_lines(const char* first, const char* last, std::size_t chunks);
+
+/**
+ * Counts the lines that are not blank, see is_blank_line.
+ *
+ * @param first start of the buffer
+ * @param last end of the buffer
+ * @return the number of rows
+ * */
+std::size_t count_rows(const char* first, const char* last);
+
+/**
+ * Counts the values in the first non-blank line.
+ *
+ * @param first start of the buffer
+ * @param last end of the buffer
+ * @param dialect the separator rules
+ * @return the number of cols, 0 if there is no such line
+ * */
+int count_fields(const char* first, const char* last, TextDialect dialect);
+
+/**
+ * The separator written between values.
+ *
+ * @param dialect the dialect
+ * @return the separator
+ * */
+inline char delimiter_of(TextDialect dialect) {
+    return dialect == Csv ? ',' : (dialect == Tsv ? '\t' : ' ');
+}
+
+/**
+ * Whether a character may pad a value.
+ *
+ * @param c the character
+ * @param dialect the dialect
+ * @return true for blanks that are not separators
+ * */
+inline bool is_blank(char c, TextDialect dialect) {
+    return c == ' ' || c == '\r' || (c == '\t' && dialect != Tsv);
+}
+
+/**
+ * Whether a line only holds spaces, tabs and carriage returns, in
+ * which case it is skipped, whatever the dialect: a tab alone is not
+ * a row of empty TSV values.
+ *
+ * @param p start of the line
+ * @param eol end of the line, excluding the newline
+ * @return true for blank lines
+ * */
+inline bool is_blank_line(const char* p, const char* eol) {
+    while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    return p == eol;
+}
+
+/**
+ * Parses the values of one line into a row.
+ *
+ * @param p start of the line
+ * @param eol end of the line, excluding the newline
+ * @param dialect the separator rules
+ * @param row the destination
+ * @param cols the expected number of values
+ * @param index the row index, for errors
+ * */
+template<typename T>
+void parse_line(const char* p, const char* eol, TextDialect dialect, T* row, int cols, std::size_t index) {
+    const char delimiter = delimiter_of(dialect);
+    for (int j = 0; j < cols; ++j) {
+        while (p < eol && is_blank(*p, dialect))
+            ++p;
+        if (p < eol && *p == '+')
+            ++p;
+        auto [next, ec] = std::from_chars(p, eol, row[j]);
+        if (ec != std::errc() || next == p)
+            throw std::invalid_argument("invalid value at row " + std::to_string(index)
+                    + ", col " + std::to_string(j));
+        p = next;
+        const char* value_end = p;
+        while (p < eol && is_blank(*p, dialect))
+            ++p;
+        if (j + 1 < cols) {
+            if (dialect == Whitespace) {
+                if (p == value_end || p == eol)
+                    throw std::invalid_argument("expected " + std::to_string(cols)
+                            + " values at row " + std::to_string(index));
+            } else {
+                if (p == eol || *p != delimiter)
+                    throw std::invalid_argument("expected " + std::to_string(cols)
+                            + " values at row " + std::to_string(index));
+                ++p;
+            }
+        }
+    }
+    if (p != eol)
+        throw std::invalid_argument("expected " + std::to_string(cols)
+                + " values at row " + std::to_string(index));
+}
+
+/**
+ * Parses every line of [first, last) that is not blank, see
+ * is_blank_line, into consecutive rows.
+ *
+ * @param first start of the buffer
+ * @param last end of the buffer
+ * @param dialect the separator rules
+ * @param dst the first row
+ * @param ld distance between rows of the destination
+ * @param cols the expected number of values per row
+ * @param index index of the first row, for errors
+ * */
+template<typename T>
+void parse_rows(const char* first, const char* last, TextDialect dialect,
+        T* dst, int ld, int cols, std::size_t index) {
+    const char* p = first;
+    while (p < last) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', last - p));
+        const char* eol = nl ? nl : last;
+        if (!is_blank_line(p, eol)) {
+            parse_line(p, eol, dialect, dst, cols, index);
+            dst += ld;
+            ++index;
+        }
+        p = nl ? nl + 1 : last;
+    }
+}
+
+/**
+ * Parses a matrix from a buffer, in parallel when it is big.
+ * Blank lines are skipped; every other line must have the
+ * same number of values as the first one.
+ *
+ * @param first start of the buffer
+ * @param last end of the buffer
+ * @param dialect the separator rules
+ * @return the matrix
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> parse_text(const char* first, const char* last, TextDialect dialect = Whitespace) {
+    static_assert(std::is_arithmetic<T>::value, "text parsing needs an arithmetic type");
+    std::size_t chunks = 1;
+    if (std::size_t(last - first) >= text_parallel_threshold)
+        chunks = std::size_t(parallel::concurrency()) * 4;
+    std::vector<const char*> bounds = split_lines(first, last, chunks);
+    chunks = bounds.size() - 1;
+
+    std::vector<std::size_t> offsets (chunks + 1, 0);
+    parallel::parallel_for(0, chunks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t c = lo; c < hi; ++c)
+            offsets[c + 1] = count_rows(bounds[c], bounds[c + 1]);
+    });
+    for (std::size_t c = 0; c < chunks; ++c)
+        offsets[c + 1] += offsets[c];
+
+    int cols = count_fields(first, last, dialect);
+    if (offsets[chunks] > std::size_t(INT32_MAX))
+        throw std::invalid_argument("too many rows for int indices");
+    Mat<T, Dynamic, Dynamic> mat (static_cast<int>(offsets[chunks]), cols);
+    T* dst = mat.raw();
+    int ld = mat.ld();
+    parallel::parallel_for(0, chunks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t c = lo; c < hi; ++c)
+            parse_rows(bounds[c], bounds[c + 1], dialect, dst + offsets[c] * ld, ld, cols, offsets[c]);
+    });
+    return mat;
+}
+
+/**
+ * Parses a matrix from a string.
+ *
+ * @param text the text
+ * @param dialect the separator rules
+ * @return the matrix
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> parse_text(const std::string& text, TextDialect dialect = Whitespace) {
+    return parse_text<T>(text.data(), text.data() + text.size(), dialect);
+}
+
+/**
+ * Loads a matrix from a text file, mapped rather than read.
+ *
+ * @param path the file path
+ * @param dialect the separator rules
+ * @return the matrix
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> load_text(const std::string& path, TextDialect dialect = Whitespace) {
+    MappedFile file {path};
+    file.advise(Sequential);
+    const char* first = reinterpret_cast<const char*>(file.data());
+    return parse_text<T>(first, first + file.size(), dialect);
+}
+
+/**
+ * Appends one row to a buffer, followed by a newline.
+ *
+ * @param out the buffer
+ * @param row the values
+ * @param cols the number of values
+ * @param dialect the separator rules
+ * */
+template<typename T>
+void format_row(std::string& out, const T* row, int cols, TextDialect dialect) {
+    const char delimiter = delimiter_of(dialect);
+    char value[64];
+    for (int j = 0; j < cols; ++j) {
+        auto [end, ec] = std::to_chars(value, value + sizeof(value), row[j]);
+        if (ec != std::errc())
+            throw std::invalid_argument("could not format value at col " + std::to_string(j));
+        out.append(value, end);
+        out.push_back(j + 1 < cols ? delimiter : '\n');
+    }
+    if (cols == 0)
+        out.push_back('\n');
+}
+
+/**
+ * Appends a matrix to a buffer, one row per line.
+ *
+ * @param out the buffer
+ * @param mat the matrix
+ * @param dialect the separator rules
+ * */
+template<typename T, int M, int N>
+void format_text(std::string& out, const Mat<T, M, N>& mat, TextDialect dialect = Whitespace) {
+    const T* src = mat.raw();
+    for (int i = 0; i < mat.nrows(); ++i)
+        format_row(out, src + std::size_t(i) * mat.ld(), mat.ncols(), dialect);
+}
+
+/**
+ * Formats a matrix, one row per line.
+ *
+ * @param mat the matrix
+ * @param dialect the separator rules
+ * @return the text
+ * */
+template<typename T, int M, int N>
+std::string to_text(const Mat<T, M, N>& mat, TextDialect dialect = Whitespace) {
+    std::string out;
+    out.reserve(std::size_t(mat.nrows()) * mat.ncols() * 12);
+    format_text(out, mat, dialect);
+    return out;
+}
+
+/**
+ * Saves a matrix as text, formatting into a buffer that is
+ * written whenever it grows past 1 MB.
+ *
+ * @param path the output path
+ * @param mat the matrix
+ * @param dialect the separator rules
+ * */
+template<typename T, int M, int N>
+void save_text(const std::string& path, const Mat<T, M, N>& mat, TextDialect dialect = Whitespace) {
+    constexpr std::size_t flush_size = std::size_t(1) << 20;
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr)
+        throw std::runtime_error("could not open " + path + " for writing");
+    std::string buffer;
+    buffer.reserve(flush_size + 4096);
+    bool ok = true;
+    const T* src = mat.raw();
+    for (int i = 0; ok && i < mat.nrows(); ++i) {
+        format_row(buffer, src + std::size_t(i) * mat.ld(), mat.ncols(), dialect);
+        if (buffer.size() >= flush_size) {
+            ok = std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+            buffer.clear();
+        }
+    }
+    if (ok && !buffer.empty())
+        ok = std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok)
+        throw std::runtime_error("could not write " + path);
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef _TAO_BACKEND_
+#define _TAO_BACKEND_
+
+#include <cstddef>
+#include <type_traits>
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace backend {
+
+/**
+ * Sizes, in multiply-adds, from which products go to the backend.
+ * The native kernels win below: they skip the call overhead and the
+ * backend threads, and their results do not depend on the threads.
+ * */
+struct Thresholds {
+    std::size_t gemm;   /** m n k of a matrix product */
+    std::size_t gemv;   /** m n of a matrix-vector product */
+};
+
+/**
+ * Thresholds used until set_thresholds: products from 32^3 and
+ * 64 x 64. With OpenBLAS on x86-64, backend_bench finds the backend
+ * faster from 16^3 and 16 x 16 already; the margin keeps fixed-size
+ * products, and others that fit in L1, inline.
+ * */
+constexpr Thresholds default_thresholds {std::size_t(1) << 15, std::size_t(1) << 12};
+
+/**
+ * Whether the library was built with an external BLAS, which must
+ * provide the CBLAS interface: configure with TAO_BLAS_BACKEND=ON,
+ * and BLA_VENDOR to choose among those installed.
+ *
+ * @return true if products can be routed
+ * */
+bool available();
+
+/**
+ * Whether large products go to the backend, when it is available.
+ *
+ * @return true by default
+ * */
+bool enabled();
+
+/**
+ * Routes large products to the backend, or keeps everything native.
+ *
+ * @param on whether to use the backend
+ * */
+void set_enabled(bool on);
+
+/**
+ * The current crossover sizes.
+ *
+ * @return the thresholds
+ * */
+Thresholds thresholds();
+
+/**
+ * Changes the crossover sizes, as measured by backend_bench.
+ *
+ * @param t the thresholds
+ * */
+void set_thresholds(const Thresholds& t);
+
+/**
+ * Row-major C = alpha A B + beta C on the backend, for the types
+ * it supports; see kernels::gemm for the arguments.
+ * */
+void gemm(int m, int n, int k, float alpha, const float* a, int lda, const float* b, int ldb,
+        float beta, float* c, int ldc);
+void gemm(int m, int n, int k, double alpha, const double* a, int lda, const double* b, int ldb,
+        double beta, double* c, int ldc);
+
+/**
+ * Row-major y = alpha A x + beta y on the backend, A being m x n.
+ * */
+void gemv(int m, int n, float alpha, const float* a, int lda, const float* x, int incx,
+        float beta, float* y, int incy);
+void gemv(int m, int n, double alpha, const double* a, int lda, const double* x, int incx,
+        double beta, double* y, int incy);
+
+/**
+ * Whether the backend has routines for elements of type T.
+ * */
+template<typename T>
+constexpr bool supports_v = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+/**
+ * Whether a product of this size goes to the backend. Never in
+ * deterministic mode, since backends do not promise results that
+ * are the same on any number of threads.
+ *
+ * @param size the multiply-adds of the product
+ * @param threshold the crossover for this kind of product
+ * @return true to call the backend
+ * */
+template<typename T>
+bool routes(std::size_t size, std::size_t threshold) {
+    if constexpr (supports_v<T>)
+        return size >= threshold && available() && enabled() && !parallel::deterministic();
+    else
+        return false;
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef _TAO_BATCH_
+#define _TAO_BATCH_
+
+#include <algorithm>
+#include <cstddef>
+#include "tao/linalg/Mat.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * Matrices per block of the batched operations, one per lane.
+ * */
+constexpr int batch_lanes = 8;
+
+/**
+ * Blocks per task of the batched operations.
+ * */
+constexpr std::size_t batch_grain = std::size_t(1) << 9;
+
+namespace kernels {
+
+/**
+ * Interleaves up to W matrices as a[row * C + col][lane], so that
+ * the lanes of an element are contiguous. Missing lanes are
+ * identities.
+ *
+ * @param m the matrices
+ * @param count how many, at most W
+ * @param a the interleaved elements
+ * */
+template<typename T, int R, int C, int W>
+void interleave(const Mat<T, R, C>* m, int count, T a[R * C][W]) {
+    for (int l = 0; l < W; ++l) {
+        if (l < count) {
+            const T* row = m[l].raw();
+            const int ld = m[l].ld();
+            for (int i = 0; i < R; ++i)
+                for (int j = 0; j < C; ++j)
+                    a[i * C + j][l] = row[i * ld + j];
+        } else {
+            for (int i = 0; i < R; ++i)
+                for (int j = 0; j < C; ++j)
+                    a[i * C + j][l] = T(i == j);
+        }
+    }
+}
+
+/**
+ * Writes back the first count lanes of interleaved matrices.
+ *
+ * @param a the interleaved elements
+ * @param count how many
+ * @param m the matrices
+ * */
+template<typename T, int R, int C, int W>
+void deinterleave(const T a[R * C][W], int count, Mat<T, R, C>* m) {
+    for (int l = 0; l < count; ++l) {
+        T* row = m[l].raw();
+        const int ld = m[l].ld();
+        for (int i = 0; i < R; ++i)
+            for (int j = 0; j < C; ++j)
+                row[i * ld + j] = a[i * C + j][l];
+    }
+}
+
+/**
+ * Determinants and adjugates of interleaved N x N matrices, N in
+ * 2..4, by cofactors; the 4 x 4 case shares the 2 x 2 minors of the
+ * top and bottom row pairs. Each lane is straight-line code, so that
+ * the loop over lanes vectorizes.
+ *
+ * @param a the matrices
+ * @param det receives the determinants
+ * @param adj receives the adjugates, unless null
+ * */
+template<typename T, int N, int W>
+void adjugate_block(const T a[N * N][W], T det[W], T (*adj)[W]) {
+    static_assert(N >= 2 && N <= 4, "cofactor kernels are for 2x2 to 4x4 matrices");
+    if constexpr (N == 2) {
+        for (int l = 0; l < W; ++l) {
+            det[l] = a[0][l] * a[3][l] - a[1][l] * a[2][l];
+            if (adj) {
+                const T a0 = a[0][l], a1 = a[1][l], a2 = a[2][l], a3 = a[3][l];
+                adj[0][l] = a3;
+                adj[1][l] = -a1;
+                adj[2][l] = -a2;
+                adj[3][l] = a0;
+            }
+        }
+    } else if constexpr (N == 3) {
+        for (int l = 0; l < W; ++l) {
+            const T a0 = a[0][l], a1 = a[1][l], a2 = a[2][l];
+            const T a3 = a[3][l], a4 = a[4][l], a5 = a[5][l];
+            const T a6 = a[6][l], a7 = a[7][l], a8 = a[8][l];
+            const T c0 = a4 * a8 - a5 * a7, c1 = a5 * a6 - a3 * a8, c2 = a3 * a7 - a4 * a6;
+            det[l] = a0 * c0 + a1 * c1 + a2 * c2;
+            if (adj) {
+                adj[0][l] = c0;
+                adj[1][l] = a2 * a7 - a1 * a8;
+                adj[2][l] = a1 * a5 - a2 * a4;
+                adj[3][l] = c1;
+                adj[4][l] = a0 * a8 - a2 * a6;
+                adj[5][l] = a2 * a3 - a0 * a5;
+                adj[6][l] = c2;
+                adj[7][l] = a1 * a6 - a0 * a7;
+                adj[8][l] = a0 * a4 - a1 * a3;
+            }
+        }
+    } else {
+        for (int l = 0; l < W; ++l) {
+            const T a00 = a[0][l], a01 = a[1][l], a02 = a[2][l], a03 = a[3][l];
+            const T a10 = a[4][l], a11 = a[5][l], a12 = a[6][l], a13 = a[7][l];
+            const T a20 = a[8][l], a21 = a[9][l], a22 = a[10][l], a23 = a[11][l];
+            const T a30 = a[12][l], a31 = a[13][l], a32 = a[14][l], a33 = a[15][l];
+            // minors of the top two rows, s, and of the bottom two, c
+            const T s0 = a00 * a11 - a10 * a01, s1 = a00 * a12 - a10 * a02, s2 = a00 * a13 - a10 * a03;
+            const T s3 = a01 * a12 - a11 * a02, s4 = a01 * a13 - a11 * a03, s5 = a02 * a13 - a12 * a03;
+            const T c0 = a20 * a31 - a30 * a21, c1 = a20 * a32 - a30 * a22, c2 = a20 * a33 - a30 * a23;
+            const T c3 = a21 * a32 - a31 * a22, c4 = a21 * a33 - a31 * a23, c5 = a22 * a33 - a32 * a23;
+            det[l] = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            if (adj) {
+                adj[0][l] = a11 * c5 - a12 * c4 + a13 * c3;
+                adj[1][l] = -a01 * c5 + a02 * c4 - a03 * c3;
+                adj[2][l] = a31 * s5 - a32 * s4 + a33 * s3;
+                adj[3][l] = -a21 * s5 + a22 * s4 - a23 * s3;
+                adj[4][l] = -a10 * c5 + a12 * c2 - a13 * c1;
+                adj[5][l] = a00 * c5 - a02 * c2 + a03 * c1;
+                adj[6][l] = -a30 * s5 + a32 * s2 - a33 * s1;
+                adj[7][l] = a20 * s5 - a22 * s2 + a23 * s1;
+                adj[8][l] = a10 * c4 - a11 * c2 + a13 * c0;
+                adj[9][l] = -a00 * c4 + a01 * c2 - a03 * c0;
+                adj[10][l] = a30 * s4 - a31 * s2 + a33 * s0;
+                adj[11][l] = -a20 * s4 + a21 * s2 - a23 * s0;
+                adj[12][l] = -a10 * c3 + a11 * c1 - a12 * c0;
+                adj[13][l] = a00 * c3 - a01 * c1 + a02 * c0;
+                adj[14][l] = -a30 * s3 + a31 * s1 - a32 * s0;
+                adj[15][l] = a20 * s3 - a21 * s1 + a22 * s0;
+            }
+        }
+    }
+}
+
+/**
+ * Runs a block operation over count items in blocks of batch_lanes,
+ * blocks in parallel.
+ *
+ * @param count how many items
+ * @param block called with the first item of a block and its size
+ * */
+template<typename F>
+void for_each_block(std::size_t count, F&& block) {
+    const std::size_t blocks = (count + batch_lanes - 1) / batch_lanes;
+    parallel::parallel_for(0, blocks, batch_grain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            const std::size_t first = b * batch_lanes;
+            block(first, int(std::min<std::size_t>(batch_lanes, count - first)));
+        }
+    });
+}
+
+};
+
+/**
+ * Multiplies pairs of small square matrices, blocks of batch_lanes
+ * pairs in parallel. Unlike the other batched operations, the pairs
+ * are not interleaved: a row of the product is a combination of rows
+ * of the right factor, which already fill vector registers, so that
+ * transposing would cost more than it saves. The output may be
+ * either input, for in-place products.
+ *
+ * @param a the left factors
+ * @param b the right factors
+ * @param count how many pairs
+ * @param out receives a[i] * b[i]
+ * */
+template<typename T, int N>
+void batch_multiply(const Mat<T, N, N>* a, const Mat<T, N, N>* b, std::size_t count, Mat<T, N, N>* out) {
+    static_assert(N != Dynamic, "batched operations are for fixed-size matrices");
+    kernels::for_each_block(count, [&](std::size_t first, int n) {
+        for (int l = 0; l < n; ++l) {
+            const T* x = a[first + l].raw();
+            const T* y = b[first + l].raw();
+            const int xld = a[first + l].ld(), yld = b[first + l].ld();
+            T z[N][N];
+            for (int i = 0; i < N; ++i) {
+                for (int j = 0; j < N; ++j)
+                    z[i][j] = x[i * xld] * y[j];
+                for (int k = 1; k < N; ++k)
+                    for (int j = 0; j < N; ++j)
+                        z[i][j] += x[i * xld + k] * y[k * yld + j];
+            }
+            T* o = out[first + l].raw();
+            const int ld = out[first + l].ld();
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                    o[i * ld + j] = z[i][j];
+        }
+    });
+}
+
+/**
+ * Determinants of 2x2, 3x3 or 4x4 matrices, batch_lanes at a time,
+ * blocks in parallel.
+ *
+ * @param m the matrices
+ * @param count how many
+ * @param out receives the determinants
+ * */
+template<typename T, int N>
+void batch_det(const Mat<T, N, N>* m, std::size_t count, T* out) {
+    constexpr int W = batch_lanes;
+    kernels::for_each_block(count, [&](std::size_t first, int n) {
+        alignas(64) T x[N * N][W];
+        alignas(64) T det[W];
+        kernels::interleave<T, N, N, W>(m + first, n, x);
+        kernels::adjugate_block<T, N, W>(x, det, nullptr);
+        std::copy(det, det + n, out + first);
+    });
+}
+
+/**
+ * Inverts 2x2, 3x3 or 4x4 matrices as their adjugates over their
+ * determinants, like inverse, batch_lanes at a time, blocks in
+ * parallel. Singular matrices get non-finite entries, and a zero
+ * determinant if asked for. The output may be the input.
+ *
+ * @param m the matrices
+ * @param count how many
+ * @param out receives the inverses
+ * @param det receives the determinants, unless null
+ * */
+template<typename T, int N>
+void batch_inverse(const Mat<T, N, N>* m, std::size_t count, Mat<T, N, N>* out, T* det = nullptr) {
+    constexpr int W = batch_lanes;
+    kernels::for_each_block(count, [&](std::size_t first, int n) {
+        alignas(64) T x[N * N][W], adj[N * N][W];
+        alignas(64) T d[W], inv[W];
+        kernels::interleave<T, N, N, W>(m + first, n, x);
+        kernels::adjugate_block<T, N, W>(x, d, adj);
+        for (int l = 0; l < W; ++l)
+            inv[l] = T(1) / d[l];
+        for (int e = 0; e < N * N; ++e)
+            for (int l = 0; l < W; ++l)
+                adj[e][l] *= inv[l];
+        kernels::deinterleave<T, N, N, W>(adj, n, out + first);
+        if (det)
+            std::copy(d, d + n, det + first);
+    });
+}
+
+/**
+ * Solves the systems a[i] x[i] = b[i] with 2x2, 3x3 or 4x4 matrices,
+ * through the adjugate, batch_lanes at a time, blocks in parallel.
+ * Without pivoting, this suits well-conditioned systems, such as
+ * those of transforms. Singular systems get non-finite solutions.
+ * The solutions may overwrite the right-hand sides.
+ *
+ * @param a the matrices
+ * @param b the right-hand sides
+ * @param count how many systems
+ * @param x receives the solutions
+ * */
+template<typename T, int N>
+void batch_solve(const Mat<T, N, N>* a, const Mat<T, N, 1>* b, std::size_t count, Mat<T, N, 1>* x) {
+    constexpr int W = batch_lanes;
+    kernels::for_each_block(count, [&](std::size_t first, int n) {
+        alignas(64) T m[N * N][W], adj[N * N][W], rhs[N][W], sol[N][W];
+        alignas(64) T d[W];
+        kernels::interleave<T, N, N, W>(a + first, n, m);
+        kernels::interleave<T, N, 1, W>(b + first, n, rhs);
+        kernels::adjugate_block<T, N, W>(m, d, adj);
+        for (int i = 0; i < N; ++i)
+            for (int l = 0; l < W; ++l) {
+                T s = adj[i * N][l] * rhs[0][l];
+                for (int k = 1; k < N; ++k)
+                    s += adj[i * N + k][l] * rhs[k][l];
+                sol[i][l] = s / d[l];
+            }
+        kernels::deinterleave<T, N, 1, W>(sol, n, x + first);
+    });
+}
+
+};
+
+#endif
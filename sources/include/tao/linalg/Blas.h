@@ -0,0 +1,271 @@
+#ifndef _TAO_BLAS_
+#define _TAO_BLAS_
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "tao/linalg/Backend.h"
+#include "tao/linalg/Mat.h"
+#include "tao/linalg/Reductions.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * Updates touching fewer elements run on the calling thread only.
+ * */
+constexpr std::size_t blas_parallel_threshold = std::size_t(1) << 15;
+
+/**
+ * Whether Op can stand for a matrix in the level 2 kernels without
+ * being stored: it tells its shape with nrows() and ncols(), and
+ * op.apply(alpha, x, beta, y) sets y = alpha Op x + beta y for
+ * dynamic column vectors, not reading y when beta is 0.
+ * */
+template<typename Op, typename T, typename = void>
+struct is_linear_operator : std::false_type {};
+
+template<typename Op, typename T>
+struct is_linear_operator<Op, T, std::void_t<
+        decltype(int(std::declval<const Op&>().nrows())),
+        decltype(int(std::declval<const Op&>().ncols())),
+        decltype(std::declval<const Op&>().apply(std::declval<T>(), std::declval<const Mat<T, Dynamic, Dynamic>&>(),
+                std::declval<T>(), std::declval<Mat<T, Dynamic, Dynamic>&>()))>> : std::true_type {};
+
+template<typename Op, typename T>
+constexpr bool is_linear_operator_v = is_linear_operator<Op, T>::value;
+
+namespace kernels {
+
+/**
+ * Distance between consecutive elements of a row or column vector.
+ *
+ * @param v the vector
+ * @param n the expected number of elements
+ * @return the stride of its elements in raw()
+ * */
+template<typename T, int M, int N>
+std::size_t vector_stride(const Mat<T, M, N>& v, std::size_t n) {
+    if (v.ncols() == 1 && std::size_t(v.nrows()) == n)
+        return std::size_t(v.ld());
+    if (v.nrows() == 1 && std::size_t(v.ncols()) == n)
+        return 1;
+    throw std::invalid_argument("expected a vector of " + std::to_string(n) + " elements, got ("
+            + std::to_string(v.nrows()) + "," + std::to_string(v.ncols()) + ")");
+}
+
+template<typename T, int M, int N, int P, int Q>
+void check_same_shape(const Mat<T, M, N>& a, const Mat<T, P, Q>& b) {
+    if (a.nrows() != b.nrows() || a.ncols() != b.ncols())
+        throw std::invalid_argument("can't combine matrices with different dimensions");
+}
+
+/**
+ * Runs span(i, lo, hi) over the columns [lo, hi) of every row i,
+ * in parallel above blas_parallel_threshold elements: by rows, or
+ * by columns of a single row, which is how contiguous storage is
+ * seen as a whole.
+ *
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param span the update of part of a row
+ * */
+template<typename F>
+void for_each_span(std::size_t rows, std::size_t cols, F&& span) {
+    if (rows == 0 || cols == 0)
+        return;
+    if (rows * cols < blas_parallel_threshold) {
+        for (std::size_t i = 0; i < rows; ++i)
+            span(i, std::size_t(0), cols);
+    } else if (rows == 1) {
+        parallel::parallel_for(0, cols, blas_parallel_threshold, [&](std::size_t lo, std::size_t hi) {
+            span(std::size_t(0), lo, hi);
+        });
+    } else {
+        parallel::parallel_for(0, rows, std::max<std::size_t>(1, blas_parallel_threshold / cols),
+            [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi; ++i)
+                    span(i, std::size_t(0), cols);
+            });
+    }
+}
+
+};
+
+/**
+ * Scales a matrix in place: x = alpha x.
+ *
+ * @param alpha the scale
+ * @param x the matrix
+ * */
+template<typename T, int M, int N>
+void scal(T alpha, Mat<T, M, N>& x) {
+    const bool flat = x.ld() == x.ncols();
+    const std::size_t rows = flat ? 1 : x.nrows();
+    const std::size_t cols = flat ? std::size_t(x.nrows()) * x.ncols() : x.ncols();
+    const std::size_t ld = x.ld();
+    T* p = x.raw();
+    kernels::for_each_span(rows, cols, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        T* r = p + i * ld;
+        for (std::size_t j = lo; j < hi; ++j)
+            r[j] *= alpha;
+    });
+}
+
+/**
+ * Fused scaled sum y = alpha x + beta y, in one pass over y and
+ * without temporaries. When beta is 0, y is only written.
+ *
+ * @param alpha scale of x
+ * @param x a matrix
+ * @param beta scale of y
+ * @param y a matrix of the same shape, updated
+ * */
+template<typename T, int M, int N>
+void axpby(T alpha, const Mat<T, M, N>& x, T beta, Mat<T, M, N>& y) {
+    kernels::check_same_shape(x, y);
+    const bool flat = x.ld() == x.ncols() && y.ld() == y.ncols();
+    const std::size_t rows = flat ? 1 : y.nrows();
+    const std::size_t cols = flat ? std::size_t(y.nrows()) * y.ncols() : y.ncols();
+    const std::size_t ldx = x.ld(), ldy = y.ld();
+    const T* px = x.raw();
+    T* py = y.raw();
+    kernels::for_each_span(rows, cols, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        const T* a = px + i * ldx;
+        T* b = py + i * ldy;
+        if (beta == T(0)) {
+            for (std::size_t j = lo; j < hi; ++j)
+                b[j] = alpha * a[j];
+        } else if (beta == T(1)) {
+            for (std::size_t j = lo; j < hi; ++j)
+                b[j] += alpha * a[j];
+        } else {
+            for (std::size_t j = lo; j < hi; ++j)
+                b[j] = alpha * a[j] + beta * b[j];
+        }
+    });
+}
+
+/**
+ * Fused update y = alpha x + y.
+ *
+ * @param alpha scale of x
+ * @param x a matrix
+ * @param y a matrix of the same shape, updated
+ * */
+template<typename T, int M, int N>
+void axpy(T alpha, const Mat<T, M, N>& x, Mat<T, M, N>& y) {
+    axpby(alpha, x, T(1), y);
+}
+
+/**
+ * Matrix-vector product y = alpha A x + beta y, row by row, each row
+ * a dot product with reduction_lanes accumulators of type
+ * accumulator_t<T>, rows in parallel.
+ * The result does not depend on the number of threads; large float
+ * and double products go to the BLAS backend instead, when there is
+ * one, outside of deterministic mode. When beta is 0, y is only
+ * written. Vectors may be rows or columns.
+ *
+ * @param alpha scale of the product
+ * @param a the matrix, m x n
+ * @param x a vector of n elements
+ * @param beta scale of y
+ * @param y a vector of m elements, updated; must not overlap x
+ * */
+template<typename T, int M, int N, int XR, int XC, int YR, int YC>
+void gemv(T alpha, const Mat<T, M, N>& a, const Mat<T, XR, XC>& x, T beta, Mat<T, YR, YC>& y) {
+    const std::size_t m = a.nrows(), n = a.ncols(), lda = a.ld();
+    const std::size_t incx = kernels::vector_stride(x, n), incy = kernels::vector_stride(y, m);
+    const T* pa = a.raw();
+    const T* px = x.raw();
+    T* py = y.raw();
+    if constexpr (backend::supports_v<T>) {
+        if (backend::routes<T>(m * n, backend::thresholds().gemv)) {
+            backend::gemv(int(m), int(n), alpha, pa, int(lda), px, int(incx), beta, py, int(incy));
+            return;
+        }
+    }
+    using A = accumulator_t<T>;
+    auto rows = [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            const T* ai = pa + i * lda;
+            const A s = incx == 1
+                ? kernels::lane_sum<A>(0, n, [ai, px](std::size_t j) { return A(ai[j]) * A(px[j]); })
+                : kernels::lane_sum<A>(0, n, [ai, px, incx](std::size_t j) { return A(ai[j]) * A(px[j * incx]); });
+            T& yi = py[i * incy];
+            yi = beta == T(0) ? T(A(alpha) * s) : T(A(alpha) * s + A(beta) * A(yi));
+        }
+    };
+    if (m * n < blas_parallel_threshold)
+        rows(0, m);
+    else
+        parallel::parallel_for(0, m, std::max<std::size_t>(1, blas_parallel_threshold / std::max<std::size_t>(n, 1)), rows);
+}
+
+/**
+ * Product y = alpha Op x + beta y with an operator that is not
+ * stored as a matrix.
+ *
+ * @param alpha scale of the product
+ * @param op the operator, see is_linear_operator
+ * @param x a column vector of op.ncols() elements
+ * @param beta scale of y
+ * @param y a column vector of op.nrows() elements, updated
+ * */
+template<typename T, typename Op, typename = std::enable_if_t<is_linear_operator_v<Op, T>>>
+void gemv(T alpha, const Op& op, const Mat<T, Dynamic, Dynamic>& x, T beta, Mat<T, Dynamic, Dynamic>& y) {
+    if (x.ncols() != 1 || x.nrows() != op.ncols() || y.ncols() != 1 || y.nrows() != op.nrows())
+        throw std::invalid_argument("operator and vectors have incompatible dimensions");
+    op.apply(alpha, x, beta, y);
+}
+
+/**
+ * Rank-1 update A = alpha x y^T + A, rows in parallel.
+ *
+ * @param alpha the scale
+ * @param x a vector of m elements
+ * @param y a vector of n elements
+ * @param a the matrix, m x n, updated; must not overlap the vectors
+ * */
+template<typename T, int M, int N, int XR, int XC, int YR, int YC>
+void ger(T alpha, const Mat<T, XR, XC>& x, const Mat<T, YR, YC>& y, Mat<T, M, N>& a) {
+    const std::size_t m = a.nrows(), n = a.ncols(), lda = a.ld();
+    const std::size_t incx = kernels::vector_stride(x, m), incy = kernels::vector_stride(y, n);
+    const T* px = x.raw();
+    const T* py = y.raw();
+    T* pa = a.raw();
+    kernels::for_each_span(m, n, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        const accumulator_t<T> s = accumulator_t<T>(alpha) * px[i * incx];
+        T* ai = pa + i * lda;
+        if (incy == 1) {
+            for (std::size_t j = lo; j < hi; ++j)
+                ai[j] += s * py[j];
+        } else {
+            for (std::size_t j = lo; j < hi; ++j)
+                ai[j] += s * py[j * incy];
+        }
+    });
+}
+
+/**
+ * Symmetric rank-1 update A = alpha x x^T + A. Both triangles are
+ * updated, so that a symmetric A stays symmetric.
+ *
+ * @param alpha the scale
+ * @param x a vector of n elements
+ * @param a the matrix, n x n, updated; must not overlap x
+ * */
+template<typename T, int M, int N, int XR, int XC>
+void syr(T alpha, const Mat<T, XR, XC>& x, Mat<T, M, N>& a) {
+    if (a.nrows() != a.ncols())
+        throw std::invalid_argument("symmetric update of a non-square matrix");
+    ger(alpha, x, x, a);
+}
+
+};
+
+#endif
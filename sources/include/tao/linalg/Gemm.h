@@ -0,0 +1,202 @@
+#ifndef _TAO_GEMM_
+#define _TAO_GEMM_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "tao/linalg/Backend.h"
+#include "tao/linalg/Half.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * Cache blocking of the matrix product C = alpha A B + beta C:
+ * C is cut into mc x nc tiles, and the shared dimension into
+ * kc-long panels, so that a kc x nc panel of B stays in L2
+ * while the mc rows of A stream through L1.
+ * */
+struct GemmBlocking {
+    int mc;     /** rows of A and C per tile */
+    int kc;     /** depth of a panel */
+    int nc;     /** cols of B and C per tile */
+};
+
+/**
+ * Blocking of hosts nothing is known about.
+ * */
+constexpr GemmBlocking default_gemm_blocking {64, 256, 256};
+
+/**
+ * Blocking used when none is given: the one of tuning::profile(),
+ * fitted to the host caches or measured by tuning::tune.
+ *
+ * @return the current blocking
+ * */
+GemmBlocking gemm_blocking();
+
+/**
+ * Products with fewer multiply-adds run on the calling thread only.
+ * */
+constexpr std::size_t gemm_parallel_threshold = std::size_t(1) << 18;
+
+namespace kernels {
+
+template<typename T>
+void gemm_widened(int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb,
+        T beta, T* c, int ldc, GemmBlocking blocking);
+
+/**
+ * C = alpha A B + beta C on row-major arrays.
+ *
+ * Threads split C into tiles, and every element of C accumulates its
+ * k products in increasing k order, straight into C: the result does
+ * not depend on the blocking or on the number of threads, so the
+ * product is bit-reproducible in any execution mode. Large float and
+ * double products go to the BLAS backend instead, when there is one,
+ * outside of deterministic mode. Half and BFloat16 products
+ * accumulate in float, see gemm_widened.
+ *
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A and rows of B
+ * @param alpha scale of the product
+ * @param a the left operand
+ * @param lda leading dimension of A
+ * @param b the right operand
+ * @param ldb leading dimension of B
+ * @param beta scale of the previous C, 0 meaning C is only written
+ * @param c the result
+ * @param ldc leading dimension of C
+ * @param blocking the cache blocking
+ * */
+template<typename T>
+void gemm(int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb,
+        T beta, T* c, int ldc, GemmBlocking blocking = gemm_blocking()) {
+    if (m <= 0 || n <= 0)
+        return;
+    if constexpr (is_low_precision_v<T>) {
+        gemm_widened(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, blocking);
+        return;
+    }
+    if constexpr (backend::supports_v<T>) {
+        if (backend::routes<T>(std::size_t(m) * n * std::max(k, 1), backend::thresholds().gemm)) {
+            backend::gemm(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            return;
+        }
+    }
+    const int mc = std::max(blocking.mc, 4), kc = std::max(blocking.kc, 1), nc = std::max(blocking.nc, 1);
+    const std::size_t row_tiles = (m + mc - 1) / mc, col_tiles = (n + nc - 1) / nc;
+
+    auto tile = [&](std::size_t t) {
+        const int ib = int(t / col_tiles) * mc, ie = std::min(ib + mc, m);
+        const int jb = int(t % col_tiles) * nc, je = std::min(jb + nc, n);
+        for (int i = ib; i < ie; ++i) {
+            T* ci = c + std::size_t(i) * ldc;
+            if (beta == T(0)) {
+                for (int j = jb; j < je; ++j) ci[j] = T(0);
+            } else if (beta != T(1)) {
+                for (int j = jb; j < je; ++j) ci[j] *= beta;
+            }
+        }
+        for (int pb = 0; pb < k; pb += kc) {
+            const int pe = std::min(pb + kc, k);
+            int i = ib;
+            // four rows of C share every load of B
+            for (; i + 4 <= ie; i += 4) {
+                T* c0 = c + std::size_t(i) * ldc;
+                T* c1 = c0 + ldc;
+                T* c2 = c1 + ldc;
+                T* c3 = c2 + ldc;
+                const T* a0 = a + std::size_t(i) * lda;
+                for (int p = pb; p < pe; ++p) {
+                    const T s0 = alpha * a0[p], s1 = alpha * a0[lda + p];
+                    const T s2 = alpha * a0[2 * std::size_t(lda) + p], s3 = alpha * a0[3 * std::size_t(lda) + p];
+                    const T* bp = b + std::size_t(p) * ldb;
+                    for (int j = jb; j < je; ++j) {
+                        const T bj = bp[j];
+                        c0[j] += s0 * bj;
+                        c1[j] += s1 * bj;
+                        c2[j] += s2 * bj;
+                        c3[j] += s3 * bj;
+                    }
+                }
+            }
+            for (; i < ie; ++i) {
+                T* ci = c + std::size_t(i) * ldc;
+                const T* ai = a + std::size_t(i) * lda;
+                for (int p = pb; p < pe; ++p) {
+                    const T s = alpha * ai[p];
+                    const T* bp = b + std::size_t(p) * ldb;
+                    for (int j = jb; j < je; ++j)
+                        ci[j] += s * bp[j];
+                }
+            }
+        }
+    };
+
+    const std::size_t tiles = row_tiles * col_tiles;
+    if (std::size_t(m) * n * std::max(k, 1) < gemm_parallel_threshold || tiles == 1) {
+        for (std::size_t t = 0; t < tiles; ++t)
+            tile(t);
+        return;
+    }
+    parallel::parallel_for(0, tiles, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t t = lo; t < hi; ++t)
+            tile(t);
+    });
+}
+
+/**
+ * gemm for 16-bit elements: every tile of C is computed in float,
+ * panels of A and B being converted to float in bulk on the way, and
+ * C is rounded once at the end. Conversions cost 1/mc + 1/nc of the
+ * multiply-adds. The float tiles go through gemm, so the result is as
+ * reproducible as a float product.
+ * */
+template<typename T>
+void gemm_widened(int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb,
+        T beta, T* c, int ldc, GemmBlocking blocking) {
+    const int mc = std::max(blocking.mc, 4), kc = std::max(blocking.kc, 1), nc = std::max(blocking.nc, 1);
+    const std::size_t row_tiles = (m + mc - 1) / mc, col_tiles = (n + nc - 1) / nc;
+    const float fa = alpha, fb = beta;
+
+    auto tile = [&](std::size_t t) {
+        const int ib = int(t / col_tiles) * mc, rows = std::min(ib + mc, m) - ib;
+        const int jb = int(t % col_tiles) * nc, cols = std::min(jb + nc, n) - jb;
+        std::vector<float> ct (std::size_t(rows) * cols), at (std::size_t(rows) * kc), bt (std::size_t(kc) * cols);
+        if (fb != 0.0f) {
+            for (int i = 0; i < rows; ++i)
+                convert(c + std::size_t(ib + i) * ldc + jb, ct.data() + std::size_t(i) * cols, cols);
+            if (fb != 1.0f)
+                for (float& x : ct) x *= fb;
+        }
+        for (int pb = 0; pb < k; pb += kc) {
+            const int depth = std::min(pb + kc, k) - pb;
+            for (int i = 0; i < rows; ++i)
+                convert(a + std::size_t(ib + i) * lda + pb, at.data() + std::size_t(i) * depth, depth);
+            for (int p = 0; p < depth; ++p)
+                convert(b + std::size_t(pb + p) * ldb + jb, bt.data() + std::size_t(p) * cols, cols);
+            gemm(rows, cols, depth, fa, at.data(), depth, bt.data(), cols, 1.0f, ct.data(), cols,
+                    GemmBlocking {rows, depth, cols});
+        }
+        for (int i = 0; i < rows; ++i)
+            convert(ct.data() + std::size_t(i) * cols, c + std::size_t(ib + i) * ldc + jb, cols);
+    };
+
+    const std::size_t tiles = row_tiles * col_tiles;
+    if (std::size_t(m) * n * std::max(k, 1) < gemm_parallel_threshold || tiles == 1) {
+        for (std::size_t t = 0; t < tiles; ++t)
+            tile(t);
+        return;
+    }
+    parallel::parallel_for(0, tiles, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t t = lo; t < hi; ++t)
+            tile(t);
+    });
+}
+
+};
+};
+
+#endif
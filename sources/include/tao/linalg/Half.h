@@ -0,0 +1,362 @@
+#ifndef _TAO_HALF_
+#define _TAO_HALF_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace tao {
+
+namespace kernels {
+
+inline std::uint32_t float_bits(float f) {
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    return x;
+}
+
+inline float bits_float(std::uint32_t x) {
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+/**
+ * IEEE binary16 bits of a float, rounded to nearest even, as F16C
+ * does: overflows give infinities, NaNs stay quiet NaNs.
+ *
+ * @param f the float
+ * @return the half bits
+ * */
+inline std::uint16_t float_to_half(float f) {
+#if defined(__F16C__)
+    return std::uint16_t(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+    const std::uint32_t x = float_bits(f);
+    const std::uint32_t sign = (x >> 16) & 0x8000u;
+    const std::uint32_t ax = x & 0x7fffffffu;
+    if (ax >= 0x7f800000u)
+        return std::uint16_t(sign | (ax > 0x7f800000u ? 0x7e00u | ((ax >> 13) & 0x3ffu) : 0x7c00u));
+    // from 65520, halfway above the largest half, everything rounds up
+    if (ax >= 0x477ff000u)
+        return std::uint16_t(sign | 0x7c00u);
+    if (ax >= 0x38800000u) {
+        const std::uint32_t m = ax - 0x38000000u;
+        return std::uint16_t(sign | ((m + 0xfffu + ((m >> 13) & 1u)) >> 13));
+    }
+    // subnormal halves, 2^-25 itself rounding to the even 0
+    if (ax <= 0x33000000u)
+        return std::uint16_t(sign);
+    const std::uint32_t shift = 126u - (ax >> 23);
+    const std::uint32_t m = (ax & 0x7fffffu) | 0x800000u;
+    std::uint32_t r = m >> shift;
+    const std::uint32_t rest = m & ((1u << shift) - 1u), halfway = 1u << (shift - 1u);
+    r += rest > halfway || (rest == halfway && (r & 1u));
+    return std::uint16_t(sign | r);
+#endif
+}
+
+/**
+ * Float of IEEE binary16 bits; exact.
+ *
+ * @param h the half bits
+ * @return the float
+ * */
+inline float half_to_float(std::uint16_t h) {
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    // exponent rebias by integer addition, subnormals renormalized by
+    // a float subtraction
+    std::uint32_t o = std::uint32_t(h & 0x7fffu) << 13;
+    const std::uint32_t exponent = o & 0x0f800000u;
+    o += (127u - 15u) << 23;
+    if (exponent == 0x0f800000u) {
+        o += (128u - 16u) << 23;
+    } else if (exponent == 0) {
+        o += 1u << 23;
+        o = float_bits(bits_float(o) - bits_float(113u << 23));
+    }
+    return bits_float(o | (std::uint32_t(h & 0x8000u) << 16));
+#endif
+}
+
+/**
+ * bfloat16 bits of a float: its upper half, rounded to nearest
+ * even; NaNs stay quiet NaNs.
+ *
+ * @param f the float
+ * @return the bfloat16 bits
+ * */
+inline std::uint16_t float_to_bfloat16(float f) {
+    const std::uint32_t x = float_bits(f);
+    if ((x & 0x7fffffffu) > 0x7f800000u)
+        return std::uint16_t((x >> 16) | 0x40u);
+    return std::uint16_t((x + 0x7fffu + ((x >> 16) & 1u)) >> 16);
+}
+
+/**
+ * Float of bfloat16 bits; exact.
+ *
+ * @param b the bfloat16 bits
+ * @return the float
+ * */
+inline float bfloat16_to_float(std::uint16_t b) {
+    return bits_float(std::uint32_t(b) << 16);
+}
+
+};
+
+/**
+ * IEEE 754 half precision: 11 significant bits, up to 65504. Only a
+ * storage format: it converts to float implicitly, so arithmetic on
+ * halves runs in float, and results are rounded once when stored.
+ * */
+class Half {
+
+    public:
+
+        Half() = default;
+
+        /**
+         * Rounds a float to the nearest half.
+         *
+         * @param f the float
+         * */
+        Half(float f) : bits {kernels::float_to_half(f)} {}
+
+        operator float() const { return kernels::half_to_float(bits); }
+
+        /**
+         * A half with the given bits.
+         *
+         * @param b the IEEE binary16 encoding
+         * @return the half
+         * */
+        static Half from_bits(std::uint16_t b) {
+            Half h;
+            h.bits = b;
+            return h;
+        }
+
+        /**
+         * The IEEE binary16 encoding.
+         *
+         * @return the bits
+         * */
+        std::uint16_t raw_bits() const { return bits; }
+
+        Half& operator+=(float x) { return *this = Half(float(*this) + x); }
+        Half& operator-=(float x) { return *this = Half(float(*this) - x); }
+        Half& operator*=(float x) { return *this = Half(float(*this) * x); }
+        Half& operator/=(float x) { return *this = Half(float(*this) / x); }
+
+    private:
+
+        std::uint16_t bits;
+};
+
+/**
+ * bfloat16: the upper half of a float, with its range and 8
+ * significant bits. Like Half, a storage format computed on as float.
+ * */
+class BFloat16 {
+
+    public:
+
+        BFloat16() = default;
+
+        /**
+         * Rounds a float to the nearest bfloat16.
+         *
+         * @param f the float
+         * */
+        BFloat16(float f) : bits {kernels::float_to_bfloat16(f)} {}
+
+        operator float() const { return kernels::bfloat16_to_float(bits); }
+
+        /**
+         * A bfloat16 with the given bits.
+         *
+         * @param b the upper 16 bits of a float
+         * @return the bfloat16
+         * */
+        static BFloat16 from_bits(std::uint16_t b) {
+            BFloat16 h;
+            h.bits = b;
+            return h;
+        }
+
+        /**
+         * The encoding, the upper 16 bits of a float.
+         *
+         * @return the bits
+         * */
+        std::uint16_t raw_bits() const { return bits; }
+
+        BFloat16& operator+=(float x) { return *this = BFloat16(float(*this) + x); }
+        BFloat16& operator-=(float x) { return *this = BFloat16(float(*this) - x); }
+        BFloat16& operator*=(float x) { return *this = BFloat16(float(*this) * x); }
+        BFloat16& operator/=(float x) { return *this = BFloat16(float(*this) / x); }
+
+    private:
+
+        std::uint16_t bits;
+};
+
+/**
+ * Whether T is one of the 16-bit storage formats.
+ * */
+template<typename T>
+struct is_low_precision : std::false_type {};
+
+template<> struct is_low_precision<Half> : std::true_type {};
+template<> struct is_low_precision<BFloat16> : std::true_type {};
+
+template<typename T>
+constexpr bool is_low_precision_v = is_low_precision<T>::value;
+
+/**
+ * Type in which sums and products of T are accumulated: float for
+ * the 16-bit formats, T itself otherwise.
+ * */
+template<typename T>
+struct accumulator {
+    using type = T;
+};
+
+template<> struct accumulator<Half> { using type = float; };
+template<> struct accumulator<BFloat16> { using type = float; };
+
+template<typename T>
+using accumulator_t = typename accumulator<T>::type;
+
+/**
+ * Converts n halves to floats, 8 at a time with F16C when the CPU
+ * has it, whatever the flags tao was compiled with.
+ *
+ * @param src the halves
+ * @param dst the floats
+ * @param n the number of elements
+ * */
+void convert(const Half* src, float* dst, std::size_t n);
+
+/**
+ * Rounds n floats to halves, to nearest even.
+ *
+ * @param src the floats
+ * @param dst the halves
+ * @param n the number of elements
+ * */
+void convert(const float* src, Half* dst, std::size_t n);
+
+/**
+ * Converts n bfloat16 to floats.
+ *
+ * @param src the bfloat16
+ * @param dst the floats
+ * @param n the number of elements
+ * */
+void convert(const BFloat16* src, float* dst, std::size_t n);
+
+/**
+ * Rounds n floats to bfloat16, to nearest even.
+ *
+ * @param src the floats
+ * @param dst the bfloat16
+ * @param n the number of elements
+ * */
+void convert(const float* src, BFloat16* dst, std::size_t n);
+
+/**
+ * Whether convert uses F16C instructions on this CPU.
+ *
+ * @return true if the halves are converted by hardware
+ * */
+bool has_f16c();
+
+};
+
+namespace std {
+
+template<> class numeric_limits<tao::Half> {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr int digits = 11;
+        static constexpr int digits10 = 3;
+        static constexpr int max_digits10 = 5;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr int radix = 2;
+        static constexpr int min_exponent = -13;
+        static constexpr int min_exponent10 = -4;
+        static constexpr int max_exponent = 16;
+        static constexpr int max_exponent10 = 4;
+        static constexpr bool has_infinity = true;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr bool has_signaling_NaN = true;
+        static constexpr float_denorm_style has_denorm = denorm_present;
+        static constexpr bool has_denorm_loss = false;
+        static constexpr bool is_iec559 = true;
+        static constexpr bool is_bounded = true;
+        static constexpr bool is_modulo = false;
+        static constexpr bool traps = false;
+        static constexpr bool tinyness_before = false;
+        static constexpr float_round_style round_style = round_to_nearest;
+        static tao::Half min() { return tao::Half::from_bits(0x0400); }
+        static tao::Half lowest() { return tao::Half::from_bits(0xfbff); }
+        static tao::Half max() { return tao::Half::from_bits(0x7bff); }
+        static tao::Half epsilon() { return tao::Half::from_bits(0x1400); }
+        static tao::Half round_error() { return tao::Half::from_bits(0x3800); }
+        static tao::Half infinity() { return tao::Half::from_bits(0x7c00); }
+        static tao::Half quiet_NaN() { return tao::Half::from_bits(0x7e00); }
+        static tao::Half signaling_NaN() { return tao::Half::from_bits(0x7d00); }
+        static tao::Half denorm_min() { return tao::Half::from_bits(0x0001); }
+};
+
+template<> class numeric_limits<tao::BFloat16> {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr int digits = 8;
+        static constexpr int digits10 = 2;
+        static constexpr int max_digits10 = 4;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr int radix = 2;
+        static constexpr int min_exponent = -125;
+        static constexpr int min_exponent10 = -37;
+        static constexpr int max_exponent = 128;
+        static constexpr int max_exponent10 = 38;
+        static constexpr bool has_infinity = true;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr bool has_signaling_NaN = true;
+        static constexpr float_denorm_style has_denorm = denorm_present;
+        static constexpr bool has_denorm_loss = false;
+        static constexpr bool is_iec559 = false;
+        static constexpr bool is_bounded = true;
+        static constexpr bool is_modulo = false;
+        static constexpr bool traps = false;
+        static constexpr bool tinyness_before = false;
+        static constexpr float_round_style round_style = round_to_nearest;
+        static tao::BFloat16 min() { return tao::BFloat16::from_bits(0x0080); }
+        static tao::BFloat16 lowest() { return tao::BFloat16::from_bits(0xff7f); }
+        static tao::BFloat16 max() { return tao::BFloat16::from_bits(0x7f7f); }
+        static tao::BFloat16 epsilon() { return tao::BFloat16::from_bits(0x3c00); }
+        static tao::BFloat16 round_error() { return tao::BFloat16::from_bits(0x3f00); }
+        static tao::BFloat16 infinity() { return tao::BFloat16::from_bits(0x7f80); }
+        static tao::BFloat16 quiet_NaN() { return tao::BFloat16::from_bits(0x7fc0); }
+        static tao::BFloat16 signaling_NaN() { return tao::BFloat16::from_bits(0x7fa0); }
+        static tao::BFloat16 denorm_min() { return tao::BFloat16::from_bits(0x0001); }
+};
+
+};
+
+#endif
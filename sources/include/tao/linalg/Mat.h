@@ -3,9 +3,14 @@
 
 #include <memory>
 #include <functional>
+#include <stdexcept>
+#include <string>
 #include <array>
 #include <type_traits>
 #include <iostream>
+#include "tao/linalg/Storage.h"
+#include "tao/linalg/Gemm.h"
+#include "tao/linalg/Half.h"
 
 enum StorageType {
     Dynamic = 0
@@ -22,11 +27,11 @@ struct mat_storage_type_traits {
     using matrix_storage_type = 
         typename std::conditional<
             (M==Dynamic && N==Dynamic),
-            typename std::unique_ptr<T[]>,
+            aligned_buffer<T, default_alignment>,
             typename std::conditional<
                 (M != Dynamic && N != Dynamic),
-                std::array<T, M*N>,
-                std::array<T, M*N>
+                aligned_array<T, M*N>,
+                aligned_array<T, M*N>
             >::type
         >::type;
 };
@@ -40,7 +45,7 @@ template<typename T>
 struct mat_storage_initializer<Dynamic, Dynamic, T> {
     void initialize(typename mat_storage_type_traits<Dynamic, Dynamic, T>::matrix_storage_type& data, 
             int _M, int _N) {
-        data = std::move(std::make_unique<T[]>(_M*_N)); 
+        data = aligned_buffer<T, default_alignment>(std::size_t(_M) * std::size_t(_N));
     }  
 };
 
@@ -60,9 +65,29 @@ class Mat {
 
         int rows {NumberRows};                  /** Number of rows */
         int cols {NumberCols};                  /** Number of cols */
+        int stride {NumberCols};                /** Distance between rows, in elements */
+
+        /**
+         * Throws unless rhs has the dimensions of this matrix, which
+         * only Dynamic matrices can lack.
+         *
+         * @param rhs the other operand
+         * */
+        void check_shape(const Mat<T, NumberRows, NumberCols>& rhs) const {
+            if (rhs.rows != rows || rhs.cols != cols)
+                throw std::invalid_argument("element-wise operation on matrices of different dimensions");
+        }
 
     public:
 
+        /**
+         * Alignment, in bytes, of the first element.
+         * */
+        static constexpr std::size_t alignment = 
+            (NumberRows == Dynamic && NumberCols == Dynamic) 
+            ? default_alignment 
+            : alignof(typename mat_storage_type_traits<NumberRows, NumberCols, T>::matrix_storage_type);
+
         Mat() {/* empty */
             for (int i = 0; i < NumberRows; ++i) {
                 for (int j = 0; j < NumberCols; ++j) {
@@ -83,6 +108,31 @@ class Mat {
                 data[i] = initial;
         }
 
+        /**
+         * Constructor of dynamic matrices based on size,
+         * with elements initialized to zero.
+         *
+         * With the Padded layout, the leading dimension is rounded up so
+         * that every row starts at an aligned address; the padding
+         * elements are never read by the library.
+         *
+         * @param rows number of rows
+         * @param cols number of cols
+         * @param layout packed or padded rows
+         * */
+        template<int R = NumberRows, int C = NumberCols, 
+            typename = std::enable_if_t<R == Dynamic && C == Dynamic>>
+        Mat(int rows, int cols, StorageLayout layout = Packed) {
+            if (rows < 0)
+                throw std::invalid_argument("negative rows number " + std::to_string(rows));
+            if (cols < 0)
+                throw std::invalid_argument("negative cols number " + std::to_string(cols));
+            this->rows = rows;
+            this->cols = cols;
+            this->stride = (layout == Padded) ? padded_stride<T, default_alignment>(cols) : cols;
+            storage_initializer.initialize(data, this->rows, this->stride);
+        }
+
 
         /**
          * Construtor based on an initializer list.
@@ -93,8 +143,9 @@ class Mat {
             auto [r, c] = validate(elements);
             this->rows = r;
             this->cols = c;
+            this->stride = c;
 
-            storage_initializer.initialize(data, rows, cols);
+            storage_initializer.initialize(data, rows, stride);
 
             if (r != this->rows || c != this->cols)
                 throw std::invalid_argument("invalid matrix initialization, expected: (" 
@@ -113,8 +164,9 @@ class Mat {
             auto [r, c] = validate(elements);
             this->rows = r;
             this->cols = c;
+            this->stride = c;
 
-            storage_initializer.initialize(data, rows, cols);
+            storage_initializer.initialize(data, rows, stride);
 
             if (r != this->rows || c != this->cols)
                 throw std::invalid_argument("invalid matrix initialization, expected: (" 
@@ -149,7 +201,7 @@ class Mat {
             if (col < 0 || col >= cols)
                 throw std::invalid_argument("invalid col access, when cols are " + std::to_string(cols)
                         + " and col is " + std::to_string(col));
-            return this->data[row * cols + col]; 
+            return this->data[row * stride + col];
         }
 
         /**
@@ -165,7 +217,7 @@ class Mat {
             if (col < 0 || col >= cols)
                 throw std::invalid_argument("invalid col access, when cols are " + std::to_string(cols)
                         + " and col is " + std::to_string(col));
-            return this->data[row * cols + col];
+            return this->data[row * stride + col];
         }
 
         /**
@@ -241,15 +293,36 @@ class Mat {
          * */
         inline int ncols() const { return cols; };
 
+        /**
+         * The leading dimension, i.e., the distance in elements
+         * between the starts of two consecutive rows.
+         *
+         * @return the leading dimension
+         * */
+        inline int ld() const { return stride; };
+
+        /**
+         * Pointer to the first element, aligned to Mat::alignment. 
+         * Element (i, j) lives at raw()[i * ld() + j].
+         *
+         * @return the underlying storage
+         * */
+        inline T* raw() { return data.data(); };
+
+        /**
+         * Read-only pointer to the first element.
+         *
+         * @return the underlying storage
+         * */
+        inline const T* raw() const { return data.data(); };
+
         /**
          * Reset matrix with a value.
          *
          * @param value the value to fill the matrix
          * */
         void reset(const T& val) {
-            for (int i = 0; i < rows * cols; ++i) {
-                this->data[i] = val;
-            }
+            stream_fill(this->raw(), std::size_t(rows) * std::size_t(stride), val);
         }
 
         /**
@@ -260,11 +333,19 @@ class Mat {
          * */
         Mat<T, NumberRows, NumberCols> element_wise(const Mat<T, NumberRows, NumberCols>& rhs, 
                 std::function<T(T, T)> operation) const {
-            tao::Mat<T, NumberRows, NumberCols> mat;
-            for (auto i = 0; i < rhs.nrows(); ++i) {
-                for (auto j = 0; j < rhs.ncols(); ++j) {
-                    mat(i, j) = operation((*this)(i, j), rhs(i, j));
-                }
+            check_shape(rhs);
+            tao::Mat<T, NumberRows, NumberCols> mat = [&]() {
+                if constexpr (NumberRows == Dynamic && NumberCols == Dynamic)
+                    return tao::Mat<T, NumberRows, NumberCols> (rows, cols);
+                else
+                    return tao::Mat<T, NumberRows, NumberCols> ( T(0) );
+            }();
+            const T *a = this->raw(), *b = rhs.raw();
+            T* c = mat.raw();
+            for (std::size_t i = 0; i < std::size_t(rows); ++i) {
+                const std::size_t ra = i * stride, rb = i * rhs.stride, rc = i * mat.stride;
+                for (std::size_t j = 0; j < std::size_t(cols); ++j)
+                    c[rc + j] = operation(a[ra + j], b[rb + j]);
             }
             return mat;
         }
@@ -277,10 +358,13 @@ class Mat {
          * */
         Mat<T, NumberRows, NumberCols>& element_wise_inplace(const Mat<T, NumberRows, NumberCols>& rhs, 
                 std::function<T(T, T)> operation) {
-            for (auto i = 0; i < rhs.nrows(); ++i) {
-                for (auto j = 0; j < rhs.ncols(); ++j) {
-                    (*this)(i, j) = operation((*this)(i, j), rhs(i, j));
-                }
+            check_shape(rhs);
+            T* a = this->raw();
+            const T* b = rhs.raw();
+            for (std::size_t i = 0; i < std::size_t(rows); ++i) {
+                const std::size_t ra = i * stride, rb = i * rhs.stride;
+                for (std::size_t j = 0; j < std::size_t(cols); ++j)
+                    a[ra + j] = operation(a[ra + j], b[rb + j]);
             }
             return (*this);
         }
@@ -291,12 +375,18 @@ class Mat {
          * @return a new matrix which is the transpose
          * */
         Mat<T, NumberCols, NumberRows> t() const {
-            Mat<T, NumberCols, NumberRows> transp;
-            for (auto i = 0; i < cols; ++i) {
-                for (auto j = 0; j < rows; ++j) {
-                    transp(i, j) = (*this)(j, i);        
-                }
-            }
+            Mat<T, NumberCols, NumberRows> transp = [&]() {
+                if constexpr (NumberRows == Dynamic && NumberCols == Dynamic)
+                    return Mat<T, NumberCols, NumberRows> (cols, rows);
+                else
+                    return Mat<T, NumberCols, NumberRows> ( T(0) );
+            }();
+            const T* a = this->raw();
+            T* b = transp.raw();
+            const std::size_t ldt = transp.ld();
+            for (std::size_t i = 0; i < std::size_t(rows); ++i)
+                for (std::size_t j = 0; j < std::size_t(cols); ++j)
+                    b[j * ldt + i] = a[i * stride + j];
             return transp;
         }
 
@@ -351,7 +441,8 @@ class Mat {
         }
 
         /**
-         * Equality comparison with precision indication.
+         * Equality comparison with precision indication. Differences
+         * are taken in accumulator_t<T>, and compared in double.
          *
          * @param m1 a matrix
          * @param m2 another matrix
@@ -359,14 +450,21 @@ class Mat {
          * @return if m1 == m2 according to the precision
          * */
         template<int O, int P>
-        bool eq(const Mat<T, O, P>& rhs, float precision = 0.0001) const {
+        bool eq(const Mat<T, O, P>& rhs, double precision = 0.0001) const {
             if (O != NumberRows || P != NumberCols)
                 return false;
-            for (auto i = 0; i < rhs.nrows(); ++i) {
-                for (auto j = 0; j < rhs.ncols(); ++j) {
-                    if (std::abs((*this)(i, j) - rhs(i, j)) >= precision)
-                        return false;
-                }
+            if (rhs.nrows() != rows || rhs.ncols() != cols)
+                return false;
+            const T* a = this->raw();
+            const T* b = rhs.raw();
+            for (auto i = 0; i < rows; ++i) {
+                const T* ra = a + i * stride;
+                const T* rb = b + i * rhs.ld();
+                bool close = true;
+                for (auto j = 0; j < cols; ++j)
+                    close &= std::abs(accumulator_t<T>(ra[j]) - accumulator_t<T>(rb[j])) < precision;
+                if (!close)
+                    return false;
             }
             return true;
         }
@@ -383,7 +481,7 @@ class Mat {
             for (auto i = 0; i < rows; ++i) {
                 auto elements_col_it = elements_row_it->begin();
                 for (auto j = 0; j < cols; ++j) {
-                    this->data[i * cols + j] = *elements_col_it;
+                    this->data[i * stride + j] = *elements_col_it;
                     elements_col_it++;
                 }
                 elements_row_it++;
@@ -410,7 +508,7 @@ class Mat {
             for (auto i = 0; i < rows; ++i) {
                 auto elements_col_it = elements_row_it->begin();
                 for (auto j = 0; j < cols; ++j) {
-                    this->data[i * cols + j] = *elements_col_it;
+                    this->data[i * stride + j] = *elements_col_it;
                     elements_col_it++;
                 }
                 elements_row_it++;
@@ -474,25 +572,22 @@ class Mat {
 };
 
 /**
- * Performs matrix multiplication.
+ * Performs matrix multiplication, overwriting m3.
  *
- * @param rhs the rhs
- * @return the conventional matrix pruduct
+ * The product runs on the blocked kernels::gemm, whose result
+ * does not depend on the number of threads.
+ *
+ * @param m1 the lhs
+ * @param m2 the rhs
+ * @param m3 the result, already with the dimensions of the product
  * */
 template<typename T, int M, int N, int P>
 void multiply(const Mat<T, M, N>& m1, const Mat<T, N, P>& m2, 
         Mat<T, M, P>& m3) {
-    for (auto i = 0; i < m1.nrows(); ++i) {
-        for (auto j = 0; j < m2.ncols(); ++j) {
-            T vm3 = m3(i, j);
-            for (auto k = 0; k < m2.nrows(); ++k) {
-                auto vm1 = m1(i, k);
-                auto vm2 = m2(k, j);
-                m3(i, j) += (vm1 * vm2);
-            }
-            m3(i, j) -= vm3;
-        }
-    }
+    if (m1.ncols() != m2.nrows() || m3.nrows() != m1.nrows() || m3.ncols() != m2.ncols())
+        throw std::invalid_argument("can't multiply matrices with incompatible dimensions");
+    kernels::gemm(m1.nrows(), m2.ncols(), m1.ncols(), T(1), m1.raw(), m1.ld(),
+            m2.raw(), m2.ld(), T(0), m3.raw(), m3.ld());
 }
 
 /**
@@ -504,8 +599,53 @@ void multiply(const Mat<T, M, N>& m1, const Mat<T, N, P>& m2,
 template<typename T, int M, int N, int P>
 Mat<T, M, P> operator*(const Mat<T, M, N>& lhs, 
                        const Mat<T, N, P>& rhs) {
-    Mat<T, M, P> result ( T(0) );
-    multiply(lhs, rhs, result);
+    if constexpr (M == Dynamic && P == Dynamic) {
+        Mat<T, M, P> result (lhs.nrows(), rhs.ncols());
+        multiply(lhs, rhs, result);
+        return result;
+    } else {
+        Mat<T, M, P> result ( T(0) );
+        multiply(lhs, rhs, result);
+        return result;
+    }
+}
+
+/**
+ * Copy of a matrix with another element type. Rows move between
+ * float and Half or BFloat16 with the bulk conversions, in parallel
+ * for large matrices; other types are cast element by element, so
+ * that doubles reach the 16-bit formats through float.
+ *
+ * @param m the matrix
+ * @return the matrix with elements of type To, packed
+ * */
+template<typename To, typename From, int M, int N>
+Mat<To, M, N> convert(const Mat<From, M, N>& m) {
+    Mat<To, M, N> result = [&]() {
+        if constexpr (M == Dynamic && N == Dynamic)
+            return Mat<To, M, N> (m.nrows(), m.ncols());
+        else
+            return Mat<To, M, N> ( To(0) );
+    }();
+    const std::size_t cols = m.ncols(), lds = m.ld(), ldd = result.ld();
+    const From* src = m.raw();
+    To* dst = result.raw();
+    auto rows = [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            if constexpr ((std::is_same_v<From, float> && is_low_precision_v<To>)
+                    || (is_low_precision_v<From> && std::is_same_v<To, float>)) {
+                convert(src + i * lds, dst + i * ldd, cols);
+            } else {
+                for (std::size_t j = 0; j < cols; ++j)
+                    dst[i * ldd + j] = To(src[i * lds + j]);
+            }
+        }
+    };
+    const std::size_t grain = std::max<std::size_t>(1, (std::size_t(1) << 16) / std::max<std::size_t>(cols, 1));
+    if (std::size_t(m.nrows()) <= grain)
+        rows(0, m.nrows());
+    else
+        parallel::parallel_for(0, m.nrows(), grain, rows);
     return result;
 }
 
@@ -527,7 +667,7 @@ inline Mat<T, M, N> operator/(const T scalar, const Mat<T, M, N>& m) {
  * */
 template<typename T, int M, int N, int O, int P>
 bool operator==(const Mat<T, M, N>& lhs, const Mat<T, O, P>& rhs) {
-    if (O != M || P != N)
+    if (O != M || P != N || lhs.nrows() != rhs.nrows() || lhs.ncols() != rhs.ncols())
         return false;
     for (auto i = 0; i < rhs.nrows(); ++i) {
         for (auto j = 0; j < rhs.ncols(); ++j) {
@@ -542,14 +682,15 @@ bool operator==(const Mat<T, M, N>& lhs, const Mat<T, O, P>& rhs) {
 
 template<typename T, int N, int M>
 std::ostream& operator<<(std::ostream& out, const tao::Mat<T, N, M>& mat) {
-    out << "[" << std::endl;
-    for (auto i {0}; i < N; ++i) {
-        for (auto j {0}; j < M; ++j) {
-            out << mat(i, j) << " ";
+    out << "[\n";
+    for (auto i {0}; i < mat.nrows(); ++i) {
+        const T* row = mat.raw() + i * mat.ld();
+        for (auto j {0}; j < mat.ncols(); ++j) {
+            out << row[j] << ' ';
         }
-        out << std::endl;
+        out << '\n';
     }
-    out << "]" << std::endl;
+    out << "]\n";
     return out;
 }
 
@@ -1,46 +1,85 @@
 #ifndef _FIXED_TAO_OPERATIONS_
 #define _FIXED_TAO_OPERATIONS_
 
+#include <algorithm>
 #include <cmath>
 #include "tao/linalg/Mat.h"
+#include "tao/linalg/Reductions.h"
 
 namespace tao {
 
 /**
- * Computes the norm of a vector.
+ * Computes the dot product between vectors. Small fixed-size vectors
+ * are handled inline, others by the parallel reduction engine.
  *
  * @param v1 the first vector
- * @return the cross product
+ * @param v2 the second vector
+ * @param mode the summation mode
+ * @return the dot product
  * */
 template<typename T, int N>
-T norm(const Mat<T, N, 1>& v1) {
-    return std::sqrt((v1.t() * v1)(0));
+accumulator_t<T> dot(const Mat<T, N, 1>& v1, const Mat<T, N, 1>& v2, Summation mode = Naive) {
+    if constexpr (N != Dynamic && N <= reduction_lanes) {
+        using A = accumulator_t<T>;
+        const T* a = v1.raw();
+        const T* b = v2.raw();
+        A r { 0 };
+        for (auto i {0}; i < N; ++i)
+            r += A(a[i]) * A(b[i]);
+        return r;
+    } else {
+        return tao::inner(v1, v2, mode);
+    }
 }
 
 /**
- * Computes the unit version of a vector.
+ * Computes the dot product between dynamic vectors, rows or columns,
+ * with the parallel reduction engine.
  *
  * @param v1 the first vector
- * @return the unit version of a vector.
+ * @param v2 the second vector
+ * @param mode the summation mode
+ * @return the dot product
+ * */
+template<typename T>
+accumulator_t<T> dot(const Mat<T, Dynamic, Dynamic>& v1, const Mat<T, Dynamic, Dynamic>& v2, Summation mode = Naive) {
+    if (v1.nrows() != 1 && v1.ncols() != 1)
+        throw std::invalid_argument("dot product is defined only for vectors");
+    return tao::inner(v1, v2, mode);
+}
+
+/**
+ * Computes the norm of a dynamic vector, or the Frobenius norm of a matrix.
+ *
+ * @param v1 the vector
+ * @param mode the summation mode
+ * @return the Euclidean norm
+ * */
+template<typename T>
+accumulator_t<T> norm(const Mat<T, Dynamic, Dynamic>& v1, Summation mode = Naive) {
+    return tao::norm_l2(v1, mode);
+}
+
+/**
+ * Computes the norm of a vector.
+ *
+ * @param v1 the first vector
+ * @return the Euclidean norm
  * */
 template<typename T, int N>
-Mat<T, N, 1> unitize(const Mat<T, N, 1>& v1) {
-    return v1 / tao::norm(v1);
+accumulator_t<T> norm(const Mat<T, N, 1>& v1) {
+    return std::sqrt(tao::dot(v1, v1));
 }
 
 /**
- * Computes the dot product between vectors.
+ * Computes the unit version of a vector.
  *
  * @param v1 the first vector
- * @param v2 the second vector
- * @return the cross product
+ * @return the unit version of a vector.
  * */
 template<typename T, int N>
-T dot(const Mat<T, N, 1>& v1, const Mat<T, N, 1>& v2) {
-    T r { 0.0 };
-    for (auto i {0}; i < N; ++i)
-        r += v1(i) * v2(i);
-    return r;
+Mat<T, N, 1> unitize(const Mat<T, N, 1>& v1) {
+    return v1 / tao::norm(v1);
 }
 
 /**
@@ -53,11 +92,14 @@ T dot(const Mat<T, N, 1>& v1, const Mat<T, N, 1>& v2) {
  * */
 template<typename T>
 Mat<T, 3, 1> cross(const Mat<T, 3, 1>& v1, const Mat<T, 3, 1>& v2) {
-    return tao::Mat<T, 3, 1>{
-        (v1(1) * v2(2) - v1(2) * v2(1)), 
-        (-(v1(0) * v2(2) - v1(2) * v2(0))), 
-        (v1(0) * v2(1) - v1(1) * v2(0))
-    };
+    const T* a = v1.raw();
+    const T* b = v2.raw();
+    Mat<T, 3, 1> result (T(0));
+    T* r = result.raw();
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+    return result;
 }
 
 template<typename T>
@@ -118,20 +160,33 @@ T lerp(float t, const Mat<T, 3, 1>& p0, const tao::Mat<T, 3, 1>& p1) {
     return (1 - t) * p0 + t * p1;
 }
 
+/**
+ * Polar angle of a direction, measured from +z. Batches are
+ * handled by math::spherical_theta.
+ *
+ * @param v the direction, of any length
+ * @return the angle in [0, pi], 0 for the zero vector
+ * */
 template<typename T>
-float spherical_theta(const Mat<T, 3, 1>& v) {
-    auto norm = tao::norm(v);
-    if (norm > 0.0f)
-        return std::acos(v(2)/tao::norm(v)); 
-    return 0.0f;
+T spherical_theta(const Mat<T, 3, 1>& v) {
+    const T* a = v.raw();
+    const T len2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    if (!(len2 > T(0)))
+        return T(0);
+    // rounding may take the cosine slightly out of [-1, 1]
+    return std::acos(std::min(T(1), std::max(T(-1), a[2] / std::sqrt(len2))));
 }
 
+/**
+ * Azimuth of a direction, measured from +x towards +y. Batches
+ * are handled by math::spherical_phi.
+ *
+ * @param v the direction
+ * @return the angle in [-pi, pi]
+ * */
 template<typename T>
-float spherical_phi(const Mat<T, 3, 1>& v) {
-    if (v(0) != 0)
-        return std::atan2(v(1), v(0)); 
-    else 
-        return 0.0f;
+T spherical_phi(const Mat<T, 3, 1>& v) {
+    return std::atan2(v.raw()[1], v.raw()[0]);
 }
 
 template<typename T, int M>
@@ -0,0 +1,587 @@
+#ifndef _TAO_QUAT_
+#define _TAO_QUAT_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "tao/linalg/Mat.h"
+
+namespace tao {
+
+/**
+ * A quaternion w + xi + yj + zk. Unit quaternions represent
+ * rotations; q and -q represent the same one.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct Quat {
+
+    T w {1};    /** real part */
+    T x {0};    /** i component */
+    T y {0};    /** j component */
+    T z {0};    /** k component */
+
+    /**
+     * The identity rotation.
+     * */
+    Quat() = default;
+
+    /**
+     * Quaternion from its components.
+     *
+     * @param w real part
+     * @param x i component
+     * @param y j component
+     * @param z k component
+     * */
+    Quat(T w, T x, T y, T z) : w {w}, x {x}, y {y}, z {z} {}
+
+    /**
+     * Rotation about an axis.
+     *
+     * @param axis the axis, of any nonzero length
+     * @param angle the angle in radians, counterclockwise looking down the axis
+     * @return the unit quaternion
+     * */
+    static Quat axis_angle(const Mat<T, 3, 1>& axis, T angle) {
+        const T* a = axis.raw();
+        const T len = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        if (!(len > T(0)))
+            throw std::invalid_argument("rotation axis must be nonzero");
+        const T s = std::sin(angle / T(2)) / len;
+        return Quat {std::cos(angle / T(2)), a[0] * s, a[1] * s, a[2] * s};
+    }
+
+    /**
+     * Rotation of a rotation matrix, by Shepperd's method: the
+     * largest of the four diagonal combinations is used as the
+     * pivot, so that no division is ill-conditioned.
+     *
+     * @param m an orthonormal matrix with determinant 1
+     * @return the unit quaternion
+     * */
+    static Quat from_matrix(const Mat<T, 3, 3>& m) {
+        return from_rows(m.raw(), m.ld());
+    }
+
+    /**
+     * Rotation of the upper-left 3x3 block of a transform.
+     *
+     * @param m a transform whose 3x3 block is a rotation
+     * @return the unit quaternion
+     * */
+    static Quat from_matrix(const Mat<T, 4, 4>& m) {
+        return from_rows(m.raw(), m.ld());
+    }
+
+    /**
+     * Hamilton product: the rotation by rhs, then by this.
+     *
+     * @param rhs the right factor
+     * @return the product, 16 multiplies
+     * */
+    Quat operator*(const Quat& rhs) const {
+        return Quat {
+            w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+            w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+            w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+            w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w
+        };
+    }
+
+    Quat operator+(const Quat& rhs) const { return Quat {w + rhs.w, x + rhs.x, y + rhs.y, z + rhs.z}; }
+
+    Quat operator-(const Quat& rhs) const { return Quat {w - rhs.w, x - rhs.x, y - rhs.y, z - rhs.z}; }
+
+    Quat operator-() const { return Quat {-w, -x, -y, -z}; }
+
+    Quat operator*(T s) const { return Quat {w * s, x * s, y * s, z * s}; }
+
+    bool operator==(const Quat& rhs) const { return w == rhs.w && x == rhs.x && y == rhs.y && z == rhs.z; }
+
+    bool operator!=(const Quat& rhs) const { return !(*this == rhs); }
+
+    /**
+     * The conjugate, which is the inverse of a unit quaternion.
+     *
+     * @return w - xi - yj - zk
+     * */
+    Quat conjugate() const { return Quat {w, -x, -y, -z}; }
+
+    /**
+     * Squared norm.
+     *
+     * @return w^2 + x^2 + y^2 + z^2
+     * */
+    T norm2() const { return w * w + x * x + y * y + z * z; }
+
+    /**
+     * Norm.
+     *
+     * @return the square root of norm2()
+     * */
+    T norm() const { return std::sqrt(norm2()); }
+
+    /**
+     * Unit quaternion of the same direction.
+     *
+     * @return this over its norm
+     * */
+    Quat normalized() const {
+        const T n = norm();
+        if (!(n > T(0)))
+            throw std::invalid_argument("cannot normalize a zero quaternion");
+        return *this * (T(1) / n);
+    }
+
+    /**
+     * Rotates a vector by a unit quaternion, as
+     * v + w t + u x t with u = (x, y, z) and t = 2 u x v,
+     * in 18 multiplies and 12 additions.
+     *
+     * @param v the vector
+     * @return the rotated vector
+     * */
+    Mat<T, 3, 1> rotate(const Mat<T, 3, 1>& v) const {
+        Mat<T, 3, 1> result (T(0));
+        rotate(v.raw(), result.raw());
+        return result;
+    }
+
+    /**
+     * Rotates a vector given by its coordinates.
+     *
+     * @param v the vector
+     * @param out the rotated vector, which may be v
+     * */
+    void rotate(const T* v, T* out) const {
+        const T tx = T(2) * (y * v[2] - z * v[1]);
+        const T ty = T(2) * (z * v[0] - x * v[2]);
+        const T tz = T(2) * (x * v[1] - y * v[0]);
+        const T ox = v[0] + w * tx + (y * tz - z * ty);
+        const T oy = v[1] + w * ty + (z * tx - x * tz);
+        const T oz = v[2] + w * tz + (x * ty - y * tx);
+        out[0] = ox;
+        out[1] = oy;
+        out[2] = oz;
+    }
+
+    /**
+     * Rotation matrix of a unit quaternion, acting on column vectors.
+     *
+     * @return the 3x3 rotation
+     * */
+    Mat<T, 3, 3> to_mat3() const {
+        Mat<T, 3, 3> m (T(0));
+        to_rows(m.raw(), m.ld());
+        return m;
+    }
+
+    /**
+     * Homogeneous transform of a unit quaternion.
+     *
+     * @return the 4x4 rotation, without translation
+     * */
+    Mat<T, 4, 4> to_mat4() const {
+        Mat<T, 4, 4> m (T(0));
+        to_rows(m.raw(), m.ld());
+        m.raw()[3 * m.ld() + 3] = T(1);
+        return m;
+    }
+
+    /**
+     * Writes the rotation matrix into the first three rows and
+     * columns of a row-major array.
+     *
+     * @param m the array
+     * @param ld its leading dimension
+     * */
+    void to_rows(T* m, int ld) const {
+        const T xx = x * x, yy = y * y, zz = z * z;
+        const T xy = x * y, xz = x * z, yz = y * z;
+        const T wx = w * x, wy = w * y, wz = w * z;
+        m[0] = T(1) - T(2) * (yy + zz);
+        m[1] = T(2) * (xy - wz);
+        m[2] = T(2) * (xz + wy);
+        m[ld] = T(2) * (xy + wz);
+        m[ld + 1] = T(1) - T(2) * (xx + zz);
+        m[ld + 2] = T(2) * (yz - wx);
+        m[2 * ld] = T(2) * (xz - wy);
+        m[2 * ld + 1] = T(2) * (yz + wx);
+        m[2 * ld + 2] = T(1) - T(2) * (xx + yy);
+    }
+
+    /**
+     * Rotation of the 3x3 block of a row-major array.
+     *
+     * @param m the array
+     * @param ld its leading dimension
+     * @return the unit quaternion
+     * */
+    static Quat from_rows(const T* m, int ld) {
+        const T m00 = m[0], m01 = m[1], m02 = m[2];
+        const T m10 = m[ld], m11 = m[ld + 1], m12 = m[ld + 2];
+        const T m20 = m[2 * ld], m21 = m[2 * ld + 1], m22 = m[2 * ld + 2];
+        const T trace = m00 + m11 + m22;
+        Quat q;
+        if (trace > T(0)) {
+            const T s = std::sqrt(trace + T(1)) * T(2);
+            q = Quat {s / T(4), (m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s};
+        } else if (m00 > m11 && m00 > m22) {
+            const T s = std::sqrt(T(1) + m00 - m11 - m22) * T(2);
+            q = Quat {(m21 - m12) / s, s / T(4), (m01 + m10) / s, (m02 + m20) / s};
+        } else if (m11 > m22) {
+            const T s = std::sqrt(T(1) + m11 - m00 - m22) * T(2);
+            q = Quat {(m02 - m20) / s, (m01 + m10) / s, s / T(4), (m12 + m21) / s};
+        } else {
+            const T s = std::sqrt(T(1) + m22 - m00 - m11) * T(2);
+            q = Quat {(m10 - m01) / s, (m02 + m20) / s, (m12 + m21) / s, s / T(4)};
+        }
+        return q.normalized();
+    }
+};
+
+/**
+ * Dot product of quaternions as 4-vectors.
+ *
+ * @param a a quaternion
+ * @param b a quaternion
+ * @return the cosine of half the angle between unit a and b
+ * */
+template<typename T>
+T dot(const Quat<T>& a, const Quat<T>& b) {
+    return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/**
+ * Normalized linear interpolation along the shortest arc: cheaper
+ * than slerp, with the same path but a nonuniform speed.
+ *
+ * @param a rotation at t = 0
+ * @param b rotation at t = 1
+ * @param t the parameter, in [0, 1]
+ * @return the unit quaternion
+ * */
+template<typename T>
+Quat<T> nlerp(const Quat<T>& a, const Quat<T>& b, T t) {
+    const T s = dot(a, b) < T(0) ? -t : t;
+    return (a * (T(1) - t) + b * s).normalized();
+}
+
+/**
+ * Spherical linear interpolation along the shortest arc, at
+ * constant angular speed. Nearly equal rotations fall back to nlerp.
+ *
+ * @param a rotation at t = 0
+ * @param b rotation at t = 1
+ * @param t the parameter, in [0, 1]
+ * @return the unit quaternion
+ * */
+template<typename T>
+Quat<T> slerp(const Quat<T>& a, const Quat<T>& b, T t) {
+    T c = dot(a, b);
+    const T sign = c < T(0) ? T(-1) : T(1);
+    c *= sign;
+    if (c > T(1) - T(16) * std::numeric_limits<T>::epsilon())
+        return nlerp(a, b, t);
+    const T theta = std::acos(c);
+    const T inv_sin = T(1) / std::sin(theta);
+    const T s0 = std::sin((T(1) - t) * theta) * inv_sin;
+    const T s1 = sign * std::sin(t * theta) * inv_sin;
+    return a * s0 + b * s1;
+}
+
+/**
+ * Quaternions stored as component arrays, for batches of joints.
+ * */
+template<typename T>
+struct QuatSoA {
+
+    std::vector<T> w, x, y, z;
+
+    /**
+     * Batch of identity rotations.
+     *
+     * @param n the number of quaternions
+     * */
+    explicit QuatSoA(std::size_t n = 0) : w (n, T(1)), x (n, T(0)), y (n, T(0)), z (n, T(0)) {}
+
+    /**
+     * Number of quaternions.
+     *
+     * @return the batch size
+     * */
+    std::size_t size() const { return w.size(); }
+
+    /**
+     * Stores a quaternion.
+     *
+     * @param i its position
+     * @param q the quaternion
+     * */
+    void set(std::size_t i, const Quat<T>& q) {
+        w[i] = q.w;
+        x[i] = q.x;
+        y[i] = q.y;
+        z[i] = q.z;
+    }
+
+    /**
+     * Loads a quaternion.
+     *
+     * @param i its position
+     * @return the quaternion
+     * */
+    Quat<T> get(std::size_t i) const { return Quat<T> {w[i], x[i], y[i], z[i]}; }
+};
+
+namespace kernels {
+
+/**
+ * Quaternions per block of the batched kernels. Blocks are copied to
+ * local arrays, which cannot alias the batches, so that the arithmetic
+ * vectorizes even when the output is one of the inputs.
+ * */
+constexpr std::size_t quat_lanes = 8;
+
+/**
+ * Coefficients of Eberly's polynomial slerp: u_i = 1 / (i (2i + 1)),
+ * v_i = i / (2i + 1), the last pair scaled by 1 + mu to absorb the
+ * truncation error. With 12 terms, the weights are within 7.2e-7 of
+ * sin(t theta) / sin(theta) over the whole shortest-arc range.
+ * */
+template<typename T>
+struct SlerpCoefficients {
+    static constexpr int terms = 12;
+    T u[terms], v[terms];
+
+    SlerpCoefficients() {
+        for (int i = 1; i <= terms; ++i) {
+            u[i - 1] = T(1) / T(i * (2 * i + 1));
+            v[i - 1] = T(i) / T(2 * i + 1);
+        }
+        const T one_plus_mu = T(1.89372);
+        u[terms - 1] *= one_plus_mu;
+        v[terms - 1] *= one_plus_mu;
+    }
+
+    /**
+     * sin(t theta) / sin(theta), where cos(theta) = c is in [0, 1].
+     * */
+    T weight(T t, T c) const {
+        const T cm1 = c - T(1), t2 = t * t;
+        T f = T(1);
+        for (int i = terms - 1; i >= 0; --i)
+            f = T(1) + (u[i] * t2 - v[i]) * cm1 * f;
+        return t * f;
+    }
+};
+
+
+/**
+ * A block of quaternions, missing lanes being identities.
+ * */
+template<typename T>
+struct QuatLanes {
+    T w[quat_lanes], x[quat_lanes], y[quat_lanes], z[quat_lanes];
+
+    void load(const QuatSoA<T>& q, std::size_t i, std::size_t m) {
+        if (m == quat_lanes) {
+            std::copy_n(q.w.data() + i, quat_lanes, w);
+            std::copy_n(q.x.data() + i, quat_lanes, x);
+            std::copy_n(q.y.data() + i, quat_lanes, y);
+            std::copy_n(q.z.data() + i, quat_lanes, z);
+            return;
+        }
+        for (std::size_t l = 0; l < quat_lanes; ++l) {
+            const bool in = l < m;
+            w[l] = in ? q.w[i + l] : T(1);
+            x[l] = in ? q.x[i + l] : T(0);
+            y[l] = in ? q.y[i + l] : T(0);
+            z[l] = in ? q.z[i + l] : T(0);
+        }
+    }
+
+    void store(QuatSoA<T>& q, std::size_t i, std::size_t m) const {
+        for (std::size_t l = 0; l < m; ++l) {
+            q.w[i + l] = w[l];
+            q.x[i + l] = x[l];
+            q.y[i + l] = y[l];
+            q.z[i + l] = z[l];
+        }
+    }
+};
+
+/**
+ * Checks that batches have the same size.
+ * */
+template<typename T>
+void check_sizes(const QuatSoA<T>& a, const QuatSoA<T>& b, const QuatSoA<T>& out) {
+    if (b.size() != a.size() || out.size() != a.size())
+        throw std::invalid_argument("quaternion batches must have the same size");
+}
+
+};
+
+/**
+ * Products out[i] = a[i] * b[i], as when composing joint rotations
+ * with their parents.
+ *
+ * @param a the left factors
+ * @param b the right factors
+ * @param out the products, of the same size, which may alias a or b
+ * */
+template<typename T>
+void multiply(const QuatSoA<T>& a, const QuatSoA<T>& b, QuatSoA<T>& out) {
+    kernels::check_sizes(a, b, out);
+    for (std::size_t i = 0, n = a.size(); i < n; i += kernels::quat_lanes) {
+        const std::size_t m = std::min(kernels::quat_lanes, n - i);
+        kernels::QuatLanes<T> p, q, r;
+        p.load(a, i, m);
+        q.load(b, i, m);
+        for (std::size_t l = 0; l < kernels::quat_lanes; ++l) {
+            r.w[l] = p.w[l] * q.w[l] - p.x[l] * q.x[l] - p.y[l] * q.y[l] - p.z[l] * q.z[l];
+            r.x[l] = p.w[l] * q.x[l] + p.x[l] * q.w[l] + p.y[l] * q.z[l] - p.z[l] * q.y[l];
+            r.y[l] = p.w[l] * q.y[l] - p.x[l] * q.z[l] + p.y[l] * q.w[l] + p.z[l] * q.x[l];
+            r.z[l] = p.w[l] * q.z[l] + p.x[l] * q.y[l] - p.y[l] * q.x[l] + p.z[l] * q.w[l];
+        }
+        r.store(out, i, m);
+    }
+}
+
+/**
+ * Normalizes every quaternion of a batch.
+ *
+ * @param q the batch
+ * */
+template<typename T>
+void normalize(QuatSoA<T>& q) {
+    for (std::size_t i = 0, n = q.size(); i < n; i += kernels::quat_lanes) {
+        const std::size_t m = std::min(kernels::quat_lanes, n - i);
+        kernels::QuatLanes<T> p;
+        p.load(q, i, m);
+        for (std::size_t l = 0; l < kernels::quat_lanes; ++l) {
+            const T s = T(1) / std::sqrt(p.w[l] * p.w[l] + p.x[l] * p.x[l] + p.y[l] * p.y[l] + p.z[l] * p.z[l]);
+            p.w[l] *= s;
+            p.x[l] *= s;
+            p.y[l] *= s;
+            p.z[l] *= s;
+        }
+        p.store(q, i, m);
+    }
+}
+
+/**
+ * Normalized linear interpolation of every pair of a batch.
+ *
+ * @param a rotations at t = 0
+ * @param b rotations at t = 1
+ * @param t the parameter, in [0, 1]
+ * @param out the interpolated unit quaternions, which may alias a or b
+ * */
+template<typename T>
+void nlerp(const QuatSoA<T>& a, const QuatSoA<T>& b, T t, QuatSoA<T>& out) {
+    kernels::check_sizes(a, b, out);
+    for (std::size_t i = 0, n = a.size(); i < n; i += kernels::quat_lanes) {
+        const std::size_t m = std::min(kernels::quat_lanes, n - i);
+        kernels::QuatLanes<T> p, q, r;
+        p.load(a, i, m);
+        q.load(b, i, m);
+        for (std::size_t l = 0; l < kernels::quat_lanes; ++l) {
+            const T c = p.w[l] * q.w[l] + p.x[l] * q.x[l] + p.y[l] * q.y[l] + p.z[l] * q.z[l];
+            const T s0 = T(1) - t, s1 = c < T(0) ? -t : t;
+            const T w = s0 * p.w[l] + s1 * q.w[l], x = s0 * p.x[l] + s1 * q.x[l];
+            const T y = s0 * p.y[l] + s1 * q.y[l], z = s0 * p.z[l] + s1 * q.z[l];
+            const T s = T(1) / std::sqrt(w * w + x * x + y * y + z * z);
+            r.w[l] = w * s;
+            r.x[l] = x * s;
+            r.y[l] = y * s;
+            r.z[l] = z * s;
+        }
+        r.store(out, i, m);
+    }
+}
+
+/**
+ * Spherical linear interpolation of every pair of a batch, along the
+ * shortest arc. Instead of acos and sin, the weights are evaluated
+ * with Eberly's polynomial approximation, which has no branches and
+ * vectorizes; it agrees with slerp to within 1e-6.
+ *
+ * @param a rotations at t = 0
+ * @param b rotations at t = 1
+ * @param t the parameter, in [0, 1]
+ * @param out the interpolated quaternions, which may alias a or b
+ * */
+template<typename T>
+void slerp(const QuatSoA<T>& a, const QuatSoA<T>& b, T t, QuatSoA<T>& out) {
+    kernels::check_sizes(a, b, out);
+    const kernels::SlerpCoefficients<T> coefficients;
+    for (std::size_t i = 0, n = a.size(); i < n; i += kernels::quat_lanes) {
+        const std::size_t m = std::min(kernels::quat_lanes, n - i);
+        kernels::QuatLanes<T> p, q, r;
+        p.load(a, i, m);
+        q.load(b, i, m);
+        for (std::size_t l = 0; l < kernels::quat_lanes; ++l) {
+            const T c = p.w[l] * q.w[l] + p.x[l] * q.x[l] + p.y[l] * q.y[l] + p.z[l] * q.z[l];
+            const T sign = c < T(0) ? T(-1) : T(1);
+            const T s0 = coefficients.weight(T(1) - t, sign * c);
+            const T s1 = sign * coefficients.weight(t, sign * c);
+            r.w[l] = s0 * p.w[l] + s1 * q.w[l];
+            r.x[l] = s0 * p.x[l] + s1 * q.x[l];
+            r.y[l] = s0 * p.y[l] + s1 * q.y[l];
+            r.z[l] = s0 * p.z[l] + s1 * q.z[l];
+        }
+        r.store(out, i, m);
+    }
+}
+
+/**
+ * Rotates vectors stored as coordinate arrays, vector i by
+ * quaternion i, in the form of Quat::rotate: 18 multiplies and 12
+ * additions per vector.
+ *
+ * @param q the unit quaternions
+ * @param vx x coordinates, q.size() of them
+ * @param vy y coordinates
+ * @param vz z coordinates
+ * @param ox rotated x coordinates, which may alias vx
+ * @param oy rotated y coordinates, which may alias vy
+ * @param oz rotated z coordinates, which may alias vz
+ * */
+template<typename T>
+void rotate(const QuatSoA<T>& q, const T* vx, const T* vy, const T* vz, T* ox, T* oy, T* oz) {
+    constexpr std::size_t W = kernels::quat_lanes;
+    for (std::size_t i = 0, n = q.size(); i < n; i += W) {
+        const std::size_t m = std::min(W, n - i);
+        kernels::QuatLanes<T> p;
+        p.load(q, i, m);
+        T x[W], y[W], z[W];
+        for (std::size_t l = 0; l < W; ++l) {
+            x[l] = l < m ? vx[i + l] : T(0);
+            y[l] = l < m ? vy[i + l] : T(0);
+            z[l] = l < m ? vz[i + l] : T(0);
+        }
+        for (std::size_t l = 0; l < W; ++l) {
+            const T tx = T(2) * (p.y[l] * z[l] - p.z[l] * y[l]);
+            const T ty = T(2) * (p.z[l] * x[l] - p.x[l] * z[l]);
+            const T tz = T(2) * (p.x[l] * y[l] - p.y[l] * x[l]);
+            x[l] += p.w[l] * tx + (p.y[l] * tz - p.z[l] * ty);
+            y[l] += p.w[l] * ty + (p.z[l] * tx - p.x[l] * tz);
+            z[l] += p.w[l] * tz + (p.x[l] * ty - p.y[l] * tx);
+        }
+        for (std::size_t l = 0; l < m; ++l) {
+            ox[i + l] = x[l];
+            oy[i + l] = y[l];
+            oz[i + l] = z[l];
+        }
+    }
+}
+
+};
+
+#endif
@@ -0,0 +1,476 @@
+#ifndef _TAO_REDUCTIONS_
+#define _TAO_REDUCTIONS_
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+#include "tao/linalg/Half.h"
+#include "tao/linalg/Mat.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * How terms are accumulated by the reductions.
+ * */
+enum Summation {
+    Naive = 0,      /** independent lane accumulators, error grows with n */
+    Kahan = 1,      /** compensated lanes, error independent of n */
+    Pairwise = 2    /** recursive halving, error grows with log n */
+};
+
+/**
+ * Number of independent accumulators per reduction: enough to
+ * hide the latency of the adds and fill an AVX register.
+ * */
+constexpr int reduction_lanes = 8;
+
+/**
+ * Below this many elements, pairwise summation adds lanes directly.
+ * */
+constexpr std::size_t pairwise_block = 256;
+
+/**
+ * Elements per task of parallel reductions, and twice the size from
+ * which they split, from tuning::profile().
+ *
+ * @return the current grain
+ * */
+std::size_t reduction_grain();
+
+namespace kernels {
+
+/**
+ * Sums term(i) for i in [lo, hi) with reduction_lanes accumulators.
+ *
+ * @param lo first index
+ * @param hi one past the last index
+ * @param term the term generator
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T lane_sum(std::size_t lo, std::size_t hi, Term&& term) {
+    T acc[reduction_lanes] = {};
+    std::size_t i = lo;
+    for (; i + reduction_lanes <= hi; i += reduction_lanes)
+        for (int l = 0; l < reduction_lanes; ++l)
+            acc[l] += term(i + l);
+    for (int l = 0; i < hi; ++i, ++l)
+        acc[l] += term(i);
+    for (int w = reduction_lanes / 2; w > 0; w /= 2)
+        for (int l = 0; l < w; ++l)
+            acc[l] += acc[l + w];
+    return acc[0];
+}
+
+/**
+ * Sums term(i) for i in [lo, hi) with compensated lane accumulators.
+ *
+ * @param lo first index
+ * @param hi one past the last index
+ * @param term the term generator
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T kahan_sum(std::size_t lo, std::size_t hi, Term&& term) {
+    T acc[reduction_lanes] = {};
+    T comp[reduction_lanes] = {};
+    std::size_t i = lo;
+    for (; i + reduction_lanes <= hi; i += reduction_lanes) {
+        for (int l = 0; l < reduction_lanes; ++l) {
+            T y = term(i + l) - comp[l];
+            T t = acc[l] + y;
+            comp[l] = (t - acc[l]) - y;
+            acc[l] = t;
+        }
+    }
+    for (int l = 0; i < hi; ++i, ++l) {
+        T y = term(i) - comp[l];
+        T t = acc[l] + y;
+        comp[l] = (t - acc[l]) - y;
+        acc[l] = t;
+    }
+    T sum {0}, c {0};
+    for (int l = 0; l < reduction_lanes; ++l) {
+        T y = (acc[l] - comp[l]) - c;
+        T t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    }
+    return sum;
+}
+
+/**
+ * Sums term(i) for i in [lo, hi) by recursive halving.
+ *
+ * @param lo first index
+ * @param hi one past the last index
+ * @param term the term generator
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T pairwise_sum(std::size_t lo, std::size_t hi, Term&& term) {
+    if (hi - lo <= pairwise_block)
+        return lane_sum<T>(lo, hi, term);
+    std::size_t mid = lo + ((hi - lo) / 2 / reduction_lanes) * reduction_lanes;
+    return pairwise_sum<T>(lo, mid, term) + pairwise_sum<T>(mid, hi, term);
+}
+
+/**
+ * Serial sum of term(i) for i in [lo, hi).
+ *
+ * @param lo first index
+ * @param hi one past the last index
+ * @param term the term generator
+ * @param mode the summation mode
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T accumulate_serial(std::size_t lo, std::size_t hi, Term&& term, Summation mode) {
+    switch (mode) {
+        case Kahan: return kahan_sum<T>(lo, hi, term);
+        case Pairwise: return pairwise_sum<T>(lo, hi, term);
+        default: return lane_sum<T>(lo, hi, term);
+    }
+}
+
+/**
+ * Sum of term(i) for i in [0, n) in deterministic mode: terms are
+ * summed in blocks of fixed size, whatever the number of threads,
+ * and the block sums are combined by the same pairwise tree, so
+ * the result is the same on any number of threads.
+ *
+ * @param n number of terms
+ * @param term the term generator
+ * @param mode the summation mode
+ * @param cost elements touched per term
+ * @param grain elements per task, reduction_grain() by default
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T accumulate_deterministic(std::size_t n, Term&& term, Summation mode, std::size_t cost = 1,
+        std::size_t grain = reduction_grain()) {
+    std::size_t block = std::max<std::size_t>(1, parallel::deterministic_block / std::max<std::size_t>(cost, 1));
+    std::size_t blocks = (n + block - 1) / block;
+    if (blocks <= 1)
+        return accumulate_serial<T>(0, n, term, mode);
+    std::vector<T> partials (blocks);
+    std::size_t block_grain = std::max<std::size_t>(1, grain / (block * std::max<std::size_t>(cost, 1)));
+    parallel::parallel_for(0, blocks, block_grain, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b)
+            partials[b] = accumulate_serial<T>(b * block, std::min(n, (b + 1) * block), term, mode);
+    });
+    return accumulate_serial<T>(0, blocks, [&](std::size_t b) { return partials[b]; },
+            mode == Kahan ? Kahan : Pairwise);
+}
+
+/**
+ * Sum of term(i) for i in [0, n), split across threads when
+ * n * cost exceeds the grain. In deterministic
+ * mode, see accumulate_deterministic.
+ *
+ * @param n number of terms
+ * @param term the term generator
+ * @param mode the summation mode
+ * @param cost elements touched per term
+ * @param grain elements per task, reduction_grain() by default
+ * @return the sum
+ * */
+template<typename T, typename Term>
+T accumulate(std::size_t n, Term&& term, Summation mode, std::size_t cost = 1,
+        std::size_t grain = reduction_grain()) {
+    if (parallel::deterministic())
+        return accumulate_deterministic<T>(n, term, mode, cost, grain);
+    std::size_t terms = std::max<std::size_t>(1, grain / std::max<std::size_t>(cost, 1));
+    if (n < 2 * terms)
+        return accumulate_serial<T>(0, n, term, mode);
+    std::size_t tasks = std::min<std::size_t>(parallel::concurrency(), n / terms);
+    if (tasks <= 1)
+        return accumulate_serial<T>(0, n, term, mode);
+    std::vector<T> partials (tasks);
+    parallel::parallel_for(0, tasks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t t = lo; t < hi; ++t)
+            partials[t] = accumulate_serial<T>(n * t / tasks, n * (t + 1) / tasks, term, mode);
+    });
+    return accumulate_serial<T>(0, tasks, [&](std::size_t t) { return partials[t]; },
+            mode == Kahan ? Kahan : Pairwise);
+}
+
+/**
+ * Index of the best term(i) for i in [lo, hi) according to better,
+ * scanning reduction_lanes candidates at once. Ties go to the
+ * lowest index.
+ *
+ * @param lo first index, lower than hi
+ * @param hi one past the last index
+ * @param term the term generator
+ * @param better strict comparison
+ * @return the best value and its index
+ * */
+template<typename T, typename Term, typename Better>
+std::pair<T, std::size_t> select_serial(std::size_t lo, std::size_t hi, Term&& term, Better better) {
+    T best[reduction_lanes];
+    std::size_t where[reduction_lanes];
+    for (int l = 0; l < reduction_lanes; ++l) {
+        best[l] = term(lo);
+        where[l] = lo;
+    }
+    std::size_t i = lo;
+    for (; i + reduction_lanes <= hi; i += reduction_lanes) {
+        for (int l = 0; l < reduction_lanes; ++l) {
+            T v = term(i + l);
+            bool b = better(v, best[l]);
+            best[l] = b ? v : best[l];
+            where[l] = b ? i + l : where[l];
+        }
+    }
+    for (int l = 0; i < hi; ++i, ++l) {
+        T v = term(i);
+        if (better(v, best[l])) {
+            best[l] = v;
+            where[l] = i;
+        }
+    }
+    std::pair<T, std::size_t> result {best[0], where[0]};
+    for (int l = 1; l < reduction_lanes; ++l)
+        if (better(best[l], result.first) || (!better(result.first, best[l]) && where[l] < result.second))
+            result = {best[l], where[l]};
+    return result;
+}
+
+/**
+ * Parallel version of select_serial over [0, n).
+ *
+ * @param n number of terms, positive
+ * @param term the term generator
+ * @param better strict comparison
+ * @return the best value and its index
+ * */
+template<typename T, typename Term, typename Better>
+std::pair<T, std::size_t> select(std::size_t n, Term&& term, Better better) {
+    if (n == 0)
+        throw std::invalid_argument("selection over an empty matrix");
+    const std::size_t grain = reduction_grain();
+    if (n < 2 * grain)
+        return select_serial<T>(0, n, term, better);
+    std::size_t tasks = std::min<std::size_t>(parallel::concurrency(), n / grain);
+    if (tasks <= 1)
+        return select_serial<T>(0, n, term, better);
+    std::vector<std::pair<T, std::size_t>> partials (tasks);
+    parallel::parallel_for(0, tasks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t t = lo; t < hi; ++t)
+            partials[t] = select_serial<T>(n * t / tasks, n * (t + 1) / tasks, term, better);
+    });
+    auto result = partials[0];
+    for (std::size_t t = 1; t < tasks; ++t)
+        if (better(partials[t].first, result.first))
+            result = partials[t];
+    return result;
+}
+
+/**
+ * Sums f(x) over the elements of a matrix, honoring its leading
+ * dimension, in accumulator_t<T>.
+ *
+ * @param m the matrix
+ * @param f the map applied to every element
+ * @param mode the summation mode
+ * @return the sum
+ * */
+template<typename T, int M, int N, typename F>
+accumulator_t<T> map_sum(const Mat<T, M, N>& m, F f, Summation mode) {
+    using A = accumulator_t<T>;
+    const T* x = m.raw();
+    const std::size_t rows = m.nrows(), cols = m.ncols(), ld = m.ld();
+    if (ld == cols)
+        return accumulate<A>(rows * cols, [x, f](std::size_t k) { return A(f(x[k])); }, mode);
+    return accumulate<A>(rows, [&](std::size_t i) {
+        const T* row = x + i * ld;
+        return accumulate_serial<A>(0, cols, [row, f](std::size_t j) { return A(f(row[j])); }, mode);
+    }, mode, cols);
+}
+
+/**
+ * Sums f(x, y) over the elements of two matrices of the same shape,
+ * in accumulator_t<T>.
+ *
+ * @param a the first matrix
+ * @param b the second matrix
+ * @param f the map applied to every pair of elements
+ * @param mode the summation mode
+ * @return the sum
+ * */
+template<typename T, int M, int N, typename F>
+accumulator_t<T> zip_sum(const Mat<T, M, N>& a, const Mat<T, M, N>& b, F f, Summation mode) {
+    using A = accumulator_t<T>;
+    if (a.nrows() != b.nrows() || a.ncols() != b.ncols())
+        throw std::invalid_argument("can't reduce matrices with different dimensions");
+    const T* x = a.raw();
+    const T* y = b.raw();
+    const std::size_t rows = a.nrows(), cols = a.ncols(), lda = a.ld(), ldb = b.ld();
+    if (lda == cols && ldb == cols)
+        return accumulate<A>(rows * cols, [x, y, f](std::size_t k) { return A(f(x[k], y[k])); }, mode);
+    return accumulate<A>(rows, [&](std::size_t i) {
+        const T* rx = x + i * lda;
+        const T* ry = y + i * ldb;
+        return accumulate_serial<A>(0, cols, [rx, ry, f](std::size_t j) { return A(f(rx[j], ry[j])); }, mode);
+    }, mode, cols);
+}
+
+/**
+ * Best element of a matrix, returned with its row-major logical index.
+ *
+ * @param m the matrix
+ * @param better strict comparison
+ * @return the value and its index i * ncols() + j
+ * */
+template<typename T, int M, int N, typename Better>
+std::pair<T, std::size_t> select(const Mat<T, M, N>& m, Better better) {
+    const T* x = m.raw();
+    const std::size_t cols = m.ncols(), ld = m.ld();
+    std::size_t n = std::size_t(m.nrows()) * cols;
+    if (ld == cols)
+        return select<T>(n, [x](std::size_t k) { return x[k]; }, better);
+    return select<T>(n, [x, cols, ld](std::size_t k) { return x[(k / cols) * ld + k % cols]; }, better);
+}
+
+};
+
+/**
+ * Sum of all elements.
+ *
+ * @param m the matrix
+ * @param mode the summation mode
+ * @return the sum
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> sum(const Mat<T, M, N>& m, Summation mode = Naive) {
+    return kernels::map_sum(m, [](T x) { return accumulator_t<T>(x); }, mode);
+}
+
+/**
+ * Sum of the squares of all elements.
+ *
+ * @param m the matrix
+ * @param mode the summation mode
+ * @return the squared Euclidean (Frobenius) norm
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> squared_norm(const Mat<T, M, N>& m, Summation mode = Naive) {
+    return kernels::map_sum(m, [](T x) { const accumulator_t<T> a = x; return a * a; }, mode);
+}
+
+/**
+ * Sum of the absolute values of all elements.
+ *
+ * @param m the matrix
+ * @param mode the summation mode
+ * @return the L1 norm
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> norm_l1(const Mat<T, M, N>& m, Summation mode = Naive) {
+    return kernels::map_sum(m, [](T x) { const accumulator_t<T> a = x; return a < 0 ? -a : a; }, mode);
+}
+
+/**
+ * Euclidean norm of all elements.
+ *
+ * @param m the matrix
+ * @param mode the summation mode
+ * @return the L2 norm
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> norm_l2(const Mat<T, M, N>& m, Summation mode = Naive) {
+    return std::sqrt(squared_norm(m, mode));
+}
+
+/**
+ * Frobenius norm, i.e., the Euclidean norm of all elements.
+ *
+ * @param m the matrix
+ * @param mode the summation mode
+ * @return the Frobenius norm
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> norm_frobenius(const Mat<T, M, N>& m, Summation mode = Naive) {
+    return norm_l2(m, mode);
+}
+
+/**
+ * Largest absolute value among the elements.
+ *
+ * @param m the matrix
+ * @return the L-infinity norm
+ * */
+template<typename T, int M, int N>
+T norm_linf(const Mat<T, M, N>& m) {
+    if (m.nrows() == 0 || m.ncols() == 0)
+        return T(0);
+    auto abs_greater = [](T a, T b) { return (a < T(0) ? -a : a) > (b < T(0) ? -b : b); };
+    T v = kernels::select(m, abs_greater).first;
+    return v < T(0) ? -v : v;
+}
+
+/**
+ * Sum of the element-wise products of two matrices of the same shape.
+ *
+ * @param a the first matrix
+ * @param b the second matrix
+ * @param mode the summation mode
+ * @return the Frobenius inner product, the dot product for vectors
+ * */
+template<typename T, int M, int N>
+accumulator_t<T> inner(const Mat<T, M, N>& a, const Mat<T, M, N>& b, Summation mode = Naive) {
+    return kernels::zip_sum(a, b, [](T x, T y) { return accumulator_t<T>(x) * accumulator_t<T>(y); }, mode);
+}
+
+/**
+ * Smallest element.
+ *
+ * @param m the matrix, not empty
+ * @return the smallest element
+ * */
+template<typename T, int M, int N>
+T min(const Mat<T, M, N>& m) {
+    return kernels::select(m, [](T a, T b) { return a < b; }).first;
+}
+
+/**
+ * Largest element.
+ *
+ * @param m the matrix, not empty
+ * @return the largest element
+ * */
+template<typename T, int M, int N>
+T max(const Mat<T, M, N>& m) {
+    return kernels::select(m, [](T a, T b) { return a > b; }).first;
+}
+
+/**
+ * Position of the smallest element, the first one on ties.
+ *
+ * @param m the matrix, not empty
+ * @return its row-major index i * ncols() + j
+ * */
+template<typename T, int M, int N>
+std::size_t argmin(const Mat<T, M, N>& m) {
+    return kernels::select(m, [](T a, T b) { return a < b; }).second;
+}
+
+/**
+ * Position of the largest element, the first one on ties.
+ *
+ * @param m the matrix, not empty
+ * @return its row-major index i * ncols() + j
+ * */
+template<typename T, int M, int N>
+std::size_t argmax(const Mat<T, M, N>& m) {
+    return kernels::select(m, [](T a, T b) { return a > b; }).second;
+}
+
+};
+
+#endif
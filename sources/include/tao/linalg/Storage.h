@@ -0,0 +1,316 @@
+#ifndef _TAO_STORAGE_
+#define _TAO_STORAGE_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tao {
+
+/**
+ * Alignment, in bytes, of dynamically allocated matrix storage.
+ * Enough for aligned AVX-512 loads and a full cache line.
+ * */
+constexpr std::size_t default_alignment = 64;
+
+/**
+ * Buffers larger than this many bytes are filled and copied
+ * with non-temporal stores, so they do not evict the cache.
+ * */
+constexpr std::size_t nontemporal_threshold = std::size_t(1) << 20;
+
+/**
+ * Layout of the rows of a dynamic matrix.
+ * */
+enum StorageLayout {
+    Packed = 0,     /** rows are contiguous, stride equals cols */
+    Padded = 1      /** stride is rounded up to a multiple of the alignment */
+};
+
+/**
+ * Tells the compiler that a pointer is aligned.
+ *
+ * @param ptr the pointer
+ * @return the same pointer
+ * */
+template<std::size_t Alignment, typename T>
+inline T* assume_aligned(T* ptr) {
+    return static_cast<T*>(__builtin_assume_aligned(ptr, Alignment));
+}
+
+/**
+ * Checks whether a pointer is aligned.
+ *
+ * @param ptr the pointer
+ * @param alignment the alignment in bytes
+ * @return true if ptr is a multiple of alignment
+ * */
+inline bool is_aligned(const void* ptr, std::size_t alignment) {
+    return (reinterpret_cast<std::uintptr_t>(ptr) & (alignment - 1)) == 0;
+}
+
+/**
+ * Leading dimension of a row of cols elements, rounded up
+ * so that every row starts at an aligned address.
+ *
+ * @param cols the number of columns
+ * @return the padded leading dimension
+ * */
+template<typename T, std::size_t Alignment = default_alignment>
+constexpr int padded_stride(int cols) {
+    if constexpr (Alignment % sizeof(T) != 0) {
+        return cols;
+    } else {
+        constexpr int lanes = Alignment / sizeof(T);
+        return ((cols + lanes - 1) / lanes) * lanes;
+    }
+}
+
+/**
+ * Allocates size bytes aligned to alignment.
+ *
+ * @param size the number of bytes
+ * @param alignment the alignment, a power of two
+ * @return the memory, null only when size is 0; failures throw
+ * std::bad_alloc
+ * */
+inline void* aligned_malloc(std::size_t size, std::size_t alignment) {
+    if (size == 0)
+        return nullptr;
+    // rounding up to the alignment would wrap around
+    if (size > std::numeric_limits<std::size_t>::max() - (alignment - 1))
+        throw std::bad_alloc();
+    std::size_t rounded = ((size + alignment - 1) / alignment) * alignment;
+    void* ptr = std::aligned_alloc(alignment, rounded);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+/**
+ * Releases memory obtained by aligned_malloc.
+ *
+ * @param ptr the memory
+ * */
+inline void aligned_free(void* ptr) {
+    std::free(ptr);
+}
+
+/**
+ * Fills n elements with a value using streaming stores when the buffer
+ * is large enough to make cache pollution a concern.
+ *
+ * @param dst the destination
+ * @param n the number of elements
+ * @param val the value
+ * */
+template<typename T>
+void stream_fill(T* dst, std::size_t n, const T& val) {
+#if defined(__SSE2__)
+    if constexpr (std::is_trivially_copyable<T>::value && 16 % sizeof(T) == 0) {
+        if (n * sizeof(T) >= nontemporal_threshold) {
+            std::size_t i = 0;
+            while (i < n && !is_aligned(dst + i, 16))
+                dst[i++] = val;
+            alignas(16) unsigned char pattern[16];
+            for (std::size_t b = 0; b < 16; b += sizeof(T))
+                std::memcpy(pattern + b, &val, sizeof(T));
+            const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(pattern));
+            constexpr std::size_t per = 16 / sizeof(T);
+            for (; i + per <= n; i += per)
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), v);
+            _mm_sfence();
+            for (; i < n; ++i)
+                dst[i] = val;
+            return;
+        }
+    }
+#endif
+    std::fill(dst, dst + n, val);
+}
+
+/**
+ * Copies n elements using streaming stores when the buffer is large
+ * enough to make cache pollution a concern.
+ *
+ * @param dst the destination
+ * @param src the source
+ * @param n the number of elements
+ * */
+template<typename T>
+void stream_copy(T* dst, const T* src, std::size_t n) {
+#if defined(__SSE2__)
+    if constexpr (std::is_trivially_copyable<T>::value && 16 % sizeof(T) == 0) {
+        if (n * sizeof(T) >= nontemporal_threshold) {
+            std::size_t i = 0;
+            while (i < n && !is_aligned(dst + i, 16)) {
+                dst[i] = src[i];
+                ++i;
+            }
+            constexpr std::size_t per = 16 / sizeof(T);
+            for (; i + per <= n; i += per) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), v);
+            }
+            _mm_sfence();
+            for (; i < n; ++i)
+                dst[i] = src[i];
+            return;
+        }
+    }
+#endif
+    std::copy(src, src + n, dst);
+}
+
+/**
+ * Standard allocator returning aligned memory, for
+ * containers feeding vectorized kernels.
+ * */
+template<typename T, std::size_t Alignment = default_alignment>
+struct aligned_allocator {
+
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+    aligned_allocator() = default;
+
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) {/* empty */}
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_alloc();
+        return static_cast<T*>(aligned_malloc(n * sizeof(T), Alignment));
+    }
+
+    void deallocate(T* ptr, std::size_t) { aligned_free(ptr); }
+
+    template<typename U>
+    bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * Owning, copyable, zero-initialized buffer whose first
+ * element is aligned to Alignment bytes.
+ * */
+template<typename T, std::size_t Alignment = default_alignment>
+class aligned_buffer {
+
+    static_assert((Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "alignment weaker than the element type");
+
+    private:
+
+        T* ptr {nullptr};          /** First element */
+        std::size_t count {0};     /** Number of elements */
+
+    public:
+
+        aligned_buffer() {/* empty */}
+
+        /**
+         * Allocates n value-initialized elements.
+         *
+         * @param n the number of elements
+         * */
+        explicit aligned_buffer(std::size_t n) : count {n} {
+            ptr = static_cast<T*>(aligned_malloc(n * sizeof(T), Alignment));
+            if constexpr (std::is_trivially_default_constructible<T>::value) {
+                if (n > 0) {
+                    if (n * sizeof(T) >= nontemporal_threshold) stream_fill(ptr, n, T());
+                    else std::memset(static_cast<void*>(ptr), 0, n * sizeof(T));
+                }
+            } else {
+                std::uninitialized_value_construct(ptr, ptr + n);
+            }
+        }
+
+        aligned_buffer(const aligned_buffer& other) : count {other.count} {
+            ptr = static_cast<T*>(aligned_malloc(count * sizeof(T), Alignment));
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                stream_copy(ptr, other.ptr, count);
+            } else {
+                std::uninitialized_copy(other.ptr, other.ptr + count, ptr);
+            }
+        }
+
+        aligned_buffer(aligned_buffer&& other) noexcept : ptr {other.ptr}, count {other.count} {
+            other.ptr = nullptr;
+            other.count = 0;
+        }
+
+        aligned_buffer& operator=(const aligned_buffer& other) {
+            if (this != &other) {
+                aligned_buffer copy {other};
+                swap(copy);
+            }
+            return *this;
+        }
+
+        aligned_buffer& operator=(aligned_buffer&& other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~aligned_buffer() {
+            if constexpr (!std::is_trivially_destructible<T>::value)
+                std::destroy(ptr, ptr + count);
+            aligned_free(ptr);
+        }
+
+        void swap(aligned_buffer& other) noexcept {
+            std::swap(ptr, other.ptr);
+            std::swap(count, other.count);
+        }
+
+        inline T& operator[](std::size_t i) { return ptr[i]; }
+        inline const T& operator[](std::size_t i) const { return ptr[i]; }
+
+        inline T* data() { return ptr; }
+        inline const T* data() const { return ptr; }
+
+        inline std::size_t size() const { return count; }
+};
+
+/**
+ * Alignment for fixed-size storage: the largest power of two,
+ * up to a cache line, dividing the storage size, so that
+ * a Mat<float, 4, 4> sits in one cache line and a Vec3f
+ * is not inflated.
+ * */
+template<typename T, std::size_t N>
+constexpr std::size_t fixed_storage_alignment() {
+    std::size_t bytes = sizeof(T) * N;
+    if (bytes < 16)
+        return alignof(T);
+    std::size_t a = 16;
+    while (a < default_alignment && bytes % (a * 2) == 0)
+        a *= 2;
+    return bytes % a == 0 ? a : alignof(T);
+}
+
+/**
+ * Fixed-size storage aligned as fixed_storage_alignment says.
+ * */
+template<typename T, std::size_t N>
+struct alignas(fixed_storage_alignment<T, N>()) aligned_array : public std::array<T, N> {};
+
+};
+
+#endif
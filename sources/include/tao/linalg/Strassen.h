@@ -0,0 +1,221 @@
+#ifndef _TAO_STRASSEN_
+#define _TAO_STRASSEN_
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "tao/linalg/Blas.h"
+#include "tao/linalg/Gemm.h"
+#include "tao/linalg/Mat.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * Smallest dimension from which products are split, on hosts
+ * nothing is known about.
+ * */
+constexpr int default_strassen_cutoff = 256;
+
+/**
+ * Smallest dimension from which strassen_multiply splits products,
+ * from tuning::profile(): below it, they run on kernels::gemm.
+ *
+ * @return the current cutoff
+ * */
+int strassen_cutoff();
+
+namespace kernels {
+
+/**
+ * Whether a product is split in four at all: every dimension must
+ * reach the cutoff.
+ * */
+inline bool strassen_splits(int m, int n, int k, int cutoff) {
+    return std::min(m, std::min(n, k)) >= std::max(cutoff, 2);
+}
+
+/**
+ * Elements of workspace kernels::strassen needs: at each level, four
+ * sums of quadrants of A, four of B and three products, with one
+ * workspace for the levels below, or seven on the parallel levels.
+ *
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A and rows of B
+ * @param cutoff see strassen_cutoff
+ * @param parallel_levels levels whose products run concurrently
+ * @return the workspace size
+ * */
+inline std::size_t strassen_workspace(int m, int n, int k, int cutoff, int parallel_levels) {
+    if (!strassen_splits(m, n, k, cutoff))
+        return 0;
+    const std::size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const std::size_t own = 4 * m2 * k2 + 4 * k2 * n2 + 3 * m2 * n2;
+    const std::size_t below = strassen_workspace(m / 2, n / 2, k / 2, cutoff, parallel_levels - 1);
+    return own + (parallel_levels > 0 ? 7 : 1) * below;
+}
+
+/**
+ * C = A B on row-major arrays with the Strassen-Winograd recursion:
+ * 7 half-size products and 15 additions per level instead of 8
+ * products. Odd dimensions are peeled off and handled by gemm, and
+ * products smaller than the cutoff in any dimension run on gemm.
+ *
+ * As with gemm, the arithmetic does not depend on the number of
+ * threads, nor here on parallel_levels, but results are not those
+ * of gemm: see strassen_multiply for the error.
+ *
+ * @param m rows of A and C
+ * @param n cols of B and C
+ * @param k cols of A and rows of B
+ * @param a the left operand
+ * @param lda leading dimension of A
+ * @param b the right operand
+ * @param ldb leading dimension of B
+ * @param c the result, only written
+ * @param ldc leading dimension of C
+ * @param cutoff see strassen_cutoff
+ * @param parallel_levels levels whose 7 products run concurrently
+ * @param work strassen_workspace(m, n, k, cutoff, parallel_levels)
+ * elements, not allocated here
+ * */
+template<typename T>
+void strassen(int m, int n, int k, const T* a, int lda, const T* b, int ldb, T* c, int ldc,
+        int cutoff, int parallel_levels, T* work) {
+    if (!strassen_splits(m, n, k, cutoff)) {
+        gemm(m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc);
+        return;
+    }
+    const int m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const std::size_t sa = std::size_t(m2) * k2, sb = std::size_t(k2) * n2, sc = std::size_t(m2) * n2;
+
+    // quadrants of the even part
+    const T *a11 = a, *a12 = a + k2, *a21 = a + std::size_t(m2) * lda, *a22 = a21 + k2;
+    const T *b11 = b, *b12 = b + n2, *b21 = b + std::size_t(k2) * ldb, *b22 = b21 + n2;
+    T *c11 = c, *c12 = c + n2, *c21 = c + std::size_t(m2) * ldc, *c22 = c21 + n2;
+
+    // sums are packed, with leading dimensions k2 and n2
+    T *s1 = work, *s2 = s1 + sa, *s3 = s2 + sa, *s4 = s3 + sa;
+    T *t1 = s4 + sa, *t2 = t1 + sb, *t3 = t2 + sb, *t4 = t3 + sb;
+    T *q1 = t4 + sb, *q5 = q1 + sc, *q6 = q5 + sc;
+    T* below = q6 + sc;
+    const std::size_t below_size = strassen_workspace(m2, n2, k2, cutoff, parallel_levels - 1);
+
+    for_each_span(m2, k2, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        const std::size_t r = i * lda, s = i * k2;
+        for (std::size_t j = lo; j < hi; ++j) {
+            const T v1 = a21[r + j] + a22[r + j];
+            const T v2 = v1 - a11[r + j];
+            s1[s + j] = v1;
+            s2[s + j] = v2;
+            s3[s + j] = a11[r + j] - a21[r + j];
+            s4[s + j] = a12[r + j] - v2;
+        }
+    });
+    for_each_span(k2, n2, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        const std::size_t r = i * ldb, s = i * n2;
+        for (std::size_t j = lo; j < hi; ++j) {
+            const T v1 = b12[r + j] - b11[r + j];
+            const T v2 = b22[r + j] - v1;
+            t1[s + j] = v1;
+            t2[s + j] = v2;
+            t3[s + j] = b22[r + j] - b12[r + j];
+            t4[s + j] = v2 - b21[r + j];
+        }
+    });
+
+    // four products land in the quadrants of C, three in the workspace
+    auto product = [&](int index, const T* x, int ldx, const T* y, int ldy, T* z, int ldz) {
+        T* w = below + (parallel_levels > 0 ? index * below_size : 0);
+        strassen(m2, n2, k2, x, ldx, y, ldy, z, ldz, cutoff, parallel_levels - 1, w);
+    };
+    auto p1 = [&]() { product(0, a11, lda, b11, ldb, q1, n2); };
+    auto p2 = [&]() { product(1, a12, lda, b21, ldb, c11, ldc); };
+    auto p3 = [&]() { product(2, s4, k2, b22, ldb, c12, ldc); };
+    auto p4 = [&]() { product(3, a22, lda, t4, n2, c21, ldc); };
+    auto p5 = [&]() { product(4, s1, k2, t1, n2, q5, n2); };
+    auto p6 = [&]() { product(5, s2, k2, t2, n2, q6, n2); };
+    auto p7 = [&]() { product(6, s3, k2, t3, n2, c22, ldc); };
+    if (parallel_levels > 0) {
+        parallel::parallel_invoke(p1, p2, p3, p4, p5, p6, p7);
+    } else {
+        p1(); p2(); p3(); p4(); p5(); p6(); p7();
+    }
+
+    for_each_span(m2, n2, [&](std::size_t i, std::size_t lo, std::size_t hi) {
+        const std::size_t r = i * ldc, s = i * n2;
+        for (std::size_t j = lo; j < hi; ++j) {
+            const T u1 = q1[s + j] + c11[r + j];
+            const T u2 = q1[s + j] + q6[s + j];
+            const T u3 = u2 + c22[r + j];
+            const T u4 = u2 + q5[s + j];
+            c11[r + j] = u1;
+            c12[r + j] = u4 + c12[r + j];
+            c21[r + j] = u3 - c21[r + j];
+            c22[r + j] = u3 + q5[s + j];
+        }
+    });
+
+    // the last col of A and row of B, then the last col and row of C
+    const int me = 2 * m2, ne = 2 * n2, ke = 2 * k2;
+    if (ke < k)
+        gemm(me, ne, 1, T(1), a + ke, lda, b + std::size_t(ke) * ldb, ldb, T(1), c, ldc);
+    if (ne < n)
+        gemm(me, 1, k, T(1), a, lda, b + ne, ldb, T(0), c + ne, ldc);
+    if (me < m)
+        gemm(1, n, k, T(1), a + std::size_t(me) * lda, lda, b, ldb, T(0), c + std::size_t(me) * ldc, ldc);
+}
+
+/**
+ * Levels whose products run concurrently: the top one, when there
+ * are threads. Further threads help within the products, whose gemm
+ * and additions are parallel too, and a second level would multiply
+ * the workspace below it by 7 again.
+ * */
+inline int strassen_parallel_levels() {
+    return parallel::concurrency() > 1 ? 1 : 0;
+}
+
+};
+
+/**
+ * Matrix product with the Strassen-Winograd recursion, overwriting
+ * m3. Splitting a level saves an eighth of the multiply-adds of the
+ * product, for products large enough that the additions and the
+ * workspace cost less: run strassen_bench to see where that starts
+ * on a host, and tuning::tune to measure the cutoff.
+ *
+ * The price is accuracy. The error of gemm is bounded elementwise by
+ * about k u |A| |B|, u being the unit roundoff; the bound of
+ * Strassen-Winograd only holds for the largest element of the whole
+ * matrix, and grows by a factor of about 4.5 per level (Higham,
+ * Accuracy and Stability of Numerical Algorithms, 23.2.2), so small
+ * elements of a product can lose all their digits next to large ones.
+ * strassen_bench reports the errors observed for each number of
+ * levels, on matrices of comparable magnitudes.
+ *
+ * The whole workspace is allocated once, before the recursion: about
+ * 3.7 n^2 elements for square matrices on one thread, and 9.2 n^2
+ * when the 7 products of the top level run concurrently.
+ *
+ * @param m1 the lhs
+ * @param m2 the rhs
+ * @param m3 the result, already with the dimensions of the product
+ * @param cutoff smallest dimension from which products are split
+ * */
+template<typename T>
+void strassen_multiply(const Mat<T, Dynamic, Dynamic>& m1, const Mat<T, Dynamic, Dynamic>& m2,
+        Mat<T, Dynamic, Dynamic>& m3, int cutoff = strassen_cutoff()) {
+    if (m1.ncols() != m2.nrows() || m3.nrows() != m1.nrows() || m3.ncols() != m2.ncols())
+        throw std::invalid_argument("can't multiply matrices with incompatible dimensions");
+    const int m = m1.nrows(), n = m2.ncols(), k = m1.ncols();
+    const int levels = kernels::strassen_parallel_levels();
+    std::vector<T> work (kernels::strassen_workspace(m, n, k, cutoff, levels));
+    kernels::strassen(m, n, k, m1.raw(), m1.ld(), m2.raw(), m2.ld(), m3.raw(), m3.ld(), cutoff, levels, work.data());
+}
+
+};
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef _TAO_TRANSFORM_
+#define _TAO_TRANSFORM_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include "tao/linalg/Mat.h"
+#include "tao/linalg/Quat.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+
+/**
+ * An affine transform split as M = T R S: a translation, a rotation,
+ * and a symmetric stretch applied first. The stretch is diagonal,
+ * holding the scale factors, unless the transform has shear; it is
+ * negative definite for transforms that flip handedness.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+struct TRS {
+
+    Mat<T, 3, 1> translation;   /** applied last */
+    Quat<T> rotation;           /** unit quaternion */
+    Mat<T, 3, 3> stretch;       /** symmetric, applied first */
+
+    /**
+     * The identity transform.
+     * */
+    TRS() : TRS(Mat<T, 3, 1>(T(0)), Quat<T> {}, Mat<T, 3, 1>(T(1))) {}
+
+    /**
+     * Transform without shear.
+     *
+     * @param translation the translation
+     * @param rotation the rotation, a unit quaternion
+     * @param scale the scale factors along the local axes
+     * */
+    TRS(const Mat<T, 3, 1>& translation, const Quat<T>& rotation, const Mat<T, 3, 1>& scale)
+        : translation {translation}, rotation {rotation}, stretch (T(0)) {
+        for (int a = 0; a < 3; ++a)
+            stretch.raw()[a * stretch.ld() + a] = scale.raw()[a];
+    }
+
+    /**
+     * The scale factors, the diagonal of the stretch.
+     *
+     * @return the scale along each local axis
+     * */
+    Mat<T, 3, 1> scale() const {
+        Mat<T, 3, 1> s (T(0));
+        for (int a = 0; a < 3; ++a)
+            s.raw()[a] = stretch.raw()[a * stretch.ld() + a];
+        return s;
+    }
+};
+
+/**
+ * Lanes per block of the batched decomposition.
+ * */
+constexpr int transform_lanes = 4;
+
+namespace kernels {
+
+/**
+ * Polar decomposition of blocks of W 3x3 matrices, stored as
+ * a[row * 3 + col][lane], by Higham's scaled Newton iteration
+ * X <- (g X + X^-T / g) / 2. Blocks whose columns are already
+ * orthogonal skip the iteration; otherwise every lane iterates
+ * until all lanes converge, converged lanes being fixed points.
+ *
+ * @param a the matrices, with positive determinants
+ * @param r receives the closest rotations
+ * */
+template<typename T, int W>
+void polar_rotation(const T a[9][W], T r[9][W]) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    bool orthogonal = true;
+    for (int l = 0; l < W; ++l) {
+        T n[3], d[3];
+        for (int c = 0; c < 3; ++c)
+            n[c] = a[c][l] * a[c][l] + a[3 + c][l] * a[3 + c][l] + a[6 + c][l] * a[6 + c][l];
+        for (int c = 0; c < 3; ++c) {
+            const int c1 = (c + 1) % 3;
+            d[c] = a[c][l] * a[c1][l] + a[3 + c][l] * a[3 + c1][l] + a[6 + c][l] * a[6 + c1][l];
+            orthogonal = orthogonal && d[c] * d[c] <= T(64) * eps * eps * n[c] * n[c1];
+        }
+    }
+    for (int e = 0; e < 9; ++e)
+        for (int l = 0; l < W; ++l)
+            r[e][l] = a[e][l];
+    if (orthogonal) {
+        // the rotation is the matrix with normalized columns
+        for (int c = 0; c < 3; ++c) {
+            for (int l = 0; l < W; ++l) {
+                const T inv = T(1) / std::sqrt(r[c][l] * r[c][l] + r[3 + c][l] * r[3 + c][l] + r[6 + c][l] * r[6 + c][l]);
+                r[c][l] *= inv;
+                r[3 + c][l] *= inv;
+                r[6 + c][l] *= inv;
+            }
+        }
+        return;
+    }
+    for (int iteration = 0; iteration < 32; ++iteration) {
+        T cof[9][W];
+        T change[W];
+        for (int l = 0; l < W; ++l) {
+            // cofactors, X^-T times the determinant: rows of X^-T are crosses of columns of X
+            cof[0][l] = r[4][l] * r[8][l] - r[5][l] * r[7][l];
+            cof[1][l] = r[5][l] * r[6][l] - r[3][l] * r[8][l];
+            cof[2][l] = r[3][l] * r[7][l] - r[4][l] * r[6][l];
+            cof[3][l] = r[2][l] * r[7][l] - r[1][l] * r[8][l];
+            cof[4][l] = r[0][l] * r[8][l] - r[2][l] * r[6][l];
+            cof[5][l] = r[1][l] * r[6][l] - r[0][l] * r[7][l];
+            cof[6][l] = r[1][l] * r[5][l] - r[2][l] * r[4][l];
+            cof[7][l] = r[2][l] * r[3][l] - r[0][l] * r[5][l];
+            cof[8][l] = r[0][l] * r[4][l] - r[1][l] * r[3][l];
+            const T det = r[0][l] * cof[0][l] + r[1][l] * cof[1][l] + r[2][l] * cof[2][l];
+            T norm_x = T(0), norm_c = T(0);
+            for (int e = 0; e < 9; ++e) {
+                norm_x += r[e][l] * r[e][l];
+                norm_c += cof[e][l] * cof[e][l];
+            }
+            // g = sqrt(|X^-1|_F / |X|_F)
+            const T g = std::sqrt(std::sqrt(norm_c / norm_x) / std::abs(det));
+            const T s0 = g / T(2), s1 = T(1) / (T(2) * g * det);
+            T diff = T(0), norm = T(0);
+            for (int e = 0; e < 9; ++e) {
+                const T next = s0 * r[e][l] + s1 * cof[e][l];
+                diff += (next - r[e][l]) * (next - r[e][l]);
+                norm += next * next;
+                r[e][l] = next;
+            }
+            change[l] = diff / norm;
+        }
+        T worst = T(0);
+        for (int l = 0; l < W; ++l)
+            worst = std::max(worst, change[l]);
+        if (worst <= T(1e4) * eps * eps)
+            break;
+    }
+}
+
+/**
+ * Decomposes a block of up to W transforms.
+ *
+ * @param m the transforms
+ * @param count how many, at most W
+ * @param out the decompositions
+ * */
+template<typename T, int W>
+void decompose_block(const Mat<T, 4, 4>* m, int count, TRS<T>* out) {
+    T a[9][W], r[9][W], sign[W];
+    for (int l = 0; l < W; ++l) {
+        // missing lanes are identities
+        const T* row = l < count ? m[l].raw() : nullptr;
+        const int ld = l < count ? m[l].ld() : 0;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                a[3 * i + j][l] = row ? row[i * ld + j] : T(i == j);
+        const T det = a[0][l] * (a[4][l] * a[8][l] - a[5][l] * a[7][l])
+            - a[1][l] * (a[3][l] * a[8][l] - a[5][l] * a[6][l])
+            + a[2][l] * (a[3][l] * a[7][l] - a[4][l] * a[6][l]);
+        if (!(det != T(0)) || !std::isfinite(det))
+            throw std::invalid_argument("cannot decompose a singular transform");
+        sign[l] = det < T(0) ? T(-1) : T(1);
+        for (int e = 0; e < 9; ++e)
+            a[e][l] *= sign[l];
+    }
+    polar_rotation<T, W>(a, r);
+    for (int l = 0; l < count; ++l) {
+        T rot[9], s[9];
+        for (int e = 0; e < 9; ++e)
+            rot[e] = r[e][l];
+        // S = sign R^T A, symmetrized
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                s[3 * i + j] = sign[l] * (rot[i] * a[j][l] + rot[3 + i] * a[3 + j][l] + rot[6 + i] * a[6 + j][l]);
+        TRS<T>& t = out[l];
+        T* st = t.stretch.raw();
+        const int sld = t.stretch.ld();
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                st[i * sld + j] = (s[3 * i + j] + s[3 * j + i]) / T(2);
+        t.rotation = Quat<T>::from_rows(rot, 3);
+        const T* row = m[l].raw();
+        const int ld = m[l].ld();
+        for (int i = 0; i < 3; ++i)
+            t.translation.raw()[i] = row[i * ld + 3];
+    }
+}
+
+};
+
+/**
+ * Splits an affine transform into translation, rotation and stretch.
+ * The rotation is the orthogonal polar factor of the 3x3 block, the
+ * rotation closest to it; transforms made of a rotation and scales
+ * only get it without iterating. The bottom row is ignored.
+ *
+ * @param m the transform
+ * @return the decomposition, such that compose gives back m
+ * */
+template<typename T>
+TRS<T> decompose(const Mat<T, 4, 4>& m) {
+    TRS<T> out;
+    kernels::decompose_block<T, 1>(&m, 1, &out);
+    return out;
+}
+
+/**
+ * Decomposes transforms in blocks of transform_lanes, which are
+ * processed in parallel.
+ *
+ * @param m the transforms
+ * @param count how many
+ * @param out the decompositions
+ * */
+template<typename T>
+void decompose(const Mat<T, 4, 4>* m, std::size_t count, TRS<T>* out) {
+    const std::size_t blocks = (count + transform_lanes - 1) / transform_lanes;
+    parallel::parallel_for(0, blocks, 1 << 10, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            const std::size_t first = b * transform_lanes;
+            const int n = int(std::min<std::size_t>(transform_lanes, count - first));
+            kernels::decompose_block<T, transform_lanes>(m + first, n, out + first);
+        }
+    });
+}
+
+/**
+ * Builds the affine transform T R S, without allocating.
+ *
+ * @param trs the decomposition
+ * @param out the transform
+ * */
+template<typename T>
+void compose(const TRS<T>& trs, Mat<T, 4, 4>& out) {
+    T rot[9];
+    trs.rotation.to_rows(rot, 3);
+    const T* s = trs.stretch.raw();
+    const int sld = trs.stretch.ld();
+    T* o = out.raw();
+    const int ld = out.ld();
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            o[i * ld + j] = rot[3 * i] * s[j] + rot[3 * i + 1] * s[sld + j] + rot[3 * i + 2] * s[2 * sld + j];
+        o[i * ld + 3] = trs.translation.raw()[i];
+    }
+    o[3 * ld] = o[3 * ld + 1] = o[3 * ld + 2] = T(0);
+    o[3 * ld + 3] = T(1);
+}
+
+/**
+ * Builds the affine transform T R S.
+ *
+ * @param trs the decomposition
+ * @return the transform
+ * */
+template<typename T>
+Mat<T, 4, 4> compose(const TRS<T>& trs) {
+    Mat<T, 4, 4> out (T(0));
+    compose(trs, out);
+    return out;
+}
+
+/**
+ * Builds transforms in parallel.
+ *
+ * @param trs the decompositions
+ * @param count how many
+ * @param out the transforms
+ * */
+template<typename T>
+void compose(const TRS<T>* trs, std::size_t count, Mat<T, 4, 4>* out) {
+    parallel::parallel_for(0, count, 1 << 12, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i)
+            compose(trs[i], out[i]);
+    });
+}
+
+};
+
+#endif
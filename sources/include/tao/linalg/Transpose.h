@@ -0,0 +1,66 @@
+#ifndef _TAO_TRANSPOSE_
+#define _TAO_TRANSPOSE_
+
+#include <algorithm>
+#include "tao/linalg/Mat.h"
+
+namespace tao {
+
+/**
+ * Default edge, in elements, of the square tiles used by the
+ * blocked transpose: a 32x32 tile of doubles is 8 KB, so source
+ * and destination tiles fit together in L1.
+ * */
+constexpr int default_transpose_block = 32;
+
+/**
+ * Tile edge used when none is given, from tuning::profile().
+ *
+ * @return the current tile edge
+ * */
+int transpose_block();
+
+/**
+ * Transposes a rows x cols row-major array into a cols x rows one,
+ * tile by tile, so that both reads and writes stay in cache.
+ *
+ * @param src the source
+ * @param rows number of rows of the source
+ * @param cols number of cols of the source
+ * @param lds leading dimension of the source
+ * @param dst the destination
+ * @param ldd leading dimension of the destination
+ * @param block tile edge
+ * */
+template<typename T>
+void transpose(const T* src, int rows, int cols, int lds, T* dst, int ldd,
+        int block = transpose_block()) {
+    for (int ib = 0; ib < rows; ib += block) {
+        const int ie = std::min(ib + block, rows);
+        for (int jb = 0; jb < cols; jb += block) {
+            const int je = std::min(jb + block, cols);
+            for (int i = ib; i < ie; ++i) {
+                const T* s = src + std::size_t(i) * lds;
+                for (int j = jb; j < je; ++j)
+                    dst[std::size_t(j) * ldd + i] = s[j];
+            }
+        }
+    }
+}
+
+/**
+ * Computes the transpose of a dynamic matrix with the blocked kernel.
+ *
+ * @param mat the matrix
+ * @return a new matrix which is the transpose
+ * */
+template<typename T>
+Mat<T, Dynamic, Dynamic> transpose(const Mat<T, Dynamic, Dynamic>& mat) {
+    Mat<T, Dynamic, Dynamic> transp (mat.ncols(), mat.nrows());
+    transpose(mat.raw(), mat.nrows(), mat.ncols(), mat.ld(), transp.raw(), transp.ld());
+    return transp;
+}
+
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef _TAO_TUNING_
+#define _TAO_TUNING_
+
+#include <cstddef>
+#include <string>
+#include "tao/linalg/Gemm.h"
+#include "tao/linalg/Strassen.h"
+
+namespace tao {
+namespace tuning {
+
+/**
+ * Data cache sizes of the host, in bytes: the first two per core,
+ * the last one shared.
+ * */
+struct CacheSizes {
+    std::size_t l1;
+    std::size_t l2;
+    std::size_t l3;
+};
+
+/**
+ * Reads the cache sizes with sysconf, or from /sys when sysconf does
+ * not know them, once. Levels neither tells fall back to 32 KB,
+ * 256 KB and 8 MB.
+ *
+ * @return the cache sizes
+ * */
+CacheSizes cache_sizes();
+
+/**
+ * Block sizes of the kernels. None of them changes results: GEMM
+ * accumulates every element in the same order under any blocking,
+ * transposition only moves elements, and the reduction grain only
+ * splits work outside of deterministic mode, whose blocks are fixed.
+ * The Strassen cutoff does, but only for strassen_multiply, which
+ * callers choose for its speed.
+ * */
+struct Profile {
+    GemmBlocking gemm;              /** tiles of the matrix product */
+    int transpose_block;            /** tile edge of the transposition */
+    std::size_t reduction_grain;    /** elements per task of parallel reductions */
+    int strassen_cutoff = default_strassen_cutoff;  /** smallest product split by strassen_multiply */
+};
+
+/**
+ * Block sizes fitted to caches: two rows of GEMM tiles in half of
+ * L1, a panel of B in half of L2, a source and a destination tile
+ * of the transposition in half of L1, and reduction tasks reading
+ * about a quarter of L2. Sizes are for doubles, and powers of two.
+ * The Strassen cutoff depends on the speed of gemm more than on the
+ * caches, and stays at its default.
+ *
+ * @param caches the cache sizes
+ * @return the profile
+ * */
+Profile derived_profile(const CacheSizes& caches);
+
+/**
+ * The profile the kernels use. On first use, it is loaded from the
+ * file named by the environment variable TAO_PROFILE, or else from
+ * ~/.cache/tao/profile, and derived from cache_sizes() if there is
+ * no such file.
+ *
+ * @return the current profile
+ * */
+Profile profile();
+
+/**
+ * Makes the kernels use other block sizes.
+ *
+ * @param p the profile, with positive sizes
+ * */
+void set_profile(const Profile& p);
+
+/**
+ * Where profiles are looked for: TAO_PROFILE, or ~/.cache/tao/profile.
+ *
+ * @return the path, empty if neither variable is set
+ * */
+std::string default_path();
+
+/**
+ * Writes a profile as lines of keys and values, creating the
+ * directories of the path if needed.
+ *
+ * @param p the profile
+ * @param path the file
+ * */
+void save(const Profile& p, const std::string& path);
+
+/**
+ * Reads a profile written by save. Keys it does not know are
+ * skipped, and missing ones keep the values derived from the caches.
+ *
+ * @param path the file
+ * @return the profile
+ * */
+Profile load(const std::string& path);
+
+/**
+ * Benchmarks candidate block sizes on the host, for doubles, and
+ * returns the fastest; the current profile is left as it was. Takes
+ * a few seconds at the default size, on the calling thread, and on
+ * concurrency() threads for reductions and Strassen products.
+ * While it runs, routing to the backend is off and the profile
+ * holds the tuned GEMM blocks, so it must not run
+ * concurrently with other tao calls.
+ *
+ * @param size edge of the matrices multiplied; the transposed ones
+ * have 4 times that edge, reductions run over size^2 elements, and
+ * the Strassen cutoff is the first of size and 2 size from which a
+ * level of recursion beats gemm, or else 4 size
+ * @return the winners
+ * */
+Profile tune(int size = 384);
+
+};
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <functional>
+#include <stdexcept>
+#include <string>
 
 /**
  * Represents a matrix whose elements
@@ -165,6 +167,20 @@ class Mat {
          * */
         inline int ncols() const { return cols; };
 
+        /**
+         * Pointer to the first element of the row-major storage.
+         *
+         * @return the underlying storage
+         * */
+        inline T* raw() { return data.get(); };
+
+        /**
+         * Read-only pointer to the first element of the row-major storage.
+         *
+         * @return the underlying storage
+         * */
+        inline const T* raw() const { return data.get(); };
+
         /**
          * Reset matrix with a value.
          *
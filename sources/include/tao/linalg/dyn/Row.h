@@ -2,6 +2,7 @@
 #define __ROW__
 
 #include "Mat.h"
+#include <optional>
 
 namespace tao {
 namespace deprecated {
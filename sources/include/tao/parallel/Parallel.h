@@ -0,0 +1,310 @@
+#ifndef _TAO_PARALLEL_
+#define _TAO_PARALLEL_
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace tao {
+namespace parallel {
+
+/**
+ * Number of threads parallel kernels may use.
+ *
+ * @return the hardware concurrency, or the value given to set_concurrency
+ * */
+unsigned int concurrency();
+
+/**
+ * Limits the number of threads parallel kernels may use.
+ *
+ * @param threads the number of threads, 0 meaning the hardware concurrency
+ * */
+void set_concurrency(unsigned int threads);
+
+/**
+ * Whether reductions run in deterministic mode, where work is cut
+ * into blocks of fixed size and the partial results are combined
+ * by a fixed tree, so that results do not depend on concurrency().
+ *
+ * @return true in deterministic mode, false by default
+ * */
+bool deterministic();
+
+/**
+ * Enables or disables the deterministic mode.
+ *
+ * @param enabled whether results must be bit-reproducible across thread counts
+ * */
+void set_deterministic(bool enabled);
+
+/**
+ * Elements per block in deterministic mode.
+ * */
+constexpr std::size_t deterministic_block = std::size_t(1) << 14;
+
+/**
+ * Where the scheduler gets its threads from. A parallel call made
+ * outside of the scheduler submits up to concurrency() - 1 jobs, each
+ * of which steals work until the call completes and then returns;
+ * jobs that start late return at once. Jobs should run on distinct
+ * threads; an executor that runs them inline makes calls serial.
+ *
+ * @author Vitor Greati
+ * */
+class Executor {
+
+    public:
+
+        virtual ~Executor() = default;
+
+        /**
+         * Runs a job, on another thread, now or later.
+         *
+         * @param job the job
+         * */
+        virtual void execute(std::function<void()> job) = 0;
+};
+
+/**
+ * Makes the scheduler draw its threads from an existing pool, instead
+ * of the threads it otherwise starts on first use. Must not be called
+ * during parallel calls.
+ *
+ * @param executor the pool, outliving its use; nullptr restores the default
+ * */
+void set_executor(Executor* executor);
+
+namespace kernels {
+
+/**
+ * A unit of work that a thread forks and may be stolen by another,
+ * the forking thread waiting for it before leaving its frame.
+ * */
+struct Task {
+    std::atomic<bool> done {false};
+    std::exception_ptr error;
+
+    virtual ~Task() = default;
+
+    /**
+     * Runs the work, keeping what it throws, and flags completion.
+     * */
+    void execute() noexcept {
+        try { run(); } catch (...) { error = std::current_exception(); }
+        done.store(true, std::memory_order_release);
+    }
+
+    virtual void run() = 0;
+};
+
+template<typename F>
+struct FunctionTask : Task {
+    F& f;
+
+    explicit FunctionTask(F& f) : f {f} {}
+
+    void run() override { f(); }
+};
+
+/**
+ * Pushes a task on the deque of the calling thread.
+ *
+ * @return false if the thread has no deque, the caller running the task itself
+ * */
+bool push(Task* task);
+
+/**
+ * Takes back the task at the bottom of the deque of the calling
+ * thread, if it is still there.
+ *
+ * @return false if it was stolen
+ * */
+bool pop(Task* task);
+
+/**
+ * Runs tasks stolen from other threads until a task completes.
+ * */
+void wait(Task& task);
+
+/**
+ * Scope of a parallel call. Made on a thread outside of the
+ * scheduler, it gives the thread a deque and submits helpers to the
+ * executor, which leave when the scope ends; within the scheduler,
+ * nested calls share the helpers of the outermost one.
+ * */
+class Region {
+
+    public:
+
+        /**
+         * @param helpers how many threads, besides the calling one, the call could use
+         * */
+        explicit Region(std::size_t helpers);
+
+        ~Region();
+
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+
+        struct State;
+
+    protected:
+
+        std::shared_ptr<State> state;
+};
+
+/**
+ * Runs f and g, g possibly on another thread, and rethrows what
+ * either threw once both completed.
+ * */
+template<typename F, typename G>
+void fork(F&& f, G&& g) {
+    FunctionTask<std::remove_reference_t<G>> right {g};
+    if (!push(&right)) {
+        f();
+        g();
+        return;
+    }
+    std::exception_ptr error;
+    try { f(); } catch (...) { error = std::current_exception(); }
+    if (pop(&right))
+        right.execute();
+    else
+        wait(right);
+    if (error)
+        std::rethrow_exception(error);
+    if (right.error)
+        std::rethrow_exception(right.error);
+}
+
+/**
+ * Elements per leaf of the splitting of n elements: at most a few
+ * leaves per thread, so that stealing balances the load without
+ * forking more than it must, and never below the grain. In
+ * deterministic mode, the grain alone, for leaves that do not depend
+ * on the thread count.
+ * */
+inline std::size_t leaf_size(std::size_t n, std::size_t grain) {
+    if (deterministic())
+        return grain;
+    return std::max(grain, n / (std::size_t(4) * concurrency()));
+}
+
+template<typename F>
+void split_for(std::size_t lo, std::size_t hi, std::size_t leaf, F& body) {
+    if (hi - lo < 2 * leaf) {
+        body(lo, hi);
+        return;
+    }
+    const std::size_t mid = lo + (hi - lo) / 2;
+    fork([&]() { split_for(lo, mid, leaf, body); }, [&]() { split_for(mid, hi, leaf, body); });
+}
+
+template<typename T, typename Map, typename Combine>
+T split_reduce(std::size_t lo, std::size_t hi, std::size_t leaf, Map& map, Combine& combine) {
+    if (hi - lo < 2 * leaf)
+        return map(lo, hi);
+    const std::size_t mid = lo + (hi - lo) / 2;
+    // filled by the forks, so that T need not be default-constructible
+    std::optional<T> left, right;
+    fork([&]() { left.emplace(split_reduce<T>(lo, mid, leaf, map, combine)); },
+        [&]() { right.emplace(split_reduce<T>(mid, hi, leaf, map, combine)); });
+    return combine(std::move(*left), std::move(*right));
+}
+
+template<typename F>
+void invoke_all(F&& f) {
+    f();
+}
+
+template<typename F, typename... G>
+void invoke_all(F&& f, G&&... g) {
+    fork(f, [&]() { invoke_all(g...); });
+}
+
+};
+
+/**
+ * Runs body(lo, hi) over disjoint subranges covering [begin, end),
+ * each at least grain elements long except possibly the last one.
+ * The range is split in halves, which idle threads steal, so that
+ * calls nest: a body may make parallel calls of its own, which share
+ * the same threads instead of starting more. The calling thread
+ * takes part in the work. Exceptions thrown by the body are rethrown
+ * in the caller.
+ *
+ * @param begin first index
+ * @param end one past the last index
+ * @param grain minimum number of indices per task
+ * @param body the work, called with a half-open range
+ * */
+template<typename F>
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F&& body) {
+    if (end <= begin)
+        return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t n = end - begin;
+    const std::size_t leaf = kernels::leaf_size(n, grain);
+    if (concurrency() <= 1 || n < 2 * leaf) {
+        body(begin, end);
+        return;
+    }
+    kernels::Region region {std::min<std::size_t>(concurrency() - 1, n / leaf - 1)};
+    kernels::split_for(begin, end, leaf, body);
+}
+
+/**
+ * Reduces [begin, end) in parallel: map(lo, hi) reduces a subrange,
+ * of at least grain elements, and combine(left, right) merges the
+ * results of adjacent subranges, in order. Splits are in halves; in
+ * deterministic mode, they only depend on the range and the grain,
+ * so that the result is the same on any number of threads. Results
+ * only need to be move-constructible: partial results are never
+ * default-constructed.
+ *
+ * @param begin first index
+ * @param end one past the last index
+ * @param grain minimum number of indices per subrange
+ * @param map the reduction of a half-open range
+ * @param combine the merging of two partial results
+ * @return the result, map(begin, end) on a single thread outside of deterministic mode
+ * */
+template<typename Map, typename Combine>
+auto parallel_reduce(std::size_t begin, std::size_t end, std::size_t grain, Map&& map, Combine&& combine) {
+    using T = std::decay_t<decltype(map(begin, end))>;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t n = end > begin ? end - begin : 0;
+    const std::size_t leaf = kernels::leaf_size(n, grain);
+    if (n < 2 * leaf || (concurrency() <= 1 && !deterministic()))
+        return T(map(begin, std::max(begin, end)));
+    kernels::Region region {std::min<std::size_t>(concurrency() - 1, n / leaf - 1)};
+    return kernels::split_reduce<T>(begin, end, leaf, map, combine);
+}
+
+/**
+ * Runs functions in parallel, and returns once all of them
+ * completed, rethrowing what one of them threw.
+ *
+ * @param f the functions
+ * */
+template<typename... F>
+void parallel_invoke(F&&... f) {
+    if (concurrency() <= 1 || sizeof...(F) < 2) {
+        (f(), ...);
+        return;
+    }
+    kernels::Region region {sizeof...(F) - 1};
+    kernels::invoke_all(f...);
+}
+
+};
+};
+
+#endif
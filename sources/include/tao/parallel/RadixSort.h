@@ -0,0 +1,160 @@
+#ifndef _TAO_RADIX_SORT_
+#define _TAO_RADIX_SORT_
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace parallel {
+
+/**
+ * Bits sorted per radix pass: 30-bit keys take three passes,
+ * 63-bit keys six, and a block's counts still fit in L1.
+ * */
+constexpr int radix_bits = 11;
+
+/**
+ * Arrays shorter than this are sorted by the calling thread only.
+ * */
+constexpr std::size_t radix_parallel_threshold = std::size_t(1) << 16;
+
+namespace kernels {
+
+/**
+ * One stable LSD pass over the digit of the given bits of the keys from
+ * shift on, at most radix_bits of them, from src to dst.
+ * Blocks of the input are counted, then scattered, in parallel; blocks
+ * only depend on the size, so the pass is the same on any thread count.
+ *
+ * @return false if every key has the same digit, dst being untouched
+ * */
+template<typename Key, typename Value>
+bool radix_pass(const Key* src_keys, const Value* src_values, Key* dst_keys, Value* dst_values,
+        std::size_t n, int shift, int bits, bool with_values) {
+    constexpr std::size_t buckets = std::size_t(1) << radix_bits;
+    const Key mask = Key((std::size_t(1) << bits) - 1);
+    const std::size_t blocks = std::max<std::size_t>(1, std::min<std::size_t>(n / radix_parallel_threshold, 64));
+    std::vector<std::size_t> counts (blocks * buckets, 0);
+    parallel_for(0, blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            std::size_t* count = counts.data() + b * buckets;
+            for (std::size_t i = n * b / blocks, end = n * (b + 1) / blocks; i < end; ++i)
+                ++count[(src_keys[i] >> shift) & mask];
+        }
+    });
+
+    // offsets in digit-major, block-minor order keep the pass stable
+    std::size_t total = 0;
+    for (std::size_t d = 0; d < buckets; ++d) {
+        std::size_t digit_total = 0;
+        for (std::size_t b = 0; b < blocks; ++b) {
+            std::size_t c = counts[b * buckets + d];
+            counts[b * buckets + d] = total + digit_total;
+            digit_total += c;
+        }
+        if (digit_total == n)
+            return false;
+        total += digit_total;
+    }
+
+    parallel_for(0, blocks, 1, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t b = lo; b < hi; ++b) {
+            std::size_t* offset = counts.data() + b * buckets;
+            for (std::size_t i = n * b / blocks, end = n * (b + 1) / blocks; i < end; ++i) {
+                std::size_t to = offset[(src_keys[i] >> shift) & mask]++;
+                dst_keys[to] = src_keys[i];
+                if (with_values)
+                    dst_values[to] = src_values[i];
+            }
+        }
+    });
+    return true;
+}
+
+/**
+ * Stable LSD radix sort of keys, and of values along with them.
+ * */
+template<typename Key, typename Value>
+void radix_sort(Key* keys, Value* values, std::size_t n, int key_bits, bool with_values) {
+    static_assert(std::is_unsigned<Key>::value, "radix sort keys must be unsigned integers");
+    if (n <= 1)
+        return;
+    std::vector<Key> key_buffer (n);
+    std::vector<Value> value_buffer (with_values ? n : 0);
+    Key* src_keys = keys;
+    Key* dst_keys = key_buffer.data();
+    Value* src_values = values;
+    Value* dst_values = value_buffer.data();
+    for (int shift = 0; shift < key_bits; shift += radix_bits) {
+        // the last digit stops at key_bits
+        const int bits = std::min(radix_bits, key_bits - shift);
+        if (radix_pass(src_keys, src_values, dst_keys, dst_values, n, shift, bits, with_values)) {
+            std::swap(src_keys, dst_keys);
+            std::swap(src_values, dst_values);
+        }
+    }
+    if (src_keys != keys) {
+        std::copy(src_keys, src_keys + n, keys);
+        if (with_values)
+            std::copy(src_values, src_values + n, values);
+    }
+}
+
+};
+
+/**
+ * Sorts unsigned integer keys, stably, with a parallel LSD radix sort.
+ * Passes over digits shared by all keys are skipped.
+ *
+ * @param keys the keys
+ * @param key_bits only the lowest key_bits bits are compared, higher
+ * ones being ignored
+ * */
+template<typename Key>
+void radix_sort(std::vector<Key>& keys, int key_bits = int(sizeof(Key)) * 8) {
+    kernels::radix_sort(keys.data(), static_cast<std::uint32_t*>(nullptr), keys.size(), key_bits, false);
+}
+
+/**
+ * Sorts unsigned integer keys and moves values along with them,
+ * stably, with a parallel LSD radix sort.
+ *
+ * @param keys the keys
+ * @param values the values, as many as keys
+ * @param key_bits only the lowest key_bits bits are compared, higher
+ * ones being ignored
+ * */
+template<typename Key, typename Value>
+void radix_sort(std::vector<Key>& keys, std::vector<Value>& values, int key_bits = int(sizeof(Key)) * 8) {
+    if (keys.size() != values.size())
+        throw std::invalid_argument("radix sort needs as many values as keys");
+    kernels::radix_sort(keys.data(), values.data(), keys.size(), key_bits, true);
+}
+
+/**
+ * Applies a permutation: item k of the result is items[order[k]].
+ *
+ * @param items the items
+ * @param order the permutation, as many indices as items
+ * */
+template<typename U, typename Index>
+void reorder(std::vector<U>& items, const std::vector<Index>& order) {
+    if (items.size() != order.size())
+        throw std::invalid_argument("reordering needs one index per item");
+    std::vector<U> sorted (items.size());
+    parallel_for(0, items.size(), 1 << 14, [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t k = lo; k < hi; ++k)
+            sorted[k] = items[order[k]];
+    });
+    items.swap(sorted);
+}
+
+};
+};
+
+#endif
@@ -0,0 +1,513 @@
+#ifndef _TAO_LOW_DISCREPANCY_
+#define _TAO_LOW_DISCREPANCY_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace sampling {
+
+namespace kernels {
+
+/**
+ * Samples per task of the batched generators.
+ * */
+constexpr std::size_t sequence_grain = std::size_t(1) << 14;
+
+/**
+ * Largest float and double below 1.
+ * */
+template<typename T>
+constexpr T one_minus_epsilon = std::is_same_v<T, float> ? T(0x1.fffffep-1) : T(0x1.fffffffffffffp-1);
+
+template<typename T>
+inline void check_real() {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "samples are float or double");
+}
+
+/**
+ * A 32-bit fraction as a sample in [0, 1): floats keep the top 24
+ * bits, so that rounding never reaches 1.
+ * */
+template<typename T>
+inline T fraction(std::uint32_t bits) {
+    if constexpr (std::is_same_v<T, float>)
+        return T(std::int32_t(bits >> 8)) * 0x1p-24f;
+    else
+        return T(bits) * 0x1p-32;
+}
+
+inline std::uint32_t reverse_bits(std::uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/**
+ * Nested uniform (Owen) scrambling of a 32-bit fraction, through the
+ * hash of Burley, "Practical hash-based Owen scrambling": on the
+ * reversed bits, every bit is flipped depending only on the bits
+ * below it, that is, on the more significant bits of the fraction.
+ * */
+inline std::uint32_t owen_scramble(std::uint32_t x, std::uint32_t seed) {
+    x = reverse_bits(x);
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1u;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return reverse_bits(x);
+}
+
+/**
+ * Mixes a seed and a dimension into the seed of that dimension.
+ * */
+inline std::uint32_t hash_seed(std::uint32_t seed, std::uint32_t dim) {
+    std::uint32_t h = seed ^ (dim * 0x9E3779B9u);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+};
+
+/**
+ * The Sobol sequence in up to 16 dimensions, with the direction
+ * numbers of Joe and Kuo, optionally Owen-scrambled. Unscrambled,
+ * every power-of-two prefix of each dimension is stratified, and the
+ * first two dimensions form a (0, 2)-sequence; scrambling keeps both
+ * properties while decorrelating dimensions and removing the bias of
+ * the sequence starting at 0. Indices are 32-bit.
+ *
+ * Batches look up the low 8 bits of each index in a table, and XOR
+ * the part of the high bits, common to runs of 256 indices, so that
+ * they vectorize.
+ *
+ * @author Vitor Greati
+ * */
+class Sobol {
+
+    public:
+
+        static constexpr int max_dimensions = 16;
+
+        /**
+         * The unscrambled sequence.
+         * */
+        Sobol() : scrambled {false} {}
+
+        /**
+         * An Owen-scrambled sequence.
+         *
+         * @param seed selects the scrambling, different seeds giving independent sequences
+         * */
+        explicit Sobol(std::uint32_t seed) : scrambled {true} {
+            for (int d = 0; d < max_dimensions; ++d)
+                seeds[d] = kernels::hash_seed(seed, std::uint32_t(d));
+        }
+
+        int dimensions() const { return max_dimensions; }
+
+        /**
+         * The bits of a sample, as a 32-bit fraction.
+         *
+         * @param index the position of the sample
+         * @param dim its dimension
+         * @return the fraction
+         * */
+        std::uint32_t bits(std::uint32_t index, int dim) const {
+            check(dim);
+            const Tables& t = tables();
+            const std::uint32_t x = t.low[dim][index & 255] ^ high(index >> 8, dim);
+            return scrambled ? kernels::owen_scramble(x, seeds[dim]) : x;
+        }
+
+        /**
+         * A sample in [0, 1).
+         *
+         * @param index the position of the sample
+         * @param dim its dimension
+         * @return the sample
+         * */
+        template<typename T>
+        T sample(std::uint32_t index, int dim) const {
+            kernels::check_real<T>();
+            return kernels::fraction<T>(bits(index, dim));
+        }
+
+        /**
+         * Consecutive samples of a dimension, generated in parallel;
+         * out[i] equals sample<T>(first + i, dim).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param dim the dimension
+         * @param out receives the samples
+         * */
+        template<typename T>
+        void generate(std::uint32_t first, std::size_t count, int dim, T* out) const {
+            kernels::check_real<T>();
+            check(dim);
+            check_range(first, count);
+            const std::uint32_t* low = tables().low[dim];
+            const std::uint32_t seed = seeds[dim];
+            parallel::parallel_for(0, count, kernels::sequence_grain, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi;) {
+                    const std::uint32_t index = first + std::uint32_t(i);
+                    const std::uint32_t h = high(index >> 8, dim);
+                    const std::uint32_t r = index & 255;
+                    const std::size_t m = std::min<std::size_t>(256 - r, hi - i);
+                    T* o = out + i;
+                    if (scrambled)
+                        for (std::size_t j = 0; j < m; ++j)
+                            o[j] = kernels::fraction<T>(kernels::owen_scramble(low[r + j] ^ h, seed));
+                    else
+                        for (std::size_t j = 0; j < m; ++j)
+                            o[j] = kernels::fraction<T>(low[r + j] ^ h);
+                    i += m;
+                }
+            });
+        }
+
+        /**
+         * Consecutive samples of every dimension, in structure-of-arrays
+         * layout: out[d * count + i] equals sample<T>(first + i, d).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param out receives dimensions() * count samples
+         * */
+        template<typename T>
+        void generate(std::uint32_t first, std::size_t count, T* out) const {
+            for (int d = 0; d < max_dimensions; ++d)
+                generate(first, count, d, out + std::size_t(d) * count);
+        }
+
+    protected:
+
+        struct Tables {
+            std::uint32_t direction[max_dimensions][32];
+            std::uint32_t low[max_dimensions][256];     /** samples of the indices below 256 */
+        };
+
+        bool scrambled;
+        std::uint32_t seeds[max_dimensions] {};
+
+        static void check(int dim) {
+            if (dim < 0 || dim >= max_dimensions)
+                throw std::invalid_argument("Sobol dimension out of range");
+        }
+
+        static void check_range(std::uint32_t first, std::size_t count) {
+            if (count > (std::uint64_t(1) << 32) - first)
+                throw std::invalid_argument("Sobol indices are 32-bit");
+        }
+
+        /**
+         * The contribution of bits 8 and up of an index.
+         * */
+        static std::uint32_t high(std::uint32_t q, int dim) {
+            const std::uint32_t* v = tables().direction[dim] + 8;
+            std::uint32_t x = 0;
+            for (int k = 0; q; ++k, q >>= 1)
+                x ^= -(q & 1u) & v[k];
+            return x;
+        }
+
+        static const Tables& tables() {
+            static const Tables t = build();
+            return t;
+        }
+
+        static Tables build() {
+            // degree, coefficients and initial numbers of the primitive
+            // polynomials of dimensions 2 to 16 (new-joe-kuo-6.21201)
+            struct Polynomial { int s; std::uint32_t a; std::uint32_t m[6]; };
+            static const Polynomial polynomials[max_dimensions - 1] = {
+                {1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}, {3, 2, {1, 1, 1}},
+                {4, 1, {1, 1, 3, 3}}, {4, 4, {1, 3, 5, 13}}, {5, 2, {1, 1, 5, 5, 17}},
+                {5, 4, {1, 1, 5, 5, 5}}, {5, 7, {1, 1, 7, 11, 19}}, {5, 11, {1, 1, 5, 1, 1}},
+                {5, 13, {1, 1, 1, 3, 11}}, {5, 14, {1, 3, 5, 5, 31}}, {6, 1, {1, 3, 3, 9, 7, 49}},
+                {6, 13, {1, 1, 1, 15, 21, 21}}, {6, 16, {1, 3, 1, 13, 27, 49}}
+            };
+            Tables t;
+            for (int k = 0; k < 32; ++k)
+                t.direction[0][k] = std::uint32_t(1) << (31 - k);
+            for (int d = 1; d < max_dimensions; ++d) {
+                const Polynomial& p = polynomials[d - 1];
+                std::uint32_t* v = t.direction[d];
+                for (int k = 0; k < p.s; ++k)
+                    v[k] = p.m[k] << (31 - k);
+                for (int k = p.s; k < 32; ++k) {
+                    v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+                    for (int j = 1; j < p.s; ++j)
+                        if ((p.a >> (p.s - 1 - j)) & 1u)
+                            v[k] ^= v[k - j];
+                }
+            }
+            for (int d = 0; d < max_dimensions; ++d)
+                for (std::uint32_t i = 0; i < 256; ++i) {
+                    std::uint32_t x = 0;
+                    for (int k = 0; k < 8; ++k)
+                        if ((i >> k) & 1u)
+                            x ^= t.direction[d][k];
+                    t.low[d][i] = x;
+                }
+            return t;
+        }
+};
+
+/**
+ * The Halton sequence in up to 32 dimensions, dimension d being the
+ * radical inverse in the d-th prime base.
+ *
+ * Each dimension keeps the radical inverses of the residues modulo
+ * B, the largest power of its base not above 1024; the inverse of
+ * an index i = q B + r is then table[r] + inverse(q) / B, so that
+ * batches, where runs of indices share q, vectorize.
+ *
+ * @author Vitor Greati
+ * */
+class Halton {
+
+    public:
+
+        static constexpr int max_dimensions = 32;
+
+        Halton() {
+            static const int primes[max_dimensions] = {
+                2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+                59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+            };
+            for (int d = 0; d < max_dimensions; ++d) {
+                Dimension& dim = dims[d];
+                dim.base = std::uint64_t(primes[d]);
+                dim.period = dim.base;
+                int digits = 1;
+                while (dim.period * dim.base <= 1024) {
+                    dim.period *= dim.base;
+                    ++digits;
+                }
+                dim.inv_period = 1.0 / double(dim.period);
+                dim.table.resize(dim.period);
+                for (std::uint64_t r = 0; r < dim.period; ++r) {
+                    double x = 0.0, scale = 1.0 / double(dim.base);
+                    std::uint64_t q = r;
+                    for (int k = 0; k < digits; ++k, q /= dim.base, scale /= double(dim.base))
+                        x += double(q % dim.base) * scale;
+                    dim.table[r] = x;
+                }
+            }
+        }
+
+        int dimensions() const { return max_dimensions; }
+
+        /**
+         * A sample in [0, 1).
+         *
+         * @param index the position of the sample
+         * @param dim its dimension
+         * @return the sample
+         * */
+        template<typename T>
+        T sample(std::uint64_t index, int dim) const {
+            kernels::check_real<T>();
+            check(dim);
+            const Dimension& d = dims[dim];
+            return clamp<T>(d.table[index % d.period] + inverse(index / d.period, d) * d.inv_period);
+        }
+
+        /**
+         * Consecutive samples of a dimension, generated in parallel;
+         * out[i] equals sample<T>(first + i, dim).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param dim the dimension
+         * @param out receives the samples
+         * */
+        template<typename T>
+        void generate(std::uint64_t first, std::size_t count, int dim, T* out) const {
+            kernels::check_real<T>();
+            check(dim);
+            const Dimension& d = dims[dim];
+            parallel::parallel_for(0, count, kernels::sequence_grain, [&](std::size_t lo, std::size_t hi) {
+                for (std::size_t i = lo; i < hi;) {
+                    const std::uint64_t index = first + i;
+                    const std::uint64_t r = index % d.period;
+                    const std::size_t m = std::min<std::size_t>(d.period - r, hi - i);
+                    const double offset = inverse(index / d.period, d) * d.inv_period;
+                    const double* t = d.table.data() + r;
+                    T* o = out + i;
+                    for (std::size_t j = 0; j < m; ++j)
+                        o[j] = clamp<T>(t[j] + offset);
+                    i += m;
+                }
+            });
+        }
+
+        /**
+         * Consecutive samples of every dimension, in structure-of-arrays
+         * layout: out[d * count + i] equals sample<T>(first + i, d).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param out receives dimensions() * count samples
+         * */
+        template<typename T>
+        void generate(std::uint64_t first, std::size_t count, T* out) const {
+            for (int d = 0; d < max_dimensions; ++d)
+                generate(first, count, d, out + std::size_t(d) * count);
+        }
+
+    protected:
+
+        struct Dimension {
+            std::uint64_t base, period;
+            double inv_period;
+            std::vector<double> table;
+        };
+
+        Dimension dims[max_dimensions];
+
+        static void check(int dim) {
+            if (dim < 0 || dim >= max_dimensions)
+                throw std::invalid_argument("Halton dimension out of range");
+        }
+
+        static double inverse(std::uint64_t q, const Dimension& d) {
+            double x = 0.0, scale = 1.0;
+            for (; q; q /= d.period, scale *= d.inv_period)
+                x += d.table[q % d.period] * scale;
+            return x;
+        }
+
+        /**
+         * Rounding to float may reach 1, which samples must not.
+         * */
+        template<typename T>
+        static T clamp(double x) {
+            const T y = T(x);
+            return y < kernels::one_minus_epsilon<T> ? y : kernels::one_minus_epsilon<T>;
+        }
+};
+
+/**
+ * The R2 sequence of Roberts, "The unreasonable effectiveness of
+ * quasirandom sequences": sample i of dimension d is the fractional
+ * part of 1/2 + i alpha_d, alpha being the powers of the inverse of
+ * the plastic number. Fractions are kept in 64-bit fixed point,
+ * where they wrap exactly, instead of accumulating rounding errors.
+ *
+ * @author Vitor Greati
+ * */
+class R2 {
+
+    public:
+
+        static constexpr int max_dimensions = 2;
+
+        int dimensions() const { return max_dimensions; }
+
+        /**
+         * The bits of a sample, as a 64-bit fraction.
+         *
+         * @param index the position of the sample
+         * @param dim its dimension
+         * @return the fraction
+         * */
+        std::uint64_t bits(std::uint64_t index, int dim) const {
+            check(dim);
+            return offset + index * alpha[dim];
+        }
+
+        /**
+         * A sample in [0, 1).
+         *
+         * @param index the position of the sample
+         * @param dim its dimension
+         * @return the sample
+         * */
+        template<typename T>
+        T sample(std::uint64_t index, int dim) const {
+            kernels::check_real<T>();
+            return to_real<T>(bits(index, dim));
+        }
+
+        /**
+         * Consecutive samples of a dimension, generated in parallel;
+         * out[i] equals sample<T>(first + i, dim).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param dim the dimension
+         * @param out receives the samples
+         * */
+        template<typename T>
+        void generate(std::uint64_t first, std::size_t count, int dim, T* out) const {
+            kernels::check_real<T>();
+            check(dim);
+            constexpr std::size_t W = 16;
+            std::uint64_t lanes[W];
+            for (std::size_t l = 0; l < W; ++l)
+                lanes[l] = l * alpha[dim];
+            parallel::parallel_for(0, count, kernels::sequence_grain, [&](std::size_t lo, std::size_t hi) {
+                std::size_t i = lo;
+                for (; i + W <= hi; i += W) {
+                    const std::uint64_t base = bits(first + i, dim);
+                    for (std::size_t l = 0; l < W; ++l)
+                        out[i + l] = to_real<T>(base + lanes[l]);
+                }
+                T* tail = out + i;
+                for (std::size_t k = 0, m = hi - i; k < m; ++k)
+                    tail[k] = to_real<T>(bits(first + i + k, dim));
+            });
+        }
+
+        /**
+         * Consecutive samples of both dimensions, in structure-of-arrays
+         * layout: out[d * count + i] equals sample<T>(first + i, d).
+         *
+         * @param first the position of the first sample
+         * @param count how many
+         * @param out receives 2 * count samples
+         * */
+        template<typename T>
+        void generate(std::uint64_t first, std::size_t count, T* out) const {
+            for (int d = 0; d < max_dimensions; ++d)
+                generate(first, count, d, out + std::size_t(d) * count);
+        }
+
+    protected:
+
+        static constexpr std::uint64_t offset = std::uint64_t(1) << 63;
+        static constexpr std::uint64_t alpha[max_dimensions] = {0xc13fa9a902a6328full, 0x91e10da5c79e7b1cull};
+
+        static void check(int dim) {
+            if (dim < 0 || dim >= max_dimensions)
+                throw std::invalid_argument("R2 dimension out of range");
+        }
+
+        template<typename T>
+        static T to_real(std::uint64_t x) {
+            if constexpr (std::is_same_v<T, float>)
+                return T(std::int32_t(x >> 40)) * 0x1p-24f;
+            else
+                return T(std::int64_t(x >> 11)) * 0x1p-53;
+        }
+};
+
+};
+};
+
+#endif
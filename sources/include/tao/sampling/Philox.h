@@ -0,0 +1,218 @@
+#ifndef _TAO_PHILOX_
+#define _TAO_PHILOX_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace sampling {
+
+namespace kernels {
+
+/**
+ * Counters per block of the batched generator.
+ * */
+constexpr std::size_t philox_lanes = 8;
+constexpr std::size_t philox_grain = std::size_t(1) << 12;
+
+/**
+ * The Philox-4x32-10 bijection on one counter. Written per counter so
+ * that a loop over counters, rounds inside, vectorizes across counters
+ * where the ISA has a widening 32-bit multiply (AVX2 and up).
+ * */
+inline void philox_rounds(std::uint32_t& c0, std::uint32_t& c1, std::uint32_t& c2, std::uint32_t& c3,
+        std::uint32_t key0, std::uint32_t key1) {
+    for (int round = 0; round < 10; ++round) {
+        const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * c0;
+        const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * c2;
+        const std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1 ^ key0;
+        const std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3 ^ key1;
+        c1 = std::uint32_t(p1);
+        c3 = std::uint32_t(p0);
+        c0 = n0;
+        c2 = n2;
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+}
+
+/**
+ * Uniform float in [0, 1) from the top 24 bits of a word.
+ * */
+inline float unit_float(std::uint32_t w) {
+    return float(w >> 8) * 0x1p-24f;
+}
+
+/**
+ * Uniform double in [0, 1) from the top 53 bits of two words.
+ * */
+inline double unit_double(std::uint32_t hi, std::uint32_t lo) {
+    return double(((std::uint64_t(hi) << 32) | lo) >> 11) * 0x1p-53;
+}
+
+};
+
+/**
+ * Counter-based random generator, Philox-4x32-10 (Salmon et al.,
+ * "Parallel random numbers: as easy as 1, 2, 3"). The n-th block of
+ * four words of a stream is the encryption of the counter (n, stream)
+ * under the seed, so any sample of any stream is available without
+ * state: threads, pixels or paths can each own a stream, or share one
+ * and draw disjoint index ranges, without synchronizing.
+ *
+ * @author Vitor Greati
+ * */
+class Philox {
+
+    public:
+
+        /**
+         * Generator of a stream.
+         *
+         * @param seed the key
+         * @param stream the stream, independent from the others of the same seed
+         * */
+        explicit Philox(std::uint64_t seed = 0, std::uint64_t stream = 0)
+            : key0 {std::uint32_t(seed)}, key1 {std::uint32_t(seed >> 32)},
+              stream0 {std::uint32_t(stream)}, stream1 {std::uint32_t(stream >> 32)} {}
+
+        /**
+         * The same seed, another stream.
+         *
+         * @param stream the stream
+         * @return its generator
+         * */
+        Philox with_stream(std::uint64_t stream) const {
+            Philox g {*this};
+            g.stream0 = std::uint32_t(stream);
+            g.stream1 = std::uint32_t(stream >> 32);
+            return g;
+        }
+
+        /**
+         * Four random words.
+         *
+         * @param counter the position of the block in the stream
+         * @return the block
+         * */
+        std::array<std::uint32_t, 4> block(std::uint64_t counter) const {
+            std::uint32_t c0 = std::uint32_t(counter), c1 = std::uint32_t(counter >> 32), c2 = stream0, c3 = stream1;
+            kernels::philox_rounds(c0, c1, c2, c3, key0, key1);
+            return {c0, c1, c2, c3};
+        }
+
+        /**
+         * A random word.
+         *
+         * @param index its position in the stream, block index / 4
+         * @return the word
+         * */
+        std::uint32_t word(std::uint64_t index) const {
+            return block(index / 4)[index % 4];
+        }
+
+        /**
+         * Consecutive words of the stream, generated in parallel;
+         * out[i] equals word(first + i).
+         *
+         * @param first the position of the first one
+         * @param out receives the words
+         * @param n how many
+         * */
+        void words(std::uint64_t first, std::uint32_t* out, std::size_t n) const {
+            parallel::parallel_for(0, n, kernels::philox_grain, [&](std::size_t lo, std::size_t hi) {
+                const std::uint64_t begin = first + lo, end = first + hi;
+                blocks(begin / 4, (end + 3) / 4, [&](std::uint64_t b, const std::uint32_t w[4]) {
+                    for (std::uint64_t k = 0; k < 4; ++k)
+                        if (4 * b + k >= begin && 4 * b + k < end)
+                            out[4 * b + k - first] = w[k];
+                });
+            });
+        }
+
+        /**
+         * A uniform sample in [0, 1). Floats take one word, doubles two.
+         *
+         * @param index the position of the sample in the stream
+         * @return the sample
+         * */
+        template<typename T>
+        T uniform(std::uint64_t index) const {
+            static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "uniform samples are float or double");
+            if constexpr (std::is_same_v<T, float>) {
+                return kernels::unit_float(word(index));
+            } else {
+                const auto b = block(index / 2);
+                return index % 2 ? kernels::unit_double(b[2], b[3]) : kernels::unit_double(b[0], b[1]);
+            }
+        }
+
+        /**
+         * Consecutive uniform samples in [0, 1), generated in parallel;
+         * out[i] equals uniform<T>(first + i).
+         *
+         * @param first the position of the first sample
+         * @param out receives the samples
+         * @param n how many
+         * */
+        template<typename T>
+        void uniform(std::uint64_t first, T* out, std::size_t n) const {
+            static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "uniform samples are float or double");
+            constexpr std::uint64_t per_block = std::is_same_v<T, float> ? 4 : 2;
+            parallel::parallel_for(0, n, kernels::philox_grain, [&](std::size_t lo, std::size_t hi) {
+                const std::uint64_t begin = first + lo, end = first + hi;
+                blocks(begin / per_block, (end + per_block - 1) / per_block, [&](std::uint64_t b, const std::uint32_t w[4]) {
+                    for (std::uint64_t k = 0; k < per_block; ++k) {
+                        const std::uint64_t j = per_block * b + k;
+                        if (j < begin || j >= end)
+                            continue;
+                        if constexpr (std::is_same_v<T, float>)
+                            out[j - first] = kernels::unit_float(w[k]);
+                        else
+                            out[j - first] = kernels::unit_double(w[2 * k], w[2 * k + 1]);
+                    }
+                });
+            });
+        }
+
+    protected:
+
+        std::uint32_t key0, key1;
+        std::uint32_t stream0, stream1;
+
+        /**
+         * Calls f(counter, words) for the blocks [lo, hi), encrypting
+         * philox_lanes counters at a time.
+         * */
+        template<typename F>
+        void blocks(std::uint64_t lo, std::uint64_t hi, F&& f) const {
+            constexpr std::size_t W = kernels::philox_lanes;
+            for (std::uint64_t b = lo; b < hi; b += W) {
+                // counters in 32-bit halves, carrying by hand, to keep the lanes 32-bit
+                const std::uint32_t lo32 = std::uint32_t(b), hi32 = std::uint32_t(b >> 32);
+                std::uint32_t c0[W], c1[W], c2[W], c3[W];
+                for (std::uint32_t l = 0; l < W; ++l) {
+                    std::uint32_t x0 = lo32 + l, x1 = hi32 + (x0 < lo32), x2 = stream0, x3 = stream1;
+                    kernels::philox_rounds(x0, x1, x2, x3, key0, key1);
+                    c0[l] = x0;
+                    c1[l] = x1;
+                    c2[l] = x2;
+                    c3[l] = x3;
+                }
+                const std::uint64_t m = std::min<std::uint64_t>(W, hi - b);
+                for (std::size_t l = 0; l < m; ++l) {
+                    const std::uint32_t w[4] {c0[l], c1[l], c2[l], c3[l]};
+                    f(b + l, w);
+                }
+            }
+        }
+};
+
+};
+};
+
+#endif
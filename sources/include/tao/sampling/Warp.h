@@ -0,0 +1,382 @@
+#ifndef _TAO_WARP_
+#define _TAO_WARP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include "tao/core.h"
+#include "tao/linalg/Elementary.h"
+#include "tao/parallel/Parallel.h"
+
+namespace tao {
+namespace sampling {
+
+namespace kernels {
+
+using tao::kernels::math_grain;
+using tao::kernels::math_lanes;
+using tao::kernels::select;
+
+/**
+ * Applies f(u, v, o0, o1) to n pairs of samples, through local blocks
+ * so that the loop vectorizes whatever the aliasing of the arrays.
+ * */
+template<typename T, typename F>
+void warp_serial(const T* u, const T* v, T* o0, T* o1, std::size_t n, F f) {
+    std::size_t i = 0;
+    for (; i + math_lanes <= n; i += math_lanes) {
+        T a[math_lanes], b[math_lanes], r0[math_lanes], r1[math_lanes];
+        std::copy_n(u + i, math_lanes, a);
+        std::copy_n(v + i, math_lanes, b);
+        for (std::size_t l = 0; l < math_lanes; ++l)
+            f(a[l], b[l], r0[l], r1[l]);
+        std::copy_n(r0, math_lanes, o0 + i);
+        std::copy_n(r1, math_lanes, o1 + i);
+    }
+    // the tail counts what remains, which GCC can bound
+    const T *tu = u + i, *tv = v + i;
+    T *t0 = o0 + i, *t1 = o1 + i;
+    for (std::size_t k = 0, m = n - i; k < m; ++k)
+        f(tu[k], tv[k], t0[k], t1[k]);
+}
+
+template<typename T, typename F>
+void warp_serial(const T* u, const T* v, T* o0, T* o1, T* o2, std::size_t n, F f) {
+    std::size_t i = 0;
+    for (; i + math_lanes <= n; i += math_lanes) {
+        T a[math_lanes], b[math_lanes], r0[math_lanes], r1[math_lanes], r2[math_lanes];
+        std::copy_n(u + i, math_lanes, a);
+        std::copy_n(v + i, math_lanes, b);
+        for (std::size_t l = 0; l < math_lanes; ++l)
+            f(a[l], b[l], r0[l], r1[l], r2[l]);
+        std::copy_n(r0, math_lanes, o0 + i);
+        std::copy_n(r1, math_lanes, o1 + i);
+        std::copy_n(r2, math_lanes, o2 + i);
+    }
+    const T *tu = u + i, *tv = v + i;
+    T *t0 = o0 + i, *t1 = o1 + i, *t2 = o2 + i;
+    for (std::size_t k = 0, m = n - i; k < m; ++k)
+        f(tu[k], tv[k], t0[k], t1[k], t2[k]);
+}
+
+template<typename T>
+inline T clamp_unit(T x) {
+    return select(x > T(1), T(1), select(x < T(-1), T(-1), x));
+}
+
+/**
+ * sqrt(max(0, 1 - x)), for the sines of cosines that rounding may
+ * take past 1.
+ * */
+template<math::Accuracy A, typename T>
+inline T sqrt_one_minus(T x) {
+    const T d = T(1) - x;
+    return tao::kernels::Sqrt::template apply<A>(select(d > T(0), d, T(0)));
+}
+
+/**
+ * Shirley and Chiu's concentric map of [0, 1)^2 onto the unit disk,
+ * with the quadrant tests turned into selects.
+ * */
+template<math::Accuracy A, typename T>
+inline void concentric_disk(T u, T v, T& x, T& y) {
+    const T a = T(2) * u - T(1), b = T(2) * v - T(1);
+    const bool wide = std::abs(a) > std::abs(b);
+    const T r = select(wide, a, b);
+    const T ratio = select(r != T(0), select(wide, b, a) / r, T(0));
+    const T quarter = T(M_PI / 4);
+    const T phi = select(wide, quarter * ratio, T(2) * quarter - quarter * ratio);
+    x = r * tao::kernels::Cos::template apply<A>(phi);
+    y = r * tao::kernels::Sin::template apply<A>(phi);
+}
+
+template<math::Accuracy A, typename T>
+inline void cosine_hemisphere(T u, T v, T& x, T& y, T& z) {
+    concentric_disk<A>(u, v, x, y);
+    z = sqrt_one_minus<A>(x * x + y * y);
+}
+
+template<math::Accuracy A, typename T>
+inline void uniform_sphere(T u, T v, T& x, T& y, T& z) {
+    z = T(1) - T(2) * u;
+    const T r = sqrt_one_minus<A>(z * z);
+    const T phi = T(2 * M_PI) * v;
+    x = r * tao::kernels::Cos::template apply<A>(phi);
+    y = r * tao::kernels::Sin::template apply<A>(phi);
+}
+
+};
+
+/**
+ * Maps uniform samples of [0, 1)^2 onto the unit disk, preserving
+ * areas and keeping strata compact (Shirley and Chiu, "A low
+ * distortion map between disk and square").
+ *
+ * @param u the first coordinate
+ * @param v the second coordinate
+ * @return the point of the disk
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+Vec2<T> concentric_disk(T u, T v) {
+    T x, y;
+    kernels::concentric_disk<A>(u, v, x, y);
+    return Vec2<T> {x, y};
+}
+
+/**
+ * Warps a batch of samples onto the unit disk, in parallel; see the
+ * scalar version.
+ *
+ * @param u the first coordinates
+ * @param v the second coordinates
+ * @param x receives the n abscissas
+ * @param y receives the n ordinates
+ * @param n the number of samples
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+void concentric_disk(const T* u, const T* v, T* x, T* y, std::size_t n) {
+    parallel::parallel_for(0, n, kernels::math_grain, [&](std::size_t lo, std::size_t hi) {
+        kernels::warp_serial(u + lo, v + lo, x + lo, y + lo, hi - lo, [](T a, T b, T& c, T& d) {
+            kernels::concentric_disk<A>(a, b, c, d);
+        });
+    });
+}
+
+/**
+ * Maps uniform samples of [0, 1)^2 onto the hemisphere around +z,
+ * with density cos(theta) / pi, by lifting the concentric disk.
+ *
+ * @param u the first coordinate
+ * @param v the second coordinate
+ * @return the unit direction
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+Vec3<T> cosine_hemisphere(T u, T v) {
+    T x, y, z;
+    kernels::cosine_hemisphere<A>(u, v, x, y, z);
+    return Vec3<T> {x, y, z};
+}
+
+/**
+ * Warps a batch of samples onto the cosine-weighted hemisphere, in
+ * parallel; see the scalar version.
+ *
+ * @param u the first coordinates
+ * @param v the second coordinates
+ * @param x receives the n x components
+ * @param y receives the n y components
+ * @param z receives the n z components
+ * @param n the number of samples
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+void cosine_hemisphere(const T* u, const T* v, T* x, T* y, T* z, std::size_t n) {
+    parallel::parallel_for(0, n, kernels::math_grain, [&](std::size_t lo, std::size_t hi) {
+        kernels::warp_serial(u + lo, v + lo, x + lo, y + lo, z + lo, hi - lo, [](T a, T b, T& c, T& d, T& e) {
+            kernels::cosine_hemisphere<A>(a, b, c, d, e);
+        });
+    });
+}
+
+/**
+ * Density of the cosine-weighted hemisphere, per solid angle.
+ *
+ * @param cos_theta the z component of the direction
+ * @return the density
+ * */
+template<typename T>
+T cosine_hemisphere_pdf(T cos_theta) {
+    return cos_theta * T(INV_PI);
+}
+
+/**
+ * Maps uniform samples of [0, 1)^2 onto the unit sphere, uniformly.
+ *
+ * @param u selects the height, z = 1 - 2u
+ * @param v selects the azimuth, 2 pi v
+ * @return the unit direction
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+Vec3<T> uniform_sphere(T u, T v) {
+    T x, y, z;
+    kernels::uniform_sphere<A>(u, v, x, y, z);
+    return Vec3<T> {x, y, z};
+}
+
+/**
+ * Warps a batch of samples onto the unit sphere, in parallel; see the
+ * scalar version.
+ *
+ * @param u the first coordinates
+ * @param v the second coordinates
+ * @param x receives the n x components
+ * @param y receives the n y components
+ * @param z receives the n z components
+ * @param n the number of samples
+ * */
+template<math::Accuracy A = math::default_accuracy, typename T>
+void uniform_sphere(const T* u, const T* v, T* x, T* y, T* z, std::size_t n) {
+    parallel::parallel_for(0, n, kernels::math_grain, [&](std::size_t lo, std::size_t hi) {
+        kernels::warp_serial(u + lo, v + lo, x + lo, y + lo, z + lo, hi - lo, [](T a, T b, T& c, T& d, T& e) {
+            kernels::uniform_sphere<A>(a, b, c, d, e);
+        });
+    });
+}
+
+/**
+ * Density of the uniform sphere, per solid angle.
+ *
+ * @return 1 / (4 pi)
+ * */
+template<typename T>
+T uniform_sphere_pdf() {
+    return T(INV_PI / 4);
+}
+
+/**
+ * Uniform sampling of the solid angle subtended by a triangle (Arvo,
+ * "Stratified sampling of spherical triangles"). The first sample
+ * picks the sub-triangle of the right area, the second a point along
+ * its edge; what depends only on the triangle is computed once.
+ *
+ * @author Vitor Greati
+ * */
+template<typename T>
+class SphericalTriangle {
+
+    public:
+
+        /**
+         * The spherical triangle of three directions. Triangles of
+         * solid angle below the machine epsilon of T are rejected.
+         *
+         * @param a the first vertex, seen from the center
+         * @param b the second vertex
+         * @param c the third vertex
+         * */
+        SphericalTriangle(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c) {
+            const Vec3<T>* in[3] = {&a, &b, &c};
+            T* out[3] = {va, vb, vc};
+            for (int k = 0; k < 3; ++k) {
+                const T* p = in[k]->raw();
+                const T len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+                for (int i = 0; i < 3; ++i)
+                    out[k][i] = p[i] / len;
+            }
+            // Van Oosterom and Strackee's formula, accurate for small triangles
+            T bc[3];
+            cross(vb, vc, bc);
+            area = T(2) * std::atan2(std::abs(dot(va, bc)), T(1) + dot(va, vb) + dot(vb, vc) + dot(vc, va));
+            // below the rounding error of T, the triangle has no orientation to sample
+            if (!(area > std::numeric_limits<T>::epsilon()) || !std::isfinite(area))
+                throw std::invalid_argument("degenerate spherical triangle");
+            // angle at a, between the tangents of the arcs towards b and c
+            T tb[3], tc[3], n[3];
+            for (int i = 0; i < 3; ++i) {
+                tb[i] = vb[i] - dot(va, vb) * va[i];
+                tc[i] = vc[i] - dot(va, vc) * va[i];
+            }
+            cross(tb, tc, n);
+            alpha = std::atan2(std::sqrt(dot(n, n)), dot(tb, tc));
+            cos_alpha = std::cos(alpha);
+            sin_alpha = std::sin(alpha);
+            cos_c = dot(va, vb);
+            const T inv = T(1) / std::sqrt(dot(tc, tc));
+            for (int i = 0; i < 3; ++i)
+                c_perp[i] = tc[i] * inv;
+        }
+
+        /**
+         * Solid angle of the triangle.
+         *
+         * @return the area on the unit sphere
+         * */
+        T solid_angle() const { return area; }
+
+        /**
+         * Density of the samples, per solid angle.
+         *
+         * @return the inverse of the solid angle
+         * */
+        T pdf() const { return T(1) / area; }
+
+        /**
+         * A direction within the triangle.
+         *
+         * @param u selects the sub-triangle
+         * @param v selects the point along its edge
+         * @return the unit direction
+         * */
+        template<math::Accuracy A = math::default_accuracy>
+        Vec3<T> sample(T u, T v) const {
+            T x, y, z;
+            sample<A>(u, v, x, y, z);
+            return Vec3<T> {x, y, z};
+        }
+
+        /**
+         * Directions within the triangle for a batch of samples, in
+         * parallel; see the scalar version.
+         *
+         * @param u the first coordinates
+         * @param v the second coordinates
+         * @param x receives the n x components
+         * @param y receives the n y components
+         * @param z receives the n z components
+         * @param n the number of samples
+         * */
+        template<math::Accuracy A = math::default_accuracy>
+        void sample(const T* u, const T* v, T* x, T* y, T* z, std::size_t n) const {
+            parallel::parallel_for(0, n, kernels::math_grain, [&](std::size_t lo, std::size_t hi) {
+                kernels::warp_serial(u + lo, v + lo, x + lo, y + lo, z + lo, hi - lo, [this](T a, T b, T& c, T& d, T& e) {
+                    sample<A>(a, b, c, d, e);
+                });
+            });
+        }
+
+    protected:
+
+        T va[3], vb[3], vc[3];
+        T c_perp[3];            /** unit tangent at a of the arc towards c */
+        T area, alpha, cos_alpha, sin_alpha, cos_c;
+
+        static T dot(const T* p, const T* q) { return p[0] * q[0] + p[1] * q[1] + p[2] * q[2]; }
+
+        static void cross(const T* p, const T* q, T* r) {
+            r[0] = p[1] * q[2] - p[2] * q[1];
+            r[1] = p[2] * q[0] - p[0] * q[2];
+            r[2] = p[0] * q[1] - p[1] * q[0];
+        }
+
+        template<math::Accuracy A>
+        void sample(T u, T v, T& x, T& y, T& z) const {
+            using kernels::select;
+            // the third vertex of the sub-triangle of area u * area, on the arc ac
+            const T phi = u * area - alpha;
+            const T s = tao::kernels::Sin::template apply<A>(phi);
+            const T t = tao::kernels::Cos::template apply<A>(phi);
+            const T p = t - cos_alpha;
+            const T q = s + sin_alpha * cos_c;
+            const T cos_b = kernels::clamp_unit(((q * t - p * s) * cos_alpha - q) / ((q * s + p * t) * sin_alpha));
+            const T sin_b = kernels::sqrt_one_minus<A>(cos_b * cos_b);
+            const T cx = cos_b * va[0] + sin_b * c_perp[0];
+            const T cy = cos_b * va[1] + sin_b * c_perp[1];
+            const T cz = cos_b * va[2] + sin_b * c_perp[2];
+            // a point on the arc from b to that vertex
+            const T d = cx * vb[0] + cy * vb[1] + cz * vb[2];
+            const T h = T(1) - v * (T(1) - d);
+            const T sin_h = kernels::sqrt_one_minus<A>(h * h);
+            const T wx = cx - d * vb[0], wy = cy - d * vb[1], wz = cz - d * vb[2];
+            const T len2 = wx * wx + wy * wy + wz * wz;
+            const T scale = select(len2 > T(0), sin_h * tao::kernels::Rsqrt::template apply<A>(len2), T(0));
+            x = h * vb[0] + scale * wx;
+            y = h * vb[1] + scale * wy;
+            z = h * vb[2] + scale * wz;
+        }
+};
+
+};
+};
+
+#endif
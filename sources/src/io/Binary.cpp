@@ -0,0 +1,46 @@
+#include "tao/io/Binary.h"
+
+tao::io::BinaryHeader tao::io::make_binary_header(ElementType type, std::size_t element_size,
+        std::uint64_t rows, std::uint64_t cols, std::uint64_t stride) {
+    BinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "TAOMAT\0\0", 8);
+    header.version = binary_version;
+    header.byte_order = binary_byte_order_mark;
+    header.element_type = type;
+    header.element_size = static_cast<std::uint32_t>(element_size);
+    header.order = RowMajor;
+    header.rows = rows;
+    header.cols = cols;
+    header.stride = stride;
+    header.offset = binary_payload_alignment;
+    return header;
+}
+
+tao::io::BinaryHeader tao::io::read_binary_header(const unsigned char* bytes, std::size_t size) {
+    BinaryHeader header;
+    if (bytes == nullptr || size < sizeof(header))
+        throw std::invalid_argument("truncated binary matrix header");
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, "TAOMAT\0\0", 8) != 0)
+        throw std::invalid_argument("not a tao binary matrix");
+    if (header.version != binary_version)
+        throw std::invalid_argument("unsupported binary matrix version " + std::to_string(header.version));
+    if (header.byte_order != binary_byte_order_mark)
+        throw std::invalid_argument("binary matrix written with a different byte order");
+    if (header.order != RowMajor && header.order != ColMajor)
+        throw std::invalid_argument("invalid storage order " + std::to_string(header.order));
+    if (header.offset < sizeof(header) || header.offset % binary_payload_alignment != 0)
+        throw std::invalid_argument("misaligned binary matrix payload");
+    std::uint64_t lines = (header.order == RowMajor) ? header.rows : header.cols;
+    std::uint64_t line = (header.order == RowMajor) ? header.cols : header.rows;
+    if (header.stride < line)
+        throw std::invalid_argument("binary matrix stride smaller than a line");
+    if (header.rows > INT32_MAX || header.cols > INT32_MAX)
+        throw std::invalid_argument("binary matrix too large for int indices");
+    if (header.element_size == 0 || header.offset > size)
+        throw std::invalid_argument("truncated binary matrix payload");
+    if (lines > 0 && line > 0 && (size - header.offset) / header.element_size / header.stride < lines)
+        throw std::invalid_argument("truncated binary matrix payload");
+    return header;
+}
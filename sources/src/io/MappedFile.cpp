@@ -0,0 +1,67 @@
+#include "tao/io/MappedFile.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+tao::io::MappedFile::MappedFile(const std::string& path, MapMode mode) : mode {mode} {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("could not open " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("could not stat " + path + ": " + std::strerror(errno));
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    if (length > 0) {
+        int prot = (mode == CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* ptr = ::mmap(nullptr, length, prot, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("could not map " + path + ": " + std::strerror(errno));
+        }
+        base = static_cast<unsigned char*>(ptr);
+    }
+    ::close(fd);
+}
+
+tao::io::MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base {other.base}, length {other.length}, mode {other.mode} {
+    other.base = nullptr;
+    other.length = 0;
+}
+
+tao::io::MappedFile& tao::io::MappedFile::operator=(MappedFile&& other) noexcept {
+    std::swap(base, other.base);
+    std::swap(length, other.length);
+    std::swap(mode, other.mode);
+    return (*this);
+}
+
+tao::io::MappedFile::~MappedFile() {
+    if (base != nullptr)
+        ::munmap(base, length);
+}
+
+void tao::io::MappedFile::advise(MapAccess access, std::size_t offset, std::size_t size) const {
+    if (base == nullptr || offset >= length)
+        return;
+    if (size == 0 || offset + size > length)
+        size = length - offset;
+    // madvise wants a page-aligned start
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t start = (offset / page) * page;
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case Sequential: advice = MADV_SEQUENTIAL; break;
+        case Random: advice = MADV_RANDOM; break;
+        case WillNeed: advice = MADV_WILLNEED; break;
+        default: break;
+    }
+    ::madvise(base + start, size + (offset - start), advice);
+}
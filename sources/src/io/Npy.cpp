@@ -0,0 +1,481 @@
+#include "tao/io/Npy.h"
+#include <array>
+#include <cctype>
+
+namespace {
+
+const char npy_magic[] = "\x93NUMPY";
+constexpr std::size_t npy_magic_size = 6;
+constexpr std::size_t npy_alignment = 64;
+
+constexpr std::uint32_t zip_local_signature = 0x04034b50;
+constexpr std::uint32_t zip_central_signature = 0x02014b50;
+constexpr std::uint32_t zip_end_signature = 0x06054b50;
+constexpr std::uint32_t zip64_end_signature = 0x06064b50;
+constexpr std::uint32_t zip64_locator_signature = 0x07064b50;
+constexpr std::uint16_t zip64_extra_id = 0x0001;
+constexpr std::uint16_t padding_extra_id = 0x5441;
+constexpr std::uint32_t zip32_max = 0xFFFFFFFFu;
+constexpr std::uint16_t zip16_max = 0xFFFFu;
+
+std::uint64_t read_le(const unsigned char* p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/**
+ * Whether [offset, offset + length) lies within size bytes, without
+ * overflowing on offsets and lengths read from a corrupt archive.
+ * */
+bool within(std::uint64_t offset, std::uint64_t length, std::uint64_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+void append_le(std::string& out, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i)
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+/**
+ * Slicing-by-8 tables for the reflected zip polynomial.
+ * */
+struct Crc32Tables {
+    std::array<std::array<std::uint32_t, 256>, 8> t;
+    Crc32Tables() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            t[0][i] = c;
+        }
+        for (std::uint32_t i = 0; i < 256; ++i)
+            for (int s = 1; s < 8; ++s)
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+
+const Crc32Tables& crc32_tables() {
+    static const Crc32Tables tables;
+    return tables;
+}
+
+std::size_t skip_spaces(const std::string& s, std::size_t i) {
+    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])))
+        ++i;
+    return i;
+}
+
+/**
+ * Position right after the colon following a dictionary key.
+ * */
+std::size_t find_value(const std::string& dict, const std::string& key) {
+    std::size_t k = dict.find("'" + key + "'");
+    if (k == std::string::npos)
+        k = dict.find("\"" + key + "\"");
+    if (k == std::string::npos)
+        throw std::invalid_argument("npy header without " + key);
+    std::size_t colon = dict.find(':', k + key.size() + 2);
+    if (colon == std::string::npos)
+        throw std::invalid_argument("malformed npy header near " + key);
+    return skip_spaces(dict, colon + 1);
+}
+
+};
+
+tao::io::NpyHeader tao::io::parse_npy_header(const unsigned char* bytes, std::size_t size) {
+    if (size < npy_magic_size + 4 || std::memcmp(bytes, npy_magic, npy_magic_size) != 0)
+        throw std::invalid_argument("not a npy file");
+    int major = bytes[6];
+    std::size_t header_len, prefix;
+    if (major == 1) {
+        header_len = read_le(bytes + 8, 2);
+        prefix = 10;
+    } else if (major == 2 || major == 3) {
+        if (size < 12)
+            throw std::invalid_argument("truncated npy header");
+        header_len = read_le(bytes + 8, 4);
+        prefix = 12;
+    } else {
+        throw std::invalid_argument("unsupported npy version " + std::to_string(major));
+    }
+    if (prefix + header_len > size)
+        throw std::invalid_argument("truncated npy header");
+
+    std::string dict (reinterpret_cast<const char*>(bytes + prefix), header_len);
+    NpyHeader header;
+    header.data_offset = prefix + header_len;
+
+    std::size_t i = find_value(dict, "descr");
+    if (i >= dict.size() || (dict[i] != '\'' && dict[i] != '"'))
+        throw std::invalid_argument("structured npy dtypes are not supported");
+    std::size_t end = dict.find(dict[i], i + 1);
+    if (end == std::string::npos)
+        throw std::invalid_argument("malformed npy descr");
+    header.descr = dict.substr(i + 1, end - i - 1);
+
+    i = find_value(dict, "fortran_order");
+    if (dict.compare(i, 4, "True") == 0)
+        header.fortran_order = true;
+    else if (dict.compare(i, 5, "False") == 0)
+        header.fortran_order = false;
+    else
+        throw std::invalid_argument("malformed npy fortran_order");
+
+    i = find_value(dict, "shape");
+    if (i >= dict.size() || dict[i] != '(')
+        throw std::invalid_argument("malformed npy shape");
+    ++i;
+    while (true) {
+        i = skip_spaces(dict, i);
+        if (i >= dict.size())
+            throw std::invalid_argument("malformed npy shape");
+        if (dict[i] == ')')
+            break;
+        if (!std::isdigit(static_cast<unsigned char>(dict[i])))
+            throw std::invalid_argument("malformed npy shape");
+        std::uint64_t dim = 0;
+        while (i < dict.size() && std::isdigit(static_cast<unsigned char>(dict[i])))
+            dim = dim * 10 + (dict[i++] - '0');
+        header.shape.push_back(dim);
+        i = skip_spaces(dict, i);
+        if (i < dict.size() && dict[i] == ',')
+            ++i;
+    }
+    return header;
+}
+
+void tao::io::check_npy_descr(const std::string& found, const char* expected) {
+    std::string normalized = found;
+    if (!normalized.empty() && normalized[0] == '=')
+        normalized[0] = expected[0];
+    if (normalized.size() == 3 && normalized[0] == '|' && expected[0] == '<' && normalized[2] == '1')
+        normalized[0] = '<';
+    if (normalized != expected)
+        throw std::invalid_argument("npy dtype " + found + " does not match " + expected);
+}
+
+std::pair<int, int> tao::io::npy_matrix_shape(const std::vector<std::uint64_t>& shape) {
+    std::uint64_t rows = 1, cols = 1;
+    if (shape.size() == 1) {
+        rows = shape[0];
+    } else if (shape.size() == 2) {
+        rows = shape[0];
+        cols = shape[1];
+    } else if (shape.size() > 2) {
+        throw std::invalid_argument("npy arrays of rank " + std::to_string(shape.size())
+                + " are not matrices");
+    }
+    if (rows > INT32_MAX || cols > INT32_MAX)
+        throw std::invalid_argument("npy array too large for int indices");
+    return {static_cast<int>(rows), static_cast<int>(cols)};
+}
+
+std::string tao::io::make_npy_header(const char* descr, std::uint64_t rows, std::uint64_t cols) {
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': ("
+        + std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+    std::size_t prefix = npy_magic_size + 4;
+    int major = 1;
+    if (prefix + dict.size() + 1 > 0xFFFF) {
+        prefix = npy_magic_size + 6;
+        major = 2;
+    }
+    std::size_t total = prefix + dict.size() + 1;
+    total = ((total + npy_alignment - 1) / npy_alignment) * npy_alignment;
+    dict.append(total - prefix - dict.size() - 1, ' ');
+    dict.push_back('\n');
+
+    std::string out (npy_magic, npy_magic_size);
+    out.push_back(static_cast<char>(major));
+    out.push_back(0);
+    append_le(out, dict.size(), major == 1 ? 2 : 4);
+    out += dict;
+    return out;
+}
+
+std::uint32_t tao::io::crc32(std::uint32_t crc, const void* bytes, std::size_t size) {
+    const auto& t = crc32_tables().t;
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    crc = ~crc;
+    while (size >= 8) {
+        std::uint32_t lo = crc ^ static_cast<std::uint32_t>(read_le(p, 4));
+        std::uint32_t hi = static_cast<std::uint32_t>(read_le(p + 4, 4));
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void tao::io::write_npy(const std::string& path, const char* descr, int rows, int cols,
+        const void* first, int ld, std::size_t element_size) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr)
+        throw std::runtime_error("could not open " + path + " for writing");
+    std::vector<char> buffer (std::size_t(1) << 20);
+    std::setvbuf(f, buffer.data(), _IOFBF, buffer.size());
+    std::string header = make_npy_header(descr, rows, cols);
+    bool ok = std::fwrite(header.data(), 1, header.size(), f) == header.size();
+    const unsigned char* bytes = static_cast<const unsigned char*>(first);
+    std::size_t row_bytes = element_size * cols;
+    if (ld == cols) {
+        std::size_t total = row_bytes * rows;
+        ok = ok && (total == 0 || std::fwrite(bytes, 1, total, f) == total);
+    } else {
+        for (int i = 0; ok && i < rows; ++i)
+            ok = std::fwrite(bytes + std::size_t(i) * ld * element_size, 1, row_bytes, f) == row_bytes;
+    }
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok)
+        throw std::runtime_error("could not write " + path);
+}
+
+tao::io::NpzArchive::NpzArchive(const std::string& path)
+    : file {std::make_shared<const MappedFile>(path)} {
+    const unsigned char* base = file->data();
+    std::size_t size = file->size();
+    if (size < 22)
+        throw std::invalid_argument("not a zip archive: " + path);
+
+    // the end of central directory record is followed by at most 64K of comment
+    std::size_t eocd = size - 22;
+    std::size_t lowest = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+    while (read_le(base + eocd, 4) != zip_end_signature) {
+        if (eocd == lowest)
+            throw std::invalid_argument("not a zip archive: " + path);
+        --eocd;
+    }
+    std::uint64_t count = read_le(base + eocd + 10, 2);
+    std::uint64_t cd_offset = read_le(base + eocd + 16, 4);
+    if ((count == zip16_max || cd_offset == zip32_max) && eocd >= 20
+            && read_le(base + eocd - 20, 4) == zip64_locator_signature) {
+        std::uint64_t eocd64 = read_le(base + eocd - 20 + 8, 8);
+        if (!within(eocd64, 56, size) || read_le(base + eocd64, 4) != zip64_end_signature)
+            throw std::invalid_argument("corrupt zip64 record in " + path);
+        count = read_le(base + eocd64 + 32, 8);
+        cd_offset = read_le(base + eocd64 + 48, 8);
+    }
+
+    std::uint64_t p = cd_offset;
+    for (std::uint64_t n = 0; n < count; ++n) {
+        if (!within(p, 46, size) || read_le(base + p, 4) != zip_central_signature)
+            throw std::invalid_argument("corrupt central directory in " + path);
+        std::uint16_t method = read_le(base + p + 10, 2);
+        std::uint64_t csize = read_le(base + p + 20, 4);
+        std::uint64_t usize = read_le(base + p + 24, 4);
+        std::size_t name_len = read_le(base + p + 28, 2);
+        std::size_t extra_len = read_le(base + p + 30, 2);
+        std::size_t comment_len = read_le(base + p + 32, 2);
+        std::uint64_t local = read_le(base + p + 42, 4);
+        if (!within(p + 46, name_len + extra_len, size))
+            throw std::invalid_argument("corrupt central directory in " + path);
+        std::string name (reinterpret_cast<const char*>(base + p + 46), name_len);
+
+        const unsigned char* extra = base + p + 46 + name_len;
+        for (std::size_t e = 0; e + 4 <= extra_len;) {
+            std::uint16_t id = read_le(extra + e, 2);
+            std::size_t len = read_le(extra + e + 2, 2);
+            if (e + 4 + len > extra_len)
+                throw std::invalid_argument("corrupt extra field of " + name + " in " + path);
+            if (id == zip64_extra_id) {
+                // the 8-byte values present are those whose 32-bit field is saturated
+                const unsigned char* field = extra + e + 4;
+                std::size_t read = 0;
+                auto next = [&]() {
+                    if (read + 8 > len)
+                        throw std::invalid_argument("corrupt zip64 field of " + name + " in " + path);
+                    read += 8;
+                    return read_le(field + read - 8, 8);
+                };
+                if (usize == zip32_max) usize = next();
+                if (csize == zip32_max) csize = next();
+                if (local == zip32_max) local = next();
+            }
+            e += 4 + len;
+        }
+
+        if (!within(local, 30, size) || read_le(base + local, 4) != zip_local_signature)
+            throw std::invalid_argument("corrupt local header in " + path);
+        std::size_t data = local + 30 + read_le(base + local + 26, 2) + read_le(base + local + 28, 2);
+        if (data > size || csize > size - data)
+            throw std::invalid_argument("truncated entry " + name + " in " + path);
+
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".npy") == 0)
+            name.resize(name.size() - 4);
+        entries[name] = Entry {data, static_cast<std::size_t>(csize), method == 0};
+        p += 46 + name_len + extra_len + comment_len;
+    }
+}
+
+std::vector<std::string> tao::io::NpzArchive::names() const {
+    std::vector<std::string> result;
+    for (const auto& e : entries)
+        result.push_back(e.first);
+    return result;
+}
+
+const tao::io::NpzArchive::Entry& tao::io::NpzArchive::entry(const std::string& name) const {
+    auto it = entries.find(name);
+    if (it == entries.end())
+        throw std::invalid_argument("no array named " + name + " in archive");
+    if (!it->second.stored)
+        throw std::invalid_argument("array " + name + " is compressed; only np.savez archives are supported");
+    return it->second;
+}
+
+tao::io::NpzWriter::NpzWriter(const std::string& path) : path {path} {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        throw std::runtime_error("could not open " + path + " for writing");
+    buffer.resize(std::size_t(1) << 20);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+}
+
+tao::io::NpzWriter::~NpzWriter() {
+    try { close(); } catch (...) {/* destructors do not throw */}
+}
+
+void tao::io::NpzWriter::write_bytes(const void* bytes, std::size_t size) {
+    if (size > 0 && std::fwrite(bytes, 1, size, file) != size)
+        throw std::runtime_error("could not write to " + path);
+    position += size;
+}
+
+void tao::io::NpzWriter::add_array(const std::string& name, const char* descr, int rows, int cols,
+        const void* first, int ld, std::size_t element_size) {
+    if (file == nullptr)
+        throw std::logic_error("write to a closed npz writer");
+
+    std::string header = make_npy_header(descr, rows, cols);
+    const unsigned char* bytes = static_cast<const unsigned char*>(first);
+    std::size_t row_bytes = element_size * cols;
+
+    Entry entry {name + ".npy", crc32(0, header.data(), header.size()),
+        header.size() + std::uint64_t(row_bytes) * rows, position};
+    for (int i = 0; i < rows; ++i)
+        entry.crc = crc32(entry.crc, bytes + std::size_t(i) * ld * element_size, row_bytes);
+
+    bool zip64 = entry.size >= zip32_max;
+    std::string local;
+    append_le(local, zip_local_signature, 4);
+    append_le(local, zip64 ? 45 : 20, 2);
+    append_le(local, 0, 2);                         // flags
+    append_le(local, 0, 2);                         // stored
+    append_le(local, 0, 2);                         // time
+    append_le(local, (0 << 9) | (1 << 5) | 1, 2);   // 1980-01-01
+    append_le(local, entry.crc, 4);
+    append_le(local, zip64 ? zip32_max : entry.size, 4);
+    append_le(local, zip64 ? zip32_max : entry.size, 4);
+    append_le(local, entry.name.size(), 2);
+    std::string extra;
+    if (zip64) {
+        append_le(extra, zip64_extra_id, 2);
+        append_le(extra, 16, 2);
+        append_le(extra, entry.size, 8);
+        append_le(extra, entry.size, 8);
+    }
+    // pad with an extra field so that the .npy, hence its data, is aligned
+    std::size_t unaligned = (position + local.size() + 2 + entry.name.size() + extra.size()) % npy_alignment;
+    std::size_t pad = (npy_alignment - unaligned) % npy_alignment;
+    if (pad > 0 && pad < 4)
+        pad += npy_alignment;
+    if (pad > 0) {
+        append_le(extra, padding_extra_id, 2);
+        append_le(extra, pad - 4, 2);
+        extra.append(pad - 4, '\0');
+    }
+    append_le(local, extra.size(), 2);
+    local += entry.name;
+    local += extra;
+
+    write_bytes(local.data(), local.size());
+    write_bytes(header.data(), header.size());
+    if (ld == cols) {
+        write_bytes(bytes, row_bytes * rows);
+    } else {
+        for (int i = 0; i < rows; ++i)
+            write_bytes(bytes + std::size_t(i) * ld * element_size, row_bytes);
+    }
+    entries.push_back(entry);
+}
+
+void tao::io::NpzWriter::close() {
+    if (file == nullptr)
+        return;
+    std::uint64_t cd_offset = position;
+    for (const Entry& e : entries) {
+        bool big_size = e.size >= zip32_max;
+        bool big_offset = e.offset >= zip32_max;
+        std::string extra;
+        if (big_size || big_offset) {
+            append_le(extra, zip64_extra_id, 2);
+            append_le(extra, (big_size ? 16 : 0) + (big_offset ? 8 : 0), 2);
+            if (big_size) {
+                append_le(extra, e.size, 8);
+                append_le(extra, e.size, 8);
+            }
+            if (big_offset)
+                append_le(extra, e.offset, 8);
+        }
+        std::string central;
+        append_le(central, zip_central_signature, 4);
+        append_le(central, extra.empty() ? 20 : 45, 2);
+        append_le(central, extra.empty() ? 20 : 45, 2);
+        append_le(central, 0, 2);
+        append_le(central, 0, 2);
+        append_le(central, 0, 2);
+        append_le(central, (0 << 9) | (1 << 5) | 1, 2);
+        append_le(central, e.crc, 4);
+        append_le(central, big_size ? zip32_max : e.size, 4);
+        append_le(central, big_size ? zip32_max : e.size, 4);
+        append_le(central, e.name.size(), 2);
+        append_le(central, extra.size(), 2);
+        append_le(central, 0, 2);                   // comment
+        append_le(central, 0, 2);                   // disk
+        append_le(central, 0, 2);                   // internal attributes
+        append_le(central, 0, 4);                   // external attributes
+        append_le(central, big_offset ? zip32_max : e.offset, 4);
+        central += e.name;
+        central += extra;
+        write_bytes(central.data(), central.size());
+    }
+    std::uint64_t cd_size = position - cd_offset;
+
+    std::string end;
+    bool zip64 = entries.size() >= zip16_max || cd_offset >= zip32_max || cd_size >= zip32_max;
+    if (zip64) {
+        std::uint64_t eocd64 = position;
+        append_le(end, zip64_end_signature, 4);
+        append_le(end, 44, 8);
+        append_le(end, 45, 2);
+        append_le(end, 45, 2);
+        append_le(end, 0, 4);
+        append_le(end, 0, 4);
+        append_le(end, entries.size(), 8);
+        append_le(end, entries.size(), 8);
+        append_le(end, cd_size, 8);
+        append_le(end, cd_offset, 8);
+        append_le(end, zip64_locator_signature, 4);
+        append_le(end, 0, 4);
+        append_le(end, eocd64, 8);
+        append_le(end, 1, 4);
+    }
+    append_le(end, zip_end_signature, 4);
+    append_le(end, 0, 2);
+    append_le(end, 0, 2);
+    append_le(end, zip64 ? zip16_max : entries.size(), 2);
+    append_le(end, zip64 ? zip16_max : entries.size(), 2);
+    append_le(end, zip64 ? zip32_max : cd_size, 4);
+    append_le(end, zip64 ? zip32_max : cd_offset, 4);
+    append_le(end, 0, 2);
+    write_bytes(end.data(), end.size());
+
+    std::FILE* f = file;
+    file = nullptr;
+    if (std::fclose(f) != 0)
+        throw std::runtime_error("could not finalize " + path);
+}
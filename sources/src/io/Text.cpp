@@ -0,0 +1,65 @@
+#include "tao/io/Text.h"
+
+std::vector<const char*> tao::io::split_lines(const char* first, const char* last, std::size_t chunks) {
+    std::vector<const char*> bounds {first};
+    std::size_t size = last - first;
+    chunks = std::max<std::size_t>(chunks, 1);
+    for (std::size_t c = 1; c < chunks; ++c) {
+        const char* p = first + size * c / chunks;
+        if (p <= bounds.back())
+            continue;
+        // move forward to the start of the next line
+        const char* nl = static_cast<const char*>(std::memchr(p - 1, '\n', last - p + 1));
+        if (nl == nullptr)
+            break;
+        if (nl + 1 > bounds.back() && nl + 1 < last)
+            bounds.push_back(nl + 1);
+    }
+    bounds.push_back(last);
+    return bounds;
+}
+
+std::size_t tao::io::count_rows(const char* first, const char* last) {
+    std::size_t rows = 0;
+    const char* p = first;
+    while (p < last) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', last - p));
+        const char* eol = nl ? nl : last;
+        if (!is_blank_line(p, eol))
+            ++rows;
+        p = nl ? nl + 1 : last;
+    }
+    return rows;
+}
+
+int tao::io::count_fields(const char* first, const char* last, TextDialect dialect) {
+    const char* p = first;
+    while (p < last) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', last - p));
+        const char* eol = nl ? nl : last;
+        const char* q = p;
+        while (q < eol && (*q == ' ' || *q == '\t' || *q == '\r'))
+            ++q;
+        if (q < eol) {
+            int fields = 0;
+            if (dialect == Whitespace) {
+                bool in_value = false;
+                for (; q < eol; ++q) {
+                    bool blank = is_blank(*q, dialect);
+                    if (!blank && !in_value)
+                        ++fields;
+                    in_value = !blank;
+                }
+            } else {
+                fields = 1;
+                const char delimiter = delimiter_of(dialect);
+                for (; q < eol; ++q)
+                    if (*q == delimiter)
+                        ++fields;
+            }
+            return fields;
+        }
+        p = nl ? nl + 1 : last;
+    }
+    return 0;
+}
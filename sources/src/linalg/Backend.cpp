@@ -0,0 +1,103 @@
+#include "tao/linalg/Backend.h"
+#include <atomic>
+#include <stdexcept>
+
+#ifdef TAO_HAS_BLAS
+// the CBLAS interface, declared here so that any BLAS shipping it
+// links, whatever the name and place of its header
+extern "C" {
+void cblas_sgemm(int order, int transa, int transb, int m, int n, int k, float alpha,
+        const float* a, int lda, const float* b, int ldb, float beta, float* c, int ldc);
+void cblas_dgemm(int order, int transa, int transb, int m, int n, int k, double alpha,
+        const double* a, int lda, const double* b, int ldb, double beta, double* c, int ldc);
+void cblas_sgemv(int order, int trans, int m, int n, float alpha, const float* a, int lda,
+        const float* x, int incx, float beta, float* y, int incy);
+void cblas_dgemv(int order, int trans, int m, int n, double alpha, const double* a, int lda,
+        const double* x, int incx, double beta, double* y, int incy);
+}
+#endif
+
+namespace {
+
+#ifdef TAO_HAS_BLAS
+constexpr int row_major = 101, no_trans = 111;
+#endif
+
+std::atomic<bool> routing {true};
+std::atomic<std::size_t> gemm_threshold {tao::backend::default_thresholds.gemm};
+std::atomic<std::size_t> gemv_threshold {tao::backend::default_thresholds.gemv};
+
+[[noreturn]] void unavailable() {
+    throw std::logic_error("tao was built without a BLAS backend");
+}
+
+};
+
+bool tao::backend::available() {
+#ifdef TAO_HAS_BLAS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool tao::backend::enabled() {
+    return routing.load(std::memory_order_relaxed);
+}
+
+void tao::backend::set_enabled(bool on) {
+    routing.store(on, std::memory_order_relaxed);
+}
+
+tao::backend::Thresholds tao::backend::thresholds() {
+    return {gemm_threshold.load(std::memory_order_relaxed), gemv_threshold.load(std::memory_order_relaxed)};
+}
+
+void tao::backend::set_thresholds(const Thresholds& t) {
+    gemm_threshold.store(t.gemm, std::memory_order_relaxed);
+    gemv_threshold.store(t.gemv, std::memory_order_relaxed);
+}
+
+void tao::backend::gemm(int m, int n, int k, float alpha, const float* a, int lda, const float* b, int ldb,
+        float beta, float* c, int ldc) {
+#ifdef TAO_HAS_BLAS
+    cblas_sgemm(row_major, no_trans, no_trans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+#else
+    (void) m; (void) n; (void) k; (void) alpha; (void) a; (void) lda;
+    (void) b; (void) ldb; (void) beta; (void) c; (void) ldc;
+    unavailable();
+#endif
+}
+
+void tao::backend::gemm(int m, int n, int k, double alpha, const double* a, int lda, const double* b, int ldb,
+        double beta, double* c, int ldc) {
+#ifdef TAO_HAS_BLAS
+    cblas_dgemm(row_major, no_trans, no_trans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+#else
+    (void) m; (void) n; (void) k; (void) alpha; (void) a; (void) lda;
+    (void) b; (void) ldb; (void) beta; (void) c; (void) ldc;
+    unavailable();
+#endif
+}
+
+void tao::backend::gemv(int m, int n, float alpha, const float* a, int lda, const float* x, int incx,
+        float beta, float* y, int incy) {
+#ifdef TAO_HAS_BLAS
+    cblas_sgemv(row_major, no_trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+#else
+    (void) m; (void) n; (void) alpha; (void) a; (void) lda; (void) x;
+    (void) incx; (void) beta; (void) y; (void) incy;
+    unavailable();
+#endif
+}
+
+void tao::backend::gemv(int m, int n, double alpha, const double* a, int lda, const double* x, int incx,
+        double beta, double* y, int incy) {
+#ifdef TAO_HAS_BLAS
+    cblas_dgemv(row_major, no_trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+#else
+    (void) m; (void) n; (void) alpha; (void) a; (void) lda; (void) x;
+    (void) incx; (void) beta; (void) y; (void) incy;
+    unavailable();
+#endif
+}
@@ -0,0 +1,77 @@
+#include "tao/linalg/Half.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TAO_F16C_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#ifdef TAO_F16C_DISPATCH
+// compiled for F16C whatever the flags, called only when the CPU has it
+__attribute__((target("avx,f16c")))
+void halves_to_floats_f16c(const std::uint16_t* src, float* dst, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+    for (; i < n; ++i)
+        dst[i] = _cvtsh_ss(src[i]);
+}
+
+__attribute__((target("avx,f16c")))
+void floats_to_halves_f16c(const float* src, std::uint16_t* dst, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    for (; i < n; ++i)
+        dst[i] = std::uint16_t(_cvtss_sh(src[i], _MM_FROUND_TO_NEAREST_INT));
+}
+
+const bool f16c = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+#else
+const bool f16c = false;
+#endif
+
+};
+
+bool tao::has_f16c() {
+    return f16c;
+}
+
+// the formats are a single uint16_t, so arrays of them are arrays of bits
+static_assert(sizeof(tao::Half) == 2 && sizeof(tao::BFloat16) == 2, "16-bit formats must be 2 bytes");
+
+void tao::convert(const Half* src, float* dst, std::size_t n) {
+#ifdef TAO_F16C_DISPATCH
+    if (f16c) {
+        halves_to_floats_f16c(reinterpret_cast<const std::uint16_t*>(src), dst, n);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = src[i];
+}
+
+void tao::convert(const float* src, Half* dst, std::size_t n) {
+#ifdef TAO_F16C_DISPATCH
+    if (f16c) {
+        floats_to_halves_f16c(src, reinterpret_cast<std::uint16_t*>(dst), n);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = src[i];
+}
+
+void tao::convert(const BFloat16* src, float* dst, std::size_t n) {
+    const std::uint16_t* bits = reinterpret_cast<const std::uint16_t*>(src);
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = kernels::bfloat16_to_float(bits[i]);
+}
+
+void tao::convert(const float* src, BFloat16* dst, std::size_t n) {
+    std::uint16_t* bits = reinterpret_cast<std::uint16_t*>(dst);
+    for (std::size_t i = 0; i < n; ++i)
+        bits[i] = kernels::float_to_bfloat16(src[i]);
+}
@@ -0,0 +1,324 @@
+#include "tao/linalg/Tuning.h"
+#include "tao/linalg/Backend.h"
+#include "tao/linalg/Reductions.h"
+#include "tao/linalg/Strassen.h"
+#include "tao/linalg/Transpose.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::size_t floor_pow2(std::size_t x) {
+    std::size_t p = 1;
+    while (p <= x / 2)
+        p *= 2;
+    return p;
+}
+
+std::size_t clamp_pow2(std::size_t x, std::size_t lo, std::size_t hi) {
+    return std::min(hi, std::max(lo, floor_pow2(x)));
+}
+
+/**
+ * Size of the data or unified cache of a level, from /sys, as
+ * "48K" or "2M"; 0 if unknown.
+ * */
+std::size_t sysfs_cache(int level) {
+    for (int index = 0; index < 16; ++index) {
+        const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        char text[3][32] = {};
+        const char* names[3] = {"level", "type", "size"};
+        bool ok = true;
+        for (int f = 0; f < 3 && ok; ++f) {
+            std::FILE* file = std::fopen((dir + names[f]).c_str(), "r");
+            ok = file != nullptr && std::fgets(text[f], sizeof(text[f]), file) != nullptr;
+            if (file)
+                std::fclose(file);
+        }
+        if (!ok)
+            return 0;
+        if (std::atoi(text[0]) != level || std::strncmp(text[1], "Instruction", 11) == 0)
+            continue;
+        char* unit = nullptr;
+        const std::size_t size = std::strtoull(text[2], &unit, 10);
+        const char u = unit ? *unit : '\0';
+        return size << (u == 'K' ? 10 : u == 'M' ? 20 : u == 'G' ? 30 : 0);
+    }
+    return 0;
+}
+
+std::size_t cache_size(int name, int level, std::size_t fallback) {
+    const long size = ::sysconf(name);
+    if (size > 0)
+        return std::size_t(size);
+    const std::size_t listed = sysfs_cache(level);
+    return listed > 0 ? listed : fallback;
+}
+
+// the profile in use, field by field
+std::atomic<int> gemm_mc, gemm_kc, gemm_nc, transpose_edge, cutoff;
+std::atomic<std::size_t> grain;
+
+void store(const tao::tuning::Profile& p) {
+    gemm_mc.store(p.gemm.mc, std::memory_order_relaxed);
+    gemm_kc.store(p.gemm.kc, std::memory_order_relaxed);
+    gemm_nc.store(p.gemm.nc, std::memory_order_relaxed);
+    transpose_edge.store(p.transpose_block, std::memory_order_relaxed);
+    grain.store(p.reduction_grain, std::memory_order_relaxed);
+    cutoff.store(p.strassen_cutoff, std::memory_order_relaxed);
+}
+
+bool initialize() {
+    tao::tuning::Profile p = tao::tuning::derived_profile(tao::tuning::cache_sizes());
+    const std::string path = tao::tuning::default_path();
+    if (!path.empty() && ::access(path.c_str(), R_OK) == 0) {
+        try {
+            p = tao::tuning::load(path);
+        } catch (const std::exception&) {
+            // a broken profile is no worse than none
+        }
+    }
+    store(p);
+    return true;
+}
+
+void ensure_initialized() {
+    static const bool ready = initialize();
+    (void) ready;
+}
+
+/**
+ * Creates the directories leading to a file, like mkdir -p.
+ * */
+void make_parents(const std::string& path) {
+    for (std::size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+        ::mkdir(path.substr(0, slash).c_str(), 0755);
+}
+
+void validate(const tao::tuning::Profile& p) {
+    if (p.gemm.mc <= 0 || p.gemm.kc <= 0 || p.gemm.nc <= 0 || p.transpose_block <= 0 || p.reduction_grain == 0
+            || p.strassen_cutoff <= 0)
+        throw std::invalid_argument("block sizes of a profile must be positive");
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Best of three timings of f.
+ * */
+template<typename F>
+double best_time(F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < 3; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, seconds_since(start));
+    }
+    return best;
+}
+
+};
+
+tao::tuning::CacheSizes tao::tuning::cache_sizes() {
+    static const CacheSizes sizes {
+        cache_size(_SC_LEVEL1_DCACHE_SIZE, 1, std::size_t(32) << 10),
+        cache_size(_SC_LEVEL2_CACHE_SIZE, 2, std::size_t(256) << 10),
+        cache_size(_SC_LEVEL3_CACHE_SIZE, 3, std::size_t(8) << 20)
+    };
+    return sizes;
+}
+
+tao::tuning::Profile tao::tuning::derived_profile(const CacheSizes& caches) {
+    const std::size_t d = sizeof(double);
+    Profile p;
+    // C rows of a tile, updated together, in half of L1
+    p.gemm.nc = int(clamp_pow2(caches.l1 / (2 * 4 * d), 64, 1024));
+    // a kc x nc panel of B in half of L2
+    p.gemm.kc = int(clamp_pow2(caches.l2 / (2 * d * p.gemm.nc), 32, 1024));
+    p.gemm.mc = default_gemm_blocking.mc;
+    // a source and a destination tile in half of L1
+    std::size_t edge = 8;
+    while (2 * (2 * edge) * (2 * edge) * d <= caches.l1 / 2 && edge < 256)
+        edge *= 2;
+    p.transpose_block = int(edge);
+    p.reduction_grain = clamp_pow2(caches.l2 / (4 * d), std::size_t(1) << 14, std::size_t(1) << 20);
+    return p;
+}
+
+tao::tuning::Profile tao::tuning::profile() {
+    ensure_initialized();
+    return {gemm_blocking(), transpose_block(), reduction_grain(), strassen_cutoff()};
+}
+
+void tao::tuning::set_profile(const Profile& p) {
+    validate(p);
+    ensure_initialized();
+    store(p);
+}
+
+std::string tao::tuning::default_path() {
+    if (const char* path = std::getenv("TAO_PROFILE"))
+        return path;
+    if (const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.cache/tao/profile";
+    return "";
+}
+
+void tao::tuning::save(const Profile& p, const std::string& path) {
+    validate(p);
+    make_parents(path);
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+        throw std::runtime_error("could not open " + path + " for writing");
+    const int written = std::fprintf(file,
+        "# tao block sizes, see tao::tuning\ngemm_mc %d\ngemm_kc %d\ngemm_nc %d\ntranspose_block %d\nreduction_grain %zu\n"
+        "strassen_cutoff %d\n",
+        p.gemm.mc, p.gemm.kc, p.gemm.nc, p.transpose_block, p.reduction_grain, p.strassen_cutoff);
+    if (std::fclose(file) != 0 || written < 0)
+        throw std::runtime_error("could not write " + path);
+}
+
+tao::tuning::Profile tao::tuning::load(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr)
+        throw std::runtime_error("could not open " + path);
+    Profile p = derived_profile(cache_sizes());
+    char line[256];
+    while (std::fgets(line, sizeof(line), file)) {
+        char key[64];
+        long long value = 0;
+        char rest = '\0';
+        if (line[0] == '#' || std::sscanf(line, " %63s", key) != 1)
+            continue;
+        if (std::sscanf(line, " %63s %lld %c", key, &value, &rest) != 2 || value <= 0 || value > (1ll << 30)) {
+            std::fclose(file);
+            throw std::invalid_argument("invalid profile line: " + std::string(line));
+        }
+        const std::string k = key;
+        if (k == "gemm_mc") p.gemm.mc = int(value);
+        else if (k == "gemm_kc") p.gemm.kc = int(value);
+        else if (k == "gemm_nc") p.gemm.nc = int(value);
+        else if (k == "transpose_block") p.transpose_block = int(value);
+        else if (k == "reduction_grain") p.reduction_grain = std::size_t(value);
+        else if (k == "strassen_cutoff") p.strassen_cutoff = int(value);
+    }
+    std::fclose(file);
+    return p;
+}
+
+tao::tuning::Profile tao::tuning::tune(int size) {
+    if (size < 16)
+        throw std::invalid_argument("tuning needs matrices of at least 16x16");
+    const Profile before = profile();
+    const bool routing = backend::enabled();
+    // the native kernels are the ones being tuned
+    backend::set_enabled(false);
+    Profile best = before;
+    try {
+        const std::size_t n = std::size_t(size);
+        std::vector<double> a (n * n), b (n * n), c (n * n);
+        for (std::size_t i = 0; i < n * n; ++i) {
+            a[i] = double(i % 13) - 6.0;
+            b[i] = double(i % 7) - 3.0;
+        }
+        double fastest = 1e30;
+        for (int mc : {32, 64, 128})
+            for (int kc : {64, 128, 256, 512})
+                for (int nc : {128, 256, 512, 1024}) {
+                    const GemmBlocking blocking {mc, kc, nc};
+                    const double t = best_time([&]() {
+                        kernels::gemm(size, size, size, 1.0, a.data(), size, b.data(), size, 0.0, c.data(), size, blocking);
+                    });
+                    if (t < fastest) {
+                        fastest = t;
+                        best.gemm = blocking;
+                    }
+                }
+
+        const int edge = 4 * size;
+        std::vector<double> src (std::size_t(edge) * edge, 1.0), dst (src.size());
+        fastest = 1e30;
+        for (int block : {8, 16, 32, 64, 128}) {
+            const double t = best_time([&]() { transpose(src.data(), edge, edge, edge, dst.data(), edge, block); });
+            if (t < fastest) {
+                fastest = t;
+                best.transpose_block = block;
+            }
+        }
+
+        std::vector<double> x (n * n * 4, 0.5);
+        fastest = 1e30;
+        for (std::size_t g = std::size_t(1) << 13; g <= (std::size_t(1) << 19); g *= 4) {
+            volatile double sink = 0.0;
+            const double t = best_time([&]() {
+                sink = sink + kernels::accumulate<double>(x.size(), [&](std::size_t i) { return x[i]; }, Naive, 1, g);
+            });
+            if (t < fastest) {
+                fastest = t;
+                best.reduction_grain = g;
+            }
+        }
+
+        // one level of recursion against gemm, whose leaves read the blocks from the profile
+        store(best);
+        best.strassen_cutoff = std::max(default_strassen_cutoff, 4 * size);
+        const int levels = kernels::strassen_parallel_levels();
+        for (int edge : {size, 2 * size}) {
+            const std::size_t e = std::size_t(edge);
+            std::vector<double> x (e * e), y (e * e), z (e * e);
+            for (std::size_t i = 0; i < e * e; ++i) {
+                x[i] = double(i % 13) - 6.0;
+                y[i] = double(i % 7) - 3.0;
+            }
+            std::vector<double> work (kernels::strassen_workspace(edge, edge, edge, edge, levels));
+            const double plain = best_time([&]() {
+                kernels::gemm(edge, edge, edge, 1.0, x.data(), edge, y.data(), edge, 0.0, z.data(), edge);
+            });
+            const double split = best_time([&]() {
+                kernels::strassen(edge, edge, edge, x.data(), edge, y.data(), edge, z.data(), edge, edge, levels, work.data());
+            });
+            if (split < plain) {
+                best.strassen_cutoff = edge;
+                break;
+            }
+        }
+    } catch (...) {
+        store(before);
+        backend::set_enabled(routing);
+        throw;
+    }
+    store(before);
+    backend::set_enabled(routing);
+    return best;
+}
+
+tao::GemmBlocking tao::gemm_blocking() {
+    ensure_initialized();
+    return {gemm_mc.load(std::memory_order_relaxed), gemm_kc.load(std::memory_order_relaxed),
+        gemm_nc.load(std::memory_order_relaxed)};
+}
+
+int tao::transpose_block() {
+    ensure_initialized();
+    return transpose_edge.load(std::memory_order_relaxed);
+}
+
+std::size_t tao::reduction_grain() {
+    ensure_initialized();
+    return grain.load(std::memory_order_relaxed);
+}
+
+int tao::strassen_cutoff() {
+    ensure_initialized();
+    return cutoff.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,279 @@
+#include "tao/parallel/Parallel.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<unsigned int> requested_threads {0};
+std::atomic<bool> deterministic_mode {false};
+
+/**
+ * The threads the scheduler starts when no executor was given,
+ * as many as concurrency() asks for, kept for later calls.
+ * */
+class ThreadPool : public tao::parallel::Executor {
+
+    public:
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> guard {lock};
+                stopping = true;
+            }
+            ready.notify_all();
+            for (auto& t : threads)
+                t.join();
+        }
+
+        void execute(std::function<void()> job) override {
+            std::lock_guard<std::mutex> guard {lock};
+            jobs.push(std::move(job));
+            if (idle < jobs.size() && threads.size() + 1 < tao::parallel::concurrency())
+                threads.emplace_back([this]() { work(); });
+            else
+                ready.notify_one();
+        }
+
+    protected:
+
+        void work() {
+            std::unique_lock<std::mutex> guard {lock};
+            for (;;) {
+                ++idle;
+                ready.wait(guard, [this]() { return stopping || !jobs.empty(); });
+                --idle;
+                if (jobs.empty())
+                    return;
+                auto job = std::move(jobs.front());
+                jobs.pop();
+                guard.unlock();
+                job();
+                guard.lock();
+            }
+        }
+
+        std::mutex lock;
+        std::condition_variable ready;
+        std::queue<std::function<void()>> jobs;
+        std::vector<std::thread> threads;
+        std::size_t idle = 0;
+        bool stopping = false;
+};
+
+ThreadPool& default_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+std::atomic<tao::parallel::Executor*> user_executor {nullptr};
+
+using tao::parallel::kernels::Task;
+
+/**
+ * Deques of the threads within the scheduler: the owner pushes and
+ * pops at the back, thieves take the oldest, largest tasks at the
+ * front.
+ * */
+struct Slot {
+    std::mutex lock;
+    std::deque<Task*> tasks;
+    std::atomic<bool> used {false};
+};
+
+constexpr std::size_t max_slots = 256;
+
+Slot slots[max_slots];
+std::atomic<std::size_t> slots_in_use {0};
+
+thread_local int current_slot = -1;
+thread_local std::uint32_t steal_state = 0;
+
+// helpers with nothing to steal sleep until something is pushed
+std::mutex sleep_lock;
+std::condition_variable wake;
+std::atomic<int> sleepers {0};
+std::atomic<std::uint64_t> pushes {0};
+
+int acquire_slot() {
+    for (std::size_t i = 0; i < max_slots; ++i) {
+        bool expected = false;
+        if (!slots[i].used.load(std::memory_order_relaxed)
+                && slots[i].used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            std::size_t high = slots_in_use.load(std::memory_order_relaxed);
+            while (high < i + 1 && !slots_in_use.compare_exchange_weak(high, i + 1));
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+void release_slot(int slot) {
+    slots[slot].used.store(false, std::memory_order_release);
+}
+
+void notify_sleepers() {
+    if (sleepers.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> guard {sleep_lock};
+        wake.notify_all();
+    }
+}
+
+/**
+ * Takes the oldest task of another thread, starting from a random one.
+ * */
+Task* steal(int self) {
+    const std::size_t n = slots_in_use.load(std::memory_order_acquire);
+    if (n == 0)
+        return nullptr;
+    if (steal_state == 0)
+        steal_state = std::uint32_t(self) * 0x9e3779b9u + 1;
+    steal_state ^= steal_state << 13;
+    steal_state ^= steal_state >> 17;
+    steal_state ^= steal_state << 5;
+    const std::size_t start = steal_state % n;
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::size_t i = (start + k) % n;
+        if (int(i) == self || !slots[i].used.load(std::memory_order_relaxed))
+            continue;
+        std::lock_guard<std::mutex> guard {slots[i].lock};
+        if (!slots[i].tasks.empty()) {
+            Task* task = slots[i].tasks.front();
+            slots[i].tasks.pop_front();
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+};
+
+struct tao::parallel::kernels::Region::State {
+    std::atomic<bool> done {false};
+};
+
+namespace {
+
+/**
+ * The job a parallel call submits: works within the scheduler until
+ * the call completes.
+ * */
+void help(const std::shared_ptr<tao::parallel::kernels::Region::State>& state) {
+    // an executor running jobs inline, or one of its threads already helping
+    if (current_slot >= 0 || state->done.load(std::memory_order_acquire))
+        return;
+    const int slot = acquire_slot();
+    if (slot < 0)
+        return;
+    current_slot = slot;
+    int misses = 0;
+    while (!state->done.load(std::memory_order_acquire)) {
+        if (Task* task = steal(slot)) {
+            task->execute();
+            misses = 0;
+        } else if (++misses < 64) {
+            std::this_thread::yield();
+        } else {
+            const std::uint64_t seen = pushes.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> guard {sleep_lock};
+            sleepers.fetch_add(1, std::memory_order_acq_rel);
+            wake.wait_for(guard, std::chrono::milliseconds(1), [&]() {
+                return state->done.load(std::memory_order_acquire) || pushes.load(std::memory_order_acquire) != seen;
+            });
+            sleepers.fetch_sub(1, std::memory_order_acq_rel);
+            misses = 0;
+        }
+    }
+    current_slot = -1;
+    release_slot(slot);
+}
+
+};
+
+bool tao::parallel::kernels::push(Task* task) {
+    if (current_slot < 0)
+        return false;
+    {
+        Slot& slot = slots[current_slot];
+        std::lock_guard<std::mutex> guard {slot.lock};
+        slot.tasks.push_back(task);
+    }
+    pushes.fetch_add(1, std::memory_order_release);
+    notify_sleepers();
+    return true;
+}
+
+bool tao::parallel::kernels::pop(Task* task) {
+    Slot& slot = slots[current_slot];
+    std::lock_guard<std::mutex> guard {slot.lock};
+    if (slot.tasks.empty() || slot.tasks.back() != task)
+        return false;
+    slot.tasks.pop_back();
+    return true;
+}
+
+void tao::parallel::kernels::wait(Task& task) {
+    // only tasks of others: the own deque holds nothing below the task
+    while (!task.done.load(std::memory_order_acquire)) {
+        if (Task* other = steal(current_slot))
+            other->execute();
+        else
+            std::this_thread::yield();
+    }
+}
+
+tao::parallel::kernels::Region::Region(std::size_t helpers) {
+    if (current_slot >= 0)
+        return;
+    const int slot = acquire_slot();
+    if (slot < 0)
+        return;
+    current_slot = slot;
+    state = std::make_shared<State>();
+    Executor* executor = user_executor.load(std::memory_order_acquire);
+    if (executor == nullptr)
+        executor = &default_pool();
+    auto shared = state;
+    for (std::size_t i = 0; i < helpers; ++i)
+        executor->execute([shared]() { help(shared); });
+}
+
+tao::parallel::kernels::Region::~Region() {
+    if (!state)
+        return;
+    state->done.store(true, std::memory_order_release);
+    notify_sleepers();
+    release_slot(current_slot);
+    current_slot = -1;
+}
+
+unsigned int tao::parallel::concurrency() {
+    unsigned int threads = requested_threads.load(std::memory_order_relaxed);
+    if (threads == 0) {
+        static const unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+        threads = hardware;
+    }
+    return threads;
+}
+
+void tao::parallel::set_concurrency(unsigned int threads) {
+    requested_threads.store(threads, std::memory_order_relaxed);
+}
+
+bool tao::parallel::deterministic() {
+    return deterministic_mode.load(std::memory_order_relaxed);
+}
+
+void tao::parallel::set_deterministic(bool enabled) {
+    deterministic_mode.store(enabled, std::memory_order_relaxed);
+}
+
+void tao::parallel::set_executor(Executor* executor) {
+    user_executor.store(executor, std::memory_order_release);
+}
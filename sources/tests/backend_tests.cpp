@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Backend.h"
+#include "tao/linalg/Blas.h"
+#include "tao/parallel/Parallel.h"
+#include <random>
+
+namespace {
+
+    using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+    DMat random_matrix(int rows, int cols, unsigned seed, tao::StorageLayout layout = tao::Packed) {
+        std::mt19937 gen {seed};
+        std::uniform_int_distribution<int> u {-8, 8};
+        DMat m (rows, cols, layout);
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                m(i, j) = u(gen);
+        return m;
+    }
+
+    /**
+     * Routes every product, and restores the settings.
+     * */
+    struct Everything {
+        tao::backend::Thresholds previous;
+        Everything() : previous {tao::backend::thresholds()} { tao::backend::set_thresholds({0, 0}); }
+        ~Everything() { tao::backend::set_thresholds(previous); tao::backend::set_enabled(true); }
+    };
+
+    TEST(Backend, SameProducts) {
+        Everything all;
+        DMat a = random_matrix(67, 45, 1, tao::Padded), b = random_matrix(45, 31, 2, tao::Padded);
+        DMat x = random_matrix(45, 1, 3), y (67, 1);
+        // small integers: exact in any order, with or without the backend
+        DMat routed = a * b;
+        tao::gemv(1.0, a, x, 0.0, y);
+        tao::backend::set_enabled(false);
+        DMat native = a * b;
+        DMat z (67, 1);
+        tao::gemv(1.0, a, x, 0.0, z);
+        ASSERT_EQ(routed, native);
+        ASSERT_EQ(y, z);
+    }
+
+    TEST(Backend, OtherElementTypes) {
+        // the backend lacks them: products stay on the native kernels
+        Everything all;
+        tao::Mat<int, 2, 2> a {{1, 2}, {3, 4}};
+        ASSERT_EQ(a * a, (tao::Mat<int, 2, 2>{{7, 10}, {15, 22}}));
+        tao::Mat<int, Dynamic, Dynamic> b (40, 40), x (40, 1), y (40, 1);
+        for (int i = 0; i < 40; ++i) {
+            x(i, 0) = i;
+            for (int j = 0; j < 40; ++j)
+                b(i, j) = i - j;
+        }
+        tao::Mat<int, Dynamic, Dynamic> c = b * b;
+        tao::gemv(2, b, x, 0, y);
+        for (int i = 0; i < 40; ++i) {
+            int row = 0, squared = 0;
+            for (int j = 0; j < 40; ++j) {
+                row += (i - j) * j;
+                squared += (i - j) * (j - 5);
+            }
+            ASSERT_EQ(y(i, 0), 2 * row);
+            ASSERT_EQ(c(i, 5), squared);
+        }
+        tao::Mat<long double, Dynamic, Dynamic> l (3, 3);
+        l(0, 0) = 2.0L;
+        ASSERT_EQ((l * l)(0, 0), 4.0L);
+    }
+
+    TEST(Backend, Routing) {
+        Everything all;
+        ASSERT_EQ(tao::backend::routes<double>(1, 0), tao::backend::available());
+        ASSERT_FALSE(tao::backend::routes<int>(1, 0));
+        tao::parallel::set_deterministic(true);
+        ASSERT_FALSE(tao::backend::routes<float>(1, 0));
+        tao::parallel::set_deterministic(false);
+        tao::backend::set_enabled(false);
+        ASSERT_FALSE(tao::backend::routes<float>(1, 0));
+        tao::backend::set_thresholds(tao::backend::default_thresholds);
+        tao::backend::set_enabled(true);
+        // small products stay inline
+        ASSERT_FALSE(tao::backend::routes<double>(16 * 16 * 16, tao::backend::thresholds().gemm));
+        ASSERT_FALSE(tao::backend::routes<float>(4 * 4, tao::backend::thresholds().gemv));
+        ASSERT_EQ(tao::backend::routes<double>(64 * 64 * 64, tao::backend::thresholds().gemm), tao::backend::available());
+        if (!tao::backend::available()) {
+            double c = 0.0;
+            ASSERT_THROW(tao::backend::gemm(1, 1, 1, 1.0, &c, 1, &c, 1, 0.0, &c, 1), std::logic_error);
+        }
+    }
+
+};
@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Batch.h"
+#include "tao/parallel/Parallel.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using tao::Mat;
+
+    template<typename T, int N>
+    std::vector<Mat<T, N, N>> random_matrices(std::size_t count, unsigned seed) {
+        std::mt19937 gen {seed};
+        std::uniform_real_distribution<T> u {T(-1), T(1)};
+        std::vector<Mat<T, N, N>> m (count, Mat<T, N, N>(T(0)));
+        for (auto& a : m)
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                    // diagonally dominant, for well-conditioned systems
+                    a(i, j) = u(gen) + (i == j ? T(N) : T(0));
+        return m;
+    }
+
+    template<typename T, int N>
+    Mat<T, N, N> product(const Mat<T, N, N>& a, const Mat<T, N, N>& b) {
+        Mat<T, N, N> c (T(0));
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                for (int k = 0; k < N; ++k)
+                    c(i, j) += a(i, k) * b(k, j);
+        return c;
+    }
+
+    template<int N>
+    void check_inverse_and_solve() {
+        // a count that leaves a partial block
+        const std::size_t count = 1000 + 5;
+        auto m = random_matrices<double, N>(count, N);
+        std::vector<Mat<double, N, N>> inv (count);
+        std::vector<double> det (count);
+        tao::batch_inverse(m.data(), count, inv.data(), det.data());
+        std::vector<double> only (count);
+        tao::batch_det(m.data(), count, only.data());
+        std::vector<Mat<double, N, 1>> x (count, Mat<double, N, 1>(1.0));
+        for (std::size_t i = 0; i < count; ++i)
+            x[i](N - 1) = double(i);
+        auto b = x;
+        tao::batch_solve(m.data(), x.data(), count, x.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(det[i], only[i]);
+            auto id = product(m[i], inv[i]);
+            for (int r = 0; r < N; ++r) {
+                double ax = 0.0;
+                for (int c = 0; c < N; ++c) {
+                    ASSERT_NEAR(id(r, c), r == c ? 1.0 : 0.0, 1e-13) << i;
+                    ax += m[i](r, c) * x[i](c);
+                }
+                ASSERT_NEAR(ax, b[i](r), 1e-12 * (1.0 + double(i)));
+            }
+        }
+    }
+
+    TEST(Batch, Multiply) {
+        auto threads = tao::parallel::concurrency();
+        tao::parallel::set_concurrency(4);
+        const std::size_t count = 10000 + 3;
+        auto a = random_matrices<float, 4>(count, 1);
+        auto b = random_matrices<float, 4>(count, 2);
+        std::vector<Mat<float, 4, 4>> c (count);
+        tao::batch_multiply(a.data(), b.data(), count, c.data());
+        for (std::size_t i = 0; i < count; ++i)
+            ASSERT_EQ(c[i], product(a[i], b[i])) << i;
+        // in place, on either side
+        tao::batch_multiply(a.data(), b.data(), count, a.data());
+        for (std::size_t i = 0; i < count; ++i)
+            ASSERT_EQ(a[i], c[i]) << i;
+        auto m3 = random_matrices<double, 3>(7, 3);
+        auto copy = m3;
+        tao::batch_multiply(copy.data(), m3.data(), 7, m3.data());
+        for (std::size_t i = 0; i < 7; ++i)
+            ASSERT_EQ(m3[i], product(copy[i], copy[i]));
+        tao::batch_multiply(a.data(), b.data(), 0, c.data());
+        tao::parallel::set_concurrency(threads);
+    }
+
+    TEST(Batch, InverseDetSolve) {
+        check_inverse_and_solve<2>();
+        check_inverse_and_solve<3>();
+        check_inverse_and_solve<4>();
+    }
+
+    TEST(Batch, MatchesSingleMatrix) {
+        auto m = random_matrices<float, 4>(64, 5);
+        std::vector<Mat<float, 4, 4>> inv (64);
+        std::vector<float> det (64);
+        tao::batch_inverse(m.data(), m.size(), inv.data(), det.data());
+        for (std::size_t i = 0; i < m.size(); ++i) {
+            ASSERT_NEAR(det[i], tao::det(m[i]), 1e-4f * std::abs(det[i]));
+            auto single = tao::inverse(m[i]);
+            for (int r = 0; r < 4; ++r)
+                for (int c = 0; c < 4; ++c)
+                    ASSERT_NEAR(inv[i](r, c), single(r, c), 1e-5f);
+        }
+        // singular matrices are flagged by their determinants
+        Mat<float, 3, 3> singular {{1.0f, 2.0f, 3.0f}, {2.0f, 4.0f, 6.0f}, {0.0f, 1.0f, 1.0f}};
+        float d = 1.0f;
+        tao::batch_inverse(&singular, 1, &singular, &d);
+        ASSERT_EQ(d, 0.0f);
+        ASSERT_FALSE(std::isfinite(singular(0, 0)));
+    }
+
+};
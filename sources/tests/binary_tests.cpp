@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+#include "tao/io/Binary.h"
+#include <cstdio>
+
+namespace {
+
+    std::string temp_path(const std::string& name) {
+        return ::testing::TempDir() + name;
+    }
+
+    TEST(Binary, SaveAndMap) {
+        tao::Mat<double, Dynamic, Dynamic> mat (5, 3);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 3; ++j)
+                mat(i, j) = i * 3 + j;
+        auto path = temp_path("tao_binary_map.bin");
+        tao::io::save_binary(path, mat);
+
+        tao::MappedMat<double> view {path};
+        ASSERT_EQ(view.nrows(), 5);
+        ASSERT_EQ(view.ncols(), 3);
+        ASSERT_TRUE(tao::is_aligned(view.raw(), 64));
+        ASSERT_DOUBLE_EQ(view(4, 2), 14.0);
+        ASSERT_DOUBLE_EQ(view(1, 0), 3.0);
+        ASSERT_THROW(view(5, 0), std::invalid_argument);
+        ASSERT_THROW(view.ref(0, 0) = 1.0, std::logic_error);
+        std::remove(path.c_str());
+    }
+
+    TEST(Binary, PaddedRoundTrip) {
+        tao::Mat<float, 2, 3> mat {
+            {1.0, 2.0, 3.0},
+            {4.0, 5.0, 6.0}
+        };
+        auto path = temp_path("tao_binary_padded.bin");
+        tao::io::save_binary(path, mat, tao::Padded);
+
+        tao::MappedMat<float> view {path};
+        ASSERT_EQ(view.ld(), 16);
+        ASSERT_TRUE(tao::is_aligned(view.raw() + view.ld(), 64));
+
+        auto loaded = tao::io::load_binary<float>(path);
+        ASSERT_EQ(loaded.nrows(), 2);
+        ASSERT_EQ(loaded.ncols(), 3);
+        ASSERT_FLOAT_EQ(loaded(1, 2), 6.0f);
+        ASSERT_FLOAT_EQ(loaded(0, 1), 2.0f);
+        std::remove(path.c_str());
+    }
+
+    TEST(Binary, StreamingWriterAndCopyOnWrite) {
+        auto path = temp_path("tao_binary_stream.bin");
+        {
+            tao::io::BinaryWriter<int> writer {path, 4};
+            for (int i = 0; i < 100; ++i) {
+                int row[4] = {i, i + 1, i + 2, i + 3};
+                writer.write_row(row);
+            }
+        }
+        {
+            tao::MappedMat<int> view {path, tao::io::CopyOnWrite};
+            ASSERT_EQ(view.nrows(), 100);
+            ASSERT_EQ(view(99, 3), 102);
+            view.ref(99, 3) = -1;
+            ASSERT_EQ(view(99, 3), -1);
+        }
+        tao::MappedMat<int> again {path};
+        ASSERT_EQ(again(99, 3), 102);
+        std::remove(path.c_str());
+    }
+
+    TEST(Binary, TypeMismatch) {
+        tao::Mat<float, 1, 2> mat {{1.0, 2.0}};
+        auto path = temp_path("tao_binary_type.bin");
+        tao::io::save_binary(path, mat);
+        ASSERT_THROW(tao::MappedMat<double> view {path}, std::invalid_argument);
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,165 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Blas.h"
+#include "tao/parallel/Parallel.h"
+#include <cmath>
+#include <random>
+
+namespace {
+
+    using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+    /**
+     * Small integers, so that sums are exact in any order.
+     * */
+    DMat random_matrix(int rows, int cols, unsigned seed, tao::StorageLayout layout = tao::Packed) {
+        std::mt19937 gen {seed};
+        std::uniform_int_distribution<int> u {-8, 8};
+        DMat m (rows, cols, layout);
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                m(i, j) = u(gen);
+        return m;
+    }
+
+    /**
+     * The 1D Laplacian with Dirichlet ends, never stored.
+     * */
+    struct Laplacian {
+        int n;
+        int nrows() const { return n; }
+        int ncols() const { return n; }
+        void apply(double alpha, const DMat& x, double beta, DMat& y) const {
+            for (int i = 0; i < n; ++i) {
+                double v = 2.0 * x(i, 0);
+                if (i > 0) v -= x(i - 1, 0);
+                if (i + 1 < n) v -= x(i + 1, 0);
+                y(i, 0) = beta == 0.0 ? alpha * v : alpha * v + beta * y(i, 0);
+            }
+        }
+    };
+
+    static_assert(tao::is_linear_operator_v<Laplacian, double>, "operators are detected");
+    static_assert(!tao::is_linear_operator_v<DMat, double>, "matrices go to the stored kernels");
+
+    /**
+     * Conjugate gradients on gemv and axpy alone, for stored and
+     * matrix-free operators alike.
+     * */
+    template<typename Op>
+    DMat solve_cg(const Op& a, const DMat& b, int iterations) {
+        DMat x (b.nrows(), 1), r = b, p = b, q (b.nrows(), 1);
+        double rr = tao::dot(r, r);
+        for (int k = 0; k < iterations && rr > 1e-24; ++k) {
+            tao::gemv(1.0, a, p, 0.0, q);
+            const double step = rr / tao::dot(p, q);
+            tao::axpy(step, p, x);
+            tao::axpy(-step, q, r);
+            const double next = tao::dot(r, r);
+            tao::axpby(1.0, r, next / rr, p);
+            rr = next;
+        }
+        return x;
+    }
+
+    TEST(Blas, Level1) {
+        for (auto layout : {tao::Packed, tao::Padded}) {
+            DMat x = random_matrix(37, 13, 1, layout), y = random_matrix(37, 13, 2, layout);
+            DMat y0 = y;
+            tao::axpy(2.0, x, y);
+            for (int i = 0; i < 37; ++i)
+                for (int j = 0; j < 13; ++j)
+                    ASSERT_EQ(y(i, j), 2.0 * x(i, j) + y0(i, j));
+            tao::axpby(-1.0, x, 0.5, y);
+            for (int i = 0; i < 37; ++i)
+                for (int j = 0; j < 13; ++j)
+                    ASSERT_EQ(y(i, j), -x(i, j) + 0.5 * (2.0 * x(i, j) + y0(i, j)));
+            tao::scal(4.0, x);
+            tao::axpby(0.25, x, 0.0, y0);
+            ASSERT_EQ(y0, random_matrix(37, 13, 1, layout));
+        }
+        tao::Vec3f a {1.0f, 2.0f, 3.0f}, b {1.0f, 1.0f, 1.0f};
+        tao::axpy(2.0f, a, b);
+        ASSERT_EQ(b, (tao::Vec3f {3.0f, 5.0f, 7.0f}));
+        DMat small (3, 2), other (2, 3);
+        ASSERT_THROW(tao::axpy(1.0, small, other), std::invalid_argument);
+    }
+
+    TEST(Blas, LargeParallel) {
+        auto threads = tao::parallel::concurrency();
+        tao::parallel::set_concurrency(4);
+        const int n = 1 << 18;
+        DMat x = random_matrix(n, 1, 3), y = random_matrix(n, 1, 4);
+        DMat y0 = y;
+        tao::axpy(3.0, x, y);
+        for (int i = 0; i < n; ++i)
+            ASSERT_EQ(y(i, 0), 3.0 * x(i, 0) + y0(i, 0));
+        DMat a = random_matrix(700, 600, 5, tao::Padded);
+        DMat v = random_matrix(600, 1, 6), w = random_matrix(700, 1, 7), w0 = w;
+        tao::gemv(2.0, a, v, -1.0, w);
+        for (int i = 0; i < 700; ++i) {
+            double s = 0.0;
+            for (int j = 0; j < 600; ++j)
+                s += a(i, j) * v(j, 0);
+            ASSERT_EQ(w(i, 0), 2.0 * s - w0(i, 0));
+        }
+        tao::parallel::set_concurrency(threads);
+    }
+
+    TEST(Blas, Level2) {
+        DMat a = random_matrix(5, 7, 8);
+        DMat row = random_matrix(1, 7, 9);
+        DMat col (5, 1, tao::Padded);
+        col.reset(std::nan(""));
+        // beta 0 does not read y
+        tao::gemv(1.0, a, row, 0.0, col);
+        for (int i = 0; i < 5; ++i) {
+            double s = 0.0;
+            for (int j = 0; j < 7; ++j)
+                s += a(i, j) * row(0, j);
+            ASSERT_EQ(col(i, 0), s);
+        }
+        ASSERT_THROW(tao::gemv(1.0, a, col, 0.0, row), std::invalid_argument);
+
+        tao::Mat<float, 3, 3> m {{1.0f, 2.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 2.0f}};
+        tao::Vec3f v {1.0f, 1.0f, 1.0f}, out (0.0f);
+        tao::gemv(1.0f, m, v, 0.0f, out);
+        ASSERT_EQ(out, (tao::Vec3f {3.0f, 1.0f, 2.0f}));
+
+        DMat g = random_matrix(5, 7, 10, tao::Padded), g0 = g;
+        DMat x = random_matrix(5, 1, 11);
+        tao::ger(0.5, x, row, g);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 7; ++j)
+                ASSERT_EQ(g(i, j), g0(i, j) + 0.5 * x(i, 0) * row(0, j));
+        DMat s (5, 5);
+        tao::syr(2.0, x, s);
+        tao::syr(-1.0, x, s);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 5; ++j)
+                ASSERT_EQ(s(i, j), x(i, 0) * x(j, 0));
+        ASSERT_THROW(tao::syr(1.0, x, g), std::invalid_argument);
+    }
+
+    TEST(Blas, Operators) {
+        const int n = 50;
+        Laplacian op {n};
+        DMat stored (n, n);
+        for (int i = 0; i < n; ++i) {
+            stored(i, i) = 2.0;
+            if (i > 0) stored(i, i - 1) = -1.0;
+            if (i + 1 < n) stored(i, i + 1) = -1.0;
+        }
+        DMat b = random_matrix(n, 1, 12);
+        DMat x1 = solve_cg(op, b, n), x2 = solve_cg(stored, b, n);
+        DMat check (n, 1);
+        tao::gemv(1.0, op, x1, 0.0, check);
+        for (int i = 0; i < n; ++i) {
+            ASSERT_NEAR(check(i, 0), b(i, 0), 1e-9);
+            ASSERT_NEAR(x1(i, 0), x2(i, 0), 1e-9);
+        }
+        DMat wrong (n + 1, 1);
+        ASSERT_THROW(tao::gemv(1.0, op, wrong, 0.0, check), std::invalid_argument);
+    }
+
+};
@@ -0,0 +1,224 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/BVH.h"
+#include "tao/geometry/Sphere.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    std::vector<Sphere<float>> random_spheres(std::size_t n, unsigned int seed) {
+        std::mt19937 gen {seed};
+        std::uniform_real_distribution<float> pos {-50.0f, 50.0f}, rad {0.05f, 0.5f};
+        std::vector<Sphere<float>> spheres;
+        spheres.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            spheres.emplace_back(tao::Vec3f {pos(gen), pos(gen), pos(gen)}, rad(gen));
+        return spheres;
+    }
+
+    std::vector<AABB<float>> bounds_of(const std::vector<Sphere<float>>& spheres) {
+        std::vector<AABB<float>> bounds;
+        for (const auto& s : spheres)
+            bounds.push_back(s.bounds());
+        return bounds;
+    }
+
+    void check_structure(const BVH<float>& bvh, std::size_t n) {
+        const auto& nodes = bvh.nodes();
+        std::vector<int> seen (n, 0);
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].leaf()) {
+                ASSERT_LE(nodes[i].count, 4);
+                for (std::uint32_t p = nodes[i].offset; p < nodes[i].offset + nodes[i].count; ++p)
+                    ++seen[bvh.primitives()[p]];
+            } else {
+                ASSERT_GT(nodes[i].offset, i + 1);
+                ASSERT_LT(nodes[i].offset, nodes.size());
+                for (std::uint32_t c : {std::uint32_t(i + 1), nodes[i].offset})
+                    for (int a = 0; a < 3; ++a) {
+                        ASSERT_LE(nodes[i].lower[a], nodes[c].lower[a]);
+                        ASSERT_GE(nodes[i].upper[a], nodes[c].upper[a]);
+                    }
+            }
+        }
+        for (std::size_t p = 0; p < n; ++p)
+            ASSERT_EQ(seen[p], 1);
+    }
+
+    TEST(BVH, NodeLayout) {
+        ASSERT_EQ(sizeof(BVHNode<float>), 32u);
+        ASSERT_EQ(alignof(BVHNode<float>), 32u);
+    }
+
+    TEST(BVH, EmptyAndInvalid) {
+        BVH<float> empty {std::vector<AABB<float>> {}};
+        ASSERT_TRUE(empty.empty());
+        std::uint32_t p;
+        float t;
+        Ray<float> ray {tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}};
+        ASSERT_FALSE(empty.closest_hit(ray, [](std::uint32_t, const Ray<float>&, float&) { return true; }, p, t));
+        BVHBuildOptions options;
+        options.bins = 1;
+        ASSERT_THROW((BVH<float> {std::vector<AABB<float>> {}, options}), std::invalid_argument);
+    }
+
+    TEST(BVH, ClosestAndAnyHitMatchBruteForce) {
+        auto spheres = random_spheres(20000, 7);
+        BVH<float> bvh {bounds_of(spheres)};
+        check_structure(bvh, spheres.size());
+        ASSERT_GT(bvh.depth(), 8);
+
+        auto hit_sphere = [&](std::uint32_t i, const Ray<float>& r, float& t) { return intersect(spheres[i], r, t); };
+        std::mt19937 gen {11};
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        int hits = 0;
+        for (int k = 0; k < 300; ++k) {
+            Ray<float> ray {tao::Vec3f {u(gen) * 60.0f, u(gen) * 60.0f, u(gen) * 60.0f},
+                tao::Vec3f {u(gen), u(gen), u(gen)}, 0.0f, 80.0f};
+            std::uint32_t expected_p = 0;
+            float expected_t = ray.tmax;
+            bool expected = false;
+            for (std::uint32_t i = 0; i < spheres.size(); ++i) {
+                Ray<float> shortened = ray;
+                shortened.tmax = expected_t;
+                float t;
+                if (intersect(spheres[i], shortened, t)) {
+                    expected = true;
+                    expected_t = t;
+                    expected_p = i;
+                }
+            }
+            std::uint32_t p;
+            float t;
+            ASSERT_EQ(bvh.closest_hit(ray, hit_sphere, p, t), expected);
+            ASSERT_EQ(bvh.any_hit(ray, hit_sphere), expected);
+            if (expected) {
+                ++hits;
+                ASSERT_EQ(p, expected_p);
+                ASSERT_FLOAT_EQ(t, expected_t);
+            }
+        }
+        ASSERT_GT(hits, 10);
+    }
+
+    TEST(BVH, SameTreeForAnyThreadCount) {
+        auto bounds = bounds_of(random_spheres(60000, 3));
+        tao::parallel::set_concurrency(1);
+        BVH<float> serial {bounds};
+        tao::parallel::set_concurrency(8);
+        BVH<float> parallel {bounds};
+        tao::parallel::set_concurrency(0);
+        ASSERT_EQ(serial.nodes().size(), parallel.nodes().size());
+        ASSERT_EQ(std::memcmp(serial.nodes().data(), parallel.nodes().data(),
+                    serial.nodes().size() * sizeof(BVHNode<float>)), 0);
+        ASSERT_EQ(serial.primitives(), parallel.primitives());
+        check_structure(parallel, bounds.size());
+    }
+
+    TEST(BVH, CoincidentCentroids) {
+        std::vector<AABB<float>> bounds (100, AABB<float> {tao::Vec3f {-1.0f, -1.0f, -1.0f}, tao::Vec3f {1.0f, 1.0f, 1.0f}});
+        BVH<float> bvh {bounds};
+        check_structure(bvh, bounds.size());
+        Ray<float> ray {tao::Vec3f {0.0f, 0.0f, -5.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}};
+        int visited = 0;
+        std::uint32_t p;
+        float t;
+        bvh.closest_hit(ray, [&](std::uint32_t, const Ray<float>&, float&) { ++visited; return false; }, p, t);
+        ASSERT_EQ(visited, 100);
+    }
+
+    void check_against_brute_force(const BVH<float>& bvh, const std::vector<Sphere<float>>& spheres, unsigned int seed) {
+        auto hit_sphere = [&](std::uint32_t i, const Ray<float>& r, float& t) { return intersect(spheres[i], r, t); };
+        std::mt19937 gen {seed};
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        for (int k = 0; k < 100; ++k) {
+            Ray<float> ray {tao::Vec3f {u(gen) * 60.0f, u(gen) * 60.0f, u(gen) * 60.0f},
+                tao::Vec3f {u(gen), u(gen), u(gen)}, 0.0f, 80.0f};
+            float expected_t = ray.tmax;
+            bool expected = false;
+            for (std::uint32_t i = 0; i < spheres.size(); ++i) {
+                Ray<float> shortened = ray;
+                shortened.tmax = expected_t;
+                float t;
+                if (intersect(spheres[i], shortened, t)) {
+                    expected = true;
+                    expected_t = t;
+                }
+            }
+            std::uint32_t p;
+            float t;
+            ASSERT_EQ(bvh.closest_hit(ray, hit_sphere, p, t), expected);
+            if (expected) {
+                ASSERT_FLOAT_EQ(t, expected_t);
+            }
+        }
+    }
+
+    TEST(BVH, RefitTracksRigidMotion) {
+        auto spheres = random_spheres(20000, 5);
+        BVH<float> bvh {bounds_of(spheres)};
+        float cost = bvh.sah_cost();
+        ASSERT_GT(cost, 0.0f);
+        ASSERT_FLOAT_EQ(bvh.quality_ratio(), 1.0f);
+        for (auto& s : spheres)
+            s.center.raw()[1] += 3.0f;
+        auto bounds = bounds_of(spheres);
+        ASSERT_EQ(bvh.update(bounds.data()), Refitted);
+        ASSERT_NEAR(bvh.quality_ratio(), 1.0f, 1e-3f);
+        ASSERT_FLOAT_EQ(bvh.bounds().lower.raw()[1], BVH<float> {bounds}.bounds().lower.raw()[1]);
+        check_structure(bvh, spheres.size());
+        check_against_brute_force(bvh, spheres, 21);
+    }
+
+    TEST(BVH, DirtyRefitMatchesFullRefit) {
+        auto spheres = random_spheres(10000, 9);
+        BVH<float> partial {bounds_of(spheres)}, full {bounds_of(spheres)};
+        for (std::size_t i = 100; i < 150; ++i)
+            spheres[i].center.raw()[0] += 1.0f;
+        spheres[7000].radius = 2.0f;
+        auto bounds = bounds_of(spheres);
+        partial.refit(bounds.data(), {{100, 150}, {7000, 7001}});
+        full.refit(bounds.data());
+        ASSERT_EQ(std::memcmp(partial.nodes().data(), full.nodes().data(),
+                    full.nodes().size() * sizeof(BVHNode<float>)), 0);
+        ASSERT_THROW(partial.refit(bounds.data(), {{9999, 10001}}), std::invalid_argument);
+        check_against_brute_force(partial, spheres, 4);
+    }
+
+    TEST(BVH, DegradationTriggersRebuilds) {
+        auto spheres = random_spheres(20000, 13);
+        BVH<float> bvh {bounds_of(spheres)};
+        std::mt19937 gen {2};
+        std::uniform_real_distribution<float> pos {-50.0f, 50.0f};
+
+        // scatter the primitives of a single corner of space
+        std::vector<DirtyRange> dirty;
+        for (std::size_t i = 0; i < spheres.size(); ++i) {
+            const float* c = spheres[i].center.raw();
+            if (c[0] > 30.0f && c[1] > 30.0f && c[2] > 30.0f) {
+                spheres[i].center = tao::Vec3f {pos(gen), pos(gen), 40.0f};
+                dirty.push_back({i, i + 1});
+            }
+        }
+        auto bounds = bounds_of(spheres);
+        BVHUpdatePolicy policy;
+        policy.rebuild_ratio = 100.0f;
+        ASSERT_EQ(bvh.update(bounds.data(), dirty, policy), PartiallyRebuilt);
+        check_structure(bvh, spheres.size());
+        check_against_brute_force(bvh, spheres, 8);
+        ASSERT_EQ(bvh.update(bounds.data(), dirty, policy), Refitted);
+
+        // then scatter everything
+        for (auto& s : spheres)
+            s.center = tao::Vec3f {pos(gen), pos(gen), pos(gen)};
+        bounds = bounds_of(spheres);
+        ASSERT_EQ(bvh.update(bounds.data()), Rebuilt);
+        ASSERT_FLOAT_EQ(bvh.quality_ratio(), 1.0f);
+        check_structure(bvh, spheres.size());
+        check_against_brute_force(bvh, spheres, 6);
+    }
+
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/Camera.h"
+#include "tao/linalg/Quat.h"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    template<typename T = double>
+    tao::Mat<T, 4, 4> placement() {
+        auto m = tao::Quat<T>::axis_angle(tao::Vec3<T> {T(1), T(2), T(0.5)}, T(0.7)).to_mat4();
+        m(0, 3) = T(1);
+        m(1, 3) = T(-2);
+        m(2, 3) = T(3);
+        return m;
+    }
+
+    TEST(Camera, PerspectiveRays) {
+        tao::Mat<double, 4, 4> identity (0.0);
+        for (int i = 0; i < 4; ++i) identity(i, i) = 1.0;
+        auto camera = Camera<double>::perspective(identity, M_PI / 2, 200, 100);
+        auto center = camera.generate_ray(100.0, 50.0);
+        ASSERT_NEAR(center.direction(0), 0.0, 1e-15);
+        ASSERT_NEAR(center.direction(1), 0.0, 1e-15);
+        ASSERT_NEAR(center.direction(2), -1.0, 1e-15);
+        auto corner = camera.generate_ray(0.0, 0.0);
+        // top-left corner of a 90 degree, 2:1 view
+        ASSERT_NEAR(corner.direction(0) / -corner.direction(2), -2.0, 1e-12);
+        ASSERT_NEAR(corner.direction(1) / -corner.direction(2), 1.0, 1e-12);
+        ASSERT_THROW(Camera<double>::perspective(identity, 0.0, 10, 10), std::invalid_argument);
+        ASSERT_THROW(Camera<double>::perspective(identity, 1.0, 0, 10), std::invalid_argument);
+    }
+
+    TEST(Camera, ProjectInvertsGenerate) {
+        for (auto kind : {Perspective, Orthographic}) {
+            auto camera = kind == Perspective ? Camera<double>::perspective(placement(), 0.9, 64, 48)
+                : Camera<double>::orthographic(placement(), 3.0, 64, 48);
+            ASSERT_EQ(camera.projection(), kind);
+            for (double px : {0.5, 10.25, 63.5})
+                for (double py : {0.5, 20.0, 47.9}) {
+                    auto ray = camera.generate_ray(px, py);
+                    ASSERT_NEAR(tao::norm(ray.direction), 1.0, 1e-14);
+                    double qx, qy;
+                    ASSERT_TRUE(camera.project(ray(7.0), qx, qy));
+                    ASSERT_NEAR(qx, px, 1e-10);
+                    ASSERT_NEAR(qy, py, 1e-10);
+                }
+        }
+        auto camera = Camera<double>::perspective(placement(), 0.9, 64, 48);
+        auto ray = camera.generate_ray(3.0, 4.0);
+        double qx, qy;
+        ASSERT_FALSE(camera.project(ray(-1.0), qx, qy));
+    }
+
+    TEST(Camera, TilesMatchSingleRays) {
+        for (auto kind : {Perspective, Orthographic}) {
+            auto camera = kind == Perspective ? Camera<float>::perspective(placement<float>(), 1.2f, 37, 29)
+                : Camera<float>::orthographic(placement<float>(), 2.0f, 37, 29);
+            RayBuffer<float> rays;
+            Tile tile {3, 5, 20, 9};
+            camera.generate(tile, rays, 0.25f, 0.75f);
+            ASSERT_EQ(rays.size(), tile.size());
+            for (int y = tile.y0; y < tile.y1; ++y)
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    auto expected = camera.generate_ray(x + 0.25f, y + 0.75f);
+                    auto got = rays.ray(std::size_t(y - tile.y0) * tile.width() + (x - tile.x0));
+                    for (int a = 0; a < 3; ++a) {
+                        ASSERT_NEAR(got.origin(a), expected.origin(a), 1e-5f);
+                        ASSERT_NEAR(got.direction(a), expected.direction(a), 1e-6f);
+                    }
+                }
+            ASSERT_THROW(camera.generate(Tile {0, 0, 38, 1}, rays), std::invalid_argument);
+
+            // every pixel is generated once, whatever the number of threads
+            std::vector<std::atomic<int>> seen (37 * 29);
+            auto threads = tao::parallel::concurrency();
+            tao::parallel::set_concurrency(4);
+            camera.for_each_tile(8, [&](const Tile& t, const RayBuffer<float>& buffer) {
+                ASSERT_EQ(buffer.size(), t.size());
+                for (int y = t.y0; y < t.y1; ++y)
+                    for (int x = t.x0; x < t.x1; ++x)
+                        ++seen[y * 37 + x];
+            });
+            tao::parallel::set_concurrency(threads);
+            for (auto& count : seen)
+                ASSERT_EQ(count.load(), 1);
+            ASSERT_EQ(camera.tiles(8).size(), 5u * 4u);
+        }
+    }
+
+};
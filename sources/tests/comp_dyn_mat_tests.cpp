@@ -13,6 +13,51 @@ namespace {
         ASSERT_EQ(mat.nrows(), 3);
         ASSERT_EQ(mat.ncols(), 2);
     };
+
+    TEST(CompDynMatFloat, ElementWiseOperations) {
+        using FMat = tao::Mat<float, Dynamic, Dynamic>;
+        FMat mat1 {{1.0, 2.0, 3.0}, {3.0, 4.0, 5.0}};
+        FMat mat2 {{5.0, 6.0, 7.0}, {7.0, 8.0, 10.0}};
+
+        ASSERT_TRUE(mat1 + mat2 == (FMat{{6.0, 8.0, 10.0}, {10.0, 12.0, 15.0}}));
+        ASSERT_TRUE(mat1 - mat2 == (FMat{{-4.0, -4.0, -4.0}, {-4.0, -4.0, -5.0}}));
+        ASSERT_TRUE(mat1 / mat2 == (FMat{{1.0f/5.0f, 2.0f/6.0f, 3.0f/7.0f}, {3.0f/7.0f, 4.0f/8.0f, 5.0f/10.0f}}));
+        ASSERT_TRUE(-mat1 == (FMat{{-1.0, -2.0, -3.0}, {-3.0, -4.0, -5.0}}));
+        ASSERT_TRUE(2.0f * mat1 == (FMat{{2.0, 4.0, 6.0}, {6.0, 8.0, 10.0}}));
+        ASSERT_TRUE(mat1 * 2.0f == (FMat{{2.0, 4.0, 6.0}, {6.0, 8.0, 10.0}}));
+        ASSERT_TRUE(mat1 / 2.0f == (FMat{{0.5, 1.0, 1.5}, {1.5, 2.0, 2.5}}));
+        ASSERT_TRUE(60.0f / mat1 == (FMat{{60.0, 30.0, 20.0}, {20.0, 15.0, 12.0}}));
+        ASSERT_TRUE(mat1.t() == (FMat{{1.0, 3.0}, {2.0, 4.0}, {3.0, 5.0}}));
+
+        FMat wrong {{1.0, 2.0}, {3.0, 4.0}};
+        ASSERT_THROW(mat1 + wrong, std::invalid_argument);
+        ASSERT_THROW(mat1 += wrong, std::invalid_argument);
+    };
+
+    TEST(CompDynMatFloat, ElementWiseOperationsPadded) {
+        using FMat = tao::Mat<float, Dynamic, Dynamic>;
+        FMat a (5, 3, tao::Padded), b (5, 3);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 3; ++j) {
+                a(i, j) = float(i * 3 + j);
+                b(i, j) = 1.0f;
+            }
+        FMat c = a + b;
+        ASSERT_EQ(c.nrows(), 5);
+        ASSERT_EQ(c.ncols(), 3);
+        a += b;
+        b -= a;
+        FMat t = a.t();
+        ASSERT_EQ(t.nrows(), 3);
+        ASSERT_EQ(t.ncols(), 5);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 3; ++j) {
+                ASSERT_FLOAT_EQ(c(i, j), float(i * 3 + j + 1));
+                ASSERT_FLOAT_EQ(a(i, j), c(i, j));
+                ASSERT_FLOAT_EQ(b(i, j), -float(i * 3 + j));
+                ASSERT_FLOAT_EQ(t(j, i), a(i, j));
+            }
+    };
 /*
     TEST(CompMatFloat, InitializerError) {
         try {
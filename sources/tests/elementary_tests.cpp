@@ -0,0 +1,210 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Elementary.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+    namespace math = tao::math;
+    using math::Exact;
+    using math::Fast;
+
+    const float ulp = 0x1p-23f;
+
+    /**
+     * Largest error of the fast tier against the library, in double,
+     * over a grid and random points of [lo, hi].
+     * */
+    template<typename F, typename G>
+    double worst_error(float lo, float hi, F fast, G exact, bool relative) {
+        std::mt19937 gen {7};
+        std::uniform_real_distribution<float> u {lo, hi};
+        double worst = 0.0;
+        for (int i = 0; i < 200000; ++i) {
+            const float x = i < 100000 ? lo + (hi - lo) * float(i) / 1e5f : u(gen);
+            const double e = exact(double(x));
+            double err = std::abs(double(fast(x)) - e);
+            if (relative)
+                err /= std::abs(e);
+            if (!(err <= worst))
+                worst = err;
+        }
+        return worst;
+    }
+
+    TEST(Elementary, FastBounds) {
+        auto rel = [](auto fast, auto exact, float lo, float hi) { return worst_error(lo, hi, fast, exact, true); };
+        auto abs = [](auto fast, auto exact, float lo, float hi) { return worst_error(lo, hi, fast, exact, false); };
+        ASSERT_LE(rel([](float x) { return math::sqrt<Fast>(x); }, [](double x) { return std::sqrt(x); }, 1e-44f, 1e38f), ulp);
+        ASSERT_LE(rel([](float x) { return math::rsqrt<Fast>(x); }, [](double x) { return 1.0 / std::sqrt(x); }, 1e-44f, 1e38f), 2 * ulp);
+        ASSERT_LE(rel([](float x) { return math::exp<Fast>(x); }, [](double x) { return std::exp(x); }, -87.0f, 88.5f), ulp);
+        ASSERT_LE(rel([](float x) { return math::log<Fast>(x); }, [](double x) { return std::log(x); }, 1e-44f, 1e38f), ulp);
+        ASSERT_LE(abs([](float x) { return math::log<Fast>(x); }, [](double x) { return std::log(x); }, 0.5f, 2.0f), ulp / 2);
+        ASSERT_LE(abs([](float x) { return math::sin<Fast>(x); }, [](double x) { return std::sin(x); }, -8192.0f, 8192.0f), ulp);
+        ASSERT_LE(abs([](float x) { return math::cos<Fast>(x); }, [](double x) { return std::cos(x); }, -8192.0f, 8192.0f), ulp);
+        ASSERT_LE(abs([](float x) { return math::acos<Fast>(x); }, [](double x) { return std::acos(x); }, -1.0f, 1.0f), 4 * ulp);
+        ASSERT_LE(rel([](float x) { return math::acos<Fast>(x); }, [](double x) { return std::acos(x); }, -1.0f, 0.999f), 3 * ulp);
+        ASSERT_LE(abs([](float t) { return math::atan2<Fast>(3.0f * std::sin(t), 3.0f * std::cos(t)); },
+                    [](double t) { return std::atan2(3.0 * std::sin(float(t)), 3.0 * std::cos(float(t))); }, -3.2f, 3.2f), 4 * ulp);
+    }
+
+    TEST(Elementary, SquareRootBounds) {
+        // every float above the smallest normal, where the estimates
+        // were least accurate, every 5th of [1, 4), and every 997th
+        // elsewhere, subnormals included
+        auto bits = [](float f) { std::uint32_t b; std::memcpy(&b, &f, sizeof(b)); return b; };
+        std::vector<float> x;
+        auto add = [&](std::uint32_t lo, std::uint32_t hi, std::uint32_t step) {
+            for (std::uint32_t b = lo; b < hi; b += step) {
+                float f;
+                std::memcpy(&f, &b, sizeof(f));
+                x.push_back(f);
+            }
+        };
+        add(bits(0x1p-126f), bits(0x1p-124f), 1);
+        add(bits(1.0f), bits(4.0f), 5);
+        add(1, 0x7f800000u, 997);
+        std::vector<float> r (x.size()), s (x.size());
+        math::rsqrt<Fast>(x.data(), r.data(), x.size());
+        math::sqrt<Fast>(x.data(), s.data(), x.size());
+        double worst_r = 0.0, worst_s = 0.0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            const double e = std::sqrt(double(x[i]));
+            worst_r = std::max(worst_r, std::abs(double(r[i]) * e - 1.0));
+            worst_s = std::max(worst_s, std::abs(double(s[i]) / e - 1.0));
+        }
+        ASSERT_LE(worst_r, ulp);
+        ASSERT_LE(worst_s, ulp);
+    }
+
+    TEST(Elementary, SpecialValues) {
+        const float inf = std::numeric_limits<float>::infinity();
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float specials[] = {0.0f, -0.0f, inf, -inf, nan, -1.0f, 1e-45f, 1e-40f};
+        auto same = [](float a, float b) {
+            return (std::isnan(a) && std::isnan(b)) || (a == b && std::signbit(a) == std::signbit(b));
+        };
+        for (float x : specials) {
+            ASSERT_TRUE(same(math::sqrt<Fast>(x), std::sqrt(x))) << x;
+            ASSERT_TRUE(same(math::rsqrt<Fast>(x), 1.0f / std::sqrt(x)) || std::abs(x) > 0.0f) << x;
+            ASSERT_TRUE(same(math::log<Fast>(x), std::log(x)) || (x > 0.0f && x < inf)) << x;
+            ASSERT_TRUE(same(math::sin<Fast>(x), std::sin(x)) || std::isfinite(x)) << x;
+            ASSERT_TRUE(same(math::cos<Fast>(x), std::cos(x)) || std::isfinite(x)) << x;
+            ASSERT_TRUE(same(math::acos<Fast>(x), std::acos(x)) || std::abs(x) <= 1.0f) << x;
+        }
+        ASSERT_TRUE(same(math::sin<Fast>(-0.0f), -0.0f));
+        ASSERT_EQ(math::exp<Fast>(100.0f), inf);
+        ASSERT_EQ(math::exp<Fast>(-200.0f), 0.0f);
+        ASSERT_EQ(math::exp<Fast>(-inf), 0.0f);
+        ASSERT_TRUE(std::isnan(math::exp<Fast>(nan)));
+        ASSERT_NEAR(math::exp<Fast>(-100.0f), std::exp(-100.0f), 2e-45f);
+        const float zeros[] = {0.0f, -0.0f, 1.0f, -1.0f};
+        for (float y : zeros)
+            for (float x : zeros)
+                ASSERT_TRUE(same(math::atan2<Fast>(y, x), std::atan2(y, x))) << y << " " << x;
+    }
+
+    TEST(Elementary, DoubleFastTier) {
+        for (int i = 1; i < 10000; ++i) {
+            const double x = -700.0 + 1400.0 * i / 1e4;
+            ASSERT_NEAR(math::exp<Fast>(x) / std::exp(x), 1.0, 2e-9);
+            const double y = std::exp(x);
+            ASSERT_NEAR(math::log<Fast>(y), x, 2e-9 * std::max(1.0, std::abs(x)));
+            ASSERT_NEAR(math::sqrt<Fast>(y) / std::sqrt(y), 1.0, 4.5e-16);
+            const double a = -8000.0 + 16000.0 * i / 1e4;
+            ASSERT_NEAR(math::sin<Fast>(a), std::sin(a), 1e-8);
+            ASSERT_NEAR(math::cos<Fast>(a), std::cos(a), 1e-8);
+            const double c = -1.0 + 2.0 * i / 1e4;
+            ASSERT_NEAR(math::acos<Fast>(c), std::acos(c), 1e-8);
+            ASSERT_NEAR(math::atan2<Fast>(c, 0.3), std::atan2(c, 0.3), 1e-8);
+        }
+        ASSERT_EQ(math::exp<Exact>(1.0), std::exp(1.0));
+    }
+
+    TEST(Elementary, BatchesAndMatrices) {
+        const std::size_t n = 100003;
+        std::vector<float> x (n), y (n), out (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = 0.01f + float(i % 977) * 0.013f;
+            y[i] = float(i % 131) * 0.01f - 0.6f;
+        }
+        math::log<Fast>(x.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; ++i)
+            ASSERT_EQ(out[i], math::log<Fast>(x[i]));
+        math::atan2<Exact>(y.data(), x.data(), out.data(), n);
+        for (std::size_t i = 0; i < n; ++i)
+            ASSERT_EQ(out[i], std::atan2(y[i], x[i]));
+        // in place, with a tail shorter than a block
+        std::vector<float> z (x.begin(), x.begin() + 37);
+        math::exp<Fast>(z.data(), z.data(), z.size());
+        for (std::size_t i = 0; i < z.size(); ++i)
+            ASSERT_EQ(z[i], math::exp<Fast>(x[i]));
+
+        tao::Mat<double, 2, 3> m {{0.0, 0.5, 1.0}, {-1.0, 2.0, 3.0}};
+        auto e = math::exp<Exact>(m);
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 3; ++j)
+                ASSERT_EQ(e(i, j), std::exp(m(i, j)));
+        tao::Mat<float, Dynamic, Dynamic> d (70, 45, tao::Padded);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j)
+                d(i, j) = float(i - j) * 0.1f;
+        auto s = math::sin<Fast>(d);
+        auto a = math::atan2<Fast>(d, s);
+        ASSERT_EQ(s.nrows(), 70);
+        ASSERT_EQ(s.ncols(), 45);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j) {
+                ASSERT_EQ(s(i, j), math::sin<Fast>(d(i, j)));
+                ASSERT_EQ(a(i, j), math::atan2<Fast>(d(i, j), s(i, j)));
+            }
+        ASSERT_THROW(math::atan2(d, tao::Mat<float, Dynamic, Dynamic> (70, 44)), std::invalid_argument);
+    }
+
+    TEST(Elementary, SphericalAngles) {
+        ASSERT_EQ(tao::spherical_theta(tao::Vec3d {0.0, 0.0, 2.0}), 0.0);
+        ASSERT_NEAR(tao::spherical_theta(tao::Vec3d {1.0, 0.0, 0.0}), M_PI / 2, 1e-15);
+        ASSERT_EQ(tao::spherical_theta(tao::Vec3d {0.0, 0.0, 0.0}), 0.0);
+        ASSERT_NEAR(tao::spherical_phi(tao::Vec3d {0.0, 1.0, 0.0}), M_PI / 2, 1e-15);
+        ASSERT_NEAR(tao::spherical_phi(tao::Vec3d {0.0, -2.0, 5.0}), -M_PI / 2, 1e-15);
+        ASSERT_NEAR(tao::spherical_phi(tao::Vec3d {-1.0, 1.0, 0.0}), 3 * M_PI / 4, 1e-15);
+
+        std::mt19937 gen {3};
+        std::normal_distribution<float> u {0.0f, 1.0f};
+        const std::size_t n = 5000;
+        std::vector<float> x (n), y (n), z (n), theta (n), phi (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = u(gen);
+            y[i] = u(gen);
+            z[i] = u(gen);
+        }
+        x[0] = y[0] = z[0] = 0.0f;
+        // along the axis, where the approximate cosine may exceed 1
+        for (std::size_t i = 1; i < 200; ++i) {
+            x[i] = y[i] = 0.0f;
+            z[i] = (i % 2 ? 1.0f : -1.0f) * (0.5f + float(i) * 0.0371f);
+        }
+        for (auto accuracy : {0, 1}) {
+            if (accuracy == 0) {
+                math::spherical_theta<Exact>(x.data(), y.data(), z.data(), theta.data(), n);
+                math::spherical_phi<Exact>(x.data(), y.data(), phi.data(), n);
+            } else {
+                math::spherical_theta<Fast>(x.data(), y.data(), z.data(), theta.data(), n);
+                math::spherical_phi<Fast>(x.data(), y.data(), phi.data(), n);
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                tao::Vec3d v {x[i], y[i], z[i]};
+                // acos is ill-conditioned at the poles
+                ASSERT_NEAR(theta[i], tao::spherical_theta(v), i < 200 ? 1e-3 : 1e-5);
+                ASSERT_NEAR(phi[i], tao::spherical_phi(v), 1e-6);
+            }
+        }
+    }
+
+};
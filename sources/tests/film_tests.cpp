@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/Film.h"
+#include "tao/parallel/Parallel.h"
+#include "tao/sampling/Philox.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    /**
+     * Splats the same samples, four per pixel with small integer
+     * values so that sums are exact in any order, tile by tile in
+     * parallel.
+     * */
+    void render(Film<float>& film, const Camera<float>& camera, int tile_size) {
+        const tao::sampling::Philox rng {11};
+        const std::vector<Tile> tiles = camera.tiles(tile_size);
+        tao::parallel::parallel_for(0, tiles.size(), 1, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t t = lo; t < hi; ++t) {
+                const Tile& tile = tiles[t];
+                auto acc = film.tile(tile);
+                for (int y = tile.y0; y < tile.y1; ++y)
+                    for (int x = tile.x0; x < tile.x1; ++x)
+                        for (int s = 0; s < 4; ++s) {
+                            const std::uint64_t k = (std::uint64_t(y) * film.width() + x) * 8 + 2 * s;
+                            // multiples of 1/256, so that positions stay within their pixel
+                            const float px = float(x) + float(rng.word(k) >> 24) / 256.0f;
+                            const float py = float(y) + float(rng.word(k + 1) >> 24) / 256.0f;
+                            acc.add(px, py, tao::Vec3f {float(x % 7), float(y % 5), float(s)}, float(1 + s % 2));
+                        }
+                film.merge(acc);
+            }
+        });
+    }
+
+    TEST(Film, BoxFootprint) {
+        Film<double> film {6, 4, 1.0};
+        film.add(2.5, 1.5, tao::Vec3d {1.0, 2.0, 3.0}, 2.0);
+        // the centers in (1.5, 3.5] x (0.5, 2.5]
+        for (int y = 0; y < 4; ++y)
+            for (int x = 0; x < 6; ++x)
+                ASSERT_EQ(film.weight(x, y), x >= 2 && x <= 3 && y >= 1 && y <= 2 ? 2.0 : 0.0) << x << " " << y;
+        film.add(2.5, 1.5, tao::Vec3d {3.0, 0.0, 1.0}, 2.0);
+        auto p = film.pixel(3, 2);
+        ASSERT_EQ(p(0), 2.0);
+        ASSERT_EQ(p(1), 1.0);
+        ASSERT_EQ(p(2), 2.0);
+        ASSERT_EQ(film.pixel(5, 3)(0), 0.0);
+        // off the raster, or not a number
+        film.add(-3.0, 1.0, tao::Vec3d {1.0, 1.0, 1.0});
+        film.add(std::nan(""), 1.0, tao::Vec3d {1.0, 1.0, 1.0});
+        ASSERT_EQ(film.weight(0, 1), 0.0);
+        // the default filter takes the samples of the pixel itself
+        Film<double> box {4, 4};
+        box.add(2.0, 3.999, tao::Vec3d {1.0, 1.0, 1.0});
+        ASSERT_EQ(box.weight(2, 3), 1.0);
+        ASSERT_EQ(box.weight(1, 3), 0.0);
+        std::vector<double> r (16), g (16), b (16);
+        box.resolve(r.data(), g.data(), b.data());
+        ASSERT_EQ(r[3 * 4 + 2], 1.0);
+        ASSERT_EQ(b[0], 0.0);
+
+        ASSERT_THROW(Film<double>(0, 4), std::invalid_argument);
+        ASSERT_THROW(Film<double>(4, 4, 0.25), std::invalid_argument);
+        ASSERT_THROW(film.weight(6, 0), std::invalid_argument);
+        auto acc = film.tile(Tile {0, 0, 2, 2});
+        ASSERT_THROW(acc.add(2.5, 0.5, tao::Vec3d {1.0, 1.0, 1.0}), std::invalid_argument);
+        ASSERT_THROW(film.tile(Tile {0, 0, 7, 2}), std::invalid_argument);
+        Film<double> other {6, 4};
+        ASSERT_THROW(other.merge(acc), std::invalid_argument);
+    }
+
+    TEST(Film, ModesAgree) {
+        tao::Mat<float, 4, 4> identity (0.0f);
+        for (int i = 0; i < 4; ++i) identity(i, i) = 1.0f;
+        const auto camera = Camera<float>::perspective(identity, 1.0f, 67, 45);
+        auto threads = tao::parallel::concurrency();
+        tao::parallel::set_concurrency(8);
+        for (float radius : {0.5f, 1.5f, 2.2f})
+            for (auto mode : {Tiled, Atomic, Hybrid}) {
+                Film<float> film {67, 45, radius, mode};
+                render(film, camera, 8);
+                Film<float> serial {67, 45, radius, Tiled};
+                tao::parallel::set_concurrency(1);
+                render(serial, camera, 67);
+                tao::parallel::set_concurrency(8);
+                for (int y = 0; y < 45; ++y)
+                    for (int x = 0; x < 67; ++x) {
+                        ASSERT_EQ(film.weight(x, y), serial.weight(x, y)) << radius << " " << mode;
+                        ASSERT_EQ(film.pixel(x, y), serial.pixel(x, y)) << radius << " " << mode;
+                    }
+            }
+        tao::parallel::set_concurrency(threads);
+        // every sample of the box filter of radius 1/2 lands in its own pixel
+        Film<float> box {67, 45};
+        render(box, camera, 16);
+        for (int y = 0; y < 45; ++y)
+            for (int x = 0; x < 67; ++x)
+                ASSERT_EQ(box.weight(x, y), 6.0f);
+    }
+
+};
@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include <vector>
+
+namespace {
+
+    TEST(Gemm, FixedProduct) {
+        tao::Mat<double, 2, 3> a {
+            {1.0, 2.0, 3.0},
+            {4.0, 5.0, 6.0}
+        };
+        tao::Mat<double, 3, 2> b {
+            {7.0, 8.0},
+            {9.0, 10.0},
+            {11.0, 12.0}
+        };
+        tao::Mat<double, 2, 2> expected {
+            {58.0, 64.0},
+            {139.0, 154.0}
+        };
+        ASSERT_TRUE(a * b == expected);
+    }
+
+    TEST(Gemm, DynamicProduct) {
+        const int m = 37, k = 53, n = 29;
+        tao::Mat<double, Dynamic, Dynamic> a (m, k, tao::Padded), b (k, n);
+        for (int i = 0; i < m; ++i)
+            for (int p = 0; p < k; ++p)
+                a(i, p) = (i * 3 + p) % 7 - 3.0;
+        for (int p = 0; p < k; ++p)
+            for (int j = 0; j < n; ++j)
+                b(p, j) = (p + 2 * j) % 5 - 2.0;
+        auto c = a * b;
+        ASSERT_EQ(c.nrows(), m);
+        ASSERT_EQ(c.ncols(), n);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                double expected = 0.0;
+                for (int p = 0; p < k; ++p)
+                    expected += a(i, p) * b(p, j);
+                ASSERT_DOUBLE_EQ(c(i, j), expected);
+            }
+        }
+    }
+
+    TEST(Gemm, IncompatibleDimensions) {
+        tao::Mat<double, Dynamic, Dynamic> a (3, 4), b (5, 2);
+        ASSERT_THROW(a * b, std::invalid_argument);
+    }
+
+    TEST(Gemm, AlphaBeta) {
+        std::vector<float> a {1, 2, 3, 4}, b {5, 6, 7, 8}, c {1, 1, 1, 1};
+        tao::kernels::gemm(2, 2, 2, 2.0f, a.data(), 2, b.data(), 2, 3.0f, c.data(), 2);
+        ASSERT_FLOAT_EQ(c[0], 2.0f * 19.0f + 3.0f);
+        ASSERT_FLOAT_EQ(c[1], 2.0f * 22.0f + 3.0f);
+        ASSERT_FLOAT_EQ(c[2], 2.0f * 43.0f + 3.0f);
+        ASSERT_FLOAT_EQ(c[3], 2.0f * 50.0f + 3.0f);
+    }
+
+    TEST(Gemm, SameBitsAcrossThreadsAndBlocking) {
+        const int n = 160;
+        std::vector<float> a (n * n), b (n * n), c1 (n * n), c2 (n * n);
+        for (int i = 0; i < n * n; ++i) {
+            a[i] = 1.0f / float(1 + i % 13) - 0.3f;
+            b[i] = float(i % 17) * 0.1f - 0.7f;
+        }
+        tao::parallel::set_concurrency(1);
+        tao::kernels::gemm(n, n, n, 1.0f, a.data(), n, b.data(), n, 0.0f, c1.data(), n);
+        tao::parallel::set_concurrency(8);
+        tao::kernels::gemm(n, n, n, 1.0f, a.data(), n, b.data(), n, 0.0f, c2.data(), n,
+                tao::GemmBlocking {12, 7, 33});
+        tao::parallel::set_concurrency(0);
+        ASSERT_EQ(c1, c2);
+    }
+
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/geometry.h"
+#include "tao/geometry/Ray.h"
+#include "tao/geometry/AABB.h"
+#include "tao/geometry/Sphere.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    TEST(Geometry, AABBBasics) {
+        AABB<float> box;
+        ASSERT_TRUE(box.empty());
+        ASSERT_FLOAT_EQ(box.surface_area(), 0.0f);
+        box.expand(tao::Vec3f {1.0f, 2.0f, 3.0f});
+        box.expand(tao::Vec3f {-1.0f, 0.0f, 7.0f});
+        ASSERT_FALSE(box.empty());
+        ASSERT_TRUE(box.contains(tao::Vec3f {0.0f, 1.0f, 5.0f}));
+        ASSERT_FALSE(box.contains(tao::Vec3f {0.0f, 3.0f, 5.0f}));
+        ASSERT_FLOAT_EQ(box.surface_area(), 2.0f * (2.0f * 2.0f + 2.0f * 4.0f + 4.0f * 2.0f));
+        ASSERT_EQ(box.max_extent(), 2);
+        ASSERT_FLOAT_EQ(box.centroid().raw()[2], 5.0f);
+        AABB<float> other {tao::Vec3f {5.0f, 5.0f, 5.0f}};
+        AABB<float> both = merge(box, other);
+        ASSERT_FLOAT_EQ(both.upper.raw()[0], 5.0f);
+        ASSERT_FLOAT_EQ(both.lower.raw()[0], -1.0f);
+    }
+
+    TEST(Geometry, RayAABBSlab) {
+        AABB<float> box {tao::Vec3f {-1.0f, -1.0f, -1.0f}, tao::Vec3f {1.0f, 1.0f, 1.0f}};
+        float t0, t1;
+        Ray<float> hit {tao::Vec3f {-5.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}};
+        ASSERT_TRUE(intersect(box, hit, t0, t1));
+        ASSERT_FLOAT_EQ(t0, 4.0f);
+        ASSERT_NEAR(t1, 6.0f, 1e-5f);
+        Ray<float> away {tao::Vec3f {-5.0f, 0.0f, 0.0f}, tao::Vec3f {-1.0f, 0.0f, 0.0f}};
+        ASSERT_FALSE(intersect(box, away, t0, t1));
+        Ray<float> miss {tao::Vec3f {-5.0f, 2.0f, 0.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}};
+        ASSERT_FALSE(intersect(box, miss, t0, t1));
+        Ray<float> shortened {tao::Vec3f {-5.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}, 0.0f, 3.0f};
+        ASSERT_FALSE(intersect(box, shortened, t0, t1));
+        // grazing the face y = 1 along x
+        Ray<float> graze {tao::Vec3f {-5.0f, 1.0f, 0.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}};
+        ASSERT_TRUE(intersect(box, graze, t0, t1));
+    }
+
+    template<int W>
+    void check_packets() {
+        AABBPacket<float, W> boxes;
+        RayPacket<float, W> rays;
+        Ray<float> ray {tao::Vec3f {0.5f, 0.5f, -10.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}};
+        AABB<float> box {tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 1.0f, 1.0f}};
+        unsigned int expected_boxes = 0, expected_rays = 0;
+        for (int l = 0; l < W - 1; ++l) {
+            float shift = float(l) * 0.75f;
+            AABB<float> b {tao::Vec3f {shift, 0.0f, float(l)}, tao::Vec3f {shift + 1.0f, 1.0f, float(l) + 1.0f}};
+            boxes.set(l, b);
+            float t0, t1;
+            if (intersect(b, ray, t0, t1))
+                expected_boxes |= 1u << l;
+            Ray<float> r {tao::Vec3f {shift, 0.5f, -1.0f}, tao::Vec3f {0.1f * float(l) - 0.2f, 0.0f, 1.0f}};
+            rays.set(l, r);
+            if (intersect(box, r, t0, t1))
+                expected_rays |= 1u << l;
+        }
+        float tnear[W];
+        ASSERT_EQ(intersect(boxes, ray, tnear), expected_boxes);
+        ASSERT_NE(expected_boxes, 0u);
+        ASSERT_FLOAT_EQ(tnear[0], 10.0f);
+        ASSERT_EQ(intersect(box, rays), expected_rays);
+        ASSERT_NE(expected_rays, 0u);
+        ASSERT_NE(expected_rays, (1u << (W - 1)) - 1);
+    }
+
+    TEST(Geometry, SlabPackets) {
+        check_packets<4>();
+        check_packets<8>();
+        check_packets<6>();
+    }
+
+    TEST(Geometry, RaySphere) {
+        Sphere<double> sphere {tao::Vec3d {0.0, 0.0, 10.0}, 2.0};
+        Ray<double> ray {tao::Vec3d {0.0, 0.0, 0.0}, tao::Vec3d {0.0, 0.0, 1.0}};
+        double t;
+        ASSERT_TRUE(intersect(sphere, ray, t));
+        ASSERT_DOUBLE_EQ(t, 8.0);
+        Ray<double> inside {tao::Vec3d {0.0, 0.0, 10.0}, tao::Vec3d {0.0, 0.0, 2.0}};
+        ASSERT_TRUE(intersect(sphere, inside, t));
+        ASSERT_DOUBLE_EQ(t, 1.0);
+        Ray<double> miss {tao::Vec3d {0.0, 3.0, 0.0}, tao::Vec3d {0.0, 0.0, 1.0}};
+        ASSERT_FALSE(intersect(sphere, miss, t));
+        // a tiny sphere far away keeps its hit distance accurate
+        Sphere<float> far {tao::Vec3f {0.0f, 0.0f, 1e4f}, 1e-2f};
+        Ray<float> rf {tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}};
+        float tf;
+        ASSERT_TRUE(intersect(far, rf, tf));
+        ASSERT_NEAR(tf, 1e4f - 1e-2f, 1e-3f);
+        AABB<double> b = sphere.bounds();
+        ASSERT_DOUBLE_EQ(b.lower.raw()[2], 8.0);
+        ASSERT_DOUBLE_EQ(b.upper.raw()[0], 2.0);
+    }
+
+    TEST(Geometry, Radians) {
+        ASSERT_FLOAT_EQ(radians(180.0f), float(M_PI));
+    }
+
+}
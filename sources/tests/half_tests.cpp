@@ -0,0 +1,253 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Blas.h"
+#include "tao/linalg/Half.h"
+#include "tao/linalg/Reductions.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+    using HMat = tao::Mat<tao::Half, Dynamic, Dynamic>;
+    using FMat = tao::Mat<float, Dynamic, Dynamic>;
+
+    std::uint16_t bits(float f) {
+        return tao::Half(f).raw_bits();
+    }
+
+    float from_bits(std::uint32_t x) {
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+
+    TEST(Half, Rounding) {
+        ASSERT_EQ(bits(1.0f), 0x3c00);
+        ASSERT_EQ(bits(-2.0f), 0xc000);
+        ASSERT_EQ(bits(65504.0f), 0x7bff);
+        ASSERT_EQ(bits(65519.0f), 0x7bff);
+        ASSERT_EQ(bits(65520.0f), 0x7c00);
+        ASSERT_EQ(bits(1e10f), 0x7c00);
+        // ties go to even
+        ASSERT_EQ(bits(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+        ASSERT_EQ(bits(1.0f + 3 * std::ldexp(1.0f, -11)), 0x3c02);
+        // subnormals
+        ASSERT_EQ(bits(std::ldexp(1.0f, -24)), 0x0001);
+        ASSERT_EQ(bits(std::ldexp(1.0f, -25)), 0x0000);
+        ASSERT_EQ(bits(1.5f * std::ldexp(1.0f, -25)), 0x0001);
+        ASSERT_EQ(bits(std::ldexp(1.0f, -14)), 0x0400);
+        ASSERT_EQ(bits(-0.0f), 0x8000);
+        ASSERT_TRUE(std::isnan(float(tao::Half(std::numeric_limits<float>::quiet_NaN()))));
+        ASSERT_EQ(float(std::numeric_limits<tao::Half>::max()), 65504.0f);
+        ASSERT_EQ(float(std::numeric_limits<tao::Half>::epsilon()), std::ldexp(1.0f, -10));
+        using half_limits = std::numeric_limits<tao::Half>;
+        ASSERT_EQ(float(half_limits::min()), std::ldexp(1.0f, half_limits::min_exponent - 1));
+        ASSERT_EQ(float(half_limits::round_error()), 0.5f);
+        ASSERT_TRUE(std::isnan(float(half_limits::signaling_NaN())));
+    }
+
+    TEST(Half, EveryHalf) {
+        std::vector<tao::Half> all (1 << 16);
+        for (std::uint32_t b = 0; b < (1u << 16); ++b)
+            all[b] = tao::Half::from_bits(std::uint16_t(b));
+        std::vector<float> bulk (all.size());
+        tao::convert(all.data(), bulk.data(), all.size());
+        for (std::uint32_t b = 0; b < (1u << 16); ++b) {
+            const float f = all[b];
+            if (std::isnan(f)) {
+                ASSERT_TRUE(std::isnan(bulk[b])) << b;
+                continue;
+            }
+            ASSERT_EQ(bits(f), b);
+            ASSERT_EQ(std::memcmp(&f, &bulk[b], sizeof(f)), 0) << b;
+        }
+    }
+
+    TEST(Half, BulkMatchesScalar) {
+        std::mt19937 gen {1};
+        std::uniform_int_distribution<std::uint32_t> u;
+        std::vector<float> f (10007);
+        for (float& x : f) {
+            // exponents around the range of halves, and some of any float
+            std::uint32_t r = u(gen);
+            if (r % 4 != 0)
+                r = (r & 0x807fffffu) | ((96u + r % 48u) << 23);
+            x = from_bits(r);
+        }
+        std::vector<tao::Half> h (f.size());
+        std::vector<tao::BFloat16> b (f.size());
+        tao::convert(f.data(), h.data(), f.size());
+        tao::convert(f.data(), b.data(), f.size());
+        for (std::size_t i = 0; i < f.size(); ++i) {
+            if (std::isnan(f[i]))
+                continue;
+            ASSERT_EQ(h[i].raw_bits(), tao::Half(f[i]).raw_bits()) << f[i];
+            ASSERT_EQ(b[i].raw_bits(), tao::BFloat16(f[i]).raw_bits()) << f[i];
+        }
+    }
+
+    TEST(Half, BFloat16) {
+        ASSERT_EQ(tao::BFloat16(1.0f).raw_bits(), 0x3f80);
+        // ties go to even
+        ASSERT_EQ(tao::BFloat16(from_bits(0x3f808000u)).raw_bits(), 0x3f80);
+        ASSERT_EQ(tao::BFloat16(from_bits(0x3f818000u)).raw_bits(), 0x3f82);
+        ASSERT_EQ(tao::BFloat16(from_bits(0x3f808001u)).raw_bits(), 0x3f81);
+        ASSERT_TRUE(std::isnan(float(tao::BFloat16(std::numeric_limits<float>::quiet_NaN()))));
+        using bf16_limits = std::numeric_limits<tao::BFloat16>;
+        ASSERT_EQ(float(bf16_limits::min()), std::numeric_limits<float>::min());
+        ASSERT_EQ(bf16_limits::max_exponent, std::numeric_limits<float>::max_exponent);
+        ASSERT_EQ(float(bf16_limits::round_error()), 0.5f);
+        ASSERT_TRUE(std::isnan(float(bf16_limits::signaling_NaN())));
+        for (std::uint32_t b = 0; b < (1u << 16); ++b) {
+            const float f = tao::BFloat16::from_bits(std::uint16_t(b));
+            if (!std::isnan(f)) {
+                ASSERT_EQ(tao::BFloat16(f).raw_bits(), b);
+            }
+        }
+    }
+
+    TEST(Half, Matrices) {
+        HMat a (3, 4, tao::Padded);
+        ASSERT_EQ(float(a(2, 3)), 0.0f);
+        a(1, 2) = 1.5f;
+        a(2, 3) = -2.0f;
+        HMat b = a;
+        ASSERT_TRUE(b.eq(a));
+        b(0, 0) = 0.25f;
+        ASSERT_FALSE(b.eq(a, 0.1));
+        ASSERT_TRUE(b.eq(a, 0.5));
+        tao::Mat<tao::BFloat16, 2, 2> f {{1.0f, 2.0f}, {3.0f, 4.0f}};
+        tao::Mat<tao::BFloat16, 2, 2> g = f + f;
+        ASSERT_EQ(float(g(1, 1)), 8.0f);
+        g -= f;
+        ASSERT_EQ(g, f);
+        f *= tao::BFloat16(0.5f);
+        ASSERT_EQ(float(f(1, 1)), 2.0f);
+        ASSERT_EQ(float(f(0, 1)), 1.0f);
+    }
+
+    template<typename H>
+    void dynamic_element_wise() {
+        using M = tao::Mat<H, Dynamic, Dynamic>;
+        M a (3, 5, tao::Padded), b (3, 5);
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 5; ++j) {
+                a(i, j) = float(i + j + 1);
+                b(i, j) = 3.0f;
+            }
+        // every result is the float operation rounded once
+        M sum = a + b, diff = a - b, quot = a / b, neg = -a;
+        M scaled = a * H(0.1f), scaled_left = H(0.1f) * a, halved = a / H(2.0f), inv = H(1.0f) / a;
+        M t = a.t();
+        ASSERT_EQ(t.nrows(), 5);
+        ASSERT_EQ(t.ncols(), 3);
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 5; ++j) {
+                const float x = float(a(i, j));
+                ASSERT_EQ(sum(i, j).raw_bits(), H(x + 3.0f).raw_bits());
+                ASSERT_EQ(diff(i, j).raw_bits(), H(x - 3.0f).raw_bits());
+                ASSERT_EQ(quot(i, j).raw_bits(), H(x / 3.0f).raw_bits());
+                ASSERT_EQ(neg(i, j).raw_bits(), H(-x).raw_bits());
+                ASSERT_EQ(scaled(i, j).raw_bits(), H(float(H(0.1f)) * x).raw_bits());
+                ASSERT_EQ(scaled_left(i, j).raw_bits(), scaled(i, j).raw_bits());
+                ASSERT_EQ(halved(i, j).raw_bits(), H(x / 2.0f).raw_bits());
+                ASSERT_EQ(inv(i, j).raw_bits(), H(1.0f / x).raw_bits());
+                ASSERT_EQ(t(j, i).raw_bits(), a(i, j).raw_bits());
+            }
+        a += b;
+        a -= b;
+        a /= b;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 5; ++j)
+                ASSERT_EQ(a(i, j).raw_bits(), quot(i, j).raw_bits());
+    }
+
+    TEST(Half, DynamicElementWise) {
+        dynamic_element_wise<tao::Half>();
+        dynamic_element_wise<tao::BFloat16>();
+    }
+
+    TEST(Half, Convert) {
+        tao::Mat<double, Dynamic, Dynamic> d (70, 300, tao::Padded);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 300; ++j)
+                d(i, j) = (i - 35) * 0.125 + j;
+        auto h = tao::convert<tao::Half>(d);
+        auto f = tao::convert<float>(h);
+        auto b = tao::convert<tao::BFloat16>(f);
+        ASSERT_EQ(h.nrows(), 70);
+        ASSERT_EQ(h.ncols(), 300);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 300; ++j) {
+                ASSERT_EQ(f(i, j), float(tao::Half(float(d(i, j)))));
+                ASSERT_EQ(b(i, j).raw_bits(), tao::BFloat16(f(i, j)).raw_bits());
+            }
+        tao::Mat<float, 2, 3> small {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+        auto hs = tao::convert<tao::Half>(small);
+        ASSERT_EQ(float(hs(1, 2)), 6.0f);
+    }
+
+    TEST(Half, FloatAccumulation) {
+        // 2048 + 1 is 2048 in half precision: sums must not be halves
+        HMat ones (4096, 1), row (1, 4096), y (1, 1);
+        ones.reset(1.0f);
+        row.reset(1.0f);
+        static_assert(std::is_same_v<decltype(tao::sum(ones)), float>);
+        ASSERT_EQ(tao::sum(ones), 4096.0f);
+        ASSERT_EQ(tao::sum(ones, tao::Kahan), 4096.0f);
+        ASSERT_EQ(tao::inner(ones, ones), 4096.0f);
+        ASSERT_EQ(tao::squared_norm(ones), 4096.0f);
+        tao::gemv(tao::Half(1.0f), row, ones, tao::Half(0.0f), y);
+        ASSERT_EQ(float(y(0, 0)), 4096.0f);
+        HMat p = row * ones;
+        ASSERT_EQ(float(p(0, 0)), 4096.0f);
+        ASSERT_EQ(float(tao::max(ones)), 1.0f);
+    }
+
+    TEST(Half, Products) {
+        std::mt19937 gen {5};
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        // below the backend thresholds, and across several tiles
+        for (auto dims : {std::array<int, 3> {20, 25, 30}, std::array<int, 3> {130, 90, 300}}) {
+            const int m = dims[0], k = dims[1], n = dims[2];
+            tao::Mat<tao::BFloat16, Dynamic, Dynamic> a (m, k), b (k, n, tao::Padded);
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j < k; ++j)
+                    a(i, j) = u(gen);
+            for (int i = 0; i < k; ++i)
+                for (int j = 0; j < n; ++j)
+                    b(i, j) = u(gen);
+            FMat reference = tao::convert<float>(a) * tao::convert<float>(b);
+            auto c = a * b;
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j < n; ++j)
+                    ASSERT_NEAR(float(c(i, j)), reference(i, j), std::abs(reference(i, j)) / 128 + 1e-5f);
+            if (m * n * k < (1 << 15)) {
+                // the same float sums, rounded once
+                for (int i = 0; i < m; ++i)
+                    for (int j = 0; j < n; ++j)
+                        ASSERT_EQ(c(i, j).raw_bits(), tao::BFloat16(reference(i, j)).raw_bits());
+            }
+        }
+    }
+
+    TEST(Half, ElementWise) {
+        HMat x (50, 40), y (50, 40);
+        x.reset(0.5f);
+        y.reset(2.0f);
+        tao::axpby(tao::Half(3.0f), x, tao::Half(0.5f), y);
+        ASSERT_EQ(float(y(49, 39)), 2.5f);
+        tao::scal(tao::Half(-2.0f), y);
+        ASSERT_EQ(float(y(0, 0)), -5.0f);
+        HMat v (50, 1), w (40, 1);
+        v.reset(1.0f);
+        w.reset(0.25f);
+        tao::ger(tao::Half(2.0f), v, w, y);
+        ASSERT_EQ(float(y(3, 7)), -4.5f);
+    }
+
+};
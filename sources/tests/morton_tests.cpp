@@ -0,0 +1,153 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/Morton.h"
+#include "tao/parallel/RadixSort.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    std::uint64_t naive_morton(std::uint64_t x, std::uint64_t y, std::uint64_t z, int bits) {
+        std::uint64_t code = 0;
+        for (int b = 0; b < bits; ++b) {
+            code |= ((x >> b) & 1) << (3 * b + 2);
+            code |= ((y >> b) & 1) << (3 * b + 1);
+            code |= ((z >> b) & 1) << (3 * b);
+        }
+        return code;
+    }
+
+    TEST(Morton, KnownCodes) {
+        ASSERT_EQ(morton30(1, 0, 0), 4u);
+        ASSERT_EQ(morton30(0, 1, 0), 2u);
+        ASSERT_EQ(morton30(0, 0, 1), 1u);
+        ASSERT_EQ(morton30(1023, 1023, 1023), (1u << 30) - 1);
+        ASSERT_EQ(morton63(1, 0, 0), 4u);
+        ASSERT_EQ(morton63((1u << 21) - 1, (1u << 21) - 1, (1u << 21) - 1), (std::uint64_t(1) << 63) - 1);
+    }
+
+    TEST(Morton, MatchesBitLoop) {
+        std::mt19937_64 gen {3};
+        for (int k = 0; k < 10000; ++k) {
+            std::uint64_t x = gen() & 0x1fffff, y = gen() & 0x1fffff, z = gen() & 0x1fffff;
+            ASSERT_EQ(morton63(x, y, z), naive_morton(x, y, z, 21));
+            ASSERT_EQ(morton30(std::uint32_t(x & 1023), std::uint32_t(y & 1023), std::uint32_t(z & 1023)),
+                    naive_morton(x & 1023, y & 1023, z & 1023, 10));
+        }
+    }
+
+    TEST(Hilbert, ContinuousCurve) {
+        const int bits = 3, side = 1 << bits;
+        std::vector<int> cell_of (side * side * side, -1);
+        for (int x = 0; x < side; ++x)
+            for (int y = 0; y < side; ++y)
+                for (int z = 0; z < side; ++z) {
+                    std::uint64_t h = hilbert_index(x, y, z, bits);
+                    ASSERT_LT(h, cell_of.size());
+                    ASSERT_EQ(cell_of[h], -1);
+                    cell_of[h] = (x * side + y) * side + z;
+                }
+        for (std::size_t h = 1; h < cell_of.size(); ++h) {
+            int a = cell_of[h - 1], b = cell_of[h];
+            int d = std::abs(a / (side * side) - b / (side * side)) + std::abs(a / side % side - b / side % side)
+                + std::abs(a % side - b % side);
+            ASSERT_EQ(d, 1);
+        }
+        ASSERT_EQ(hilbert30(5, 6, 7), std::uint32_t(hilbert_index(5, 6, 7, 10)));
+    }
+
+    TEST(Morton, EncodePoints) {
+        std::vector<tao::Vec3f> points {tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 1.0f, 1.0f},
+            tao::Vec3f {-5.0f, 0.5f, 2.0f}};
+        AABB<float> bounds {tao::Vec3f {0.0f, 0.0f, 0.0f}, tao::Vec3f {1.0f, 1.0f, 1.0f}};
+        std::vector<std::uint32_t> codes (points.size());
+        encode_points(points.data(), points.size(), bounds, codes.data());
+        ASSERT_EQ(codes[0], 0u);
+        ASSERT_EQ(codes[1], (1u << 30) - 1);
+        ASSERT_EQ(codes[2], morton30(0, 512, 1023));
+        std::vector<std::uint64_t> wide (points.size());
+        encode_points(points.data(), points.size(), bounds, wide.data(), Hilbert);
+        ASSERT_EQ(wide[0], 0u);
+        ASSERT_EQ(wide[2], hilbert63(0, 1u << 20, (1u << 21) - 1));
+    }
+
+    template<typename Key>
+    void check_radix_sort(std::size_t n, int key_bits) {
+        std::mt19937_64 gen {n};
+        std::vector<Key> keys (n);
+        for (auto& k : keys)
+            k = Key(gen() & ((std::uint64_t(1) << key_bits) - 1)) & Key(0xfff0fff0fff0fff0ull);
+        std::vector<std::uint32_t> values (n);
+        std::iota(values.begin(), values.end(), 0u);
+        std::vector<std::uint32_t> expected = values;
+        std::stable_sort(expected.begin(), expected.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return keys[a] < keys[b];
+        });
+        std::vector<Key> sorted_keys = keys;
+        tao::parallel::radix_sort(sorted_keys, key_bits);
+        for (std::size_t i = 0; i < n; ++i)
+            ASSERT_EQ(sorted_keys[i], keys[expected[i]]);
+        tao::parallel::radix_sort(keys, values, key_bits);
+        ASSERT_EQ(values, expected);
+    }
+
+    TEST(RadixSort, MatchesStableSort) {
+        for (std::size_t n : {0, 1, 7, 1000, 300000}) {
+            check_radix_sort<std::uint32_t>(n, 30);
+            check_radix_sort<std::uint32_t>(n, 32);
+            check_radix_sort<std::uint64_t>(n, 63);
+        }
+        std::vector<std::uint32_t> keys {1, 2};
+        std::vector<int> values {1};
+        ASSERT_THROW(tao::parallel::radix_sort(keys, values), std::invalid_argument);
+    }
+
+    TEST(RadixSort, IgnoresHighBits) {
+        // 30 bits make a last digit of 8 bits: bits 30 and 31 are noise
+        std::mt19937 gen {4};
+        std::vector<std::uint32_t> keys (5000);
+        for (auto& k : keys) k = gen();
+        std::vector<std::uint32_t> values (keys.size());
+        std::iota(values.begin(), values.end(), 0u);
+        auto low = [](std::uint32_t k) { return k & ((1u << 30) - 1); };
+        std::vector<std::uint32_t> expected = values;
+        std::stable_sort(expected.begin(), expected.end(),
+            [&](std::uint32_t a, std::uint32_t b) { return low(keys[a]) < low(keys[b]); });
+        tao::parallel::radix_sort(keys, values, 30);
+        ASSERT_EQ(values, expected);
+    }
+
+    TEST(RadixSort, SameOnAnyThreadCount) {
+        std::mt19937 gen {9};
+        std::vector<tao::Vec3f> points;
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        for (int k = 0; k < 200000; ++k)
+            points.emplace_back(tao::Vec3f {u(gen), u(gen), u(gen)});
+        auto threads = tao::parallel::concurrency();
+        tao::parallel::set_concurrency(1);
+        auto serial = spatial_order(points, Hilbert);
+        tao::parallel::set_concurrency(8);
+        auto parallel = spatial_order(points, Hilbert);
+        tao::parallel::set_concurrency(threads);
+        ASSERT_EQ(serial, parallel);
+    }
+
+    TEST(RadixSort, Reorder) {
+        std::vector<AABB<float>> boxes;
+        for (int k = 0; k < 64; ++k) {
+            float x = float((k * 37) % 64);
+            boxes.emplace_back(tao::Vec3f {x, 0.0f, 0.0f}, tao::Vec3f {x + 0.5f, 0.5f, 0.5f});
+        }
+        auto order = spatial_order(boxes);
+        tao::parallel::reorder(boxes, order);
+        for (std::size_t k = 1; k < boxes.size(); ++k)
+            ASSERT_LT(boxes[k - 1].lower(0), boxes[k].lower(0));
+        std::vector<int> items {1, 2};
+        ASSERT_THROW(tao::parallel::reorder(items, order), std::invalid_argument);
+    }
+
+};
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/HashGrid.h"
+#include "tao/geometry/KdTree.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    std::vector<tao::Vec3f> random_points(std::size_t n, unsigned seed) {
+        std::mt19937 gen {seed};
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        std::vector<tao::Vec3f> points;
+        for (std::size_t i = 0; i < n; ++i)
+            points.emplace_back(tao::Vec3f {u(gen), u(gen), 0.25f * u(gen)});
+        return points;
+    }
+
+    float distance2(const tao::Vec3f& a, const tao::Vec3f& b) {
+        float d = 0.0f;
+        for (int k = 0; k < 3; ++k)
+            d += (a.raw()[k] - b.raw()[k]) * (a.raw()[k] - b.raw()[k]);
+        return d;
+    }
+
+    TEST(HashGrid, RadiusMatchesBruteForce) {
+        auto points = random_points(5000, 1);
+        auto queries = random_points(200, 2);
+        queries.emplace_back(tao::Vec3f {5.0f, 5.0f, 5.0f});
+        HashGrid<float> grid {points, 0.1f};
+        ASSERT_EQ(grid.size(), points.size());
+        for (float radius : {0.0f, 0.05f, 0.1f, 0.35f, 4.0f}) {
+            NeighborList list = grid.radius_search(queries, radius);
+            ASSERT_EQ(list.offsets.size(), queries.size() + 1);
+            for (std::size_t q = 0; q < queries.size(); ++q) {
+                std::vector<std::uint32_t> expected;
+                for (std::size_t i = 0; i < points.size(); ++i)
+                    if (distance2(points[i], queries[q]) <= radius * radius)
+                        expected.push_back(std::uint32_t(i));
+                std::vector<std::uint32_t> got (list.neighbors(q), list.neighbors(q) + list.count(q));
+                ASSERT_EQ(got, expected);
+                std::vector<std::uint32_t> single;
+                grid.radius_search(queries[q], radius, single);
+                ASSERT_EQ(single, expected);
+            }
+        }
+    }
+
+    TEST(HashGrid, Degenerate) {
+        std::vector<tao::Vec3f> empty;
+        HashGrid<float> none {empty, 1.0f};
+        std::vector<std::uint32_t> found {7};
+        none.radius_search(tao::Vec3f {0.0f, 0.0f, 0.0f}, 1.0f, found);
+        ASSERT_TRUE(found.empty());
+        std::vector<tao::Vec3f> same (10, tao::Vec3f {1.0f, 2.0f, 3.0f});
+        HashGrid<float> stacked {same, 0.5f};
+        stacked.radius_search(tao::Vec3f {1.0f, 2.0f, 3.0f}, 0.0f, found);
+        ASSERT_EQ(found.size(), 10u);
+        ASSERT_THROW((HashGrid<float> {same, 0.0f}), std::invalid_argument);
+    }
+
+    void check_knn(const std::vector<tao::Vec3f>& points, const KdTree<float>& tree, const tao::Vec3f& q, std::size_t k) {
+        std::vector<std::pair<float, std::uint32_t>> all;
+        for (std::size_t i = 0; i < points.size(); ++i)
+            all.emplace_back(distance2(points[i], q), std::uint32_t(i));
+        std::sort(all.begin(), all.end());
+        std::vector<std::uint32_t> idx (k);
+        std::vector<float> d2 (k);
+        std::size_t found = tree.knn(q, k, idx.data(), d2.data());
+        ASSERT_EQ(found, std::min(k, points.size()));
+        for (std::size_t j = 0; j < k; ++j) {
+            if (j < found) {
+                ASSERT_EQ(idx[j], all[j].second);
+                ASSERT_EQ(d2[j], all[j].first);
+            } else {
+                ASSERT_EQ(idx[j], no_neighbor);
+            }
+        }
+    }
+
+    TEST(KdTree, KnnMatchesBruteForce) {
+        auto points = random_points(3000, 3);
+        // duplicates check the tie order
+        for (int i = 0; i < 20; ++i)
+            points.push_back(points[i]);
+        for (int leaf : {1, 4, 8, 32}) {
+            KdTree<float> tree {points, leaf};
+            ASSERT_EQ(tree.size(), points.size());
+            for (const auto& q : random_points(50, 4))
+                for (std::size_t k : {1, 5, 16})
+                    check_knn(points, tree, q, k);
+            check_knn(points, tree, points[3], 4);
+        }
+        std::vector<tao::Vec3f> few (random_points(5, 5));
+        KdTree<float> small {few};
+        ASSERT_EQ(small.depth(), 0);
+        check_knn(few, small, tao::Vec3f {0.0f, 0.0f, 0.0f}, 8);
+        ASSERT_THROW((KdTree<float> {few, 0}), std::invalid_argument);
+    }
+
+    TEST(KdTree, BatchSameOnAnyThreadCount) {
+        auto points = random_points(100000, 6);
+        auto queries = random_points(1000, 7);
+        const std::size_t k = 8;
+        auto threads = tao::parallel::concurrency();
+        std::vector<std::uint32_t> idx1 (queries.size() * k), idx8 (queries.size() * k);
+        std::vector<float> d1 (queries.size() * k), d8 (queries.size() * k);
+        tao::parallel::set_concurrency(1);
+        KdTree<float> serial {points};
+        serial.knn(queries.data(), queries.size(), k, idx1.data(), d1.data());
+        tao::parallel::set_concurrency(8);
+        KdTree<float> parallel {points};
+        parallel.knn(queries.data(), queries.size(), k, idx8.data(), d8.data());
+        tao::parallel::set_concurrency(threads);
+        ASSERT_EQ(idx1, idx8);
+        ASSERT_EQ(d1, d8);
+        for (std::size_t q = 0; q < 20; ++q)
+            check_knn(points, serial, queries[q], k);
+    }
+
+};
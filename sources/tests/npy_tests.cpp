@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include "tao/io/Npy.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+    std::string temp_path(const std::string& name) {
+        return ::testing::TempDir() + name;
+    }
+
+    TEST(Npy, RoundTrip) {
+        tao::Mat<double, Dynamic, Dynamic> mat (4, 3, tao::Padded);
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 3; ++j)
+                mat(i, j) = i - 0.5 * j;
+        auto path = temp_path("tao_roundtrip.npy");
+        tao::io::save_npy(path, mat);
+
+        tao::NpyView<double> view {path};
+        ASSERT_EQ(view.nrows(), 4);
+        ASSERT_EQ(view.ncols(), 3);
+        ASSERT_FALSE(view.fortran_order());
+        ASSERT_TRUE(tao::is_aligned(view.raw(), 64));
+
+        auto loaded = tao::io::load_npy<double>(path);
+        ASSERT_EQ(loaded.nrows(), 4);
+        ASSERT_EQ(loaded.ncols(), 3);
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 3; ++j)
+                ASSERT_DOUBLE_EQ(loaded(i, j), mat(i, j));
+        std::remove(path.c_str());
+    }
+
+    TEST(Npy, FortranOrder) {
+        // a 2x3 float32 array [[1, 2, 3], [4, 5, 6]] stored column by column
+        std::string dict = "{'descr': '<f4', 'fortran_order': True, 'shape': (2, 3), }";
+        dict.append(128 - 10 - dict.size() - 1, ' ');
+        dict.push_back('\n');
+        std::string bytes ("\x93NUMPY\x01\x00", 8);
+        bytes.push_back(static_cast<char>(dict.size()));
+        bytes.push_back(0);
+        bytes += dict;
+        float data[] = {1, 4, 2, 5, 3, 6};
+        bytes.append(reinterpret_cast<const char*>(data), sizeof(data));
+        auto path = temp_path("tao_fortran.npy");
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), f);
+        std::fclose(f);
+
+        tao::NpyView<float> view {path};
+        ASSERT_TRUE(view.fortran_order());
+        ASSERT_FLOAT_EQ(view(0, 2), 3.0f);
+        ASSERT_FLOAT_EQ(view(1, 0), 4.0f);
+
+        auto mat = view.to_mat();
+        ASSERT_TRUE(mat.eq(tao::Mat<float, Dynamic, Dynamic>{{1, 2, 3}, {4, 5, 6}}));
+        ASSERT_THROW(tao::NpyView<double> wrong {path}, std::invalid_argument);
+        std::remove(path.c_str());
+    }
+
+    TEST(Npy, Deprecated) {
+        tao::deprecated::Mat<int> mat {{1, 2}, {3, 4}, {5, 6}};
+        auto path = temp_path("tao_deprecated.npy");
+        tao::io::save_npy(path, mat);
+        tao::deprecated::Mat<int> loaded;
+        tao::io::load_npy(path, loaded);
+        ASSERT_TRUE(loaded == mat);
+        std::remove(path.c_str());
+    }
+
+    TEST(Npy, Archive) {
+        tao::Mat<float, 2, 2> a {{1, 2}, {3, 4}};
+        tao::Mat<double, Dynamic, Dynamic> b (3, 5);
+        b(2, 4) = 7.0;
+        auto path = temp_path("tao_archive.npz");
+        {
+            tao::io::NpzWriter writer {path};
+            writer.add("a", a);
+            writer.add("b", b);
+        }
+        tao::io::NpzArchive archive {path};
+        ASSERT_EQ(archive.names(), (std::vector<std::string>{"a", "b"}));
+        auto va = archive.view<float>("a");
+        ASSERT_TRUE(va.aligned());
+        ASSERT_FLOAT_EQ(va(1, 0), 3.0f);
+        auto lb = archive.load<double>("b");
+        ASSERT_EQ(lb.nrows(), 3);
+        ASSERT_DOUBLE_EQ(lb(2, 4), 7.0);
+        ASSERT_THROW(archive.view<float>("c"), std::invalid_argument);
+        std::remove(path.c_str());
+    }
+
+    std::string le(std::uint64_t v, int bytes) {
+        std::string out;
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        return out;
+    }
+
+    // a stored single-entry archive whose central sizes are saturated, so
+    // both are taken from the given central extra field
+    std::string zip64_archive(const std::string& data, const std::string& extra) {
+        std::string name = "x.npy";
+        std::string zip = le(0x04034b50, 4) + le(45, 2) + le(0, 2) + le(0, 2) + le(0, 4) + le(0, 4)
+                + le(data.size(), 4) + le(data.size(), 4) + le(name.size(), 2) + le(0, 2) + name + data;
+        std::size_t cd_offset = zip.size();
+        std::string central = le(0x02014b50, 4) + le(45, 2) + le(45, 2) + le(0, 2) + le(0, 2) + le(0, 4)
+                + le(0, 4) + le(0xFFFFFFFF, 4) + le(0xFFFFFFFF, 4) + le(name.size(), 2)
+                + le(extra.size(), 2) + le(0, 2) + le(0, 2) + le(0, 2) + le(0, 4) + le(0, 4) + name + extra;
+        return zip + central + le(0x06054b50, 4) + le(0, 2) + le(0, 2) + le(1, 2) + le(1, 2)
+                + le(central.size(), 4) + le(cd_offset, 4) + le(0, 2);
+    }
+
+    bool opens(const std::string& bytes) {
+        auto path = temp_path("tao_zip64.npz");
+        std::ofstream(path, std::ios::binary) << bytes;
+        bool ok = true;
+        try {
+            tao::io::NpzArchive archive {path};
+            ok = archive.contains("x");
+        } catch (const std::invalid_argument&) {
+            ok = false;
+        }
+        std::remove(path.c_str());
+        return ok;
+    }
+
+    TEST(Npy, CorruptZip64) {
+        std::string data (64, '\0');
+        ASSERT_TRUE(opens(zip64_archive(data, le(1, 2) + le(16, 2) + le(64, 8) + le(64, 8))));
+        // field too short for the compressed size
+        ASSERT_FALSE(opens(zip64_archive(data, le(1, 2) + le(8, 2) + le(64, 8))));
+        // field longer than the extra data
+        ASSERT_FALSE(opens(zip64_archive(data, le(1, 2) + le(24, 2) + le(64, 8) + le(64, 8))));
+        // compressed size wrapping past the end of the file
+        ASSERT_FALSE(opens(zip64_archive(data, le(1, 2) + le(16, 2) + le(64, 8) + le(~std::uint64_t(0) - 8, 8))));
+    }
+
+    TEST(Npy, Crc32) {
+        const char text[] = "123456789";
+        ASSERT_EQ(tao::io::crc32(0, text, 9), 0xCBF43926u);
+        ASSERT_EQ(tao::io::crc32(tao::io::crc32(0, text, 4), text + 4, 5), 0xCBF43926u);
+    }
+
+    TEST(Npy, BlockedTranspose) {
+        tao::Mat<int, Dynamic, Dynamic> mat (70, 45);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j)
+                mat(i, j) = i * 100 + j;
+        auto transp = tao::transpose(mat);
+        ASSERT_EQ(transp.nrows(), 45);
+        ASSERT_EQ(transp.ncols(), 70);
+        for (int i = 0; i < 70; ++i)
+            for (int j = 0; j < 45; ++j)
+                ASSERT_EQ(transp(j, i), mat(i, j));
+    }
+}
@@ -0,0 +1,247 @@
+#include "gtest/gtest.h"
+#include "tao/parallel/Parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using namespace tao::parallel;
+
+    /**
+     * Sets the concurrency for the scope of a test.
+     * */
+    struct Threads {
+        unsigned int previous;
+        explicit Threads(unsigned int n) : previous {concurrency()} { set_concurrency(n); }
+        ~Threads() { set_concurrency(previous); }
+    };
+
+    /**
+     * A pool of the kind applications already have, counting the jobs
+     * it was given.
+     * */
+    class CountingPool : public Executor {
+
+        public:
+
+            explicit CountingPool(int n) {
+                for (int i = 0; i < n; ++i)
+                    threads.emplace_back([this]() {
+                        std::unique_lock<std::mutex> guard {lock};
+                        for (;;) {
+                            ready.wait(guard, [this]() { return stopping || !jobs.empty(); });
+                            if (jobs.empty())
+                                return;
+                            auto job = std::move(jobs.front());
+                            jobs.pop_front();
+                            guard.unlock();
+                            job();
+                            guard.lock();
+                        }
+                    });
+            }
+
+            ~CountingPool() {
+                {
+                    std::lock_guard<std::mutex> guard {lock};
+                    stopping = true;
+                }
+                ready.notify_all();
+                for (auto& t : threads)
+                    t.join();
+            }
+
+            void execute(std::function<void()> job) override {
+                ++submitted;
+                {
+                    std::lock_guard<std::mutex> guard {lock};
+                    jobs.push_back(std::move(job));
+                }
+                ready.notify_one();
+            }
+
+            std::atomic<int> submitted {0};
+
+        private:
+
+            std::mutex lock;
+            std::condition_variable ready;
+            std::deque<std::function<void()>> jobs;
+            std::vector<std::thread> threads;
+            bool stopping = false;
+    };
+
+    /**
+     * An executor with no threads of its own.
+     * */
+    struct InlineExecutor : Executor {
+        void execute(std::function<void()> job) override { job(); }
+    };
+
+    void check_cover(std::size_t begin, std::size_t end, std::size_t grain) {
+        std::vector<std::atomic<int>> hits (end);
+        std::atomic<std::size_t> short_ranges {0};
+        parallel_for(begin, end, grain, [&](std::size_t lo, std::size_t hi) {
+            ASSERT_LT(lo, hi);
+            if (hi - lo < grain)
+                ++short_ranges;
+            for (std::size_t i = lo; i < hi; ++i)
+                ++hits[i];
+        });
+        for (std::size_t i = 0; i < end; ++i)
+            ASSERT_EQ(hits[i].load(), i >= begin ? 1 : 0) << i;
+        ASSERT_LE(short_ranges.load(), 1u);
+    }
+
+    TEST(Parallel, ForCoversRange) {
+        Threads threads {8};
+        check_cover(0, 0, 4);
+        check_cover(3, 4, 4);
+        check_cover(5, 1000, 1);
+        check_cover(0, 100003, 64);
+        check_cover(17, 5000, 0);
+        set_concurrency(1);
+        check_cover(0, 1000, 1);
+    }
+
+    TEST(Parallel, Nesting) {
+        Threads threads {8};
+        std::atomic<long> sum {0};
+        parallel_for(0, 64, 1, [&](std::size_t lo, std::size_t hi) {
+            for (std::size_t i = lo; i < hi; ++i)
+                parallel_for(0, 64, 1, [&](std::size_t a, std::size_t b) {
+                    for (std::size_t j = a; j < b; ++j)
+                        parallel_invoke([&]() { sum += long(i * j); }, [&]() { sum += 1; });
+                });
+        });
+        ASSERT_EQ(sum.load(), 63L * 64 / 2 * 63 * 64 / 2 + 64 * 64);
+    }
+
+    TEST(Parallel, Exceptions) {
+        Threads threads {8};
+        std::atomic<int> ran {0};
+        ASSERT_THROW(parallel_for(0, 1000, 1, [&](std::size_t lo, std::size_t hi) {
+            ran += int(hi - lo);
+            if (lo <= 500 && 500 < hi)
+                throw std::runtime_error {"500"};
+        }), std::runtime_error);
+        // the other subranges still ran to completion before the throw
+        ASSERT_EQ(ran.load(), 1000);
+        ASSERT_THROW(parallel_invoke([]() {}, []() { throw std::logic_error {"g"}; }), std::logic_error);
+        ASSERT_THROW(parallel_reduce(0, 100, 1, [](std::size_t lo, std::size_t) -> int {
+            if (lo == 0) throw std::out_of_range {"0"};
+            return 0;
+        }, [](int a, int b) { return a + b; }), std::out_of_range);
+        // and the scheduler is still usable
+        check_cover(0, 1000, 3);
+    }
+
+    TEST(Parallel, Reduce) {
+        Threads threads {8};
+        std::vector<double> x (100000);
+        for (std::size_t i = 0; i < x.size(); ++i)
+            x[i] = 1.0 / double(i + 1);
+        auto sum = [&]() {
+            return parallel_reduce(0, x.size(), 1000, [&](std::size_t lo, std::size_t hi) {
+                double s = 0.0;
+                for (std::size_t i = lo; i < hi; ++i) s += x[i];
+                return s;
+            }, [](double a, double b) { return a + b; });
+        };
+        double serial = 0.0;
+        for (double v : x) serial += v;
+        ASSERT_NEAR(sum(), serial, 1e-12);
+        // the order of combination is kept
+        auto concat = parallel_reduce(0, 200, 7, [](std::size_t lo, std::size_t hi) {
+            std::vector<std::size_t> v;
+            for (std::size_t i = lo; i < hi; ++i) v.push_back(i);
+            return v;
+        }, [](std::vector<std::size_t> a, const std::vector<std::size_t>& b) {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
+        });
+        ASSERT_EQ(concat.size(), 200u);
+        for (std::size_t i = 0; i < 200; ++i)
+            ASSERT_EQ(concat[i], i);
+        ASSERT_EQ(parallel_reduce(4, 4, 1, [](std::size_t lo, std::size_t hi) { return int(hi - lo); },
+            [](int a, int b) { return a + b; }), 0);
+        // results without a default constructor
+        struct Range {
+            std::size_t lo, hi;
+            Range(std::size_t l, std::size_t h) : lo {l}, hi {h} {}
+        };
+        auto whole = parallel_reduce(3, 5000, 10, [](std::size_t lo, std::size_t hi) { return Range {lo, hi}; },
+            [](Range a, Range b) { return Range {a.lo, b.hi}; });
+        ASSERT_EQ(whole.lo, 3u);
+        ASSERT_EQ(whole.hi, 5000u);
+        // bit-identical on any number of threads in deterministic mode
+        set_deterministic(true);
+        const double reference = sum();
+        for (unsigned int n : {1u, 2u, 3u, 16u}) {
+            set_concurrency(n);
+            ASSERT_EQ(sum(), reference) << n;
+        }
+        set_deterministic(false);
+    }
+
+    TEST(Parallel, Invoke) {
+        Threads threads {4};
+        int a = 0, b = 0, c = 0;
+        parallel_invoke([&]() { a = 1; }, [&]() { b = 2; }, [&]() { c = 3; });
+        ASSERT_EQ(a + b + c, 6);
+        parallel_invoke([&]() { a = 5; });
+        ASSERT_EQ(a, 5);
+    }
+
+    TEST(Parallel, Executors) {
+        Threads threads {4};
+        {
+            CountingPool pool {3};
+            set_executor(&pool);
+            check_cover(0, 100000, 10);
+            // helpers are only asked from outside of the scheduler
+            const int submitted = pool.submitted.load();
+            ASSERT_GT(submitted, 0);
+            ASSERT_LE(submitted, 3);
+            std::atomic<int> calls {0};
+            parallel_for(0, 8, 1, [&](std::size_t, std::size_t) {
+                parallel_for(0, 8, 1, [&](std::size_t, std::size_t) { ++calls; });
+            });
+            ASSERT_GE(calls.load(), 4);
+            ASSERT_LE(pool.submitted.load(), submitted + 3);
+            set_executor(nullptr);
+        }
+        InlineExecutor serial;
+        set_executor(&serial);
+        check_cover(0, 10000, 10);
+        set_executor(nullptr);
+    }
+
+    TEST(Parallel, ConcurrentCallers) {
+        Threads threads {4};
+        std::vector<std::thread> callers;
+        std::atomic<int> failures {0};
+        for (int t = 0; t < 6; ++t)
+            callers.emplace_back([&, t]() {
+                for (int r = 0; r < 20; ++r) {
+                    const long n = 1000 + 37 * t + r;
+                    const long s = parallel_reduce(0, std::size_t(n), 16, [](std::size_t lo, std::size_t hi) {
+                        long v = 0;
+                        for (std::size_t i = lo; i < hi; ++i) v += long(i);
+                        return v;
+                    }, [](long a, long b) { return a + b; });
+                    if (s != n * (n - 1) / 2)
+                        ++failures;
+                }
+            });
+        for (auto& c : callers)
+            c.join();
+        ASSERT_EQ(failures.load(), 0);
+    }
+
+};
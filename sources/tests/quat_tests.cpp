@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Quat.h"
+#include <cmath>
+#include <random>
+
+namespace {
+
+    using tao::Quat;
+    using tao::QuatSoA;
+
+    Quat<double> random_rotation(std::mt19937& gen) {
+        std::normal_distribution<double> n {0.0, 1.0};
+        return Quat<double> {n(gen), n(gen), n(gen), n(gen)}.normalized();
+    }
+
+    void expect_same_rotation(const Quat<double>& a, const Quat<double>& b, double tolerance) {
+        ASSERT_NEAR(std::abs(dot(a, b)), 1.0, tolerance);
+    }
+
+    TEST(Quat, AxisAngleAndProduct) {
+        auto qz = Quat<double>::axis_angle(tao::Vec3d {0.0, 0.0, 2.0}, M_PI / 2);
+        auto v = qz.rotate(tao::Vec3d {1.0, 0.0, 0.0});
+        ASSERT_NEAR(v(0), 0.0, 1e-15);
+        ASSERT_NEAR(v(1), 1.0, 1e-15);
+        ASSERT_NEAR(v(2), 0.0, 1e-15);
+        auto half = Quat<double>::axis_angle(tao::Vec3d {0.0, 0.0, 1.0}, M_PI / 4);
+        expect_same_rotation(half * half, qz, 1e-15);
+        auto identity = qz * qz.conjugate();
+        ASSERT_NEAR(identity.w, 1.0, 1e-15);
+        ASSERT_NEAR(identity.x * identity.x + identity.y * identity.y + identity.z * identity.z, 0.0, 1e-30);
+        ASSERT_THROW(Quat<double>::axis_angle(tao::Vec3d {0.0, 0.0, 0.0}, 1.0), std::invalid_argument);
+        ASSERT_THROW((Quat<double> {0.0, 0.0, 0.0, 0.0}.normalized()), std::invalid_argument);
+    }
+
+    TEST(Quat, MatrixRoundTrip) {
+        std::mt19937 gen {1};
+        for (int k = 0; k < 1000; ++k) {
+            auto q = random_rotation(gen);
+            auto m = q.to_mat3();
+            expect_same_rotation(Quat<double>::from_matrix(m), q, 1e-12);
+            auto m4 = q.to_mat4();
+            ASSERT_EQ(m4(3, 3), 1.0);
+            ASSERT_EQ(m4(0, 3), 0.0);
+            expect_same_rotation(Quat<double>::from_matrix(m4), q, 1e-12);
+            // the matrix and the quaternion rotate alike, and products compose alike
+            tao::Vec3d v {0.3, -1.2, 2.0};
+            auto r = q.rotate(v);
+            for (int i = 0; i < 3; ++i)
+                ASSERT_NEAR(r(i), m(i, 0) * v(0) + m(i, 1) * v(1) + m(i, 2) * v(2), 1e-12);
+            auto p = random_rotation(gen);
+            auto pm = p.to_mat3();
+            auto product = (p * q).to_mat3();
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    ASSERT_NEAR(product(i, j), pm(i, 0) * m(0, j) + pm(i, 1) * m(1, j) + pm(i, 2) * m(2, j), 1e-12);
+        }
+        // pivots other than the trace
+        for (int axis = 0; axis < 3; ++axis) {
+            tao::Vec3d u {axis == 0 ? 1.0 : 0.0, axis == 1 ? 1.0 : 0.0, axis == 2 ? 1.0 : 0.0};
+            auto q = Quat<double>::axis_angle(u, M_PI);
+            expect_same_rotation(Quat<double>::from_matrix(q.to_mat3()), q, 1e-15);
+        }
+    }
+
+    TEST(Quat, SlerpAndNlerp) {
+        auto a = Quat<double>::axis_angle(tao::Vec3d {0.0, 1.0, 0.0}, 0.2);
+        auto b = Quat<double>::axis_angle(tao::Vec3d {0.0, 1.0, 0.0}, 1.4);
+        for (double t : {0.0, 0.25, 0.5, 1.0}) {
+            expect_same_rotation(slerp(a, b, t), Quat<double>::axis_angle(tao::Vec3d {0.0, 1.0, 0.0}, 0.2 + 1.2 * t), 1e-14);
+            // shortest arc even when the signs disagree
+            expect_same_rotation(slerp(a, -b, t), slerp(a, b, t), 1e-14);
+            expect_same_rotation(nlerp(a, -b, t), nlerp(a, b, t), 1e-14);
+        }
+        expect_same_rotation(nlerp(a, b, 0.5), slerp(a, b, 0.5), 1e-14);
+        expect_same_rotation(slerp(a, a, 0.3), a, 1e-15);
+    }
+
+    TEST(Quat, Batches) {
+        std::mt19937 gen {2};
+        const std::size_t n = 1001;
+        QuatSoA<float> a (n), b (n), out (n);
+        std::vector<Quat<double>> qa, qb;
+        for (std::size_t i = 0; i < n; ++i) {
+            qa.push_back(random_rotation(gen));
+            qb.push_back(i % 3 == 0 ? qa.back() : random_rotation(gen));
+            a.set(i, Quat<float> {float(qa[i].w), float(qa[i].x), float(qa[i].y), float(qa[i].z)});
+            b.set(i, Quat<float> {float(qb[i].w), float(qb[i].x), float(qb[i].y), float(qb[i].z)});
+        }
+        auto widen = [](const Quat<float>& q) { return Quat<double> {q.w, q.x, q.y, q.z}; };
+
+        tao::multiply(a, b, out);
+        for (std::size_t i = 0; i < n; ++i)
+            expect_same_rotation(widen(out.get(i)).normalized(), qa[i] * qb[i], 4e-6);
+        for (float t : {0.0f, 0.3f, 0.5f, 1.0f}) {
+            tao::slerp(a, b, t, out);
+            for (std::size_t i = 0; i < n; ++i) {
+                auto expected = slerp(qa[i], qb[i], double(t));
+                auto got = widen(out.get(i));
+                ASSERT_NEAR(got.norm(), 1.0, 4e-6);
+                expect_same_rotation(got, expected, 4e-6);
+            }
+            tao::nlerp(a, b, t, out);
+            for (std::size_t i = 0; i < n; ++i)
+                expect_same_rotation(widen(out.get(i)), nlerp(qa[i], qb[i], double(t)), 4e-6);
+        }
+
+        std::vector<float> x (n), y (n), z (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = 1.0f;
+            y[i] = float(i) / n;
+            z[i] = -2.0f;
+        }
+        tao::rotate(a, x.data(), y.data(), z.data(), x.data(), y.data(), z.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            auto r = qa[i].rotate(tao::Vec3d {1.0, double(float(i) / n), -2.0});
+            ASSERT_NEAR(x[i], r(0), 1e-5);
+            ASSERT_NEAR(y[i], r(1), 1e-5);
+            ASSERT_NEAR(z[i], r(2), 1e-5);
+        }
+        QuatSoA<float> c (n);
+        c.w.assign(n, 2.0f);
+        tao::normalize(c);
+        ASSERT_EQ(c.get(7), Quat<float> {});
+        QuatSoA<float> shorter (n - 1);
+        ASSERT_THROW(tao::multiply(a, shorter, out), std::invalid_argument);
+    }
+
+};
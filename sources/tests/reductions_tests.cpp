@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include <cmath>
+
+namespace {
+
+    TEST(Reductions, SmallMatrix) {
+        tao::Mat<double, 2, 3> mat {
+            {1.0, -7.0, 3.0},
+            {4.0, 5.0, -2.0}
+        };
+        ASSERT_DOUBLE_EQ(tao::sum(mat), 4.0);
+        ASSERT_DOUBLE_EQ(tao::squared_norm(mat), 104.0);
+        ASSERT_DOUBLE_EQ(tao::norm_l1(mat), 22.0);
+        ASSERT_DOUBLE_EQ(tao::norm_frobenius(mat), std::sqrt(104.0));
+        ASSERT_DOUBLE_EQ(tao::norm_linf(mat), 7.0);
+        ASSERT_DOUBLE_EQ(tao::min(mat), -7.0);
+        ASSERT_DOUBLE_EQ(tao::max(mat), 5.0);
+        ASSERT_EQ(tao::argmin(mat), 1u);
+        ASSERT_EQ(tao::argmax(mat), 4u);
+    }
+
+    TEST(Reductions, PaddedMatrix) {
+        tao::Mat<float, Dynamic, Dynamic> mat (5, 3, tao::Padded);
+        mat.reset(9.0f);
+        for (int i = 0; i < 5; ++i)
+            for (int j = 0; j < 3; ++j)
+                mat(i, j) = 1.0f;
+        ASSERT_FLOAT_EQ(tao::sum(mat), 15.0f);
+        ASSERT_FLOAT_EQ(tao::max(mat), 1.0f);
+        mat(4, 2) = 2.0f;
+        ASSERT_EQ(tao::argmax(mat), 14u);
+    }
+
+    TEST(Reductions, LargeParallel) {
+        const int n = 1 << 20;
+        tao::Mat<double, Dynamic, Dynamic> v (n, 1);
+        for (int i = 0; i < n; ++i)
+            v(i) = (i % 7) - 3.0;
+        v(777777) = 100.0;
+        v(123) = -100.0;
+        double expected = 0.0;
+        for (int i = 0; i < n; ++i)
+            expected += v(i);
+        ASSERT_DOUBLE_EQ(tao::sum(v), expected);
+        ASSERT_DOUBLE_EQ(tao::sum(v, tao::Kahan), expected);
+        ASSERT_DOUBLE_EQ(tao::sum(v, tao::Pairwise), expected);
+        ASSERT_EQ(tao::argmax(v), 777777u);
+        ASSERT_EQ(tao::argmin(v), 123u);
+        ASSERT_DOUBLE_EQ(tao::norm_linf(v), 100.0);
+        ASSERT_DOUBLE_EQ(tao::dot(v, v), tao::squared_norm(v));
+    }
+
+    TEST(Reductions, CompensatedAccuracy) {
+        const int n = 1 << 21;
+        tao::Mat<float, Dynamic, Dynamic> v (n, 1);
+        v.reset(0.1f);
+        double exact = double(0.1f) * n;
+        float naive = tao::sum(v);
+        float kahan = tao::sum(v, tao::Kahan);
+        float pairwise = tao::sum(v, tao::Pairwise);
+        ASSERT_LE(std::abs(kahan - exact), std::abs(naive - exact));
+        ASSERT_NEAR(kahan, exact, exact * 1e-6);
+        ASSERT_NEAR(pairwise, exact, exact * 1e-5);
+    }
+
+    TEST(Reductions, DynamicDotAndNorm) {
+        tao::Mat<double, Dynamic, Dynamic> a (2, 1);
+        a(0) = 3.0;
+        a(1) = 4.0;
+        ASSERT_DOUBLE_EQ(tao::inner(a, a), 25.0);
+        ASSERT_DOUBLE_EQ(tao::norm(a), 5.0);
+        tao::Mat<double, 16, 1> b (1.0);
+        ASSERT_DOUBLE_EQ(tao::norm(b), 4.0);
+    }
+
+    TEST(Reductions, DeterministicAcrossThreads) {
+        const int n = (1 << 20) + 123;
+        tao::Mat<float, Dynamic, Dynamic> v (n, 1);
+        for (int i = 0; i < n; ++i)
+            v(i) = std::sin(float(i)) * 1e3f + 1e-3f * float(i % 11);
+        tao::parallel::set_deterministic(true);
+        tao::parallel::set_concurrency(1);
+        float serial = tao::sum(v);
+        float serial_dot = tao::inner(v, v, tao::Pairwise);
+        for (unsigned int threads : {2u, 3u, 8u, 64u}) {
+            tao::parallel::set_concurrency(threads);
+            ASSERT_EQ(tao::sum(v), serial);
+            ASSERT_EQ(tao::inner(v, v, tao::Pairwise), serial_dot);
+        }
+        tao::parallel::set_concurrency(0);
+        tao::parallel::set_deterministic(false);
+        ASSERT_NEAR(tao::sum(v), serial, 1e-2f * std::abs(serial) + 1.0f);
+    }
+
+}
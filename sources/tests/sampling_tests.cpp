@@ -0,0 +1,252 @@
+#include "gtest/gtest.h"
+#include "tao/sampling/Philox.h"
+#include "tao/sampling/LowDiscrepancy.h"
+#include "tao/sampling/Warp.h"
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace {
+
+    using namespace tao::sampling;
+    using tao::math::Exact;
+    using tao::math::Fast;
+
+    TEST(Sampling, PhiloxKnownAnswers) {
+        // Random123's kat_vectors for philox4x32_10
+        auto zero = Philox(0, 0).block(0);
+        ASSERT_EQ(zero, (std::array<std::uint32_t, 4> {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+        auto ones = Philox(~0ull, ~0ull).block(~0ull);
+        ASSERT_EQ(ones, (std::array<std::uint32_t, 4> {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+        auto pi = Philox(0x299f31d0a4093822ull, 0x0370734413198a2eull).block(0x85a308d3243f6a88ull);
+        ASSERT_EQ(pi, (std::array<std::uint32_t, 4> {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+    }
+
+    TEST(Sampling, PhiloxBatches) {
+        const Philox g {42, 7};
+        const std::size_t n = 50003;
+        // starting mid-block, and across the carry into the high word
+        for (std::uint64_t first : {std::uint64_t(5), (std::uint64_t(1) << 34) - 9}) {
+            std::vector<std::uint32_t> w (n);
+            std::vector<float> f (n);
+            std::vector<double> d (n);
+            g.words(first, w.data(), n);
+            g.uniform(first, f.data(), n);
+            g.uniform(first, d.data(), n);
+            for (std::size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(w[i], g.word(first + i));
+                ASSERT_EQ(f[i], g.uniform<float>(first + i));
+                ASSERT_EQ(d[i], g.uniform<double>(first + i));
+                ASSERT_TRUE(f[i] >= 0.0f && f[i] < 1.0f);
+                ASSERT_TRUE(d[i] >= 0.0 && d[i] < 1.0);
+            }
+        }
+        ASSERT_NE(g.word(0), g.with_stream(8).word(0));
+        ASSERT_EQ(g.with_stream(8).word(3), Philox(42, 8).word(3));
+        double mean = 0.0;
+        std::vector<double> d (100000);
+        g.uniform(0, d.data(), d.size());
+        for (double x : d)
+            mean += x / double(d.size());
+        ASSERT_NEAR(mean, 0.5, 0.005);
+    }
+
+    TEST(Sampling, SobolValues) {
+        const Sobol s;
+        const float first[][2] = {{0.0f, 0.0f}, {0.5f, 0.5f}, {0.25f, 0.75f}, {0.75f, 0.25f}, {0.125f, 0.625f}};
+        for (int i = 0; i < 5; ++i) {
+            ASSERT_EQ(s.sample<float>(i, 0), first[i][0]);
+            ASSERT_EQ(s.sample<float>(i, 1), first[i][1]);
+        }
+        ASSERT_THROW(s.sample<float>(0, 16), std::invalid_argument);
+        ASSERT_THROW(s.generate(~0u, 2, 0, std::vector<float> (2).data()), std::invalid_argument);
+    }
+
+    /**
+     * Whether the first 2^m points of two dimensions put one point in
+     * every elementary interval of area 2^-m, and whether each
+     * dimension alone has one point per interval of length 2^-m.
+     * */
+    bool stratified(const std::vector<double>& x, const std::vector<double>& y, int m) {
+        const std::size_t n = std::size_t(1) << m;
+        for (int k = 0; k <= m; ++k) {
+            std::set<std::size_t> cells;
+            for (std::size_t i = 0; i < n; ++i)
+                cells.insert((std::size_t(x[i] * double(1 << k)) << (m - k)) | std::size_t(y[i] * double(1 << (m - k))));
+            if (cells.size() != n)
+                return false;
+        }
+        return true;
+    }
+
+    TEST(Sampling, SobolStratification) {
+        const int m = 10;
+        const std::size_t n = std::size_t(1) << m;
+        for (const Sobol& s : {Sobol(), Sobol(1234)}) {
+            std::vector<double> all (Sobol::max_dimensions * n);
+            s.generate(0, n, all.data());
+            std::vector<double> x (all.begin(), all.begin() + n), y (all.begin() + n, all.begin() + 2 * n);
+            ASSERT_TRUE(stratified(x, y, m));
+            for (int d = 0; d < Sobol::max_dimensions; ++d) {
+                std::set<std::size_t> cells;
+                for (std::size_t i = 0; i < n; ++i) {
+                    const double v = all[d * n + i];
+                    ASSERT_EQ(v, s.sample<double>(std::uint32_t(i), d));
+                    cells.insert(std::size_t(v * double(n)));
+                }
+                ASSERT_EQ(cells.size(), n) << d;
+            }
+        }
+        // scrambling changes the points, differently per seed
+        ASSERT_NE(Sobol(1).bits(1, 0), Sobol().bits(1, 0));
+        ASSERT_NE(Sobol(1).bits(1, 0), Sobol(2).bits(1, 0));
+    }
+
+    TEST(Sampling, SobolBatches) {
+        const Sobol s {99};
+        const std::size_t n = 70001;
+        std::vector<float> out (n);
+        s.generate(300, n, 5, out.data());
+        for (std::size_t i = 0; i < n; ++i)
+            ASSERT_EQ(out[i], s.sample<float>(std::uint32_t(300 + i), 5));
+    }
+
+    TEST(Sampling, Halton) {
+        const Halton h;
+        ASSERT_EQ(h.sample<double>(1, 0), 0.5);
+        ASSERT_EQ(h.sample<double>(6, 0), 0.375);
+        ASSERT_NEAR(h.sample<double>(5, 1), 7.0 / 9.0, 1e-15);
+        ASSERT_NEAR(h.sample<double>(1000, 2), 0.0 + 0.0 / 5 + 0.0 / 25 + 3.0 / 625 + 1.0 / 3125, 1e-15);
+        // 1000 is 13000 in base 5
+        const std::size_t n = 100003;
+        std::vector<float> f (n);
+        std::vector<double> all (Halton::max_dimensions * 2000);
+        h.generate(std::uint64_t(1) << 33, n, 31, f.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(f[i], h.sample<float>((std::uint64_t(1) << 33) + i, 31));
+            ASSERT_LT(f[i], 1.0f);
+        }
+        h.generate(0, 2000, all.data());
+        for (int d = 0; d < Halton::max_dimensions; ++d) {
+            double mean = 0.0;
+            for (std::size_t i = 0; i < 2000; ++i)
+                mean += all[d * 2000 + i] / 2000.0;
+            ASSERT_NEAR(mean, 0.5, 0.04) << d;
+        }
+        ASSERT_THROW(h.sample<float>(0, 32), std::invalid_argument);
+    }
+
+    TEST(Sampling, R2) {
+        const R2 r;
+        for (std::uint64_t i = 0; i < 1000; ++i) {
+            ASSERT_NEAR(r.sample<double>(i, 0), std::fmod(0.5 + double(i) * 0.7548776662466927, 1.0), 1e-12);
+            ASSERT_NEAR(r.sample<double>(i, 1), std::fmod(0.5 + double(i) * 0.5698402909980532, 1.0), 1e-12);
+        }
+        const std::size_t n = 1000;
+        std::vector<float> all (2 * n);
+        r.generate(77, n, all.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(all[i], r.sample<float>(77 + i, 0));
+            ASSERT_EQ(all[n + i], r.sample<float>(77 + i, 1));
+        }
+    }
+
+    TEST(Sampling, DiskHemisphereSphere) {
+        const Sobol s {5};
+        const std::size_t n = 4096;
+        std::vector<float> u (n), v (n), x (n), y (n), z (n);
+        s.generate(0, n, 0, u.data());
+        s.generate(0, n, 1, v.data());
+        concentric_disk<Fast>(u.data(), v.data(), x.data(), y.data(), n);
+        int inner = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            auto p = concentric_disk<Exact>(u[i], v[i]);
+            ASSERT_NEAR(x[i], p(0), 1e-6f);
+            ASSERT_NEAR(y[i], p(1), 1e-6f);
+            ASSERT_LE(x[i] * x[i] + y[i] * y[i], 1.0f + 1e-6f);
+            inner += x[i] * x[i] + y[i] * y[i] < 0.25f;
+        }
+        // the disk of radius 1/2 covers a quarter of the area
+        ASSERT_NEAR(inner / double(n), 0.25, 0.01);
+        auto center = concentric_disk<Exact>(0.5f, 0.5f);
+        ASSERT_EQ(center(0), 0.0f);
+        ASSERT_EQ(center(1), 0.0f);
+
+        cosine_hemisphere<Fast>(u.data(), v.data(), x.data(), y.data(), z.data(), n);
+        double mean_z = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            ASSERT_NEAR(x[i] * x[i] + y[i] * y[i] + z[i] * z[i], 1.0f, 1e-5f);
+            ASSERT_GE(z[i], 0.0f);
+            ASSERT_EQ(z[i], cosine_hemisphere<Fast>(u[i], v[i])(2));
+            mean_z += z[i] / double(n);
+        }
+        // E[cos theta] = 2/3 under the cosine density
+        ASSERT_NEAR(mean_z, 2.0 / 3.0, 1e-3);
+        ASSERT_NEAR(cosine_hemisphere_pdf(1.0), 1.0 / M_PI, 1e-15);
+
+        uniform_sphere<Exact>(u.data(), v.data(), x.data(), y.data(), z.data(), n);
+        double mean[3] = {0.0, 0.0, 0.0};
+        for (std::size_t i = 0; i < n; ++i) {
+            ASSERT_NEAR(x[i] * x[i] + y[i] * y[i] + z[i] * z[i], 1.0f, 1e-5f);
+            mean[0] += x[i] / double(n);
+            mean[1] += y[i] / double(n);
+            mean[2] += z[i] / double(n);
+        }
+        for (int a = 0; a < 3; ++a)
+            ASSERT_NEAR(mean[a], 0.0, 2e-3);
+        ASSERT_NEAR(uniform_sphere_pdf<double>() * 4 * M_PI, 1.0, 1e-15);
+    }
+
+    TEST(Sampling, SphericalTriangle) {
+        using V = tao::Vec3d;
+        // an octant: solid angle pi / 2, in either winding
+        for (bool flip : {false, true}) {
+            SphericalTriangle<double> octant {V {2.0, 0.0, 0.0}, flip ? V {0.0, 0.0, 1.0} : V {0.0, 1.0, 0.0},
+                flip ? V {0.0, 1.0, 0.0} : V {0.0, 0.0, 1.0}};
+            ASSERT_NEAR(octant.solid_angle(), M_PI / 2, 1e-14);
+            ASSERT_NEAR(octant.pdf(), 2 / M_PI, 1e-14);
+        }
+
+        const V a {1.0, 0.2, 0.1}, b {-0.3, 1.0, 0.4}, c {0.2, -0.1, 1.0};
+        SphericalTriangle<double> tri {a, b, c};
+        // the samples falling in the sub-triangle (a, b, m), m the midpoint of bc,
+        // are in proportion to its solid angle
+        const V m = (b / tao::norm(b) + c / tao::norm(c)) * 0.5;
+        const double part = SphericalTriangle<double> {a, b, m}.solid_angle() / tri.solid_angle();
+        const std::size_t n = 1 << 14;
+        const Sobol s {3};
+        std::vector<double> u (n), v (n), x (n), y (n), z (n);
+        s.generate(0, n, 0, u.data());
+        s.generate(0, n, 1, v.data());
+        tri.sample<Exact>(u.data(), v.data(), x.data(), y.data(), z.data(), n);
+        const V n_ab = tao::cross(a, b), n_bc = tao::cross(b, c), n_ca = tao::cross(c, a), n_am = tao::cross(a, m);
+        std::size_t inside = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const V p {x[i], y[i], z[i]};
+            ASSERT_NEAR(tao::norm(p), 1.0, 1e-12);
+            ASSERT_GE(tao::dot(p, n_ab), -1e-12);
+            ASSERT_GE(tao::dot(p, n_bc), -1e-12);
+            ASSERT_GE(tao::dot(p, n_ca), -1e-12);
+            auto q = tri.sample<Exact>(u[i], v[i]);
+            ASSERT_EQ(q(0), x[i]);
+            inside += tao::dot(p, n_am) <= 0.0;
+        }
+        ASSERT_NEAR(inside / double(n), part, 2e-3);
+
+        std::vector<float> fu (n), fv (n), fx (n), fy (n), fz (n);
+        s.generate(0, n, 0, fu.data());
+        s.generate(0, n, 1, fv.data());
+        SphericalTriangle<float> ftri {tao::Vec3f {1.0f, 0.2f, 0.1f}, tao::Vec3f {-0.3f, 1.0f, 0.4f}, tao::Vec3f {0.2f, -0.1f, 1.0f}};
+        ftri.sample<Fast>(fu.data(), fv.data(), fx.data(), fy.data(), fz.data(), n);
+        // thin sub-triangles, for u near 0, lose digits in float whatever the tier
+        for (std::size_t i = 0; i < n; ++i) {
+            ASSERT_NEAR(fx[i], x[i], 1e-3);
+            ASSERT_NEAR(fy[i], y[i], 1e-3);
+            ASSERT_NEAR(fz[i], z[i], 1e-3);
+        }
+
+        ASSERT_THROW(SphericalTriangle<double>(a, a * 2.0, c), std::invalid_argument);
+        ASSERT_THROW(SphericalTriangle<double>(a, V {0.0, 0.0, 0.0}, c), std::invalid_argument);
+    }
+
+};
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "tao/linalg/Mat.h"
+#include <vector>
+
+namespace {
+
+    TEST(Storage, DynamicIsAligned) {
+        tao::Mat<float, Dynamic, Dynamic> mat (7, 5);
+        ASSERT_EQ(mat.nrows(), 7);
+        ASSERT_EQ(mat.ncols(), 5);
+        ASSERT_EQ(mat.ld(), 5);
+        ASSERT_TRUE(tao::is_aligned(mat.raw(), tao::default_alignment));
+        for (int i = 0; i < 7; ++i)
+            for (int j = 0; j < 5; ++j)
+                ASSERT_FLOAT_EQ(mat(i, j), 0.0f);
+    }
+
+    TEST(Storage, PaddedLeadingDimension) {
+        tao::Mat<double, Dynamic, Dynamic> mat (3, 5, tao::Padded);
+        ASSERT_EQ(mat.ld(), 8);
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(tao::is_aligned(mat.raw() + i * mat.ld(), 64));
+            for (int j = 0; j < 5; ++j)
+                mat(i, j) = i * 10 + j;
+        }
+        ASSERT_DOUBLE_EQ(mat.raw()[2 * mat.ld() + 4], 24.0);
+        ASSERT_DOUBLE_EQ(mat(1, 3), 13.0);
+    }
+
+    TEST(Storage, DynamicCopy) {
+        tao::Mat<int, Dynamic, Dynamic> mat {
+            {1, 2},
+            {3, 4}
+        };
+        tao::Mat<int, Dynamic, Dynamic> copy = mat;
+        copy(0, 0) = 10;
+        ASSERT_EQ(mat(0, 0), 1);
+        ASSERT_EQ(copy(0, 0), 10);
+        ASSERT_EQ(copy(1, 1), 4);
+        ASSERT_NE(copy.raw(), mat.raw());
+    }
+
+    TEST(Storage, FixedAlignment) {
+        ASSERT_EQ((tao::Mat<float, 4, 4>::alignment), 64u);
+        ASSERT_EQ((tao::Mat<float, 4, 1>::alignment), 16u);
+        ASSERT_EQ((tao::Mat<float, 3, 1>::alignment), alignof(float));
+        tao::Mat<float, 4, 4> mat;
+        ASSERT_TRUE(tao::is_aligned(mat.raw(), 64));
+    }
+
+    TEST(Storage, ResetLarge) {
+        tao::Mat<float, Dynamic, Dynamic> mat (1024, 513);
+        mat.reset(2.5f);
+        ASSERT_FLOAT_EQ(mat(0, 0), 2.5f);
+        ASSERT_FLOAT_EQ(mat(1023, 512), 2.5f);
+        ASSERT_FLOAT_EQ(mat(511, 100), 2.5f);
+    }
+
+    TEST(Storage, StreamCopy) {
+        std::vector<double, tao::aligned_allocator<double>> src (300000), dst (300000);
+        ASSERT_TRUE(tao::is_aligned(src.data(), 64));
+        for (std::size_t i = 0; i < src.size(); ++i)
+            src[i] = i * 0.5;
+        tao::stream_copy(dst.data() + 1, src.data() + 1, src.size() - 1);
+        ASSERT_DOUBLE_EQ(dst[0], 0.0);
+        ASSERT_DOUBLE_EQ(dst[1], 0.5);
+        ASSERT_DOUBLE_EQ(dst[299999], 299999 * 0.5);
+    }
+
+    TEST(Storage, NegativeSize) {
+        try {
+            tao::Mat<float, Dynamic, Dynamic> mat (-1, 3);
+            FAIL();
+        } catch (std::invalid_argument& e) {
+            SUCCEED();
+        }
+    }
+
+    TEST(Storage, AlignedMallocOverflow) {
+        ASSERT_EQ(tao::aligned_malloc(0, 64), nullptr);
+        ASSERT_THROW(tao::aligned_malloc(std::numeric_limits<std::size_t>::max() - 10, 64), std::bad_alloc);
+    }
+}
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Strassen.h"
+#include "tao/parallel/Parallel.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+    DMat random_matrix(int rows, int cols, unsigned seed, tao::StorageLayout layout = tao::Packed) {
+        std::mt19937 gen {seed};
+        std::uniform_int_distribution<int> u {-8, 8};
+        DMat m (rows, cols, layout);
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                m(i, j) = u(gen);
+        return m;
+    }
+
+    TEST(Strassen, ExactOnIntegers) {
+        // small integers: every sum is exact, so any order agrees with gemm
+        for (int m : {1, 7, 16, 33, 64})
+            for (int n : {5, 16, 31})
+                for (int k : {3, 18, 29}) {
+                    DMat a = random_matrix(m, k, m + k, tao::Padded), b = random_matrix(k, n, n + k);
+                    DMat c (m, n, tao::Padded);
+                    tao::strassen_multiply(a, b, c, 4);
+                    ASSERT_EQ(c, a * b) << m << "x" << k << " by " << k << "x" << n;
+                }
+    }
+
+    TEST(Strassen, Accuracy) {
+        std::mt19937 gen {3};
+        std::uniform_real_distribution<double> u {-1.0, 1.0};
+        DMat a (96, 96), b (96, 96), c (96, 96);
+        for (int i = 0; i < 96; ++i)
+            for (int j = 0; j < 96; ++j) {
+                a(i, j) = u(gen);
+                b(i, j) = u(gen);
+            }
+        tao::strassen_multiply(a, b, c, 8);
+        DMat reference = a * b;
+        double worst = 0.0;
+        for (int i = 0; i < 96; ++i)
+            for (int j = 0; j < 96; ++j)
+                worst = std::max(worst, std::fabs(c(i, j) - reference(i, j)));
+        ASSERT_GT(worst, 0.0);
+        ASSERT_LT(worst, 1e-11);
+    }
+
+    TEST(Strassen, Workspace) {
+        ASSERT_EQ(tao::kernels::strassen_workspace(100, 100, 100, 128, 1), 0u);
+        ASSERT_EQ(tao::kernels::strassen_workspace(64, 64, 64, 64, 0), 11u * 32 * 32);
+        ASSERT_EQ(tao::kernels::strassen_workspace(64, 64, 64, 32, 0), 11u * 32 * 32 + 11u * 16 * 16);
+        ASSERT_EQ(tao::kernels::strassen_workspace(64, 64, 64, 32, 1), 11u * 32 * 32 + 7 * 11u * 16 * 16);
+    }
+
+    TEST(Strassen, SameOnAnyThreads) {
+        DMat a = random_matrix(75, 70, 1), b = random_matrix(70, 66, 2);
+        for (int i = 0; i < 75; ++i)
+            a(i, i % 70) += 0.1;
+        std::vector<double> work (tao::kernels::strassen_workspace(75, 66, 70, 8, 2));
+        DMat serial (75, 66), parallel (75, 66);
+        tao::kernels::strassen(75, 66, 70, a.raw(), a.ld(), b.raw(), b.ld(), serial.raw(), serial.ld(), 8, 0, work.data());
+        unsigned threads = tao::parallel::concurrency();
+        tao::parallel::set_concurrency(4);
+        tao::kernels::strassen(75, 66, 70, a.raw(), a.ld(), b.raw(), b.ld(), parallel.raw(), parallel.ld(), 8, 2, work.data());
+        tao::parallel::set_concurrency(threads);
+        ASSERT_EQ(serial, parallel);
+    }
+
+    TEST(Strassen, Dimensions) {
+        DMat a (4, 3), b (4, 3), c (4, 3);
+        ASSERT_THROW(tao::strassen_multiply(a, b, c), std::invalid_argument);
+    }
+
+};
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "tao/io/Text.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace {
+
+    TEST(Text, ParseWhitespace) {
+        auto mat = tao::io::parse_text<double>("1 2.5  -3\n\n\t4 5e2 +6\r\n");
+        ASSERT_EQ(mat.nrows(), 2);
+        ASSERT_EQ(mat.ncols(), 3);
+        ASSERT_TRUE(mat.eq(tao::Mat<double, Dynamic, Dynamic>{{1, 2.5, -3}, {4, 500, 6}}));
+    }
+
+    TEST(Text, ParseCsvAndTsv) {
+        auto csv = tao::io::parse_text<int>("1, 2,3\n4 ,5, 6", tao::io::Csv);
+        ASSERT_EQ(csv.nrows(), 2);
+        ASSERT_EQ(csv(1, 2), 6);
+        ASSERT_EQ(csv(1, 0), 4);
+        auto tsv = tao::io::parse_text<float>("1\t2\n3\t4\n", tao::io::Tsv);
+        ASSERT_FLOAT_EQ(tsv(1, 0), 3.0f);
+    }
+
+    TEST(Text, BlankLines) {
+        // lines of only spaces, tabs and carriage returns are skipped
+        // in every dialect, so that the rows counted are the rows parsed
+        for (auto dialect : {tao::io::Whitespace, tao::io::Csv, tao::io::Tsv}) {
+            std::string sep (1, tao::io::delimiter_of(dialect));
+            auto mat = tao::io::parse_text<int>("\t\n1" + sep + "2\n\t\n \t \r\n3" + sep + "4\n\t", dialect);
+            ASSERT_EQ(mat.nrows(), 2) << dialect;
+            ASSERT_EQ(mat(1, 1), 4) << dialect;
+        }
+        std::string big;
+        for (int i = 0; i < 200000; ++i)
+            big += std::to_string(i) + "\t1\n\t\n";
+        auto mat = tao::io::parse_text<int>(big, tao::io::Tsv);
+        ASSERT_EQ(mat.nrows(), 200000);
+        ASSERT_EQ(mat(199999, 0), 199999);
+    }
+
+    TEST(Text, ParseErrors) {
+        ASSERT_THROW(tao::io::parse_text<double>("1 2\n3\n"), std::invalid_argument);
+        ASSERT_THROW(tao::io::parse_text<double>("1,x\n", tao::io::Csv), std::invalid_argument);
+        ASSERT_THROW(tao::io::parse_text<int>("1 2 3\n4 5 6 7\n"), std::invalid_argument);
+    }
+
+    TEST(Text, RoundTripShortest) {
+        tao::Mat<double, 2, 2> mat {{0.1, 1.0 / 3.0}, {-2e-300, 12345678.9}};
+        std::string text = tao::io::to_text(mat, tao::io::Csv);
+        ASSERT_EQ(text.substr(0, 4), "0.1,");
+        auto back = tao::io::parse_text<double>(text, tao::io::Csv);
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 2; ++j)
+                ASSERT_EQ(back(i, j), mat(i, j));
+    }
+
+    TEST(Text, ParallelFile) {
+        tao::Mat<float, Dynamic, Dynamic> mat (60000, 7);
+        for (int i = 0; i < mat.nrows(); ++i)
+            for (int j = 0; j < mat.ncols(); ++j)
+                mat(i, j) = i * 0.25f - j;
+        auto path = ::testing::TempDir() + "tao_text_parallel.txt";
+        tao::io::save_text(path, mat);
+        auto back = tao::io::load_text<float>(path);
+        ASSERT_EQ(back.nrows(), 60000);
+        ASSERT_EQ(back.ncols(), 7);
+        ASSERT_FLOAT_EQ(back(59999, 6), 59999 * 0.25f - 6);
+        ASSERT_FLOAT_EQ(back(31234, 3), 31234 * 0.25f - 3);
+        std::remove(path.c_str());
+    }
+
+    TEST(Text, StreamOperatorDynamic) {
+        tao::Mat<int, Dynamic, Dynamic> mat {{1, 2}, {3, 4}};
+        std::ostringstream out;
+        out << mat;
+        ASSERT_EQ(out.str(), "[\n1 2 \n3 4 \n]\n");
+    }
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Transform.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using tao::Mat;
+    using tao::Quat;
+    using tao::TRS;
+
+    Quat<double> random_rotation(std::mt19937& gen) {
+        std::normal_distribution<double> n {0.0, 1.0};
+        return Quat<double> {n(gen), n(gen), n(gen), n(gen)}.normalized();
+    }
+
+    Mat<double, 4, 4> random_affine(std::mt19937& gen) {
+        std::uniform_real_distribution<double> u {-2.0, 2.0};
+        Mat<double, 4, 4> m (0.0);
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 4; ++j)
+                m(i, j) = u(gen);
+        m(3, 3) = 1.0;
+        return m;
+    }
+
+    void expect_near(const Mat<double, 4, 4>& a, const Mat<double, 4, 4>& b, double tolerance) {
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                ASSERT_NEAR(a(i, j), b(i, j), tolerance) << "at (" << i << ", " << j << ")";
+    }
+
+    TEST(Transform, RecoversTranslationRotationScale) {
+        std::mt19937 gen {1};
+        std::uniform_real_distribution<double> s {0.1, 4.0};
+        for (int k = 0; k < 500; ++k) {
+            tao::Vec3d t {s(gen), -s(gen), s(gen)};
+            tao::Vec3d scale {s(gen), s(gen), k % 2 ? s(gen) : -s(gen)};
+            Quat<double> q = random_rotation(gen);
+            TRS<double> trs {t, q, scale};
+            Mat<double, 4, 4> m = tao::compose(trs);
+            TRS<double> back = tao::decompose(m);
+            expect_near(tao::compose(back), m, 1e-12);
+            for (int a = 0; a < 3; ++a)
+                ASSERT_NEAR(back.translation(a), t(a), 1e-15);
+            if (k % 2) {
+                ASSERT_NEAR(std::abs(dot(back.rotation, q)), 1.0, 1e-12);
+                for (int a = 0; a < 3; ++a)
+                    ASSERT_NEAR(back.scale()(a), scale(a), 1e-12);
+                for (int i = 0; i < 3; ++i)
+                    for (int j = 0; j < 3; ++j)
+                        if (i != j) {
+                            ASSERT_NEAR(back.stretch(i, j), 0.0, 1e-12);
+                        }
+            }
+        }
+    }
+
+    TEST(Transform, PolarDecompositionOfShear) {
+        std::mt19937 gen {2};
+        for (int k = 0; k < 500; ++k) {
+            Mat<double, 4, 4> m = random_affine(gen);
+            TRS<double> trs = tao::decompose(m);
+            expect_near(tao::compose(trs), m, 1e-11);
+            ASSERT_NEAR(trs.rotation.norm(), 1.0, 1e-14);
+            auto s = trs.stretch;
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    ASSERT_EQ(s(i, j), s(j, i));
+            // the stretch is definite, with the sign of the determinant
+            double det = s(0, 0) * (s(1, 1) * s(2, 2) - s(1, 2) * s(2, 1)) - s(0, 1) * (s(1, 0) * s(2, 2) - s(1, 2) * s(2, 0))
+                + s(0, 2) * (s(1, 0) * s(2, 1) - s(1, 1) * s(2, 0));
+            ASSERT_EQ(det > 0, tao::det(m) > 0);
+            ASSERT_EQ(s(0, 0) > 0, det > 0);
+        }
+        Mat<double, 4, 4> singular (0.0);
+        singular(3, 3) = 1.0;
+        ASSERT_THROW(tao::decompose(singular), std::invalid_argument);
+    }
+
+    TEST(Transform, Batches) {
+        std::mt19937 gen {3};
+        const std::size_t n = 4099;
+        std::vector<Mat<double, 4, 4>> m;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i % 2) {
+                m.push_back(random_affine(gen));
+            } else {
+                TRS<double> trs {tao::Vec3d {1.0, 2.0, 3.0}, random_rotation(gen), tao::Vec3d {1.0, 2.0, 0.5}};
+                m.push_back(tao::compose(trs));
+            }
+        }
+        std::vector<TRS<double>> trs (n);
+        tao::decompose(m.data(), n, trs.data());
+        std::vector<Mat<double, 4, 4>> back (n, Mat<double, 4, 4>(0.0));
+        tao::compose(trs.data(), n, back.data());
+        for (std::size_t i = 0; i < n; ++i)
+            expect_near(back[i], m[i], 1e-11);
+        ASSERT_NEAR(std::abs(dot(trs[7].rotation, tao::decompose(m[7]).rotation)), 1.0, 1e-14);
+        m[5](0, 0) = m[5](1, 0) = m[5](2, 0) = 0.0;
+        ASSERT_THROW(tao::decompose(m.data(), n, trs.data()), std::invalid_argument);
+    }
+
+};
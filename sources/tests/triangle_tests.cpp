@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+#include "tao/geometry/Triangle.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using namespace tao::geometry;
+
+    TEST(Triangle, SingleHit) {
+        Triangle<float> tri {tao::Vec3f {0.0f, 0.0f, 5.0f}, tao::Vec3f {1.0f, 0.0f, 5.0f}, tao::Vec3f {0.0f, 1.0f, 5.0f}};
+        Ray<float> ray {tao::Vec3f {0.25f, 0.5f, 0.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}};
+        for (auto algorithm : {MollerTrumbore, Watertight}) {
+            float t, u, v;
+            ASSERT_TRUE(intersect(tri, ray, t, u, v, algorithm));
+            ASSERT_FLOAT_EQ(t, 5.0f);
+            ASSERT_FLOAT_EQ(u, 0.25f);
+            ASSERT_FLOAT_EQ(v, 0.5f);
+            Ray<float> back {tao::Vec3f {0.25f, 0.5f, 0.0f}, tao::Vec3f {0.0f, 0.0f, -1.0f}};
+            ASSERT_FALSE(intersect(tri, back, t, u, v, algorithm));
+            Ray<float> outside {tao::Vec3f {0.75f, 0.5f, 0.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}};
+            ASSERT_FALSE(intersect(tri, outside, t, u, v, algorithm));
+            Ray<float> shortened {tao::Vec3f {0.25f, 0.5f, 0.0f}, tao::Vec3f {0.0f, 0.0f, 1.0f}, 0.0f, 4.0f};
+            ASSERT_FALSE(intersect(tri, shortened, t, u, v, algorithm));
+            Ray<float> parallel {tao::Vec3f {0.25f, 0.5f, 5.0f}, tao::Vec3f {1.0f, 0.0f, 0.0f}};
+            ASSERT_FALSE(intersect(tri, parallel, t, u, v, algorithm));
+        }
+    }
+
+    template<int W>
+    void check_packet(TriangleIntersection algorithm) {
+        std::mt19937 gen {W};
+        std::uniform_real_distribution<float> u {-1.0f, 1.0f};
+        for (int round = 0; round < 200; ++round) {
+            std::vector<Triangle<float>> tris;
+            TrianglePacket<float, W> packet;
+            for (int l = 0; l < W; ++l) {
+                tris.emplace_back(tao::Vec3f {u(gen), u(gen), 3.0f + u(gen)}, tao::Vec3f {u(gen), u(gen), 3.0f + u(gen)},
+                        tao::Vec3f {u(gen), u(gen), 3.0f + u(gen)});
+                packet.set(l, tris.back());
+            }
+            Ray<float> ray {tao::Vec3f {0.2f * u(gen), 0.2f * u(gen), 0.0f}, tao::Vec3f {0.1f * u(gen), 0.1f * u(gen), 1.0f}};
+            TriangleHits<float, W> hits;
+            intersect(packet, ray, hits, algorithm);
+            int nearest = -1;
+            for (int l = 0; l < W; ++l) {
+                float t, bu, bv;
+                bool hit = intersect(tris[l], ray, t, bu, bv, algorithm);
+                ASSERT_EQ(hit, bool((hits.mask >> l) & 1u));
+                if (hit) {
+                    ASSERT_FLOAT_EQ(hits.t[l], t);
+                    if (nearest < 0 || t < hits.t[nearest])
+                        nearest = l;
+                }
+            }
+            ASSERT_EQ(hits.nearest(), nearest);
+        }
+    }
+
+    TEST(Triangle, PacketsMatchSingleTests) {
+        check_packet<4>(MollerTrumbore);
+        check_packet<4>(Watertight);
+        check_packet<8>(MollerTrumbore);
+        check_packet<8>(Watertight);
+        // widths that are not powers of two
+        check_packet<3>(Watertight);
+        check_packet<6>(MollerTrumbore);
+        static_assert(alignof(TrianglePacket<float, 6>) == 8);
+        static_assert(alignof(TrianglePacket<float, 32>) == 64);
+    }
+
+    TEST(Triangle, AlgorithmsAgreeAwayFromEdges) {
+        std::mt19937 gen {3};
+        std::uniform_real_distribution<double> u {-1.0, 1.0};
+        int hits = 0;
+        for (int k = 0; k < 2000; ++k) {
+            Triangle<double> tri {tao::Vec3d {u(gen), u(gen), u(gen) + 4.0}, tao::Vec3d {u(gen), u(gen), u(gen) + 4.0},
+                tao::Vec3d {u(gen), u(gen), u(gen) + 4.0}};
+            Ray<double> ray {tao::Vec3d {0.0, 0.0, 0.0}, tao::Vec3d {0.3 * u(gen), 0.3 * u(gen), 1.0}};
+            double t0, u0, v0, t1, u1, v1;
+            bool h0 = intersect(tri, ray, t0, u0, v0, MollerTrumbore);
+            bool h1 = intersect(tri, ray, t1, u1, v1, Watertight);
+            if (h0 && std::min({u0, v0, 1.0 - u0 - v0}) < 1e-9)
+                continue;
+            ASSERT_EQ(h0, h1);
+            if (h0) {
+                ++hits;
+                ASSERT_NEAR(t0, t1, 1e-9);
+                ASSERT_NEAR(u0, u1, 1e-9);
+                ASSERT_NEAR(v0, v1, 1e-9);
+            }
+        }
+        ASSERT_GT(hits, 100);
+    }
+
+    TEST(Triangle, WatertightAlongSharedEdges) {
+        // a fan around a vertex: rays aimed at points of the shared edges
+        // must hit at least one of the two triangles sharing them
+        const int sides = 7;
+        tao::Vec3f center {0.1f, -0.2f, 10.0f};
+        std::vector<tao::Vec3f> rim;
+        for (int k = 0; k < sides; ++k) {
+            float a = 2.0f * float(M_PI) * float(k) / sides;
+            rim.push_back(tao::Vec3f {0.1f + 3.0f * std::cos(a), -0.2f + 3.0f * std::sin(a), 10.0f + 0.37f * float(k % 3)});
+        }
+        TrianglePacket<float, 8> fan;
+        for (int k = 0; k < sides; ++k)
+            fan.set(k, Triangle<float> {center, rim[k], rim[(k + 1) % sides]});
+        std::mt19937 gen {1};
+        std::uniform_real_distribution<float> u {0.0f, 1.0f};
+        for (int k = 0; k < 2000; ++k) {
+            const tao::Vec3f& edge = rim[k % sides];
+            float s = u(gen);
+            tao::Vec3f target (0.0f);
+            for (int a = 0; a < 3; ++a)
+                target.raw()[a] = center.raw()[a] + s * (edge.raw()[a] - center.raw()[a]);
+            tao::Vec3f origin {u(gen) * 4.0f - 2.0f, u(gen) * 4.0f - 2.0f, 0.0f};
+            Ray<float> ray {origin, target - origin};
+            TriangleHits<float, 8> hits;
+            intersect(fan, ray, hits, Watertight);
+            ASSERT_NE(hits.mask, 0u) << "ray " << k << " slipped through";
+        }
+    }
+
+    TEST(Triangle, CrossProduct) {
+        tao::Vec3d x {1.0, 0.0, 0.0}, y {0.0, 1.0, 0.0}, z {0.0, 0.0, 1.0};
+        ASSERT_TRUE(tao::cross(x, y) == z);
+        ASSERT_TRUE(tao::cross(y, x) == -z);
+    }
+
+}
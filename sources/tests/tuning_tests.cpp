@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+#include "tao/core.h"
+#include "tao/linalg/Reductions.h"
+#include "tao/linalg/Transpose.h"
+#include "tao/linalg/Tuning.h"
+#include <cstdio>
+#include <random>
+
+namespace {
+
+    using DMat = tao::Mat<double, Dynamic, Dynamic>;
+
+    /**
+     * Restores the profile in use when it goes out of scope.
+     * */
+    struct KeepProfile {
+        tao::tuning::Profile previous;
+        KeepProfile() : previous {tao::tuning::profile()} {}
+        ~KeepProfile() { tao::tuning::set_profile(previous); }
+    };
+
+    TEST(Tuning, CacheSizes) {
+        auto caches = tao::tuning::cache_sizes();
+        ASSERT_GE(caches.l1, std::size_t(4) << 10);
+        ASSERT_GE(caches.l2, caches.l1);
+        ASSERT_GT(caches.l3, 0u);
+    }
+
+    TEST(Tuning, DerivedProfile) {
+        auto p = tao::tuning::derived_profile({std::size_t(32) << 10, std::size_t(256) << 10, std::size_t(8) << 20});
+        ASSERT_EQ(p.gemm.nc, 512);
+        ASSERT_EQ(p.gemm.kc, 32);
+        ASSERT_EQ(p.gemm.mc, tao::default_gemm_blocking.mc);
+        ASSERT_EQ(p.transpose_block, 32);
+        ASSERT_EQ(p.reduction_grain, std::size_t(1) << 14);
+        auto big = tao::tuning::derived_profile({std::size_t(48) << 10, std::size_t(2) << 20, std::size_t(100) << 20});
+        ASSERT_EQ(big.gemm.nc, 512);
+        ASSERT_EQ(big.gemm.kc, 256);
+        ASSERT_EQ(big.reduction_grain, std::size_t(1) << 16);
+    }
+
+    TEST(Tuning, SaveLoad) {
+        auto path = ::testing::TempDir() + "tao_tuning/nested/profile";
+        tao::tuning::Profile p {{32, 128, 512}, 64, std::size_t(1) << 15};
+        tao::tuning::save(p, path);
+        auto back = tao::tuning::load(path);
+        ASSERT_EQ(back.gemm.mc, 32);
+        ASSERT_EQ(back.gemm.kc, 128);
+        ASSERT_EQ(back.gemm.nc, 512);
+        ASSERT_EQ(back.transpose_block, 64);
+        ASSERT_EQ(back.reduction_grain, std::size_t(1) << 15);
+        ASSERT_EQ(back.strassen_cutoff, tao::default_strassen_cutoff);
+        std::remove(path.c_str());
+        ASSERT_THROW(tao::tuning::load(path), std::runtime_error);
+    }
+
+    TEST(Tuning, LoadPartialAndInvalid) {
+        auto path = ::testing::TempDir() + "tao_tuning_partial";
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        std::fprintf(file, "# comment\n\ntranspose_block 8\nfuture_key 3\n");
+        std::fclose(file);
+        auto p = tao::tuning::load(path);
+        auto derived = tao::tuning::derived_profile(tao::tuning::cache_sizes());
+        ASSERT_EQ(p.transpose_block, 8);
+        ASSERT_EQ(p.gemm.kc, derived.gemm.kc);
+        ASSERT_EQ(p.reduction_grain, derived.reduction_grain);
+        for (const char* line : {"gemm_mc -4\n", "gemm_kc lots\n", "gemm_nc 64 128\n", "transpose_block\n"}) {
+            file = std::fopen(path.c_str(), "w");
+            std::fputs(line, file);
+            std::fclose(file);
+            ASSERT_THROW(tao::tuning::load(path), std::invalid_argument) << line;
+        }
+        std::remove(path.c_str());
+    }
+
+    TEST(Tuning, SetProfile) {
+        KeepProfile keep;
+        tao::tuning::set_profile({{16, 32, 64}, 8, std::size_t(1) << 10});
+        ASSERT_EQ(tao::gemm_blocking().kc, 32);
+        ASSERT_EQ(tao::transpose_block(), 8);
+        ASSERT_EQ(tao::reduction_grain(), std::size_t(1) << 10);
+        ASSERT_THROW(tao::tuning::set_profile({{0, 32, 64}, 8, 1}), std::invalid_argument);
+        ASSERT_EQ(tao::gemm_blocking().mc, 16);
+    }
+
+    TEST(Tuning, SameResults) {
+        KeepProfile keep;
+        std::mt19937 gen {7};
+        std::uniform_real_distribution<double> u {-1.0, 1.0};
+        DMat a (150, 90), b (90, 110);
+        for (int i = 0; i < 150; ++i)
+            for (int j = 0; j < 90; ++j)
+                a(i, j) = u(gen);
+        for (int i = 0; i < 90; ++i)
+            for (int j = 0; j < 110; ++j)
+                b(i, j) = u(gen);
+        DMat c = a * b;
+        DMat t = tao::transpose(a);
+        double s = tao::sum(c);
+        tao::tuning::set_profile({{16, 8, 24}, 4, std::size_t(1) << 8});
+        ASSERT_EQ(c, a * b);
+        ASSERT_EQ(t, tao::transpose(a));
+        ASSERT_NEAR(s, tao::sum(c), 1e-9);
+    }
+
+    TEST(Tuning, Tune) {
+        KeepProfile keep;
+        auto before = tao::tuning::profile();
+        auto p = tao::tuning::tune(32);
+        ASSERT_GT(p.gemm.mc, 0);
+        ASSERT_GT(p.gemm.kc, 0);
+        ASSERT_GT(p.gemm.nc, 0);
+        ASSERT_GT(p.transpose_block, 0);
+        ASSERT_GT(p.reduction_grain, 0u);
+        ASSERT_GT(p.strassen_cutoff, 0);
+        ASSERT_EQ(tao::tuning::profile().gemm.kc, before.gemm.kc);
+        ASSERT_EQ(tao::tuning::profile().reduction_grain, before.reduction_grain);
+        ASSERT_THROW(tao::tuning::tune(4), std::invalid_argument);
+    }
+
+};